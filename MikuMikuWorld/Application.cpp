@@ -228,6 +228,7 @@ namespace MikuMikuWorld
 					break;
 
 				case DialogResult::No:
+					editor->discardJournal();
 					glfwSetWindowShouldClose(window, 1);
 					break;
 
@@ -95,6 +95,10 @@ namespace MikuMikuWorld
 			pvStageOpacity = jsonIO::tryGetValue<float>(previewObj, "stage_opacity", 1.f);
 			pvBackgroundBrightness = jsonIO::tryGetValue<float>(previewObj, "background_brightness", 1.f);
 			pvEffectsProfile = jsonIO::tryGetValue<int>(previewObj, "effects_profile", 0);
+			pvEffectsThreadCount = jsonIO::tryGetValue<int>(previewObj, "effects_thread_count", 0);
+			pvEffectsCurveResolution = jsonIO::tryGetValue<int>(previewObj, "effects_curve_resolution", 256);
+			pvBakeEffects = jsonIO::tryGetValue<bool>(previewObj, "bake_effects", false);
+			pvEffectsBakeMemory = jsonIO::tryGetValue<int>(previewObj, "effects_bake_memory", 128);
 			pvDrawToolbar = jsonIO::tryGetValue<bool>(previewObj, "draw_toolbar", true);
 		}
 
@@ -110,6 +114,7 @@ namespace MikuMikuWorld
 			autoSaveEnabled	= jsonIO::tryGetValue<bool>(config["save"], "auto_save_enabled", true);
 			autoSaveInterval = jsonIO::tryGetValue<int>(config["save"], "auto_save_interval", 5);
 			autoSaveMaxCount = jsonIO::tryGetValue<int>(config["save"], "auto_save_max_count", 100);
+			historyMemoryBudget = jsonIO::tryGetValue<int>(config["save"], "history_memory_budget", 256);
 			lastSelectedExportIndex = jsonIO::tryGetValue<int>(config["save"], "last_export_option", 0);
 		}
 
@@ -119,6 +124,10 @@ namespace MikuMikuWorld
 			masterVolume	= std::clamp(jsonIO::tryGetValue<float>(config["audio"], "master_volume", 1.0f), 0.0f, 1.0f);
 			bgmVolume		= std::clamp(jsonIO::tryGetValue<float>(config["audio"], "bgm_volume", 1.0f), 0.0f, 1.0f);
 			seVolume		= std::clamp(jsonIO::tryGetValue<float>(config["audio"], "se_volume", 1.0f), 0.0f, 1.0f);
+			streamMusic		= jsonIO::tryGetValue<bool>(config["audio"], "stream_music", false);
+			cacheMusic		= jsonIO::tryGetValue<bool>(config["audio"], "cache_music", true);
+			cacheDecodedMusic	= jsonIO::tryGetValue<bool>(config["audio"], "cache_decoded_music", true);
+			musicCacheSize	= std::max(jsonIO::tryGetValue<int>(config["audio"], "music_cache_size", 2048), 0);
 		}
 
 		if (jsonIO::keyExists(config, "input") && jsonIO::keyExists(config["input"], "bindings"))
@@ -205,6 +214,10 @@ namespace MikuMikuWorld
 			{"stage_opacity", pvStageOpacity},
 			{"background_brightness", pvBackgroundBrightness},
 			{"effects_profile", pvEffectsProfile},
+			{"effects_thread_count", pvEffectsThreadCount},
+			{"effects_curve_resolution", pvEffectsCurveResolution},
+			{"bake_effects", pvBakeEffects},
+			{"effects_bake_memory", pvEffectsBakeMemory},
 			{"draw_toolbar", pvDrawToolbar}
 		};
 
@@ -225,6 +238,7 @@ namespace MikuMikuWorld
 			{"auto_save_enabled", autoSaveEnabled},
 			{"auto_save_interval", autoSaveInterval},
 			{"auto_save_max_count", autoSaveMaxCount},
+			{"history_memory_budget", historyMemoryBudget},
 			{"last_export_option", lastSelectedExportIndex}
 		};
 
@@ -232,7 +246,11 @@ namespace MikuMikuWorld
 			{"se_profile", seProfileIndex},
 			{"master_volume", masterVolume},
 			{"bgm_volume", bgmVolume},
-			{"se_volume", seVolume}
+			{"se_volume", seVolume},
+			{"stream_music", streamMusic},
+			{"cache_music", cacheMusic},
+			{"cache_decoded_music", cacheDecodedMusic},
+			{"music_cache_size", musicCacheSize}
 		};
 
 		json keyBindings;
@@ -303,18 +321,27 @@ namespace MikuMikuWorld
 		pvStageOpacity = 1.f;
 		pvBackgroundBrightness = 1.f;
 		pvEffectsProfile = 0;
+		pvEffectsThreadCount = 0;
+		pvEffectsCurveResolution = 256;
+		pvBakeEffects = false;
+		pvEffectsBakeMemory = 128;
 		notesSkin = 0;
 		pvDrawToolbar = true;
 
 		autoSaveEnabled = true;
 		autoSaveInterval = 5;
 		autoSaveMaxCount = 100;
+		historyMemoryBudget = 256;
 		lastSelectedExportIndex = 0;
 
 		seProfileIndex = 0;
 		masterVolume = 1.0f;
 		bgmVolume = 1.0f;
 		seVolume = 1.0f;
+		streamMusic = false;
+		cacheMusic = true;
+		cacheDecodedMusic = true;
+		musicCacheSize = 2048;
 
 		debugEnabled = false;
 	}
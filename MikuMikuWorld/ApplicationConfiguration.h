@@ -100,10 +100,15 @@ namespace MikuMikuWorld
 		bool autoSaveEnabled;
 		int autoSaveInterval;
 		int autoSaveMaxCount;
+		int historyMemoryBudget;
 		float masterVolume;
 		float bgmVolume;
 		float seVolume;
 		int seProfileIndex;
+		bool streamMusic;
+		bool cacheMusic;
+		bool cacheDecodedMusic;
+		int musicCacheSize;
 		int lastSelectedExportIndex;
 		bool debugEnabled;
 		bool pvMirrorScore;
@@ -117,6 +122,10 @@ namespace MikuMikuWorld
 		float pvStageOpacity;
 		float pvBackgroundBrightness;
 		int pvEffectsProfile;
+		int pvEffectsThreadCount; // 0 uses one thread per core
+		int pvEffectsCurveResolution; // 0 evaluates the effect curves from their keyframes
+		bool pvBakeEffects;
+		int pvEffectsBakeMemory; // In megabytes
 		int notesSkin;
 		bool pvDrawToolbar;
 
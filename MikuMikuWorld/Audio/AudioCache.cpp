@@ -0,0 +1,492 @@
+#include "../IO.h"
+#include "AudioCache.h"
+#include "Waveform.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Audio
+{
+	namespace fs = std::filesystem;
+
+	constexpr char cacheMagic[4] = { 'M', 'M', 'W', 'C' };
+	constexpr const char* waveformExtension = ".waveform";
+	constexpr const char* samplesExtension = ".pcm";
+
+	struct CacheFileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t fileSize;
+		int64_t modifiedTime;
+		uint64_t contentHash;
+	};
+
+	struct SamplesHeader
+	{
+		uint32_t sampleRate;
+		uint32_t channelCount;
+		uint64_t frameCount;
+	};
+
+	struct ChainHeader
+	{
+		double durationInSeconds;
+		uint64_t mipCount;
+	};
+
+	struct MipHeader
+	{
+		uint64_t powerOfTwoSampleCount;
+		double secondsPerSample;
+		double samplesPerSecond;
+		uint64_t sampleCount;
+		uint64_t summaryCount;
+	};
+
+	// Every section starts 8 byte aligned so it can be read in place from the mapped file
+	constexpr size_t sectionAlignment = 8;
+
+	static size_t alignSection(size_t size)
+	{
+		return (size + sectionAlignment - 1) & ~(sectionAlignment - 1);
+	}
+
+	class CacheWriter
+	{
+	public:
+		CacheWriter(const fs::path& path) : stream(path, std::ios::binary | std::ios::trunc) {}
+
+		bool isGood() const { return stream.good(); }
+
+		void write(const void* data, size_t size)
+		{
+			static constexpr char padding[sectionAlignment]{};
+			stream.write(static_cast<const char*>(data), size);
+			stream.write(padding, alignSection(size) - size);
+		}
+
+		template <typename T>
+		void write(const T& value)
+		{
+			write(&value, sizeof(T));
+		}
+
+		void close() { stream.close(); }
+
+	private:
+		std::ofstream stream;
+	};
+
+	class CacheReader
+	{
+	public:
+		CacheReader(const IO::MappedFile& file) : data{ file.getData() }, size{ file.getSize() } {}
+
+		// Returns the next section or nullptr if the file is too short
+		const uint8_t* read(size_t sectionSize)
+		{
+			if (sectionSize > size - position || alignSection(sectionSize) > size - position)
+				return nullptr;
+
+			const size_t alignedSize = alignSection(sectionSize);
+			const uint8_t* section = data + position;
+			position += alignedSize;
+			return section;
+		}
+
+		template <typename T>
+		bool read(T& value)
+		{
+			const uint8_t* section = read(sizeof(T));
+			if (section)
+				std::memcpy(&value, section, sizeof(T));
+
+			return section != nullptr;
+		}
+
+		bool isAtEnd() const { return position == size; }
+
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t position{};
+	};
+
+	// FNV-1a over 64-bit words, only meant to tell music files apart
+	static uint64_t hashBytes(uint64_t hash, const uint8_t* bytes, size_t size)
+	{
+		constexpr uint64_t prime = 0x100000001b3ull;
+
+		size_t index = 0;
+		for (; index + sizeof(uint64_t) <= size; index += sizeof(uint64_t))
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + index, sizeof(uint64_t));
+			hash = (hash ^ word) * prime;
+		}
+
+		for (; index < size; index++)
+			hash = (hash ^ bytes[index]) * prime;
+
+		return hash;
+	}
+
+	std::string AudioCacheKey::toString() const
+	{
+		return IO::formatString("%016llx-%llx-%llx",
+			static_cast<unsigned long long>(contentHash),
+			static_cast<unsigned long long>(fileSize),
+			static_cast<unsigned long long>(modifiedTime));
+	}
+
+	void AudioCache::setDirectory(const std::string& directory)
+	{
+		this->directory = directory;
+	}
+
+	void AudioCache::setEnabled(bool enabled)
+	{
+		this->enabled = enabled;
+	}
+
+	void AudioCache::setSamplesEnabled(bool enabled)
+	{
+		samplesEnabled = enabled;
+	}
+
+	void AudioCache::setSizeLimit(uint64_t bytes)
+	{
+		sizeLimit = bytes;
+	}
+
+	bool AudioCache::createKey(const std::string& filename, AudioCacheKey& key)
+	{
+		key = {};
+		const fs::path path = IO::mbToWideStr(filename);
+
+		std::error_code error;
+		const uint64_t fileSize = fs::file_size(path, error);
+		if (error || fileSize == 0)
+			return false;
+
+		const fs::file_time_type modifiedTime = fs::last_write_time(path, error);
+		if (error)
+			return false;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		// Chunks are a multiple of the hashed word size so only the last one has a tail
+		constexpr size_t chunkSize = 1 << 20;
+		std::vector<uint8_t> chunk(chunkSize);
+		uint64_t hash = 0xcbf29ce484222325ull;
+		uint64_t bytesRead{};
+
+		while (file)
+		{
+			file.read(reinterpret_cast<char*>(chunk.data()), chunkSize);
+			const size_t count = static_cast<size_t>(file.gcount());
+			hash = hashBytes(hash, chunk.data(), count);
+			bytesRead += count;
+		}
+
+		if (bytesRead != fileSize)
+			return false;
+
+		key.fileSize = fileSize;
+		key.modifiedTime = static_cast<int64_t>(modifiedTime.time_since_epoch().count());
+		key.contentHash = hash;
+		return true;
+	}
+
+	std::string AudioCache::getEntryFilename(const AudioCacheKey& key, const char* extension) const
+	{
+		return directory + "\\" + key.toString() + extension;
+	}
+
+	static CacheFileHeader createHeader(const AudioCacheKey& key)
+	{
+		CacheFileHeader header{};
+		std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+		header.version = AudioCache::version;
+		header.fileSize = key.fileSize;
+		header.modifiedTime = key.modifiedTime;
+		header.contentHash = key.contentHash;
+		return header;
+	}
+
+	static bool isHeaderValid(const CacheFileHeader& header, const AudioCacheKey& key)
+	{
+		return std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0
+			&& header.version == AudioCache::version
+			&& header.fileSize == key.fileSize
+			&& header.modifiedTime == key.modifiedTime
+			&& header.contentHash == key.contentHash;
+	}
+
+	// Opens an entry and marks it as the most recently used one
+	static bool openEntry(const std::string& filename, IO::MappedFile& file)
+	{
+		const fs::path path = IO::mbToWideStr(filename);
+		std::error_code error;
+		if (!fs::exists(path, error))
+			return false;
+
+		fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+		return file.open(filename);
+	}
+
+	// An entry that can't be read is from another version or was cut short, it will only be in the way
+	static void removeEntry(const std::string& filename)
+	{
+		std::error_code error;
+		fs::remove(IO::mbToWideStr(filename), error);
+	}
+
+	// Written to a temporary file first so a crash never leaves a truncated entry behind
+	template <typename WriteFunction>
+	static bool writeEntry(const std::string& directory, const std::string& filename, WriteFunction&& writeContents)
+	{
+		std::error_code error;
+		fs::create_directories(IO::mbToWideStr(directory), error);
+
+		const fs::path path = IO::mbToWideStr(filename);
+		fs::path tempPath = path;
+		tempPath += L".tmp";
+
+		CacheWriter writer(tempPath);
+		if (writer.isGood())
+			writeContents(writer);
+
+		const bool written = writer.isGood();
+		writer.close();
+
+		if (!written)
+		{
+			fs::remove(tempPath, error);
+			return false;
+		}
+
+		fs::rename(tempPath, path, error);
+		if (error)
+		{
+			fs::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool readMipChain(CacheReader& reader, WaveformMipChain& chain)
+	{
+		ChainHeader chainHeader{};
+		if (!reader.read(chainHeader) || chainHeader.mipCount > WaveformMipChain::maxMipLevels)
+			return false;
+
+		chain.clear();
+		chain.durationInSeconds = chainHeader.durationInSeconds;
+		for (size_t i = 0; i < chainHeader.mipCount; i++)
+		{
+			MipHeader mipHeader{};
+			if (!reader.read(mipHeader) || mipHeader.sampleCount > mipHeader.powerOfTwoSampleCount)
+				return false;
+
+			const uint8_t* samples = reader.read(mipHeader.sampleCount * sizeof(int16_t));
+			const uint8_t* summaries = reader.read(mipHeader.summaryCount * sizeof(WaveformSummary));
+			if (!samples || !summaries)
+				return false;
+
+			WaveformMip& mip = chain.mips[i];
+			mip.powerOfTwoSampleCount = mipHeader.powerOfTwoSampleCount;
+			mip.secondsPerSample = mipHeader.secondsPerSample;
+			mip.samplesPerSecond = mipHeader.samplesPerSecond;
+
+			const int16_t* sampleData = reinterpret_cast<const int16_t*>(samples);
+			mip.absoluteSamples.assign(sampleData, sampleData + mipHeader.sampleCount);
+
+			const WaveformSummary* summaryData = reinterpret_cast<const WaveformSummary*>(summaries);
+			mip.summaries.assign(summaryData, summaryData + mipHeader.summaryCount);
+		}
+
+		return true;
+	}
+
+	static void writeMipChain(CacheWriter& writer, const WaveformMipChain& chain)
+	{
+		ChainHeader chainHeader{};
+		chainHeader.durationInSeconds = chain.durationInSeconds;
+		chainHeader.mipCount = chain.getUsedMipCount();
+		writer.write(chainHeader);
+
+		for (size_t i = 0; i < chainHeader.mipCount; i++)
+		{
+			const WaveformMip& mip = chain.mips[i];
+			MipHeader mipHeader{};
+			mipHeader.powerOfTwoSampleCount = mip.powerOfTwoSampleCount;
+			mipHeader.secondsPerSample = mip.secondsPerSample;
+			mipHeader.samplesPerSecond = mip.samplesPerSecond;
+			mipHeader.sampleCount = mip.absoluteSamples.size();
+			mipHeader.summaryCount = mip.summaries.size();
+
+			writer.write(mipHeader);
+			writer.write(mip.absoluteSamples.data(), mip.absoluteSamples.size() * sizeof(int16_t));
+			writer.write(mip.summaries.data(), mip.summaries.size() * sizeof(WaveformSummary));
+		}
+	}
+
+	bool AudioCache::loadWaveforms(const AudioCacheKey& key, WaveformMipChain& left, WaveformMipChain& right)
+	{
+		if (!isEnabled() || !key.isValid())
+			return false;
+
+		const std::string filename = getEntryFilename(key, waveformExtension);
+		IO::MappedFile file;
+		if (!openEntry(filename, file))
+			return false;
+
+		CacheReader reader(file);
+		CacheFileHeader header{};
+		if (reader.read(header) && isHeaderValid(header, key) && readMipChain(reader, left) && readMipChain(reader, right) && reader.isAtEnd())
+			return true;
+
+		left.clear();
+		right.clear();
+		file.close();
+		removeEntry(filename);
+		return false;
+	}
+
+	bool AudioCache::storeWaveforms(const AudioCacheKey& key, const WaveformMipChain& left, const WaveformMipChain& right)
+	{
+		if (!isEnabled() || !key.isValid() || left.isEmpty())
+			return false;
+
+		const bool stored = writeEntry(directory, getEntryFilename(key, waveformExtension), [&](CacheWriter& writer)
+		{
+			writer.write(createHeader(key));
+			writeMipChain(writer, left);
+			writeMipChain(writer, right);
+		});
+
+		evict();
+		return stored;
+	}
+
+	bool AudioCache::loadSamples(const AudioCacheKey& key, const std::string& name, SoundBuffer& sound)
+	{
+		if (!isSamplesEnabled() || !key.isValid())
+			return false;
+
+		const std::string filename = getEntryFilename(key, samplesExtension);
+		std::unique_ptr<IO::MappedFile> file = std::make_unique<IO::MappedFile>();
+		if (!openEntry(filename, *file))
+			return false;
+
+		CacheReader reader(*file);
+		CacheFileHeader header{};
+		SamplesHeader samplesHeader{};
+		if (reader.read(header) && isHeaderValid(header, key) && reader.read(samplesHeader) && samplesHeader.sampleRate > 0 && samplesHeader.channelCount > 0)
+		{
+			const size_t sampleOffset = alignSection(sizeof(CacheFileHeader)) + alignSection(sizeof(SamplesHeader));
+			const uint64_t samplesSize = samplesHeader.frameCount * samplesHeader.channelCount * sizeof(int16_t);
+			const bool sizeValid = samplesHeader.frameCount > 0 && samplesHeader.frameCount <= file->getSize() && samplesHeader.channelCount <= 64;
+			if (sizeValid && reader.read(static_cast<size_t>(samplesSize)) && reader.isAtEnd())
+			{
+				sound.initialize(name, samplesHeader.sampleRate, samplesHeader.channelCount, samplesHeader.frameCount, std::move(file), sampleOffset);
+				return true;
+			}
+		}
+
+		file->close();
+		removeEntry(filename);
+		return false;
+	}
+
+	bool AudioCache::storeSamples(const AudioCacheKey& key, const SoundBuffer& sound)
+	{
+		if (!isSamplesEnabled() || !key.isValid() || !sound.isValid())
+			return false;
+
+		const bool stored = writeEntry(directory, getEntryFilename(key, samplesExtension), [&](CacheWriter& writer)
+		{
+			SamplesHeader samplesHeader{};
+			samplesHeader.sampleRate = sound.sampleRate;
+			samplesHeader.channelCount = sound.channelCount;
+			samplesHeader.frameCount = sound.frameCount;
+
+			writer.write(createHeader(key));
+			writer.write(samplesHeader);
+			writer.write(sound.getSamples(), static_cast<size_t>(sound.frameCount) * sound.channelCount * sizeof(int16_t));
+		});
+
+		evict();
+		return stored;
+	}
+
+	static bool isCacheEntry(const fs::directory_entry& entry)
+	{
+		std::error_code error;
+		const fs::path extension = entry.path().extension();
+		return entry.is_regular_file(error) && (extension == waveformExtension || extension == samplesExtension);
+	}
+
+	uint64_t AudioCache::getSize() const
+	{
+		uint64_t size{};
+		std::error_code error;
+		for (const auto& entry : fs::directory_iterator(IO::mbToWideStr(directory), error))
+		{
+			if (isCacheEntry(entry))
+				size += entry.file_size(error);
+		}
+
+		return size;
+	}
+
+	void AudioCache::evict()
+	{
+		std::vector<fs::directory_entry> entries;
+		uint64_t size{};
+		std::error_code error;
+		for (const auto& entry : fs::directory_iterator(IO::mbToWideStr(directory), error))
+		{
+			if (!isCacheEntry(entry))
+				continue;
+
+			entries.push_back(entry);
+			size += entry.file_size(error);
+		}
+
+		if (size <= sizeLimit)
+			return;
+
+		// Hits refresh the write time of an entry, so the oldest one is the least recently used
+		std::sort(entries.begin(), entries.end(), [](const auto& e1, const auto& e2) {
+			return e1.last_write_time() < e2.last_write_time();
+		});
+
+		for (const auto& entry : entries)
+		{
+			if (size <= sizeLimit)
+				break;
+
+			// An entry that is still mapped can't be removed and stays until a later eviction
+			const uint64_t entrySize = entry.file_size(error);
+			if (fs::remove(entry.path(), error))
+				size -= entrySize;
+		}
+	}
+
+	void AudioCache::clear()
+	{
+		std::error_code error;
+		for (const auto& entry : fs::directory_iterator(IO::mbToWideStr(directory), error))
+		{
+			if (isCacheEntry(entry))
+				fs::remove(entry.path(), error);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Sound.h"
+#include <cstdint>
+#include <string>
+
+namespace Audio
+{
+	class WaveformMipChain;
+
+	/// <summary>
+	/// Identifies a music file by its size, last write time and contents rather than its path
+	/// </summary>
+	struct AudioCacheKey
+	{
+		uint64_t fileSize{};
+		int64_t modifiedTime{};
+		uint64_t contentHash{};
+
+		bool isValid() const { return fileSize != 0; }
+		std::string toString() const;
+	};
+
+	/// <summary>
+	/// Keeps the waveforms and decoded samples of recently opened music in a directory so reopening a chart
+	/// neither decodes the music nor rebuilds its waveforms. Entries are written in the layout they are read in
+	/// so a hit only maps the file. The least recently used entries are removed once the directory grows past the size limit.
+	/// </summary>
+	class AudioCache
+	{
+	public:
+		static constexpr uint32_t version = 1;
+		static constexpr uint64_t defaultSizeLimit = 2048ull * 1024 * 1024;
+
+		void setDirectory(const std::string& directory);
+		void setEnabled(bool enabled);
+		void setSamplesEnabled(bool enabled);
+		void setSizeLimit(uint64_t bytes);
+
+		inline const std::string& getDirectory() const { return directory; }
+		inline bool isEnabled() const { return enabled && !directory.empty(); }
+		inline bool isSamplesEnabled() const { return isEnabled() && samplesEnabled; }
+		inline uint64_t getSizeLimit() const { return sizeLimit; }
+
+		/// <summary>
+		/// Reads the whole file to hash its contents. Returns false if the file can't be read.
+		/// </summary>
+		static bool createKey(const std::string& filename, AudioCacheKey& key);
+
+		bool loadWaveforms(const AudioCacheKey& key, WaveformMipChain& left, WaveformMipChain& right);
+		bool storeWaveforms(const AudioCacheKey& key, const WaveformMipChain& left, const WaveformMipChain& right);
+
+		/// <summary>
+		/// Maps the cached samples into the sound instead of decoding the music
+		/// </summary>
+		bool loadSamples(const AudioCacheKey& key, const std::string& name, SoundBuffer& sound);
+		bool storeSamples(const AudioCacheKey& key, const SoundBuffer& sound);
+
+		uint64_t getSize() const;
+		void evict();
+		void clear();
+
+	private:
+		std::string directory;
+		bool enabled{ true };
+		bool samplesEnabled{ true };
+		uint64_t sizeLimit{ defaultSizeLimit };
+
+		std::string getEntryFilename(const AudioCacheKey& key, const char* extension) const;
+	};
+}
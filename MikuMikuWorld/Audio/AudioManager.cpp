@@ -129,14 +129,32 @@ namespace Audio
 		ma_engine_uninit(&engine);
 	}
 
-	mmw::Result AudioManager::loadMusic(const std::string& filename)
+	mmw::Result AudioManager::loadMusic(const std::string& filename, bool stream)
 	{
 		disposeMusic();
-		mmw::Result result = decodeAudioFile(filename, musicBuffer);
+
+		// The key is also needed by the waveforms, which are cached even when the music is streamed
+		if (musicCache.isEnabled())
+			AudioCache::createKey(filename, musicCacheKey);
+
+		mmw::Result result = mmw::Result::Ok();
+		if (stream)
+		{
+			result = musicStream.open(filename);
+		}
+		else if (!musicCache.loadSamples(musicCacheKey, IO::File::getFilenameWithoutExtension(filename), musicBuffer))
+		{
+			result = decodeAudioFile(filename, musicBuffer);
+			if (result.isOk())
+				musicCache.storeSamples(musicCacheKey, musicBuffer);
+		}
+
 		if (result.isOk())
 		{
+			ma_data_source* source = stream ? musicStream.getDataSource() : &musicBuffer.buffer;
+
 			// We want to always enable pitch here for miniaudio's resampler to work with playback speed
-			ma_sound_init_from_data_source(&engine, &musicBuffer.buffer, MA_SOUND_FLAG_NO_SPATIALIZATION, &musicGroup, &music);
+			ma_sound_init_from_data_source(&engine, source, MA_SOUND_FLAG_NO_SPATIALIZATION, &musicGroup, &music);
 
 			// Sync
 			setPlaybackSpeed(playbackSpeed, 0);
@@ -154,7 +172,7 @@ namespace Audio
 		float time = musicOffset - currentTime;
 
 		// Starting past the music end
-		if (time * musicBuffer.sampleRate * -1 > length)
+		if (time * getMusicSampleRate() * -1 > length)
 			return;
 
 		ma_sound_set_start_time_in_milliseconds(&music, std::max(0.0f, time * 1000));
@@ -170,7 +188,7 @@ namespace Audio
 	{
 		musicOffset = offset / 1000.0f;
 		float seekTime = currentTime - musicOffset;
-		ma_sound_seek_to_pcm_frame(&music, seekTime * musicBuffer.sampleRate);
+		ma_sound_seek_to_pcm_frame(&music, seekTime * getMusicSampleRate());
 
 		float start = getAudioEngineAbsoluteTime() + musicOffset - currentTime;
 		ma_sound_set_start_time_in_milliseconds(&music, std::max(0.0f, start * 1000));
@@ -194,17 +212,23 @@ namespace Audio
 
 	void AudioManager::disposeMusic()
 	{
-		if (musicBuffer.isValid())
+		musicCacheKey = {};
+		if (isMusicInitialized())
 		{
 			ma_sound_stop(&music);
 			ma_sound_uninit(&music);
-			musicBuffer.dispose();
+
+			if (musicBuffer.isValid())
+				musicBuffer.dispose();
+
+			// The sound no longer reads from the stream so its decode thread can stop
+			musicStream.close();
 		}
 	}
 
 	void AudioManager::seekMusic(float time)
 	{
-		ma_uint64 seekFrame = (time - musicOffset) * musicBuffer.sampleRate;
+		ma_uint64 seekFrame = (time - musicOffset) * getMusicSampleRate();
 		ma_sound_seek_to_pcm_frame(&music, seekFrame);
 
 		ma_uint64 length{};
@@ -264,7 +288,7 @@ namespace Audio
 
 	void AudioManager::setPlaybackSpeed(float speed, float currentTime)
 	{
-		const ma_uint32 speedAdjustedSampleRate = static_cast<ma_uint32>(speed * musicBuffer.sampleRate);
+		const ma_uint32 speedAdjustedSampleRate = static_cast<ma_uint32>(speed * getMusicSampleRate());
 		musicBuffer.effectiveSampleRate = speedAdjustedSampleRate;
 		music.engineNode.sampleRate = speedAdjustedSampleRate;
 
@@ -307,10 +331,18 @@ namespace Audio
 
 	void AudioManager::playSoundEffect(std::string_view name, float start, float end, float currentTime)
 	{
-		if (sounds[soundEffectsProfileIndex].pool.find(name) == sounds[soundEffectsProfileIndex].pool.end())
+		auto it = sounds[soundEffectsProfileIndex].pool.find(name);
+		if (it == sounds[soundEffectsProfileIndex].pool.end())
+			return;
+
+		playSoundEffect(it->second.get(), start, end, currentTime);
+	}
+
+	void AudioManager::playSoundEffect(SoundPool* soundPool, float start, float end, float currentTime)
+	{
+		if (soundPool == nullptr)
 			return;
 
-		SoundPool* soundPool = sounds[soundEffectsProfileIndex].pool.at(name).get();
 		const float absoluteStart = start + lastPlaybackTime;
 		const float absoluteEnd = end + lastPlaybackTime;
 		const int poolIndex = soundPool->getCurrentIndex();
@@ -418,7 +450,37 @@ namespace Audio
 
 	bool AudioManager::isMusicInitialized() const
 	{
-		return musicBuffer.isValid();
+		return musicBuffer.isValid() || musicStream.isOpen();
+	}
+
+	bool AudioManager::isMusicStreaming() const
+	{
+		return musicStream.isOpen();
+	}
+
+	bool AudioManager::isMusicMapped() const
+	{
+		return musicBuffer.isMapped();
+	}
+
+	const AudioCacheKey& AudioManager::getMusicCacheKey() const
+	{
+		return musicCacheKey;
+	}
+
+	ma_uint32 AudioManager::getMusicSampleRate() const
+	{
+		return musicStream.isOpen() ? musicStream.getSampleRate() : musicBuffer.sampleRate;
+	}
+
+	size_t AudioManager::getMusicMemory() const
+	{
+		return musicStream.isOpen() ? musicStream.getMemory() : musicBuffer.getMemory();
+	}
+
+	size_t AudioManager::getMusicPeakMemory() const
+	{
+		return musicStream.isOpen() ? musicStream.getPeakMemory() : musicBuffer.peakMemory;
 	}
 
 	bool AudioManager::isMusicAtEnd() const
@@ -439,6 +501,11 @@ namespace Audio
 		return soundEffectsProfileIndex;
 	}
 
+	SoundEffectProfile& AudioManager::getSoundEffectsProfile()
+	{
+		return sounds[soundEffectsProfileIndex];
+	}
+
 	void AudioManager::setSoundEffectsProfileIndex(size_t index)
 	{
 		soundEffectsProfileIndex = index;
@@ -1,5 +1,7 @@
 #pragma once
 #include "Sound.h"
+#include "MusicStream.h"
+#include "AudioCache.h"
 #include <map>
 #include <vector>
 #include <array>
@@ -28,8 +30,16 @@ namespace Audio
 
 		float lastPlaybackTime{};
 
+		// Identifies the loaded music in musicCache, invalid when caching is disabled
+		AudioCacheKey musicCacheKey{};
+
+		ma_uint32 getMusicSampleRate() const;
+
 	public:
+		// The music is either fully decoded to musicBuffer or streamed from musicStream
 		SoundBuffer musicBuffer;
+		MusicStream musicStream;
+		AudioCache musicCache;
 		std::vector<SoundInstance> debugSounds;
 
 		void initializeAudioEngine();
@@ -45,7 +55,7 @@ namespace Audio
 		float getAudioEngineAbsoluteTime() const;
 
 		void loadSoundEffects();
-		MikuMikuWorld::Result loadMusic(const std::string& filename);
+		MikuMikuWorld::Result loadMusic(const std::string& filename, bool stream = false);
 
 		void setMasterVolume(float volume);
 		float getMasterVolume() const;
@@ -68,15 +78,26 @@ namespace Audio
 		float getMusicOffset() const;
 		float getMusicEndTime() const;
 		bool isMusicInitialized() const;
+		bool isMusicStreaming() const;
+		bool isMusicMapped() const;
+		const AudioCacheKey& getMusicCacheKey() const;
+		size_t getMusicMemory() const;
+		size_t getMusicPeakMemory() const;
 		bool isMusicAtEnd() const;
 		void disposeMusic();
 
 		void playOneShotSound(std::string_view name);
 		void playSoundEffect(std::string_view name, float start, float end, float currentTime);
+
+		/// <summary>
+		/// Plays a sound effect from a pool of the current profile looked up in advance
+		/// </summary>
+		void playSoundEffect(SoundPool* soundPool, float start, float end, float currentTime);
 		void stopSoundEffects(bool all);
 		bool isSoundPlaying(std::string_view name) const;
 
 		size_t getSoundEffectsProfileIndex() const;
+		SoundEffectProfile& getSoundEffectsProfile();
 		void setSoundEffectsProfileIndex(size_t index);
 
 		float getLastPlaybackTime() const;
@@ -0,0 +1,346 @@
+#include "../IO.h"
+#include "../File.h"
+#include "MusicStream.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace Audio
+{
+	namespace mmw = MikuMikuWorld;
+
+	// Each block starts with its size so frees can be counted, padded to keep the block aligned
+	constexpr size_t allocationHeaderSize = alignof(std::max_align_t);
+
+	ma_allocation_callbacks AllocationCounter::getCallbacks()
+	{
+		ma_allocation_callbacks callbacks{};
+		callbacks.pUserData = this;
+		callbacks.onMalloc = onMalloc;
+		callbacks.onRealloc = onRealloc;
+		callbacks.onFree = onFree;
+		return callbacks;
+	}
+
+	void AllocationCounter::reset()
+	{
+		current = 0;
+		peak = 0;
+	}
+
+	void* AllocationCounter::onMalloc(size_t size, void* userData)
+	{
+		return onRealloc(nullptr, size, userData);
+	}
+
+	void* AllocationCounter::onRealloc(void* block, size_t size, void* userData)
+	{
+		AllocationCounter* counter = static_cast<AllocationCounter*>(userData);
+		uint8_t* header = block ? static_cast<uint8_t*>(block) - allocationHeaderSize : nullptr;
+		const size_t oldSize = header ? *reinterpret_cast<size_t*>(header) : 0;
+
+		uint8_t* newHeader = static_cast<uint8_t*>(std::realloc(header, size + allocationHeaderSize));
+		if (newHeader == nullptr)
+			return nullptr;
+
+		*reinterpret_cast<size_t*>(newHeader) = size;
+		const size_t current = counter->current += size - oldSize;
+
+		size_t peak = counter->peak;
+		while (current > peak && !counter->peak.compare_exchange_weak(peak, current));
+
+		return newHeader + allocationHeaderSize;
+	}
+
+	void AllocationCounter::onFree(void* block, void* userData)
+	{
+		if (block == nullptr)
+			return;
+
+		uint8_t* header = static_cast<uint8_t*>(block) - allocationHeaderSize;
+		static_cast<AllocationCounter*>(userData)->current -= *reinterpret_cast<size_t*>(header);
+		std::free(header);
+	}
+
+	MusicStream::MusicStream()
+	{
+		dataSource.stream = this;
+	}
+
+	MusicStream::~MusicStream()
+	{
+		close();
+	}
+
+	mmw::Result MusicStream::open(const std::string& filename)
+	{
+		close();
+		if (!IO::File::exists(filename))
+			return mmw::Result(mmw::ResultStatus::Error, "File not found");
+
+		std::string fileExtension = IO::File::getFileExtension(filename);
+		std::transform(fileExtension.begin(), fileExtension.end(), fileExtension.begin(), ::tolower);
+
+		if (!isSupportedFileFormat(fileExtension))
+			return mmw::Result(mmw::ResultStatus::Error, "Unsupported file format");
+
+		decoderMemory.reset();
+		ma_decoder_config decoderConfig = ma_decoder_config_init(ma_format_s16, 0, 0);
+		decoderConfig.allocationCallbacks = decoderMemory.getCallbacks();
+
+		// Without a seek table an mp3 seek decodes everything before the target
+		decoderConfig.seekPointCount = 1024;
+
+		if (ma_decoder_init_file_w(IO::mbToWideStr(filename).c_str(), &decoderConfig, &decoder) != MA_SUCCESS)
+			return mmw::Result(mmw::ResultStatus::Error, "Failed to open the music file for decoding");
+
+		if (ma_decoder_get_length_in_pcm_frames(&decoder, &frameCount) != MA_SUCCESS || frameCount == 0)
+		{
+			ma_decoder_uninit(&decoder);
+			return mmw::Result(mmw::ResultStatus::Error, "Failed to get the length of the music");
+		}
+
+		name = IO::File::getFilenameWithoutExtension(filename);
+		sampleRate = decoder.outputSampleRate;
+		channelCount = decoder.outputChannels;
+
+		ringCapacity = static_cast<size_t>(sampleRate) * bufferSeconds;
+		ring = std::make_unique<int16_t[]>(ringCapacity * channelCount);
+		chunk = std::make_unique<int16_t[]>(static_cast<size_t>(chunkFrames) * channelCount);
+		ringRead = ringSize = 0;
+		decodeFrame = 0;
+		skipFrames = 0;
+		seekPending = false;
+		cursor = 0;
+		underrunFrames = 0;
+
+		static ma_data_source_vtable vtable
+		{
+			onRead,
+			onSeek,
+			onGetDataFormat,
+			onGetCursor,
+			onGetLength,
+			nullptr,
+			0
+		};
+
+		ma_data_source_config dataSourceConfig = ma_data_source_config_init();
+		dataSourceConfig.vtable = &vtable;
+		ma_data_source_init(&dataSourceConfig, &dataSource.base);
+		streamOpen = true;
+
+		stopping = false;
+		decodeThread = std::thread(&MusicStream::decodeMain, this);
+		return mmw::Result::Ok();
+	}
+
+	void MusicStream::close()
+	{
+		if (decodeThread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				stopping = true;
+			}
+
+			decodeRequested.notify_all();
+			decodeThread.join();
+		}
+
+		if (!streamOpen)
+			return;
+
+		ma_data_source_uninit(&dataSource.base);
+		ma_decoder_uninit(&decoder);
+		streamOpen = false;
+
+		ring.reset();
+		chunk.reset();
+		ringCapacity = ringRead = ringSize = 0;
+		name.clear();
+		sampleRate = channelCount = 0;
+		frameCount = 0;
+	}
+
+	size_t MusicStream::getBufferedFrames() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return ringSize;
+	}
+
+	bool MusicStream::isDecodeFinished() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return !seekPending && decodeFrame >= frameCount;
+	}
+
+	size_t MusicStream::getMemory() const
+	{
+		const size_t buffersSize = (ringCapacity + (chunk ? chunkFrames : 0)) * channelCount * sizeof(int16_t);
+		return buffersSize + decoderMemory.getCurrent();
+	}
+
+	size_t MusicStream::getPeakMemory() const
+	{
+		// The buffers live as long as the stream is open so they always add up to the peak
+		const size_t buffersSize = (ringCapacity + (chunk ? chunkFrames : 0)) * channelCount * sizeof(int16_t);
+		return buffersSize + decoderMemory.getPeak();
+	}
+
+	bool MusicStream::canDecode() const
+	{
+		return decodeFrame < frameCount && ringCapacity - ringSize >= chunkFrames;
+	}
+
+	void MusicStream::decodeMain()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		while (true)
+		{
+			decodeRequested.wait(lock, [this] { return stopping || seekPending || canDecode(); });
+			if (stopping)
+				return;
+
+			if (seekPending)
+			{
+				const ma_uint64 target = seekFrame;
+				seekPending = false;
+
+				lock.unlock();
+				ma_decoder_seek_to_pcm_frame(&decoder, target);
+				lock.lock();
+
+				decodeFrame = target;
+				continue;
+			}
+
+			const uint64_t generation = seekGeneration;
+			lock.unlock();
+
+			ma_uint64 framesRead{};
+			const ma_result result = ma_decoder_read_pcm_frames(&decoder, chunk.get(), chunkFrames, &framesRead);
+
+			lock.lock();
+
+			// A seek while decoding makes the chunk useless
+			if (generation != seekGeneration)
+				continue;
+
+			const size_t skipped = static_cast<size_t>(std::min(framesRead, skipFrames));
+			skipFrames -= skipped;
+			writeRing(chunk.get() + skipped * channelCount, static_cast<size_t>(framesRead) - skipped);
+			decodeFrame += framesRead;
+
+			// Stop at the end of the file or on a decode error instead of retrying it
+			if (framesRead == 0 || result != MA_SUCCESS)
+				decodeFrame = frameCount;
+		}
+	}
+
+	void MusicStream::writeRing(const int16_t* samples, size_t frames)
+	{
+		size_t writePos = (ringRead + ringSize) % ringCapacity;
+		while (frames > 0)
+		{
+			const size_t count = std::min(frames, ringCapacity - writePos);
+			std::memcpy(ring.get() + writePos * channelCount, samples, count * channelCount * sizeof(int16_t));
+
+			samples += count * channelCount;
+			frames -= count;
+			ringSize += count;
+			writePos = (writePos + count) % ringCapacity;
+		}
+	}
+
+	size_t MusicStream::readRing(int16_t* samples, size_t frames)
+	{
+		frames = std::min(frames, ringSize);
+		for (size_t remaining = frames; remaining > 0;)
+		{
+			const size_t count = std::min(remaining, ringCapacity - ringRead);
+			std::memcpy(samples, ring.get() + ringRead * channelCount, count * channelCount * sizeof(int16_t));
+
+			samples += count * channelCount;
+			remaining -= count;
+			ringSize -= count;
+			ringRead = (ringRead + count) % ringCapacity;
+		}
+
+		return frames;
+	}
+
+	ma_result MusicStream::onRead(ma_data_source* source, void* framesOut, ma_uint64 frameCount, ma_uint64* framesRead)
+	{
+		MusicStream& stream = *static_cast<DataSource*>(source)->stream;
+		const ma_uint64 position = stream.cursor;
+		if (position >= stream.frameCount)
+		{
+			*framesRead = 0;
+			return MA_AT_END;
+		}
+
+		frameCount = std::min(frameCount, stream.frameCount - position);
+		int16_t* samples = static_cast<int16_t*>(framesOut);
+
+		size_t read{};
+		{
+			std::lock_guard<std::mutex> lock{ stream.mutex };
+			read = stream.readRing(samples, static_cast<size_t>(frameCount));
+			stream.skipFrames += frameCount - read;
+		}
+
+		stream.decodeRequested.notify_one();
+
+		// Play silence rather than stall the mixer when the decoder falls behind, keeping the music in sync with the chart
+		if (read < frameCount)
+		{
+			std::memset(samples + read * stream.channelCount, 0, (frameCount - read) * stream.channelCount * sizeof(int16_t));
+			stream.underrunFrames += frameCount - read;
+		}
+
+		stream.cursor = position + frameCount;
+		*framesRead = frameCount;
+		return MA_SUCCESS;
+	}
+
+	ma_result MusicStream::onSeek(ma_data_source* source, ma_uint64 frameIndex)
+	{
+		MusicStream& stream = *static_cast<DataSource*>(source)->stream;
+		{
+			std::lock_guard<std::mutex> lock{ stream.mutex };
+			stream.ringRead = stream.ringSize = 0;
+			stream.skipFrames = 0;
+			stream.seekFrame = std::min(frameIndex, stream.frameCount);
+			stream.seekPending = true;
+			stream.seekGeneration++;
+			stream.cursor = stream.seekFrame;
+		}
+
+		stream.decodeRequested.notify_one();
+		return MA_SUCCESS;
+	}
+
+	ma_result MusicStream::onGetDataFormat(ma_data_source* source, ma_format* format, ma_uint32* channels, ma_uint32* sampleRate, ma_channel* channelMap, size_t channelMapCap)
+	{
+		const MusicStream& stream = *static_cast<DataSource*>(source)->stream;
+		*format = ma_format_s16;
+		*channels = stream.channelCount;
+		*sampleRate = stream.sampleRate;
+		ma_channel_map_init_standard(ma_standard_channel_map_default, channelMap, channelMapCap, stream.channelCount);
+		return MA_SUCCESS;
+	}
+
+	ma_result MusicStream::onGetCursor(ma_data_source* source, ma_uint64* cursor)
+	{
+		*cursor = static_cast<DataSource*>(source)->stream->cursor;
+		return MA_SUCCESS;
+	}
+
+	ma_result MusicStream::onGetLength(ma_data_source* source, ma_uint64* length)
+	{
+		*length = static_cast<DataSource*>(source)->stream->frameCount;
+		return MA_SUCCESS;
+	}
+}
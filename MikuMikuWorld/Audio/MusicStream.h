@@ -0,0 +1,125 @@
+#pragma once
+#include "Sound.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Audio
+{
+	/// <summary>
+	/// Keeps track of the memory allocated through miniaudio's allocation callbacks
+	/// </summary>
+	class AllocationCounter
+	{
+	public:
+		ma_allocation_callbacks getCallbacks();
+		void reset();
+
+		inline size_t getCurrent() const { return current; }
+		inline size_t getPeak() const { return peak; }
+
+	private:
+		std::atomic<size_t> current{};
+		std::atomic<size_t> peak{};
+
+		static void* onMalloc(size_t size, void* userData);
+		static void* onRealloc(void* block, size_t size, void* userData);
+		static void onFree(void* block, void* userData);
+	};
+
+	/// <summary>
+	/// A data source for the music that decodes the file in chunks on a background thread into a ring buffer.
+	/// Playback can start as soon as the first chunk is decoded and only a couple of seconds of samples are kept in memory.
+	/// Seeking restarts decoding from the new position.
+	/// </summary>
+	class MusicStream
+	{
+	public:
+		static constexpr ma_uint32 chunkFrames = 4096;
+		static constexpr ma_uint32 bufferSeconds = 2;
+
+		MusicStream();
+		MusicStream(const MusicStream&) = delete;
+		MusicStream& operator=(const MusicStream&) = delete;
+		~MusicStream();
+
+		MikuMikuWorld::Result open(const std::string& filename);
+		void close();
+
+		inline bool isOpen() const { return streamOpen; }
+		inline ma_data_source* getDataSource() { return &dataSource; }
+
+		inline const std::string& getName() const { return name; }
+		inline ma_uint32 getSampleRate() const { return sampleRate; }
+		inline ma_uint32 getChannelCount() const { return channelCount; }
+		inline ma_uint64 getFrameCount() const { return frameCount; }
+
+		size_t getBufferedFrames() const;
+
+		// Whether the decoder reached the end of the file or stopped on an error, until the next seek
+		bool isDecodeFinished() const;
+
+		// Frames played as silence because the decoder fell behind
+		inline ma_uint64 getUnderrunFrames() const { return underrunFrames; }
+
+		/// <summary>
+		/// Memory used by the ring buffer, the decode chunk and the decoder's own allocations
+		/// </summary>
+		size_t getMemory() const;
+		size_t getPeakMemory() const;
+
+	private:
+		// Must be the first member of the data source so miniaudio can treat it as an ma_data_source
+		struct DataSource
+		{
+			ma_data_source_base base;
+			MusicStream* stream;
+		} dataSource{};
+
+		std::string name;
+		ma_decoder decoder{};
+		bool streamOpen{ false };
+		AllocationCounter decoderMemory;
+
+		ma_uint32 sampleRate{};
+		ma_uint32 channelCount{};
+		ma_uint64 frameCount{};
+
+		// Guards the ring and the decoder's position. The decoder itself is only used by the decode thread.
+		mutable std::mutex mutex;
+		std::condition_variable decodeRequested;
+		std::thread decodeThread;
+		bool stopping{ false };
+
+		std::unique_ptr<int16_t[]> ring;
+		std::unique_ptr<int16_t[]> chunk;
+		size_t ringCapacity{};
+		size_t ringRead{};
+		size_t ringSize{};
+
+		// The frame decoded next and a seek the decode thread hasn't done yet
+		ma_uint64 decodeFrame{};
+		ma_uint64 seekFrame{};
+		bool seekPending{ false };
+		uint64_t seekGeneration{};
+
+		// Frames played as silence that the decoder has yet to reach. They are dropped from the next chunks
+		// instead of being played late, so the music stays at the cursor.
+		ma_uint64 skipFrames{};
+
+		std::atomic<ma_uint64> cursor{};
+		std::atomic<ma_uint64> underrunFrames{};
+
+		void decodeMain();
+		bool canDecode() const;
+		void writeRing(const int16_t* samples, size_t frames);
+		size_t readRing(int16_t* samples, size_t frames);
+
+		static ma_result onRead(ma_data_source* source, void* framesOut, ma_uint64 frameCount, ma_uint64* framesRead);
+		static ma_result onSeek(ma_data_source* source, ma_uint64 frameIndex);
+		static ma_result onGetDataFormat(ma_data_source* source, ma_format* format, ma_uint32* channels, ma_uint32* sampleRate, ma_channel* channelMap, size_t channelMapCap);
+		static ma_result onGetCursor(ma_data_source* source, ma_uint64* cursor);
+		static ma_result onGetLength(ma_data_source* source, ma_uint64* length);
+	};
+}
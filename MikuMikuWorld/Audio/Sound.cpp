@@ -26,17 +26,37 @@ namespace Audio
 		ma_audio_buffer_init(&bufferConfig, &buffer);
 	}
 
+	void SoundBuffer::initialize(const std::string& name, ma_uint32 sampleRate, ma_uint32 channelCount, ma_uint64 frameCount, std::unique_ptr<IO::MappedFile> file, size_t sampleOffset)
+	{
+		this->name = name;
+		this->sampleFormat = ma_format_s16;
+		this->channelCount = channelCount;
+		this->frameCount = frameCount;
+		this->sampleRate = sampleRate;
+		this->effectiveSampleRate = sampleRate;
+		this->mappedFile = std::move(file);
+		this->mappedSamples = reinterpret_cast<const int16_t*>(mappedFile->getData() + sampleOffset);
+
+		// The audio buffer only reads from the samples so it can point into the read-only view
+		ma_audio_buffer_config bufferConfig = ma_audio_buffer_config_init(this->sampleFormat, channelCount, frameCount, this->mappedSamples, nullptr);
+		bufferConfig.sampleRate = sampleRate;
+		ma_audio_buffer_init(&bufferConfig, &buffer);
+	}
+
 	void SoundBuffer::dispose()
 	{
 		name.clear();
 		ma_audio_buffer_uninit(&buffer);
 		samples.reset();
+		mappedSamples = nullptr;
+		mappedFile.reset();
 
 		sampleFormat	= ma_format_unknown;
 		sampleRate		= 0;
 		channelCount	= 0;
 		frameCount		= 0;
 		effectiveSampleRate = 0;
+		peakMemory		= 0;
 	}
 
 	mmw::Result decodeAudioFile(std::string filename, SoundBuffer& sound)
@@ -66,6 +86,7 @@ namespace Audio
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode mp3");
 
 			sound.initialize(nameWithoutExtension, mp3Config.sampleRate, mp3Config.channels, frameCount, samples);
+			sound.peakMemory = bytes.size() + sound.getMemory();
 			return mmw::Result::Ok();
 		}
 		else if (fileExtension == ".wav")
@@ -78,6 +99,7 @@ namespace Audio
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode wav");
 
 			sound.initialize(nameWithoutExtension, sampleRate, channels, frameCount, samples);
+			sound.peakMemory = bytes.size() + sound.getMemory();
 			return mmw::Result::Ok();
 		}
 		else if (fileExtension == ".flac")
@@ -90,6 +112,7 @@ namespace Audio
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode flac");
 
 			sound.initialize(nameWithoutExtension, sampleRate, channels, frameCount, samples);
+			sound.peakMemory = bytes.size() + sound.getMemory();
 			return mmw::Result::Ok();
 		}
 		else if (fileExtension == ".ogg")
@@ -102,6 +125,7 @@ namespace Audio
 				return mmw::Result(mmw::ResultStatus::Error, "Failed to decode ogg vorbis");
 
 			sound.initialize(nameWithoutExtension, sampleRate, channels, frameCount, samples);
+			sound.peakMemory = bytes.size() + sound.getMemory();
 			return mmw::Result::Ok();
 		}
 
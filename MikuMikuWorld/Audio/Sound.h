@@ -11,6 +11,7 @@
 #include <stb_vorbis.c>
 #include <miniaudio.h>
 #include "../Utilities.h"
+#include "../File.h"
 
 namespace Audio
 {
@@ -42,6 +43,11 @@ namespace Audio
 	{
 		std::string name;
 		std::unique_ptr<int16_t[]> samples;
+
+		// Samples read straight from a cache file instead of being decoded
+		std::unique_ptr<IO::MappedFile> mappedFile;
+		const int16_t* mappedSamples{ nullptr };
+
 		ma_format sampleFormat{ ma_format_unknown };
 		ma_uint32 sampleRate{};
 		ma_uint32 channelCount{};
@@ -50,10 +56,23 @@ namespace Audio
 
 		ma_uint32 effectiveSampleRate;
 
+		// The compressed file and the decoded samples, which are both held while decoding
+		size_t peakMemory{};
+
 		void initialize(const std::string &name, ma_uint32 sampleRate, ma_uint32 channelCount, ma_uint64 frameCount, int16_t* samples);
+
+		/// <summary>
+		/// Plays the samples found at sampleOffset bytes into a mapped file, keeping the file mapped until disposed
+		/// </summary>
+		void initialize(const std::string& name, ma_uint32 sampleRate, ma_uint32 channelCount, ma_uint64 frameCount, std::unique_ptr<IO::MappedFile> file, size_t sampleOffset);
 		void dispose();
 
-		bool isValid() const { return samples.get() != nullptr && sampleRate > 0 && frameCount > 0; }
+		const int16_t* getSamples() const { return mappedSamples ? mappedSamples : samples.get(); }
+		bool isMapped() const { return mappedSamples != nullptr; }
+		bool isValid() const { return getSamples() != nullptr && sampleRate > 0 && frameCount > 0; }
+
+		// Mapped samples live in the OS file cache and aren't counted
+		size_t getMemory() const { return samples ? static_cast<size_t>(frameCount) * channelCount * sizeof(int16_t) : 0; }
 	};
 
 	constexpr std::array<std::string_view, 4> supportedFileFormats =
@@ -84,14 +103,14 @@ namespace Audio
 		
 		uint64_t getCurrentFrame()
 		{
-			uint64_t frame{};
+			ma_uint64 frame{};
 			ma_sound_get_cursor_in_pcm_frames(&source, &frame);
 			return frame;
 		}
 
 		uint64_t getLengthInFrames()
 		{
-			uint64_t frame{};
+			ma_uint64 frame{};
 			ma_sound_get_length_in_pcm_frames(&source, &frame);
 			return frame;
 		}
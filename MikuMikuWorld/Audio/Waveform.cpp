@@ -0,0 +1,354 @@
+#include "Waveform.h"
+#include "../IO.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace Audio
+{
+	// Same as abs on an int16_t stored back to an int16_t, -32768 stays -32768
+	static inline __m128i absInt16(__m128i samples)
+	{
+		return _mm_max_epi16(samples, _mm_sub_epi16(_mm_setzero_si128(), samples));
+	}
+
+	// Halves 32-bit sums rounding toward zero like averageTwoInt16Samples
+	static inline __m128i halveTowardZero(__m128i sums)
+	{
+		return _mm_srai_epi32(_mm_add_epi32(sums, _mm_srli_epi32(sums, 31)), 1);
+	}
+
+	// Averages the adjacent pairs of 16 samples into 8
+	static inline __m128i averagePairs(__m128i samplesLo, __m128i samplesHi)
+	{
+		const __m128i ones = _mm_set1_epi16(1);
+		const __m128i sumsLo = halveTowardZero(_mm_madd_epi16(samplesLo, ones));
+		const __m128i sumsHi = halveTowardZero(_mm_madd_epi16(samplesHi, ones));
+
+		// The averages of two int16_t always fit in an int16_t, so the pack never saturates
+		return _mm_packs_epi32(sumsLo, sumsHi);
+	}
+
+	// Swaps the middle two samples of every four, turning L R L R into L L R R
+	static inline __m128i swapMiddleSamples(__m128i samples)
+	{
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(samples, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+	}
+
+	// Base mip samples [begin, end) of both channels from interleaved stereo frames
+	static void averageStereoFrames(const int16_t* frames, int16_t* left, int16_t* right, size_t begin, size_t end)
+	{
+		size_t index = begin;
+		for (; index + 4 <= end; index += 4)
+		{
+			// Four base samples per channel come from eight frames
+			const __m128i* source = reinterpret_cast<const __m128i*>(frames + index * 4);
+			const __m128i framesLo = swapMiddleSamples(absInt16(_mm_loadu_si128(source)));
+			const __m128i framesHi = swapMiddleSamples(absInt16(_mm_loadu_si128(source + 1)));
+
+			// L0 R0 L1 R1 L2 R2 L3 R3 -> L0 L1 L2 L3 R0 R1 R2 R3
+			const __m128i averages = _mm_shuffle_epi32(swapMiddleSamples(averagePairs(framesLo, framesHi)), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(left + index), averages);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(right + index), _mm_unpackhi_epi64(averages, averages));
+		}
+
+		for (; index < end; index++)
+		{
+			const int16_t* frame = frames + index * 4;
+			left[index] = averageTwoInt16Samples(abs(frame[0]), abs(frame[2]));
+			right[index] = averageTwoInt16Samples(abs(frame[1]), abs(frame[3]));
+		}
+	}
+
+	static void averageMipSamples(const int16_t* parentSamples, int16_t* samples, size_t count)
+	{
+		size_t index = 0;
+		for (; index + 8 <= count; index += 8)
+		{
+			const __m128i* source = reinterpret_cast<const __m128i*>(parentSamples + index * 2);
+			const __m128i averages = averagePairs(_mm_loadu_si128(source), _mm_loadu_si128(source + 1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(samples + index), averages);
+		}
+
+		for (; index < count; index++)
+			samples[index] = averageTwoInt16Samples(parentSamples[index * 2], parentSamples[index * 2 + 1]);
+	}
+
+	static inline int16_t horizontalMin(__m128i samples)
+	{
+		samples = _mm_min_epi16(samples, _mm_shuffle_epi32(samples, _MM_SHUFFLE(1, 0, 3, 2)));
+		samples = _mm_min_epi16(samples, _mm_shuffle_epi32(samples, _MM_SHUFFLE(2, 3, 0, 1)));
+		samples = _mm_min_epi16(samples, _mm_shufflelo_epi16(samples, _MM_SHUFFLE(2, 3, 0, 1)));
+		return static_cast<int16_t>(_mm_cvtsi128_si32(samples));
+	}
+
+	static inline int16_t horizontalMax(__m128i samples)
+	{
+		samples = _mm_max_epi16(samples, _mm_shuffle_epi32(samples, _MM_SHUFFLE(1, 0, 3, 2)));
+		samples = _mm_max_epi16(samples, _mm_shuffle_epi32(samples, _MM_SHUFFLE(2, 3, 0, 1)));
+		samples = _mm_max_epi16(samples, _mm_shufflelo_epi16(samples, _MM_SHUFFLE(2, 3, 0, 1)));
+		return static_cast<int16_t>(_mm_cvtsi128_si32(samples));
+	}
+
+	// Adds the four 32-bit sums of squares from _mm_madd_epi16 into two 64-bit lanes.
+	// Two squares of -32768 add up to 2^31, which only fits when the sums are read as unsigned.
+	static inline __m128i addSquareSums(__m128i totals, __m128i squareSums)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		totals = _mm_add_epi64(totals, _mm_unpacklo_epi32(squareSums, zero));
+		return _mm_add_epi64(totals, _mm_unpackhi_epi32(squareSums, zero));
+	}
+
+	// A full block of summaryBlockSamples, which is two registers of samples
+	static WaveformSummary summarizeBlock(const int16_t* samples)
+	{
+		static_assert(WaveformMip::summaryBlockSamples == 16);
+		const __m128i samplesLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+		const __m128i samplesHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples) + 1);
+
+		__m128i sumSquares = addSquareSums(_mm_setzero_si128(), _mm_madd_epi16(samplesLo, samplesLo));
+		sumSquares = addSquareSums(sumSquares, _mm_madd_epi16(samplesHi, samplesHi));
+		sumSquares = _mm_add_epi64(sumSquares, _mm_unpackhi_epi64(sumSquares, sumSquares));
+
+		uint64_t sumSquaresValue{};
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(&sumSquaresValue), sumSquares);
+
+		WaveformSummary summary{};
+		summary.min = horizontalMin(_mm_min_epi16(samplesLo, samplesHi));
+		summary.max = horizontalMax(_mm_max_epi16(samplesLo, samplesHi));
+		summary.meanSquare = static_cast<uint32_t>(sumSquaresValue / WaveformMip::summaryBlockSamples);
+		return summary;
+	}
+
+	void WaveformMip::generateSummaries()
+	{
+		const size_t fullBlockCount = absoluteSamples.size() / summaryBlockSamples;
+		const size_t blockCount = (absoluteSamples.size() + summaryBlockSamples - 1) / summaryBlockSamples;
+		summaries.resize(blockCount);
+
+		for (size_t block = 0; block < fullBlockCount; block++)
+			summaries[block] = summarizeBlock(absoluteSamples.data() + block * summaryBlockSamples);
+
+		// Mip sizes are powers of two so only a mip smaller than a block has a partial one
+		for (size_t block = fullBlockCount; block < blockCount; block++)
+		{
+			const size_t begin = block * summaryBlockSamples;
+			const size_t end = std::min(begin + summaryBlockSamples, absoluteSamples.size());
+
+			WaveformSummary& summary = summaries[block];
+			summary.min = std::numeric_limits<int16_t>::max();
+			summary.max = std::numeric_limits<int16_t>::min();
+
+			uint64_t sumSquares{};
+			for (size_t index = begin; index < end; index++)
+			{
+				const int16_t sample = absoluteSamples[index];
+				summary.min = std::min(summary.min, sample);
+				summary.max = std::max(summary.max, sample);
+				sumSquares += static_cast<uint64_t>(static_cast<int32_t>(sample) * sample);
+			}
+
+			summary.meanSquare = static_cast<uint32_t>(sumSquares / (end - begin));
+		}
+	}
+
+	WaveformPeak WaveformMip::peakInTimeRange(double startTime, double endTime) const
+	{
+		if (absoluteSamples.empty() || summaries.empty() || endTime <= 0)
+			return {};
+
+		const size_t first = static_cast<size_t>(std::max(startTime, 0.0) * samplesPerSecond);
+		if (first >= absoluteSamples.size())
+			return {};
+
+		// A range shorter than a sample still gets the sample it starts in
+		const size_t last = std::clamp(static_cast<size_t>(std::ceil(endTime * samplesPerSecond)), first + 1, absoluteSamples.size());
+
+		int16_t minSample = std::numeric_limits<int16_t>::max();
+		int16_t maxSample = std::numeric_limits<int16_t>::min();
+		uint64_t sumSquares{};
+
+		auto addSamples = [&](size_t begin, size_t end)
+		{
+			for (size_t index = begin; index < end; index++)
+			{
+				const int16_t sample = absoluteSamples[index];
+				minSample = std::min(minSample, sample);
+				maxSample = std::max(maxSample, sample);
+				sumSquares += static_cast<uint64_t>(static_cast<int32_t>(sample) * sample);
+			}
+		};
+
+		// Only blocks fully inside the range are used, the partial ones at the edges are read sample by sample
+		const size_t firstBlock = (first + summaryBlockSamples - 1) / summaryBlockSamples;
+		const size_t lastBlock = last / summaryBlockSamples;
+		if (firstBlock >= lastBlock)
+		{
+			addSamples(first, last);
+		}
+		else
+		{
+			addSamples(first, firstBlock * summaryBlockSamples);
+			for (size_t block = firstBlock; block < lastBlock; block++)
+			{
+				const WaveformSummary& summary = summaries[block];
+				minSample = std::min(minSample, summary.min);
+				maxSample = std::max(maxSample, summary.max);
+				sumSquares += static_cast<uint64_t>(summary.meanSquare) * summaryBlockSamples;
+			}
+			addSamples(lastBlock * summaryBlockSamples, last);
+		}
+
+		const float meanSquare = static_cast<float>(static_cast<double>(sumSquares) / (last - first));
+		return
+		{
+			minSample / static_cast<float>(int16_t_max),
+			maxSample / static_cast<float>(int16_t_max),
+			std::sqrt(meanSquare) / static_cast<float>(int16_t_max)
+		};
+	}
+
+	void WaveformMipChain::generateSummaries()
+	{
+		for (auto& mip : mips)
+		{
+			if (mip.powerOfTwoSampleCount == 0)
+				break;
+
+			mip.generateSummaries();
+		}
+	}
+
+	void WaveformMipChain::generateHigherMips()
+	{
+		for (size_t i = 1; i < maxMipLevels; i++)
+		{
+			if (mips[i - 1].powerOfTwoSampleCount == 0)
+				break;
+
+			const size_t samplesToFill = std::min(mips[i].absoluteSamples.size(), mips[i - 1].absoluteSamples.size() / 2);
+			averageMipSamples(mips[i - 1].absoluteSamples.data(), mips[i].absoluteSamples.data(), samplesToFill);
+		}
+	}
+
+	void WaveformMipChain::averageChannelFrames(const int16_t* frames, uint32_t channelCount, uint32_t channelIndex, int16_t* samples, size_t count)
+	{
+		channelIndex = std::min(channelIndex, channelCount - 1);
+		for (size_t index = 0; index < count; index++)
+		{
+			const int16_t* pair = frames + index * 2 * channelCount + channelIndex;
+			samples[index] = averageTwoInt16Samples(abs(pair[0]), abs(pair[channelCount]));
+		}
+	}
+
+	void WaveformMipChain::generateMipChains(const SoundBuffer& audioData, WaveformMipChain& left, WaveformMipChain& right)
+	{
+		if (audioData.channelCount != 2)
+		{
+			left.generateMipChainsFromSampleBuffer(audioData, 0);
+			right.generateMipChainsFromSampleBuffer(audioData, 1);
+			return;
+		}
+
+		left.doneProcessing = right.doneProcessing = false;
+		const bool leftPrepared = left.prepareMips(audioData);
+		const bool rightPrepared = right.prepareMips(audioData);
+		if (!leftPrepared || !rightPrepared)
+		{
+			left.doneProcessing = right.doneProcessing = true;
+			return;
+		}
+
+		const int16_t* frames = audioData.getSamples();
+		int16_t* leftSamples = left.mips[0].absoluteSamples.data();
+		int16_t* rightSamples = right.mips[0].absoluteSamples.data();
+
+		// The base mip is split in two halves and each channel's higher mips only depend on its own base mip
+		const size_t samplesToFill = left.getSamplesToFill(0, audioData.frameCount);
+		std::thread worker(averageStereoFrames, frames, leftSamples, rightSamples, samplesToFill / 2, samplesToFill);
+		averageStereoFrames(frames, leftSamples, rightSamples, 0, samplesToFill / 2);
+		worker.join();
+
+		worker = std::thread([&right]()
+		{
+			right.generateHigherMips();
+			right.generateSummaries();
+		});
+
+		left.generateHigherMips();
+		left.generateSummaries();
+		worker.join();
+
+		left.doneProcessing = right.doneProcessing = true;
+	}
+
+	MikuMikuWorld::Result WaveformMipChain::generateMipChainsFromFile(const std::string& filename, WaveformMipChain& left, WaveformMipChain& right)
+	{
+		left.clear();
+		right.clear();
+		left.durationInSeconds = right.durationInSeconds = 0;
+
+		ma_decoder decoder{};
+		ma_decoder_config decoderConfig = ma_decoder_config_init(ma_format_s16, 0, 0);
+		if (ma_decoder_init_file_w(IO::mbToWideStr(filename).c_str(), &decoderConfig, &decoder) != MA_SUCCESS)
+			return MikuMikuWorld::Result(MikuMikuWorld::ResultStatus::Error, "Failed to open the music file for decoding");
+
+		ma_uint64 frameCount{};
+		ma_decoder_get_length_in_pcm_frames(&decoder, &frameCount);
+		const ma_uint32 channelCount = decoder.outputChannels;
+
+		left.doneProcessing = right.doneProcessing = false;
+		if (!left.prepareMips(frameCount, decoder.outputSampleRate) || !right.prepareMips(frameCount, decoder.outputSampleRate))
+		{
+			ma_decoder_uninit(&decoder);
+			left.doneProcessing = right.doneProcessing = true;
+			return MikuMikuWorld::Result(MikuMikuWorld::ResultStatus::Error, "Failed to get the length of the music");
+		}
+
+		// An even number of frames so every chunk fills whole base mip samples
+		constexpr size_t chunkFrames = 1 << 16;
+		std::vector<int16_t> chunk(chunkFrames * channelCount);
+		int16_t* leftSamples = left.mips[0].absoluteSamples.data();
+		int16_t* rightSamples = right.mips[0].absoluteSamples.data();
+		const size_t samplesToFill = left.getSamplesToFill(0, frameCount);
+
+		for (size_t filled = 0; filled < samplesToFill;)
+		{
+			ma_uint64 framesRead{};
+			ma_decoder_read_pcm_frames(&decoder, chunk.data(), chunkFrames, &framesRead);
+
+			// A frame without a pair at the end of the file is left out, the same as for a decoded buffer
+			const size_t count = std::min(static_cast<size_t>(framesRead) / 2, samplesToFill - filled);
+			if (channelCount == 2)
+			{
+				averageStereoFrames(chunk.data(), leftSamples + filled, rightSamples + filled, 0, count);
+			}
+			else
+			{
+				averageChannelFrames(chunk.data(), channelCount, 0, leftSamples + filled, count);
+				averageChannelFrames(chunk.data(), channelCount, 1, rightSamples + filled, count);
+			}
+
+			filled += count;
+			if (framesRead < chunkFrames)
+				break;
+		}
+
+		ma_decoder_uninit(&decoder);
+
+		std::thread worker([&right]()
+		{
+			right.generateHigherMips();
+			right.generateSummaries();
+		});
+
+		left.generateHigherMips();
+		left.generateSummaries();
+		worker.join();
+
+		left.doneProcessing = right.doneProcessing = true;
+		return MikuMikuWorld::Result::Ok();
+	}
+}
@@ -19,13 +19,34 @@ namespace Audio
 
 	constexpr int16_t int16_t_max = std::numeric_limits<int16_t>::max();
 
+	// The smallest, largest and mean square sample of a block of samples
+	struct WaveformSummary
+	{
+		int16_t min{};
+		int16_t max{};
+
+		// Mean rather than sum so a whole block fits in 32 bits
+		uint32_t meanSquare{};
+	};
+
+	// Normalized amplitudes of a time range
+	struct WaveformPeak
+	{
+		float min{};
+		float max{};
+		float rms{};
+	};
+
 	class WaveformMip
 	{
 	public:
+		static constexpr size_t summaryBlockSamples{ 16 };
+
 		size_t powerOfTwoSampleCount{};
 		double secondsPerSample{};
 		double samplesPerSecond{};
 		std::vector<int16_t> absoluteSamples;
+		std::vector<WaveformSummary> summaries;
 
 		double getDuration() const
 		{
@@ -80,12 +101,24 @@ namespace Audio
 			return sampleAverage / static_cast<float>(int16_t_max);
 		}
 
+		/// <summary>
+		/// Min, max and RMS of the samples in a time range from the whole blocks it covers and the samples at its edges.
+		/// The cost depends on the number of samples in the range divided by summaryBlockSamples.
+		/// </summary>
+		WaveformPeak peakInTimeRange(double startTime, double endTime) const;
+
+		/// <summary>
+		/// Summarizes every block of summaryBlockSamples once absoluteSamples is filled
+		/// </summary>
+		void generateSummaries();
+
 		void clear()
 		{
 			powerOfTwoSampleCount = {};
 			secondsPerSample = {};
 			samplesPerSecond = {};
 			absoluteSamples.clear();
+			summaries.clear();
 		}
 	};
 
@@ -93,10 +126,75 @@ namespace Audio
 	{
 	private:
 		bool doneProcessing{ true };
+
+		// Sets up the size of every mip, returning false and clearing the chain when there are no samples
+		bool prepareMips(const SoundBuffer& audioData)
+		{
+			return prepareMips(audioData.isValid() ? audioData.frameCount : 0, audioData.sampleRate);
+		}
+
+		bool prepareMips(ma_uint64 frameCount, ma_uint32 sampleRate)
+		{
+			if (frameCount == 0 || sampleRate == 0)
+			{
+				durationInSeconds = 0;
+				clear();
+				return false;
+			}
+
+			durationInSeconds = static_cast<float>(frameCount) / static_cast<float>(sampleRate);
+			
+			if (mips[0].powerOfTwoSampleCount != 0)
+				for (auto& mip : mips) mip.clear();
+
+			WaveformMip& baseMip = mips[0];
+			baseMip.powerOfTwoSampleCount = MikuMikuWorld::roundUpToPowerOfTwo(frameCount);
+			baseMip.secondsPerSample = 1.0 / static_cast<double>(sampleRate);
+			baseMip.samplesPerSecond = sampleRate;
+
+			// The original full samples are already included in the sample buffer
+			// So we'll skip processing the full data mip to reduce memory usage
+			baseMip.powerOfTwoSampleCount /= 2;
+			baseMip.secondsPerSample *= 2.0;
+			baseMip.samplesPerSecond /= 2.0;
+			baseMip.absoluteSamples.resize(baseMip.powerOfTwoSampleCount);
+
+			for (size_t i = 1; i < maxMipLevels; i++)
+			{
+				const WaveformMip& parentMip = mips[i - 1];
+				if (parentMip.powerOfTwoSampleCount <= minMipSamples)
+					break;
+
+				WaveformMip& newMip = mips[i];
+				newMip.powerOfTwoSampleCount = parentMip.powerOfTwoSampleCount / 2;
+				newMip.secondsPerSample = parentMip.secondsPerSample * 2.0;
+				newMip.samplesPerSecond = parentMip.samplesPerSecond / 2.0;
+				newMip.absoluteSamples.resize(newMip.powerOfTwoSampleCount);
+			}
+
+			return true;
+		}
+
+		// Number of samples of a mip made from its parent, the rest of the mip stays silent
+		size_t getSamplesToFill(size_t mipIndex, ma_uint64 frameCount) const
+		{
+			const size_t parentSampleCount = mipIndex == 0 ? static_cast<size_t>(frameCount) : mips[mipIndex - 1].absoluteSamples.size();
+			return std::min(mips[mipIndex].absoluteSamples.size(), parentSampleCount / 2);
+		}
+
+		void generateHigherMips();
+		void generateSummaries();
+
+		/// <summary>
+		/// Base mip samples of one channel from count pairs of interleaved frames.
+		/// A channel past the last one reads the last one, so mono shows the same on both sides.
+		/// </summary>
+		static void averageChannelFrames(const int16_t* frames, uint32_t channelCount, uint32_t channelIndex, int16_t* samples, size_t count);
 		
 	public:
 		static constexpr size_t maxMipLevels{ 24 };
 		static constexpr size_t minMipSamples{ 256 };
+		static constexpr double peakSamplesPerPixel{ 64.0 };
 
 		WaveformMip mips[maxMipLevels]{};
 		double durationInSeconds{};
@@ -148,69 +246,44 @@ namespace Audio
 			return mip.averageNormalizedSampleInTimeRange(seconds, seconds + secondsPerPixel);
 		}
 
+		/// <summary>
+		/// The mip to query peaks from, fine enough that a pixel spans about peakSamplesPerPixel samples.
+		/// Averaging hides peaks, so a mip matching the pixel size would show the same as getAmplitudeAt.
+		/// </summary>
+		const WaveformMip& findPeakMip(double secondsPerPixel) const
+		{
+			return findClosestMip(secondsPerPixel / peakSamplesPerPixel);
+		}
+
+		WaveformPeak getPeakAt(const WaveformMip& mip, double seconds, double secondsPerPixel) const
+		{
+			return mip.peakInTimeRange(seconds, seconds + secondsPerPixel);
+		}
+
+		/// <summary>
+		/// Builds the chain of one channel one sample at a time. Used for buffers that aren't stereo.
+		/// </summary>
 		void generateMipChainsFromSampleBuffer(const SoundBuffer& audioData, uint32_t channelIndex)
 		{
 			doneProcessing = false;
-			if (!audioData.isValid())
+			if (!prepareMips(audioData))
 			{
-				durationInSeconds = 0;
-				clear();
-
 				doneProcessing = true;
 				return;
 			}
 
-			durationInSeconds = static_cast<float>(audioData.frameCount) / static_cast<float>(audioData.sampleRate);
-			
-			if (mips[0].powerOfTwoSampleCount != 0)
-				for (auto& mip : mips) mip.clear();
-
 			WaveformMip& baseMip = mips[0];
-			baseMip.powerOfTwoSampleCount = MikuMikuWorld::roundUpToPowerOfTwo(audioData.frameCount);
-			baseMip.secondsPerSample = 1.0 / static_cast<double>(audioData.sampleRate);
-			baseMip.samplesPerSecond = audioData.sampleRate;
-
-			baseMip.powerOfTwoSampleCount /= 2;
-			baseMip.secondsPerSample *= 2.0;
-			baseMip.samplesPerSecond /= 2.0;
-			baseMip.absoluteSamples.resize(baseMip.powerOfTwoSampleCount);
-			const size_t samplesToFill = std::min(baseMip.absoluteSamples.size(), static_cast<size_t>(audioData.frameCount / 2));
-
-			// The original full samples are already included in the sample buffer
-			// So we'll skip processing the full data mip to reduce memory usage
-			for (size_t frameIndex = 0; frameIndex < samplesToFill; frameIndex++)
-			{
-				int16_t sampleA = audioData.samples[((frameIndex * 2 + 0) * audioData.channelCount) + channelIndex];
-				int16_t sampleB = audioData.samples[((frameIndex * 2 + 1) * audioData.channelCount) + channelIndex];
-				baseMip.absoluteSamples[frameIndex] = averageTwoInt16Samples(abs(sampleA), abs(sampleB));
-			}
-
-			// First loop to calculate sample counts
-			for (size_t i = 1; i < maxMipLevels; i++)
-			{
-				const WaveformMip& parentMip = mips[i - 1];
-				if (parentMip.powerOfTwoSampleCount <= minMipSamples)
-					break;
+			averageChannelFrames(audioData.getSamples(), audioData.channelCount, channelIndex, baseMip.absoluteSamples.data(), getSamplesToFill(0, audioData.frameCount));
 
-				WaveformMip& newMip = mips[i];
-				newMip.powerOfTwoSampleCount = parentMip.powerOfTwoSampleCount / 2;
-				newMip.secondsPerSample = parentMip.secondsPerSample * 2.0;
-				newMip.samplesPerSecond = parentMip.samplesPerSecond / 2.0;
-			}
-
-			// Second loop to generate the acutal mip sample buffers
 			for (size_t i = 1; i < maxMipLevels; i++)
 			{
 				const WaveformMip& parentMip = mips[i - 1];
 				if (parentMip.powerOfTwoSampleCount == 0)
 					break;
 
-				const size_t parentSampleCount = parentMip.absoluteSamples.size();
 				const int16_t* parentSamples = parentMip.absoluteSamples.data();
-
 				WaveformMip& currentMip = mips[i];
-				currentMip.absoluteSamples.resize(currentMip.powerOfTwoSampleCount);
-				const size_t samplesToFill = std::min(currentMip.absoluteSamples.size(), parentSampleCount / 2);
+				const size_t samplesToFill = getSamplesToFill(i, audioData.frameCount);
 
 				for (size_t index = 0; index < samplesToFill; index++)
 				{
@@ -219,7 +292,21 @@ namespace Audio
 				}
 			}
 
+			generateSummaries();
 			doneProcessing = true;
 		}
+
+		/// <summary>
+		/// Builds the chains of both channels, de-interleaving a stereo buffer in a single SIMD pass
+		/// and reducing the higher mips of the two channels in parallel. The mips are the same as
+		/// generateMipChainsFromSampleBuffer's, which is used for other channel counts.
+		/// </summary>
+		static void generateMipChains(const SoundBuffer& audioData, WaveformMipChain& left, WaveformMipChain& right);
+
+		/// <summary>
+		/// Builds the chains of both channels while decoding the file a chunk at a time, for music that is streamed
+		/// instead of decoded. Only one chunk of samples is held besides the mips themselves.
+		/// </summary>
+		static MikuMikuWorld::Result generateMipChainsFromFile(const std::string& filename, WaveformMipChain& left, WaveformMipChain& right);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "Benchmark.h"
+#include "IO.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <json.hpp>
+#include <new>
+#include <thread>
+
+namespace Debug
+{
+	BenchmarkState::BenchmarkState(int64_t iterations) :
+		iterations{ iterations }, remaining{ iterations }
+	{
+
+	}
+
+	bool BenchmarkState::keepRunning()
+	{
+		if (!started)
+		{
+			started = true;
+			start = clock_type::now();
+		}
+
+		if (remaining-- > 0 && error.empty())
+			return true;
+
+		if (!paused)
+			elapsed += clock_type::now() - start;
+
+		return false;
+	}
+
+	void BenchmarkState::pauseTiming()
+	{
+		if (paused)
+			return;
+
+		elapsed += clock_type::now() - start;
+		paused = true;
+	}
+
+	void BenchmarkState::resumeTiming()
+	{
+		if (!paused)
+			return;
+
+		start = clock_type::now();
+		paused = false;
+	}
+
+	void BenchmarkState::skipWithError(const std::string& message)
+	{
+		error = message;
+		remaining = 0;
+	}
+
+	void BenchmarkRunner::add(const std::string& name, BenchmarkFunction function)
+	{
+		benchmarks.push_back({ name, std::move(function) });
+	}
+
+	std::vector<BenchmarkResult> BenchmarkRunner::run(const std::string& filter, double minTime) const
+	{
+		constexpr int64_t maxIterations = 1000000000;
+
+		std::vector<BenchmarkResult> results;
+		for (const Benchmark& benchmark : benchmarks)
+		{
+			if (benchmark.name.find(filter) == std::string::npos)
+				continue;
+
+			int64_t iterations = 1;
+			while (true)
+			{
+				BenchmarkState state(iterations);
+				try
+				{
+					benchmark.function(state);
+				}
+				catch (const std::exception& ex)
+				{
+					state.skipWithError(ex.what());
+				}
+
+				const double seconds = state.getElapsedSeconds();
+				if (!state.getError().empty())
+				{
+					results.push_back({ benchmark.name, 0, 0, 0, state.getError() });
+					break;
+				}
+
+				if (seconds >= minTime || iterations >= maxIterations)
+				{
+					results.push_back({
+						benchmark.name,
+						iterations,
+						seconds * 1e9 / iterations,
+						seconds > 0 ? state.getItemsProcessed() / seconds : 0.0,
+						std::string(),
+						state.getCounters()
+					});
+					break;
+				}
+
+				// Same growth as Google Benchmark: aim slightly past the minimum time, but grow at most tenfold per attempt
+				const double multiplier = seconds > 0 ? std::min(10.0, std::max(1.4 * minTime / seconds, 2.0)) : 10.0;
+				iterations = std::min(maxIterations, static_cast<int64_t>(iterations * multiplier));
+			}
+		}
+
+		return results;
+	}
+
+	std::string benchmarkResultsToJson(const std::vector<BenchmarkResult>& results)
+	{
+		char date[32]{};
+		std::time_t now = std::time(nullptr);
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+		nlohmann::json benchmarks = nlohmann::json::array();
+		for (const BenchmarkResult& result : results)
+		{
+			nlohmann::json benchmark = {
+				{ "name", result.name },
+				{ "run_name", result.name },
+				{ "run_type", "iteration" },
+				{ "iterations", result.iterations },
+				{ "real_time", result.realTime },
+				{ "time_unit", "ns" }
+			};
+
+			if (result.itemsPerSecond > 0)
+				benchmark["items_per_second"] = result.itemsPerSecond;
+
+			for (const auto& [name, value] : result.counters)
+				benchmark[name] = value;
+
+			if (!result.error.empty())
+			{
+				benchmark["error_occurred"] = true;
+				benchmark["error_message"] = result.error;
+			}
+
+			benchmarks.push_back(std::move(benchmark));
+		}
+
+		nlohmann::json output = {
+			{ "context", {
+				{ "date", date },
+				{ "executable", "MikuMikuWorld" },
+				{ "num_cpus", std::thread::hardware_concurrency() },
+#ifdef _DEBUG
+				{ "library_build_type", "debug" }
+#else
+				{ "library_build_type", "release" }
+#endif
+			} },
+			{ "benchmarks", benchmarks }
+		};
+
+		return output.dump(2);
+	}
+
+	int runBenchmarks(const BenchmarkRunner& runner, const std::vector<std::string>& arguments)
+	{
+		constexpr std::string_view filterOption = "--benchmark_filter=";
+		constexpr std::string_view minTimeOption = "--benchmark_min_time=";
+		constexpr std::string_view outputOption = "--benchmark_out=";
+
+		std::string filter;
+		std::string output = "benchmark_results.json";
+		double minTime = 0.5;
+		for (const std::string& argument : arguments)
+		{
+			if (IO::startsWith(argument, filterOption))
+				filter = argument.substr(filterOption.size());
+			else if (IO::startsWith(argument, minTimeOption))
+				minTime = std::atof(argument.c_str() + minTimeOption.size());
+			else if (IO::startsWith(argument, outputOption))
+				output = argument.substr(outputOption.size());
+			else
+			{
+				std::cerr << "Unknown benchmark option: " << argument << '\n';
+				return 2;
+			}
+		}
+
+		const std::vector<BenchmarkResult> results = runner.run(filter, minTime);
+
+		bool failed = false;
+		for (const BenchmarkResult& result : results)
+		{
+			if (!result.error.empty())
+			{
+				std::cout << IO::formatString("%-36s ERROR: %s\n", result.name.c_str(), result.error.c_str());
+				failed = true;
+				continue;
+			}
+
+			std::cout << IO::formatString("%-36s %14.0f ns %10lld iterations %14.0f items/s",
+				result.name.c_str(), result.realTime, static_cast<long long>(result.iterations), result.itemsPerSecond);
+
+			for (const auto& [name, value] : result.counters)
+				std::cout << IO::formatString(" %s=%g", name.c_str(), value);
+
+			std::cout << '\n';
+		}
+
+		std::ofstream outputFile(std::filesystem::u8path(output));
+		outputFile << benchmarkResultsToJson(results);
+		outputFile.close();
+
+		if (!outputFile)
+		{
+			std::cerr << "Failed to write " << output << '\n';
+			return 2;
+		}
+
+		return failed ? 1 : 0;
+	}
+
+#ifdef MMW_COUNT_ALLOCATIONS
+	static thread_local uint64_t threadAllocationCount = 0;
+
+	uint64_t getThreadAllocationCount()
+	{
+		return threadAllocationCount;
+	}
+}
+
+// Every other form of new and delete forwards to these, except the over-aligned ones
+void* operator new(size_t size)
+{
+	Debug::threadAllocationCount++;
+	if (void* block = std::malloc(size ? size : 1))
+		return block;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+	std::free(block);
+}
+#else
+	uint64_t getThreadAllocationCount()
+	{
+		return 0;
+	}
+}
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Debug
+{
+	/// <summary>
+	/// Times the loop of a single benchmark run, in the style of Google Benchmark:
+	/// while (state.keepRunning()) { ... }
+	/// </summary>
+	class BenchmarkState
+	{
+	private:
+		using clock_type = std::chrono::steady_clock;
+
+		clock_type::time_point start;
+		clock_type::duration elapsed{};
+		int64_t iterations;
+		int64_t remaining;
+		int64_t itemsProcessed{};
+		bool started{ false };
+		bool paused{ false };
+		std::string error;
+		std::map<std::string, double> counters;
+
+	public:
+		BenchmarkState(int64_t iterations);
+
+		bool keepRunning();
+
+		/// <summary>
+		/// Excludes the work done until resumeTiming is called from the measurement, e.g. per iteration setup
+		/// </summary>
+		void pauseTiming();
+		void resumeTiming();
+
+		/// <summary>
+		/// Stops the benchmark and reports the message instead of its timings
+		/// </summary>
+		void skipWithError(const std::string& message);
+
+		inline void setItemsProcessed(int64_t items) { itemsProcessed = items; }
+
+		/// <summary>
+		/// Reports a value measured by the benchmark alongside its timings, like Google Benchmark's user counters
+		/// </summary>
+		inline void setCounter(const std::string& name, double value) { counters[name] = value; }
+		inline const std::map<std::string, double>& getCounters() const { return counters; }
+		inline int64_t getIterations() const { return iterations; }
+		inline int64_t getItemsProcessed() const { return itemsProcessed; }
+		inline double getElapsedSeconds() const { return std::chrono::duration<double>(elapsed).count(); }
+		inline const std::string& getError() const { return error; }
+	};
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		int64_t iterations;
+
+		// Nanoseconds per iteration
+		double realTime;
+		double itemsPerSecond;
+		std::string error;
+		std::map<std::string, double> counters;
+	};
+
+	using BenchmarkFunction = std::function<void(BenchmarkState&)>;
+
+	class BenchmarkRunner
+	{
+	private:
+		struct Benchmark
+		{
+			std::string name;
+			BenchmarkFunction function;
+		};
+
+		std::vector<Benchmark> benchmarks;
+
+	public:
+		void add(const std::string& name, BenchmarkFunction function);
+
+		/// <summary>
+		/// Runs every benchmark whose name contains the filter, raising the iteration count until a run lasts at least minTime seconds
+		/// </summary>
+		std::vector<BenchmarkResult> run(const std::string& filter, double minTime) const;
+	};
+
+	/// <summary>
+	/// Serializes the results in Google Benchmark's JSON output format so runs of different commits can be compared with its tools
+	/// </summary>
+	std::string benchmarkResultsToJson(const std::vector<BenchmarkResult>& results);
+
+	/// <summary>
+	/// Runs the benchmarks, prints a summary and writes the JSON results. Returns 1 if any benchmark failed and 2 on bad options.
+	/// Accepts --benchmark_filter=[substring], --benchmark_min_time=[seconds] and --benchmark_out=[filename].
+	/// </summary>
+	int runBenchmarks(const BenchmarkRunner& runner, const std::vector<std::string>& arguments);
+
+#ifdef MMW_COUNT_ALLOCATIONS
+	constexpr bool allocationCountingEnabled = true;
+#else
+	constexpr bool allocationCountingEnabled = false;
+#endif
+
+	/// <summary>
+	/// Returns the number of heap allocations made by the calling thread so far, so a benchmark can check its loop doesn't allocate.
+	/// Allocations are only counted in builds with MMW_COUNT_ALLOCATIONS defined, which replaces the global operator new; otherwise this is always 0.
+	/// MikuMikuWorldBench is always built with it.
+	/// </summary>
+	uint64_t getThreadAllocationCount();
+}
@@ -1,13 +1,41 @@
 #include "BinaryReader.h"
 #include "IO.h"
+#include <cstring>
+#include <stdexcept>
 
 namespace IO
 {
 	BinaryReader::BinaryReader(const std::string& filename)
 	{
-		stream = NULL;
-		std::wstring wFilename = mbToWideStr(filename);
-		stream = _wfopen(wFilename.c_str(), L"rb");
+#ifdef _WIN32
+		FILE* stream = _wfopen(mbToWideStr(filename).c_str(), L"rb");
+#else
+		FILE* stream = fopen(filename.c_str(), "rb");
+#endif
+		if (!stream)
+			return;
+
+		fseek(stream, 0, SEEK_END);
+		long size = ftell(stream);
+		fseek(stream, 0, SEEK_SET);
+
+		if (size > 0)
+		{
+			buffer.resize(size);
+			valid = fread(buffer.data(), sizeof(uint8_t), buffer.size(), stream) == buffer.size();
+		}
+		else
+		{
+			valid = size == 0;
+		}
+
+		fclose(stream);
+	}
+
+	BinaryReader::BinaryReader(std::vector<uint8_t> data) :
+		buffer{ std::move(data) }, valid{ true }
+	{
+
 	}
 
 	BinaryReader::~BinaryReader()
@@ -17,77 +45,104 @@ namespace IO
 
 	bool BinaryReader::isStreamValid()
 	{
-		return stream;
+		return valid;
 	}
 
 	void BinaryReader::close()
 	{
-		if (stream)
-			fclose(stream);
-
-		stream = NULL;
+		buffer.clear();
+		buffer.shrink_to_fit();
+		position = 0;
+		valid = false;
 	}
 
 	size_t BinaryReader::getFileSize()
 	{
-		size_t pos = ftell(stream);
-		fseek(stream, 0, SEEK_END);
-
-		size_t size = ftell(stream);
-		fseek(stream, pos, SEEK_SET);
-
-		return size;
+		return buffer.size();
 	}
 
 	size_t BinaryReader::getStreamPosition()
 	{
-		return ftell(stream);
+		return position;
+	}
+
+	void BinaryReader::seek(size_t pos)
+	{
+		position = pos;
 	}
 
-	uint16_t IO::BinaryReader::readInt16()
+	const uint8_t* BinaryReader::advance(size_t size)
 	{
-		uint16_t data = 0;
-		if (stream)
-			fread(&data, sizeof(uint16_t), 1, stream);
+		if (position > buffer.size() || buffer.size() - position < size)
+			throw std::out_of_range("Unexpected end of file");
+
+		const uint8_t* data = buffer.data() + position;
+		position += size;
 		return data;
 	}
 
+	uint8_t BinaryReader::readByte()
+	{
+		return *advance(sizeof(uint8_t));
+	}
+
+	uint16_t BinaryReader::readInt16()
+	{
+		const uint8_t* data = advance(sizeof(uint16_t));
+		return data[0] | (data[1] << 8);
+	}
+
 	uint32_t BinaryReader::readInt32()
 	{
-		uint32_t data = 0;
-		if (stream)
-			fread(&data, sizeof(uint32_t), 1, stream);
-		return data;
+		const uint8_t* data = advance(sizeof(uint32_t));
+		return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
 	}
 
 	float BinaryReader::readSingle()
 	{
-		float data = 0;
-		if (stream)
-			fread(&data, sizeof(float), 1, stream);
+		uint32_t bits = readInt32();
+		float data;
+		memcpy(&data, &bits, sizeof(float));
 		return data;
 	}
 
 	std::string BinaryReader::readString()
 	{
-		char c = 'a';
-		std::string data = "";
-		if (stream)
-		{
-			while (c && !feof(stream))
-			{
-				fread(&c, sizeof(uint8_t), 1, stream);
-				if (c)
-					data += c;
-			}
+		// Strings are null terminated, or end with the file
+		if (position >= buffer.size())
+			return {};
+
+		const uint8_t* begin = buffer.data() + position;
+		const uint8_t* end = static_cast<const uint8_t*>(memchr(begin, 0, buffer.size() - position));
+		size_t length = end ? end - begin : buffer.size() - position;
 
+		position += end ? length + 1 : length;
+		return std::string(reinterpret_cast<const char*>(begin), length);
+	}
+
+	std::vector<uint8_t> BinaryReader::readBytes(size_t size)
+	{
+		const uint8_t* data = advance(size);
+		return std::vector<uint8_t>(data, data + size);
+	}
+
+	uint32_t BinaryReader::readVarUInt32()
+	{
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			uint8_t byte = readByte();
+			value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return value;
 		}
-		return data;
+
+		throw std::runtime_error("Malformed variable length integer");
 	}
 
-	void BinaryReader::seek(size_t pos)
+	int32_t BinaryReader::readVarInt32()
 	{
-		if (stream)
-			fseek(stream, pos, SEEK_SET);
+		uint32_t value = readVarUInt32();
+		return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
 	}
-}
\ No newline at end of file
+}
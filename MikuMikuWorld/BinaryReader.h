@@ -1,16 +1,27 @@
 #pragma once
 #include <stdio.h>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace IO
 {
+	/// <summary>
+	/// Reads the whole file into memory with a single call and decodes little-endian values from it.
+	/// Reading past the end of the data throws instead of returning garbage.
+	/// </summary>
 	class BinaryReader
 	{
 	private:
-		FILE* stream;
+		std::vector<uint8_t> buffer;
+		size_t position{};
+		bool valid{ false };
+
+		const uint8_t* advance(size_t size);
 
 	public:
 		BinaryReader(const std::string& filename);
+		BinaryReader(std::vector<uint8_t> data);
 		~BinaryReader();
 
 		bool isStreamValid();
@@ -20,9 +31,21 @@ namespace IO
 		size_t getStreamPosition();
 		void seek(size_t pos);
 
+		uint8_t readByte();
 		uint16_t readInt16();
 		uint32_t readInt32();
 		float readSingle();
 		std::string readString();
+		std::vector<uint8_t> readBytes(size_t size);
+
+		/// <summary>
+		/// Reads an unsigned LEB128 value of up to 5 bytes
+		/// </summary>
+		uint32_t readVarUInt32();
+
+		/// <summary>
+		/// Reads a zigzag encoded LEB128 value so small negative numbers stay short
+		/// </summary>
+		int32_t readVarInt32();
 	};
-}
\ No newline at end of file
+}
@@ -1,13 +1,22 @@
 #include "BinaryWriter.h"
 #include "IO.h"
+#include <algorithm>
+#include <cstring>
 
 namespace IO
 {
+	BinaryWriter::BinaryWriter() : stream{ NULL }
+	{
+
+	}
+
 	BinaryWriter::BinaryWriter(const std::string& filename)
 	{
-		stream = NULL;
-		std::wstring wFilename = mbToWideStr(filename);
-		stream = _wfopen(wFilename.c_str(), L"wb");
+#ifdef _WIN32
+		stream = _wfopen(mbToWideStr(filename).c_str(), L"wb");
+#else
+		stream = fopen(filename.c_str(), "wb");
+#endif
 	}
 
 	BinaryWriter::~BinaryWriter()
@@ -23,82 +32,122 @@ namespace IO
 	void BinaryWriter::close()
 	{
 		if (stream)
+		{
+			flush();
 			fclose(stream);
+		}
+
+		stream = NULL;
 	}
 
 	void BinaryWriter::flush()
 	{
-		if (stream)
-			fflush(stream);
+		if (!stream || !dirty)
+			return;
+
+		// The buffer always holds the whole file, so rewrite it from the start
+		fseek(stream, 0, SEEK_SET);
+		fwrite(buffer.data(), sizeof(uint8_t), buffer.size(), stream);
+		fflush(stream);
+		dirty = false;
 	}
 
 	size_t BinaryWriter::getFileSize()
 	{
-		size_t pos = ftell(stream);
-		fseek(stream, 0, SEEK_END);
-
-		size_t size = ftell(stream);
-		fseek(stream, pos, SEEK_SET);
-
-		return size;
+		return buffer.size();
 	}
 
 	size_t BinaryWriter::getStreamPosition()
 	{
-		return ftell(stream);
+		return position;
+	}
+
+	const std::vector<uint8_t>& BinaryWriter::getBuffer() const
+	{
+		return buffer;
 	}
 
 	void BinaryWriter::seek(size_t pos)
 	{
-		if (stream)
-			fseek(stream, pos, SEEK_SET);
+		position = pos;
+	}
+
+	uint8_t* BinaryWriter::advance(size_t size)
+	{
+		// Seeking past the end fills the gap with zeros like a file does
+		if (buffer.size() < position + size)
+		{
+			if (buffer.capacity() < position + size)
+				buffer.reserve(std::max(position + size, buffer.capacity() * 2));
+
+			buffer.resize(position + size);
+		}
+
+		uint8_t* data = buffer.data() + position;
+		position += size;
+		dirty = true;
+		return data;
+	}
+
+	void BinaryWriter::writeByte(uint8_t data)
+	{
+		*advance(sizeof(uint8_t)) = data;
 	}
 
 	void BinaryWriter::writeInt16(uint16_t data)
 	{
-		if (stream)
-			fwrite(&data, sizeof(uint16_t), 1, stream);
+		uint8_t* bytes = advance(sizeof(uint16_t));
+		bytes[0] = data & 0xff;
+		bytes[1] = data >> 8;
 	}
 
 	void BinaryWriter::writeInt32(uint32_t data)
 	{
-		if (stream)
-			fwrite(&data, sizeof(uint32_t), 1, stream);
+		uint8_t* bytes = advance(sizeof(uint32_t));
+		bytes[0] = data & 0xff;
+		bytes[1] = (data >> 8) & 0xff;
+		bytes[2] = (data >> 16) & 0xff;
+		bytes[3] = data >> 24;
 	}
 
 	void BinaryWriter::writeSingle(float data)
 	{
-		if (stream)
-			fwrite(&data, sizeof(float), 1, stream);
+		uint32_t bits;
+		memcpy(&bits, &data, sizeof(float));
+		writeInt32(bits);
 	}
 
 	void BinaryWriter::writeNull(size_t length)
 	{
-		static const uint8_t zero[1024] = { 0 };
-		if (!stream)
-			return;
-		while (sizeof(zero) < length)
-		{
-			fwrite(zero, sizeof(uint8_t), sizeof(zero), stream);
-			length -= sizeof(zero);
-		}
-		fwrite(zero, sizeof(uint8_t), length, stream);
+		memset(advance(length), 0, length);
 	}
 
 	void BinaryWriter::writeString(std::string data)
 	{
-		if (stream)
+		// Null terminated
+		uint8_t* bytes = advance(data.size() + 1);
+		memcpy(bytes, data.c_str(), data.size() + 1);
+	}
+
+	void BinaryWriter::writeBytes(const std::vector<uint8_t>& data)
+	{
+		if (!data.empty())
+			memcpy(advance(data.size()), data.data(), data.size());
+	}
+
+	void BinaryWriter::writeVarUInt32(uint32_t data)
+	{
+		while (data >= 0x80)
 		{
-			size_t length = data.size();
-			if (length)
-			{
-				fwrite(data.c_str(), sizeof(char), length, stream);
-				writeNull(1);
-			}
-			else
-			{
-				writeNull(1);
-			}
+			writeByte(static_cast<uint8_t>(data) | 0x80);
+			data >>= 7;
 		}
+
+		writeByte(static_cast<uint8_t>(data));
+	}
+
+	void BinaryWriter::writeVarInt32(int32_t data)
+	{
+		writeVarUInt32((static_cast<uint32_t>(data) << 1) ^ static_cast<uint32_t>(data >> 31));
 	}
-}
\ No newline at end of file
+}
@@ -1,16 +1,32 @@
 #pragma once
 #include <stdio.h>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace IO
 {
+	/// <summary>
+	/// Encodes little-endian values into a growable buffer that is written to the file with a single call on flush or close
+	/// </summary>
 	class BinaryWriter
 	{
 	private:
 		FILE* stream;
+		std::vector<uint8_t> buffer;
+		size_t position{};
+		bool dirty{ false };
+
+		uint8_t* advance(size_t size);
 
 	public:
+		/// <summary>
+		/// Creates a writer that only encodes into memory, retrieved with getBuffer
+		/// </summary>
+		BinaryWriter();
 		BinaryWriter(const std::string& filename);
+		BinaryWriter(const BinaryWriter&) = delete;
+		BinaryWriter& operator=(const BinaryWriter&) = delete;
 		~BinaryWriter();
 
 		bool isStreamValid();
@@ -19,12 +35,17 @@ namespace IO
 
 		size_t getFileSize();
 		size_t getStreamPosition();
+		const std::vector<uint8_t>& getBuffer() const;
 
 		void seek(size_t pos);
+		void writeByte(uint8_t data);
 		void writeInt16(uint16_t data);
 		void writeInt32(uint32_t data);
 		void writeSingle(float data);
 		void writeString(std::string data);
 		void writeNull(size_t length);
+		void writeBytes(const std::vector<uint8_t>& data);
+		void writeVarUInt32(uint32_t data);
+		void writeVarInt32(int32_t data);
 	};
-}
\ No newline at end of file
+}
@@ -250,22 +250,20 @@ namespace MikuMikuWorld::Effect
 
 		if (emitter.visible)
 		{
-			for (auto& particle : emitter.particles)
+			const ParticleStore& particles = emitter.particles;
+			for (int i = 0; i < emitter.getAliveCount(); i++)
 			{
-				if (!particle.alive)
-					continue;
-
-				float normalizedTime = particle.time / particle.duration;
+				float normalizedTime = particles.time[i] / particles.duration[i];
 				float blend = ref.blend == BlendMode::Additive ? 1.f : 0.f;
 
-				int frame = ref.textureSplitX * ref.textureSplitY * ref.startFrame.evaluate(particle.time, particle.spriteSheetLerpRatio);
-				frame += ref.textureSplitX * ref.textureSplitY * ref.frameOverTime.evaluate(normalizedTime, particle.spriteSheetLerpRatio);
+				int frame = ref.textureSplitX * ref.textureSplitY * ref.startFrame.evaluate(particles.time[i], particles.spriteSheetLerpRatio[i]);
+				frame += ref.textureSplitX * ref.textureSplitY * ref.frameOverTime.evaluate(normalizedTime, particles.spriteSheetLerpRatio[i]);
 
-				Color color = particle.startColor * ref.colorOverLifetime.evaluate(normalizedTime, particle.colorLerpRatio);
+				Color color = particles.startColor[i] * ref.colorOverLifetime.evaluate(normalizedTime, particles.colorLerpRatio[i]);
 
 				// TODO: We should provide a second Z-Index according to the notes order.
 				// Maybe use the note's tick?
-				renderer->drawQuadWithBlend(particle.matrix, *effectsTex, ref.textureSplitX, ref.textureSplitY, frame, color, ref.order, blend, flipUVs);
+				renderer->drawQuadWithBlend(particles.matrix[i], *effectsTex, ref.textureSplitX, ref.textureSplitY, frame, color, ref.order, blend, flipUVs);
 			}
 		}
 
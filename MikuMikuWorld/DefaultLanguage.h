@@ -63,6 +63,8 @@ namespace MikuMikuWorld
 		{"error_open_file_msg2", ""},
 		{"error_load_score_file", "An error occurred while reading the score file"},
 		{"error_save_score_file", "An error occurred while saving the score file"},
+		{"error_recover_unsaved_changes", "An error occurred while recovering the unsaved changes"},
+		{"recover_unsaved_changes", "Unsaved changes from a previous session were found. Do you want to recover them?"},
 		{"error_load_music_file", "Cannot open music file"},
 		{"cancel", "Cancel"},
 		{"general", "General"},
@@ -73,6 +75,11 @@ namespace MikuMikuWorld
 		{"auto_save_enable", "Auto Save Enabled"},
 		{"auto_save_interval", "Auto Save Interval (min)"},
 		{"auto_save_count", "Maximum Auto Save Entries"},
+		{"auto_saving", "Auto saving..."},
+		{"auto_save_complete", "Auto saved"},
+		{"auto_save_failed", "Auto save failed"},
+		{"history", "History"},
+		{"history_memory_budget", "Undo History Memory Limit (MB)"},
 		{"theme", "Theme"},
 		{"base_theme", "Base Theme"},
 		{"theme_light", "Light"},
@@ -104,6 +111,11 @@ namespace MikuMikuWorld
 		{"lanes_opacity", "Lanes Opacity"},
 		{"video", "Video"},
 		{"notes_se", "Notes SE"},
+		{"stream_music", "Stream Music"},
+		{"cache_music", "Cache Music"},
+		{"cache_decoded_music", "Cache Decoded Music"},
+		{"music_cache_size", "Music Cache Size (MB)"},
+		{"clear_music_cache", "Clear Music Cache"},
 		{"visuals", "Visuals"},
 		{"preview_draw_toolbar", "Draw Preview Toolbar"},
 		{"notes_speed", "Notes Speed"},
@@ -111,6 +123,7 @@ namespace MikuMikuWorld
 		{"flicks_animation", "Animate Flick Arrow"},
 		{"holds_animation", "Animate Long Note"},
 		{"simultaneous_lines", "Multi-Tap Line"},
+		{"bake_effects", "Pre-simulate Effects"},
 		{"notes_effect", "Notes Effect"},
 		{"effects_normal", "Normal"},
 		{"effects_reduced", "Reduced"},
@@ -0,0 +1,599 @@
+#include "EditJournal.h"
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
+#include "NativeScoreSerializer.h"
+#include "Constants.h"
+#include "File.h"
+#include "IO.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace MikuMikuWorld
+{
+	using namespace IO;
+
+	static constexpr int JOURNAL_VERSION = 2;
+	static constexpr size_t journalRecordHeaderSize = sizeof(uint32_t) * 2;
+
+	// Replaying a journal of this size takes about as long as loading a large score
+	static constexpr size_t maxJournalSize = 1024 * 1024;
+
+	struct JournalHeader
+	{
+		std::string baseFilename;
+		uint32_t baseSize{};
+		uint32_t baseChecksum{};
+		uint32_t baseNoteCount{};
+	};
+
+	static std::string getSnapshotFilename(const std::string& filename, int slot)
+	{
+		return filename + ".journal." + std::to_string(slot) + MMWS_EXTENSION;
+	}
+
+	static void removeFile(const std::string& filename)
+	{
+		std::error_code error;
+		std::filesystem::remove(mbToWideStr(filename), error);
+	}
+
+	static void removeSnapshotsExcept(const std::string& filename, const std::string& keptFilename)
+	{
+		for (int slot = 0; slot < 2; ++slot)
+		{
+			if (getSnapshotFilename(filename, slot) != keptFilename)
+				removeFile(getSnapshotFilename(filename, slot));
+		}
+	}
+
+	static bool readFileChecksum(const std::string& filename, uint32_t& size, uint32_t& checksum)
+	{
+		if (!File::exists(filename))
+			return false;
+
+		File file(filename, FileMode::ReadBinary);
+		std::vector<uint8_t> bytes = file.readAllBytes();
+		file.close();
+
+		size = static_cast<uint32_t>(bytes.size());
+		checksum = crc32(0L, bytes.data(), static_cast<uInt>(bytes.size()));
+		return true;
+	}
+
+	static JournalHeader readJournalHeader(BinaryReader& reader)
+	{
+		if (reader.readString() != "MMWJ")
+			throw std::runtime_error("Not a MMWJ file.");
+
+		// Journals before version 2 numbered the base's notes in a different order
+		if (static_cast<int>(reader.readInt32()) != JOURNAL_VERSION)
+			throw std::runtime_error("Unsupported journal version.");
+
+		JournalHeader header;
+		header.baseFilename = reader.readString();
+		header.baseSize = reader.readInt32();
+		header.baseChecksum = reader.readInt32();
+		header.baseNoteCount = reader.readVarUInt32();
+		return header;
+	}
+
+	template <typename ResolveID>
+	static HoldStep readStep(BinaryReader& reader, ResolveID&& resolveID)
+	{
+		HoldStep step{};
+		step.ID = resolveID(reader.readVarUInt32());
+		step.type = (HoldStepType)reader.readByte();
+		step.ease = (EaseType)reader.readByte();
+		return step;
+	}
+
+	template <typename ResolveID>
+	static ScorePatch readPatch(BinaryReader& reader, ResolveID&& resolveID)
+	{
+		ScorePatch patch;
+		uint32_t noteCount = reader.readVarUInt32();
+		for (uint32_t i = 0; i < noteCount; ++i)
+		{
+			int id = resolveID(reader.readVarUInt32());
+			if (!reader.readByte())
+			{
+				patch.notes[id] = std::nullopt;
+				continue;
+			}
+
+			Note note((NoteType)reader.readByte());
+			note.ID = id;
+			note.tick = reader.readVarInt32();
+			note.lane = reader.readVarInt32();
+			note.width = reader.readVarInt32();
+			note.flick = (FlickType)reader.readByte();
+
+			unsigned int flags = reader.readByte();
+			note.critical = (bool)(flags & 1);
+			note.friction = (bool)(flags & 2);
+
+			uint32_t parent = reader.readVarUInt32();
+			note.parentID = parent ? resolveID(parent - 1) : -1;
+			patch.notes[id] = note;
+		}
+
+		uint32_t holdCount = reader.readVarUInt32();
+		for (uint32_t i = 0; i < holdCount; ++i)
+		{
+			int id = resolveID(reader.readVarUInt32());
+			if (!reader.readByte())
+			{
+				patch.holdNotes[id] = std::nullopt;
+				continue;
+			}
+
+			HoldNote hold;
+			hold.startType = (HoldNoteType)reader.readByte();
+			hold.endType = (HoldNoteType)reader.readByte();
+			hold.start = readStep(reader, resolveID);
+
+			uint32_t stepCount = reader.readVarUInt32();
+			hold.steps.reserve(stepCount);
+			for (uint32_t s = 0; s < stepCount; ++s)
+				hold.steps.push_back(readStep(reader, resolveID));
+
+			hold.end = resolveID(reader.readVarUInt32());
+			patch.holdNotes[id] = std::move(hold);
+		}
+
+		if (reader.readByte())
+		{
+			ScoreEvents events;
+			uint32_t tempoCount = reader.readVarUInt32();
+			for (uint32_t i = 0; i < tempoCount; ++i)
+			{
+				int tick = reader.readVarInt32();
+				float bpm = reader.readSingle();
+				events.tempoChanges.push_back({ tick, bpm });
+			}
+
+			uint32_t timeSignatureCount = reader.readVarUInt32();
+			for (uint32_t i = 0; i < timeSignatureCount; ++i)
+			{
+				int measure = reader.readVarInt32();
+				int numerator = reader.readVarInt32();
+				int denominator = reader.readVarInt32();
+				events.timeSignatures[measure] = { measure, numerator, denominator };
+			}
+
+			uint32_t hiSpeedCount = reader.readVarUInt32();
+			for (uint32_t i = 0; i < hiSpeedCount; ++i)
+			{
+				int tick = reader.readVarInt32();
+				float speed = reader.readSingle();
+				events.hiSpeedChanges.push_back({ tick, speed });
+			}
+
+			uint32_t skillCount = reader.readVarUInt32();
+			for (uint32_t i = 0; i < skillCount; ++i)
+				events.skills.push_back({ nextSkillID++, reader.readVarInt32() });
+
+			events.fever.startTick = reader.readVarInt32();
+			events.fever.endTick = reader.readVarInt32();
+			patch.events = std::move(events);
+		}
+
+		return patch;
+	}
+
+	EditJournal::~EditJournal()
+	{
+		close();
+	}
+
+	int EditJournal::toJournalID(int id)
+	{
+		auto it = journalIDs.find(id);
+		if (it != journalIDs.end())
+			return it->second;
+
+		journalIDs[id] = nextJournalID;
+		return nextJournalID++;
+	}
+
+	int EditJournal::getNextSnapshotSlot(const std::string& filename) const
+	{
+		// Alternate between two snapshots so the base of the current journal is never overwritten
+		if (isOpen() && scoreFilename == filename)
+			return baseFilename == getSnapshotFilename(filename, 0) ? 1 : 0;
+
+		return File::exists(getSnapshotFilename(filename, 0)) ? 1 : 0;
+	}
+
+	bool EditJournal::begin(const JournalBase& base, const std::string& filename)
+	{
+		const std::vector<int>& order = base.noteOrder;
+		BinaryWriter header;
+		header.writeString("MMWJ");
+		header.writeInt32(JOURNAL_VERSION);
+		header.writeString(base.filename);
+		header.writeInt32(base.size);
+		header.writeInt32(base.checksum);
+		header.writeVarUInt32(order.size());
+
+		// Write the new journal beside the current one and swap them, so there is always a complete journal to recover from
+		const std::string journalFilename = getJournalFilename(filename);
+		const std::string tempFilename = journalFilename + ".tmp";
+		FILE* tempStream = _wfopen(mbToWideStr(tempFilename).c_str(), L"wb");
+		if (!tempStream)
+			return false;
+
+		const std::vector<uint8_t>& bytes = header.getBuffer();
+		bool written = fwrite(bytes.data(), sizeof(uint8_t), bytes.size(), tempStream) == bytes.size();
+		written &= fclose(tempStream) == 0;
+
+		// The journal cannot be renamed over while it is open
+		close();
+
+		std::error_code error;
+		if (written)
+			std::filesystem::rename(mbToWideStr(tempFilename), mbToWideStr(journalFilename), error);
+
+		if (!written || error)
+		{
+			removeFile(tempFilename);
+			return false;
+		}
+
+		stream = _wfopen(mbToWideStr(journalFilename).c_str(), L"ab");
+		if (!stream)
+			return false;
+
+		journalIDs.clear();
+		for (size_t i = 0; i < order.size(); ++i)
+			journalIDs[order[i]] = static_cast<int>(i);
+
+		nextJournalID = static_cast<int>(order.size());
+		scoreFilename = filename;
+		baseFilename = base.filename;
+		journalSize = bytes.size();
+		return true;
+	}
+
+	bool EditJournal::beginFromFile(const Score& score, const std::string& filename, uint32_t size, uint32_t checksum)
+	{
+		cancelPendingBase();
+
+		// The tick order was just sorted to save the score, so numbering its notes the same way is cheap
+		const JournalBase base{ filename, size, checksum, NativeScoreSerializer::getNoteOrder(score) };
+		if (size == 0 || !begin(base, filename))
+			return false;
+
+		removeSnapshotsExcept(filename, {});
+		return true;
+	}
+
+	void EditJournal::beginFromFile(const Score& score, const std::string& filename)
+	{
+		cancelPendingBase();
+
+		pendingFilename = filename;
+		pendingBase = std::async(std::launch::async, [score, filename]() -> std::optional<JournalBase>
+		{
+			JournalBase base;
+			base.filename = filename;
+			if (!readFileChecksum(filename, base.size, base.checksum))
+				return std::nullopt;
+
+			base.noteOrder = NativeScoreSerializer::getNoteOrder(score);
+			return base;
+		});
+	}
+
+	std::optional<EditJournal::JournalBase> EditJournal::writeSnapshot(const Score& score, const std::string& snapshotFilename)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(mbToWideStr(snapshotFilename)).parent_path(), error);
+
+		try
+		{
+			NativeScoreSerializer serializer;
+			serializer.serialize(score, snapshotFilename);
+			if (serializer.getWrittenSize() == 0)
+				return std::nullopt;
+
+			return JournalBase{ snapshotFilename, serializer.getWrittenSize(), serializer.getWrittenChecksum(), NativeScoreSerializer::getNoteOrder(score) };
+		}
+		catch (const std::exception&)
+		{
+			removeFile(snapshotFilename);
+			return std::nullopt;
+		}
+	}
+
+	void EditJournal::beginFromSnapshot(const Score& score, const std::string& filename)
+	{
+		cancelPendingBase();
+
+		const std::string snapshotFilename = getSnapshotFilename(filename, getNextSnapshotSlot(filename));
+		pendingFilename = filename;
+		pendingBase = std::async(std::launch::async, [score, snapshotFilename]() { return writeSnapshot(score, snapshotFilename); });
+	}
+
+	void EditJournal::append(const ScorePatch& patch)
+	{
+		if (patch.empty())
+			return;
+
+		if (isWritingBase())
+			pendingPatches.push_back(patch);
+
+		if (!stream)
+			return;
+
+		BinaryWriter writer;
+		auto writeStep = [&](const HoldStep& step)
+		{
+			writer.writeVarUInt32(toJournalID(step.ID));
+			writer.writeByte((uint8_t)step.type);
+			writer.writeByte((uint8_t)step.ease);
+		};
+
+		writer.writeVarUInt32(patch.notes.size());
+		for (const auto& [id, note] : patch.notes)
+		{
+			writer.writeVarUInt32(toJournalID(id));
+			writer.writeByte(note.has_value());
+			if (!note)
+				continue;
+
+			writer.writeByte((uint8_t)note->getType());
+			writer.writeVarInt32(note->tick);
+			writer.writeVarInt32(note->lane);
+			writer.writeVarInt32(note->width);
+			writer.writeByte((uint8_t)note->flick);
+			writer.writeByte((note->critical ? 1 : 0) | (note->friction ? 2 : 0));
+			writer.writeVarUInt32(note->parentID < 0 ? 0 : toJournalID(note->parentID) + 1);
+		}
+
+		writer.writeVarUInt32(patch.holdNotes.size());
+		for (const auto& [id, hold] : patch.holdNotes)
+		{
+			writer.writeVarUInt32(toJournalID(id));
+			writer.writeByte(hold.has_value());
+			if (!hold)
+				continue;
+
+			writer.writeByte((uint8_t)hold->startType);
+			writer.writeByte((uint8_t)hold->endType);
+			writeStep(hold->start);
+
+			writer.writeVarUInt32(hold->steps.size());
+			for (const auto& step : hold->steps)
+				writeStep(step);
+
+			writer.writeVarUInt32(toJournalID(hold->end));
+		}
+
+		writer.writeByte(patch.events.has_value());
+		if (patch.events)
+		{
+			const ScoreEvents& events = *patch.events;
+			writer.writeVarUInt32(events.tempoChanges.size());
+			for (const auto& tempo : events.tempoChanges)
+			{
+				writer.writeVarInt32(tempo.tick);
+				writer.writeSingle(tempo.bpm);
+			}
+
+			writer.writeVarUInt32(events.timeSignatures.size());
+			for (const auto& [_, timeSignature] : events.timeSignatures)
+			{
+				writer.writeVarInt32(timeSignature.measure);
+				writer.writeVarInt32(timeSignature.numerator);
+				writer.writeVarInt32(timeSignature.denominator);
+			}
+
+			writer.writeVarUInt32(events.hiSpeedChanges.size());
+			for (const auto& hiSpeed : events.hiSpeedChanges)
+			{
+				writer.writeVarInt32(hiSpeed.tick);
+				writer.writeSingle(hiSpeed.speed);
+			}
+
+			writer.writeVarUInt32(events.skills.size());
+			for (const auto& skill : events.skills)
+				writer.writeVarInt32(skill.tick);
+
+			writer.writeVarInt32(events.fever.startTick);
+			writer.writeVarInt32(events.fever.endTick);
+		}
+
+		// Records are checksummed so one cut short by a crash is ignored along with everything after it
+		const std::vector<uint8_t>& payload = writer.getBuffer();
+		BinaryWriter record;
+		record.writeInt32(payload.size());
+		record.writeInt32(crc32(0L, payload.data(), static_cast<uInt>(payload.size())));
+		record.writeBytes(payload);
+
+		const std::vector<uint8_t>& bytes = record.getBuffer();
+		fwrite(bytes.data(), sizeof(uint8_t), bytes.size(), stream);
+		fflush(stream);
+		journalSize += bytes.size();
+	}
+
+	bool EditJournal::needsCompaction() const
+	{
+		return isOpen() && !isWritingBase() && journalSize > maxJournalSize;
+	}
+
+	bool EditJournal::compact(const Score& score)
+	{
+		if (!isOpen() || isWritingBase())
+			return false;
+
+		// Serializing a large score takes long enough to stall the editor, so only the copy is made here
+		const std::string snapshotFilename = getSnapshotFilename(scoreFilename, getNextSnapshotSlot(scoreFilename));
+		pendingFilename = scoreFilename;
+		pendingBase = std::async(std::launch::async, [score, snapshotFilename]() { return writeSnapshot(score, snapshotFilename); });
+		return true;
+	}
+
+	void EditJournal::update()
+	{
+		if (!isWritingBase() || pendingBase.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		std::optional<JournalBase> base = pendingBase.get();
+		std::vector<ScorePatch> patches = std::move(pendingPatches);
+		pendingPatches.clear();
+
+		// The current journal, if there is one, still holds every edit when the base could not be written
+		if (!base)
+			return;
+
+		const std::string filename = pendingFilename;
+		if (!begin(*base, filename))
+		{
+			if (base->filename != filename)
+				removeFile(base->filename);
+
+			return;
+		}
+
+		for (const ScorePatch& patch : patches)
+			append(patch);
+
+		// The previous snapshot, if any, is no longer the base of the journal
+		removeSnapshotsExcept(filename, base->filename);
+	}
+
+	void EditJournal::cancelPendingBase()
+	{
+		if (!isWritingBase())
+			return;
+
+		// The score file itself may be the base, only snapshots are removed
+		std::optional<JournalBase> base = pendingBase.get();
+		if (base && base->filename != pendingFilename)
+			removeFile(base->filename);
+
+		pendingPatches.clear();
+	}
+
+	void EditJournal::close()
+	{
+		cancelPendingBase();
+		if (stream)
+			fclose(stream);
+
+		stream = NULL;
+	}
+
+	void EditJournal::discard()
+	{
+		close();
+		if (!scoreFilename.empty())
+			remove(scoreFilename);
+
+		scoreFilename.clear();
+		baseFilename.clear();
+		journalIDs.clear();
+		journalSize = 0;
+	}
+
+	std::string EditJournal::getJournalFilename(const std::string& filename)
+	{
+		return filename + ".journal";
+	}
+
+	bool EditJournal::hasRecovery(const std::string& filename)
+	{
+		const std::string journalFilename = getJournalFilename(filename);
+		if (!File::exists(journalFilename))
+			return false;
+
+		try
+		{
+			BinaryReader reader(journalFilename);
+			if (!reader.isStreamValid())
+				return false;
+
+			readJournalHeader(reader);
+			return reader.getFileSize() - reader.getStreamPosition() > journalRecordHeaderSize;
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+	}
+
+	Score EditJournal::recover(const std::string& filename)
+	{
+		BinaryReader reader(getJournalFilename(filename));
+		if (!reader.isStreamValid())
+			throw std::runtime_error("Failed to open the journal.");
+
+		const JournalHeader header = readJournalHeader(reader);
+		uint32_t baseSize{}, baseChecksum{};
+		if (!readFileChecksum(header.baseFilename, baseSize, baseChecksum))
+			throw std::runtime_error("The journaled score no longer exists.");
+
+		if (baseSize != header.baseSize || baseChecksum != header.baseChecksum)
+			throw std::runtime_error("The score was modified after the journal was started.");
+
+		Score score = NativeScoreSerializer().deserialize(header.baseFilename);
+		std::vector<int> scoreIDs = NativeScoreSerializer::getNoteOrder(score);
+		if (scoreIDs.size() != header.baseNoteCount)
+			throw std::runtime_error("The journaled score does not match the journal.");
+
+		// Notes created after the journal was started get new IDs the first time they appear
+		std::unordered_map<uint32_t, int> createdIDs;
+		auto resolveID = [&](uint32_t journalID) -> int
+		{
+			if (journalID < scoreIDs.size())
+				return scoreIDs[journalID];
+
+			auto it = createdIDs.find(journalID);
+			if (it != createdIDs.end())
+				return it->second;
+
+			return createdIDs[journalID] = nextID++;
+		};
+
+		while (reader.getFileSize() - reader.getStreamPosition() >= journalRecordHeaderSize)
+		{
+			uint32_t size = reader.readInt32();
+			uint32_t checksum = reader.readInt32();
+			if (reader.getFileSize() - reader.getStreamPosition() < size)
+				break;
+
+			std::vector<uint8_t> payload = reader.readBytes(size);
+			if (crc32(0L, payload.data(), static_cast<uInt>(payload.size())) != checksum)
+				break;
+
+			BinaryReader record(std::move(payload));
+			readPatch(record, resolveID).apply(score);
+		}
+
+		reader.close();
+		return score;
+	}
+
+	void EditJournal::remove(const std::string& filename)
+	{
+		removeFile(getJournalFilename(filename));
+		removeFile(getJournalFilename(filename) + ".tmp");
+		removeFile(getSnapshotFilename(filename, 0));
+		removeFile(getSnapshotFilename(filename, 1));
+	}
+
+	void EditJournal::setAside(const std::string& filename)
+	{
+		for (const std::string& journalFile : { getJournalFilename(filename), getSnapshotFilename(filename, 0), getSnapshotFilename(filename, 1) })
+		{
+			if (!File::exists(journalFile))
+				continue;
+
+			std::error_code error;
+			std::filesystem::rename(mbToWideStr(journalFile), mbToWideStr(journalFile + ".failed"), error);
+		}
+	}
+}
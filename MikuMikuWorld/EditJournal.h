@@ -0,0 +1,128 @@
+#pragma once
+#include "HistoryManager.h"
+#include <stdio.h>
+#include <future>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// <summary>
+	/// Append-only log of every patch applied to a score since its last full save, written next to the score
+	/// so unsaved edits survive a crash. Each record costs as much as the edit it describes, and the log is
+	/// periodically compacted into a full snapshot of the score.
+	/// </summary>
+	class EditJournal
+	{
+	private:
+		// The file a journal starts from, and the order its notes are numbered in
+		struct JournalBase
+		{
+			std::string filename;
+			uint32_t size{};
+			uint32_t checksum{};
+			std::vector<int> noteOrder;
+		};
+
+		FILE* stream{ NULL };
+		std::string scoreFilename;
+		std::string baseFilename;
+		size_t journalSize{};
+
+		// Note IDs are only valid for one session, so the journal keeps its own numbering
+		std::unordered_map<int, int> journalIDs;
+		int nextJournalID{};
+
+		// Snapshots and checksums of new bases are written on a worker thread. Patches appended in the meantime
+		// still go to the current journal, if there is one, and are kept to be replayed on top of the new base.
+		std::future<std::optional<JournalBase>> pendingBase;
+		std::string pendingFilename;
+		std::vector<ScorePatch> pendingPatches;
+
+		int toJournalID(int id);
+		int getNextSnapshotSlot(const std::string& filename) const;
+		static std::optional<JournalBase> writeSnapshot(const Score& score, const std::string& snapshotFilename);
+		bool begin(const JournalBase& base, const std::string& filename);
+		void cancelPendingBase();
+
+	public:
+		EditJournal() = default;
+		EditJournal(const EditJournal&) = delete;
+		EditJournal& operator=(const EditJournal&) = delete;
+		~EditJournal();
+
+		/// <summary>
+		/// Starts a new journal for a score that was just saved, given the size and checksum of the bytes written
+		/// </summary>
+		bool beginFromFile(const Score& score, const std::string& filename, uint32_t size, uint32_t checksum);
+
+		/// <summary>
+		/// Starts a new journal for a score that is identical to the file it was just loaded from.
+		/// The file is checksummed in the background and the journal opens in a later call to update.
+		/// </summary>
+		void beginFromFile(const Score& score, const std::string& filename);
+
+		/// <summary>
+		/// Starts a new journal for a score that does not match any file.
+		/// A snapshot of it is written in the background and the journal opens in a later call to update.
+		/// </summary>
+		void beginFromSnapshot(const Score& score, const std::string& filename);
+
+		/// <summary>
+		/// Appends the patch that was just applied to the score
+		/// </summary>
+		void append(const ScorePatch& patch);
+
+		/// <summary>
+		/// Whether the journal has grown large enough that replaying it would be slower than loading a snapshot
+		/// </summary>
+		bool needsCompaction() const;
+
+		/// <summary>
+		/// Starts replacing the journal with a snapshot of the score and an empty log in the background.
+		/// The journal switches over in a later call to update once the snapshot is written.
+		/// </summary>
+		bool compact(const Score& score);
+		inline bool isWritingBase() const { return pendingBase.valid(); }
+
+		/// <summary>
+		/// Switches to the base written in the background once it is finished
+		/// </summary>
+		void update();
+
+		/// <summary>
+		/// Closes the journal and removes its files, as its edits were either saved or discarded
+		/// </summary>
+		void discard();
+
+		/// <summary>
+		/// Closes the journal, keeping its files for recovery
+		/// </summary>
+		void close();
+
+		inline bool isOpen() const { return stream != NULL; }
+		inline size_t getSize() const { return journalSize; }
+
+		static std::string getJournalFilename(const std::string& filename);
+		static bool hasRecovery(const std::string& filename);
+
+		/// <summary>
+		/// Loads the base of the journal kept for the given score and replays every complete record on top of it.
+		/// Throws if the base has changed since the journal was started.
+		/// </summary>
+		static Score recover(const std::string& filename);
+
+		/// <summary>
+		/// Removes the journal kept for the given score without opening it
+		/// </summary>
+		static void remove(const std::string& filename);
+
+		/// <summary>
+		/// Renames the journal kept for the given score and its snapshots with a .failed suffix,
+		/// so a journal that could not be recovered isn't replaced by the next one
+		/// </summary>
+		static void setAside(const std::string& filename);
+	};
+}
@@ -0,0 +1,880 @@
+#include "EditorBenchmarks.h"
+#include "ScoreBenchmarks.h"
+#include "PreviewData.h"
+#include "ResourceManager.h"
+#include "PreviewEngine.h"
+#include "Rendering/QuadSorter.h"
+#include "Rendering/Renderer.h"
+#include "Rendering/StreamRing.h"
+#include "Audio/MusicStream.h"
+#include "Audio/Waveform.h"
+#include "Audio/AudioCache.h"
+#include "ApplicationConfiguration.h"
+#include "Constants.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <unordered_set>
+
+namespace mmw = MikuMikuWorld;
+
+namespace Debug
+{
+	// Keeps the compiler from discarding the benchmarked work
+	static volatile double benchmarkSink;
+
+	static constexpr int benchmarkQuadCounts[] = { 1000, 10000 };
+
+	static bool loadNoteEffects(const std::string& appDir)
+	{
+		const std::string effectsDir = appDir + "res\\effect\\" + std::to_string(mmw::config.pvEffectsProfile) + "\\";
+		mmw::ResourceManager::removeAllParticleEffects();
+		for (const char* name : mmw::Effect::effectNames)
+		{
+			if (mmw::ResourceManager::loadParticleEffect(effectsDir + name + ".json") == -1)
+				return false;
+		}
+
+		return true;
+	}
+
+	// The IDs of every emitter of every note effect, roots first
+	static std::vector<int> getNoteEffectIDs()
+	{
+		std::vector<int> effectIDs;
+		for (const char* name : mmw::Effect::effectNames)
+			effectIDs.push_back(mmw::ResourceManager::getRootParticleIdByName(name));
+
+		for (size_t i = 0; i < effectIDs.size(); ++i)
+		{
+			for (int child : mmw::ResourceManager::getParticleEffect(effectIDs[i]).children)
+				effectIDs.push_back(child);
+		}
+
+		return effectIDs;
+	}
+
+	struct EffectCurves
+	{
+		std::vector<mmw::Effect::MinMax> curves;
+		std::vector<mmw::Effect::MinMaxColor> gradients;
+	};
+
+	// Copies of the curves and gradients of every note effect that change over time, baked at the given resolution
+	static EffectCurves getNoteEffectCurves(int resolution)
+	{
+		EffectCurves result;
+		for (int id : getNoteEffectIDs())
+		{
+			const mmw::Effect::Particle& p = mmw::ResourceManager::getParticleEffect(id);
+			std::vector<const mmw::Effect::MinMax*> curves = {
+				&p.startDelay, &p.startLifeTime, &p.startSpeed, &p.gravityModifier, &p.speedModifier, &p.startFrame, &p.frameOverTime,
+				&p.emission.rateOverTime, &p.emission.rateOverDistance, &p.emission.arcSpeed
+			};
+
+			for (const mmw::Effect::MinMax3* curve : { &p.startSize, &p.startRotation, &p.limitVelocitySpeed, &p.velocityOverLifetime,
+				&p.limitVelocityOverLifetime, &p.forceOverLifetime, &p.sizeOverLifetime, &p.rotationOverLifetime })
+			{
+				curves.insert(curves.end(), { &curve->x, &curve->y, &curve->z });
+			}
+
+			for (const mmw::Effect::MinMax* curve : curves)
+			{
+				if (curve->mode == mmw::Effect::MinMaxMode::Curve || curve->mode == mmw::Effect::MinMaxMode::TwoCurves)
+				{
+					result.curves.push_back(*curve);
+					result.curves.back().bake(resolution);
+				}
+			}
+
+			for (const mmw::Effect::MinMaxColor* gradient : { &p.startColor, &p.colorOverLifetime })
+			{
+				if (gradient->mode == mmw::Effect::MinMaxColorMode::Gradient || gradient->mode == mmw::Effect::MinMaxColorMode::TwoGradients)
+				{
+					result.gradients.push_back(*gradient);
+					result.gradients.back().bake(resolution);
+				}
+			}
+		}
+
+		return result;
+	}
+
+	static void addPreviewBenchmarks(BenchmarkRunner& runner, int size)
+	{
+		const std::string suffix = "/" + std::to_string(size);
+		runner.add("CalculateDrawData" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			const mmw::TempoMap tempoMap(score.tempoChanges, score.hiSpeedChanges, mmw::TICKS_PER_BEAT);
+			mmw::Engine::DrawData drawData;
+
+			while (state.keepRunning())
+				drawData.calculateDrawData(score, tempoMap);
+
+			// The draw data is cleared when the score is inconsistent
+			if (drawData.drawingNotes.empty())
+				state.skipWithError("No draw data was calculated");
+
+			state.setItemsProcessed(state.getIterations() * score.notes.size());
+		});
+
+		// The sound effects lookup each frame of playback used to do before the schedule
+		runner.add("Playback/NoteSounds/Lookup" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			const mmw::TempoMap tempoMap(score.tempoChanges, score.hiSpeedChanges, mmw::TICKS_PER_BEAT);
+			const float duration = getNoteSoundsDuration(score, tempoMap);
+			mmw::Engine::DrawData drawData;
+			drawData.calculateDrawData(score, tempoMap);
+
+			std::vector<int> noteRange;
+			std::unordered_set<std::string> playingNoteSounds;
+			int64_t frames = 0, sounds = 0;
+			uint64_t allocations = 0;
+			while (state.keepRunning())
+			{
+				for (float time = 0, timeLastFrame = 0; time < duration; timeLastFrame = time, time += noteSoundFrameTime, frames++)
+				{
+					const uint64_t allocationsBefore = getThreadAllocationCount();
+					playingNoteSounds.clear();
+
+					const int fromTick = tempoMap.secondsToTicks(std::max(time - 1.f, 0.f));
+					const int toTick = tempoMap.secondsToTicks(time + 1.f);
+					drawData.notesList.getTickRange(fromTick, toTick, noteRange);
+
+					const auto& notesList = drawData.notesList.getView();
+					for (int i : noteRange)
+					{
+						const float offsetNoteTime = notesList[i].time - noteSoundLookAhead;
+						if (offsetNoteTime < timeLastFrame || offsetNoteTime >= time)
+							continue;
+
+						const mmw::Note& note = score.notes.at(notesList[i].refID);
+						if (note.getType() == mmw::NoteType::Hold && score.holdNotes.at(note.ID).startType != mmw::HoldNoteType::Normal)
+							continue;
+
+						if (note.getType() == mmw::NoteType::HoldEnd && score.holdNotes.at(note.parentID).endType != mmw::HoldNoteType::Normal)
+							continue;
+
+						std::string_view se = mmw::getNoteSE(note, score);
+						std::string key = std::to_string(note.tick) + "-" + se.data();
+						if (!se.empty() && playingNoteSounds.insert(key).second)
+							sounds++;
+					}
+
+					allocations += getThreadAllocationCount() - allocationsBefore;
+				}
+			}
+
+			state.setItemsProcessed(frames);
+			state.setCounter("sounds", static_cast<double>(sounds) / state.getIterations());
+			if (allocationCountingEnabled)
+				state.setCounter("allocations_per_frame", static_cast<double>(allocations) / std::max<int64_t>(frames, 1));
+		});
+	}
+
+	static void addParticleBenchmarks(BenchmarkRunner& runner, const std::string& appDir)
+	{
+		const bool effectsLoaded = loadNoteEffects(appDir);
+		runner.add("Particles/Update", [effectsLoaded](BenchmarkState& state)
+		{
+			if (!effectsLoaded)
+			{
+				state.skipWithError("Failed to load the note effects");
+				return;
+			}
+
+			mmw::Camera camera;
+			camera.positionCamNormal();
+
+			// Every lane and note effect playing in each lane, replayed as soon as it ends
+			const mmw::Note note(mmw::NoteType::Tap);
+			std::vector<mmw::Effect::EffectPool> pools(mmw::Effect::fx_note_hold_aura);
+			for (size_t i = 0; i < pools.size(); ++i)
+			{
+				pools[i].setup(static_cast<mmw::Effect::EffectType>(i), mmw::NUM_LANES);
+				for (auto& controller : pools[i].pool)
+					controller.play(note, 0, -1);
+			}
+
+			float time = 0;
+			int64_t updates = 0;
+			while (state.keepRunning())
+			{
+				time += 1 / 60.0f;
+				for (auto& pool : pools)
+				{
+					for (auto& controller : pool.pool)
+					{
+						if (time >= controller.time.max)
+							controller.play(note, time, -1);
+
+						controller.effectRoot.update(time, controller.worldOffset, camera);
+						++updates;
+					}
+				}
+			}
+
+			state.setItemsProcessed(updates);
+		});
+
+		runner.add("Particles/Update10k", [effectsLoaded](BenchmarkState& state)
+		{
+			if (!effectsLoaded)
+			{
+				state.skipWithError("Failed to load the note effects");
+				return;
+			}
+
+			mmw::Camera camera;
+			camera.positionCamNormal();
+
+			// Every emitter of every note effect on its own, kept full so about 10k particles are alive at once
+			const std::vector<int> effectIDs = getNoteEffectIDs();
+			constexpr int totalParticles = 10000;
+			const int particlesPerEmitter = totalParticles / static_cast<int>(effectIDs.size()) + 1;
+			const mmw::Effect::Transform transform{};
+			std::vector<mmw::Effect::EmitterInstance> emitters(effectIDs.size());
+			for (size_t i = 0; i < emitters.size(); ++i)
+			{
+				const mmw::Effect::Particle& ref = mmw::ResourceManager::getParticleEffect(effectIDs[i]);
+				emitters[i].init(ref, transform);
+				emitters[i].start(0);
+				emitters[i].particles.resize(particlesPerEmitter);
+				emitters[i].emit(transform, ref, 0, particlesPerEmitter);
+			}
+
+			float time = 0;
+			int64_t updates = 0;
+			while (state.keepRunning())
+			{
+				time += 1 / 60.0f;
+				for (auto& emitter : emitters)
+				{
+					const mmw::Effect::Particle& ref = mmw::ResourceManager::getParticleEffect(emitter.getRefID());
+					emitter.emit(transform, ref, time, particlesPerEmitter - emitter.getAliveCount());
+					emitter.update(time, transform, camera);
+					updates += emitter.getAliveCount();
+				}
+			}
+
+			state.setItemsProcessed(updates);
+		});
+
+		// Checks the four-wide simulation against matrices built one particle at a time, and times building them that way
+		runner.add("Particles/ScalarReference", [effectsLoaded](BenchmarkState& state)
+		{
+			if (!effectsLoaded)
+			{
+				state.skipWithError("Failed to load the note effects");
+				return;
+			}
+
+			mmw::Camera camera;
+			camera.positionCamNormal();
+
+			const std::vector<int> effectIDs = getNoteEffectIDs();
+			const mmw::Effect::Transform transform{};
+			std::vector<mmw::Effect::EmitterInstance> emitters;
+			for (int id : effectIDs)
+			{
+				const mmw::Effect::Particle& ref = mmw::ResourceManager::getParticleEffect(id);
+				if (ref.renderMode == mmw::Effect::RenderMode::StretchedBillboard)
+					continue;
+
+				mmw::Effect::EmitterInstance& emitter = emitters.emplace_back();
+				emitter.init(ref, transform);
+				emitter.start(0);
+			}
+
+			// Relative to the magnitude of each element, since translations can be much larger than one
+			constexpr double tolerance = 1e-5;
+			double maxError = 0;
+			for (int frame = 1; frame <= 120; ++frame)
+			{
+				const float time = frame / 60.0f;
+				for (auto& emitter : emitters)
+				{
+					const mmw::Effect::Particle& ref = mmw::ResourceManager::getParticleEffect(emitter.getRefID());
+					emitter.update(time, transform, camera);
+					for (int i = 0; i < emitter.getAliveCount(); ++i)
+					{
+						if (emitter.particles.time[i] < 0)
+							continue;
+
+						DirectX::XMFLOAT4X4 actual, expected;
+						DirectX::XMStoreFloat4x4(&actual, emitter.particles.matrix[i]);
+						DirectX::XMStoreFloat4x4(&expected, emitter.calculateParticleMatrix(ref, i, transform, camera));
+						for (int r = 0; r < 4; ++r)
+						{
+							for (int c = 0; c < 4; ++c)
+							{
+								const double error = std::abs(actual.m[r][c] - expected.m[r][c]) / std::max(1.0, std::abs(static_cast<double>(expected.m[r][c])));
+								maxError = std::max(maxError, error);
+							}
+						}
+					}
+				}
+			}
+
+			if (maxError > tolerance)
+			{
+				state.skipWithError("The particle matrices differ from the scalar reference by " + std::to_string(maxError));
+				return;
+			}
+
+			int64_t particles = 0;
+			DirectX::XMMATRIX sum = DirectX::XMMatrixIdentity();
+			while (state.keepRunning())
+			{
+				for (const auto& emitter : emitters)
+				{
+					const mmw::Effect::Particle& ref = mmw::ResourceManager::getParticleEffect(emitter.getRefID());
+					for (int i = 0; i < emitter.getAliveCount(); ++i)
+						sum.r[3] = DirectX::XMVectorAdd(sum.r[3], emitter.calculateParticleMatrix(ref, i, transform, camera).r[3]);
+
+					particles += emitter.getAliveCount();
+				}
+			}
+
+			benchmarkSink = DirectX::XMVectorGetX(sum.r[3]);
+			state.setItemsProcessed(particles);
+			state.setCounter("max_error", maxError);
+		});
+
+		// A resolution of 0 evaluates the keyframes and is the reference the baked curves are compared against
+		for (int resolution : { 0, 64, 256, 1024 })
+		{
+			runner.add("Particles/Curves/" + std::to_string(resolution), [effectsLoaded, resolution](BenchmarkState& state)
+			{
+				if (!effectsLoaded)
+				{
+					state.skipWithError("Failed to load the note effects");
+					return;
+				}
+
+				constexpr int sampleCount = 1000;
+				const EffectCurves exact = getNoteEffectCurves(0);
+				const EffectCurves baked = getNoteEffectCurves(resolution);
+
+				double maxError = 0, maxAreaError = 0, maxColorError = 0;
+				for (int i = 0; i <= sampleCount; ++i)
+				{
+					const float time = i / static_cast<float>(sampleCount);
+					for (size_t c = 0; c < exact.curves.size(); ++c)
+					{
+						maxError = std::max(maxError, static_cast<double>(std::abs(exact.curves[c].evaluate(time, 0.5f) - baked.curves[c].evaluate(time, 0.5f))));
+						maxAreaError = std::max(maxAreaError, static_cast<double>(std::abs(exact.curves[c].integrate(0, time, 1, 0.5f) - baked.curves[c].integrate(0, time, 1, 0.5f))));
+					}
+
+					for (size_t g = 0; g < exact.gradients.size(); ++g)
+					{
+						const mmw::Color c1 = exact.gradients[g].evaluate(time, 0.5f), c2 = baked.gradients[g].evaluate(time, 0.5f);
+						maxColorError = std::max({ maxColorError, static_cast<double>(std::abs(c1.r - c2.r)), static_cast<double>(std::abs(c1.g - c2.g)),
+							static_cast<double>(std::abs(c1.b - c2.b)), static_cast<double>(std::abs(c1.a - c2.a)) });
+					}
+				}
+
+				double sum = 0;
+				while (state.keepRunning())
+				{
+					for (int i = 0; i <= sampleCount; ++i)
+					{
+						const float time = i / static_cast<float>(sampleCount);
+						for (const mmw::Effect::MinMax& curve : baked.curves)
+							sum += curve.evaluate(time, 0.5f) + curve.integrate(0, time, 1, 0.5f);
+
+						for (const mmw::Effect::MinMaxColor& gradient : baked.gradients)
+							sum += gradient.evaluate(time, 0.5f).a;
+					}
+				}
+
+				benchmarkSink = sum;
+				state.setItemsProcessed(state.getIterations() * (sampleCount + 1) * (baked.curves.size() + baked.gradients.size()));
+				state.setCounter("max_error", maxError);
+				state.setCounter("max_integral_error", maxAreaError);
+				state.setCounter("max_color_error", maxColorError);
+			});
+		}
+	}
+
+	static std::vector<mmw::Quad<mmw::Vertex>> createBenchmarkQuads(int count)
+	{
+		// Notes of three quads sharing a z index and texture, spread over the layers and lanes like a dense preview frame
+		std::mt19937 random(count);
+		std::uniform_real_distribution<float> laneDistribution(-6, 6), progressDistribution(0, 1);
+		std::uniform_int_distribution<int> layerDistribution(0, static_cast<int>(mmw::SpriteLayer::UNDER_NOTE_EFFECT));
+		std::uniform_int_distribution<int> textureDistribution(1, 3);
+
+		std::vector<mmw::Quad<mmw::Vertex>> quads;
+		quads.reserve(count);
+		while (quads.size() < count)
+		{
+			const float x = laneDistribution(random), y = progressDistribution(random);
+			const int zIndex = mmw::Engine::getZIndex(static_cast<mmw::SpriteLayer>(layerDistribution(random)), x, y);
+			const int texture = textureDistribution(random);
+			for (int i = 0; i < 3 && quads.size() < count; ++i)
+			{
+				mmw::Quad<mmw::Vertex> quad{ texture, zIndex };
+				for (int v = 0; v < 4; ++v)
+					quad.vertices[v].position = DirectX::XMVectorSet(x + i + (v & 1), y + (v >> 1), 0, 1);
+
+				quads.push_back(quad);
+			}
+		}
+
+		return quads;
+	}
+
+	static void addRenderBenchmarks(BenchmarkRunner& runner, int count)
+	{
+		const std::string suffix = "/" + std::to_string(count);
+		runner.add("Render/SortQuads" + suffix, [count](BenchmarkState& state)
+		{
+			const std::vector<mmw::Quad<mmw::Vertex>> quads = createBenchmarkQuads(count);
+			mmw::QuadSorter sorter;
+
+			while (state.keepRunning())
+				sorter.sort(quads);
+
+			state.setItemsProcessed(state.getIterations() * quads.size());
+			state.setCounter("draw_runs", static_cast<double>(sorter.getRuns().size()));
+		});
+
+		// The sort used before the radix sort, for comparison
+		runner.add("Render/StableSortQuads" + suffix, [count](BenchmarkState& state)
+		{
+			const std::vector<mmw::Quad<mmw::Vertex>> quads = createBenchmarkQuads(count);
+			std::vector<mmw::Quad<mmw::Vertex>> sortedQuads;
+			std::vector<mmw::Vertex> vertices(quads.size() * 4);
+			int drawRuns = 0;
+
+			while (state.keepRunning())
+			{
+				state.pauseTiming();
+				sortedQuads = quads;
+				state.resumeTiming();
+
+				std::stable_sort(sortedQuads.begin(), sortedQuads.end(),
+					[](const mmw::Quad<mmw::Vertex>& q1, const mmw::Quad<mmw::Vertex>& q2) { return q1.zIndex < q2.zIndex; });
+
+				drawRuns = 0;
+				for (size_t i = 0; i < sortedQuads.size(); ++i)
+				{
+					std::copy(sortedQuads[i].vertices, sortedQuads[i].vertices + 4, vertices.begin() + i * 4);
+					if (i == 0 || sortedQuads[i].texture != sortedQuads[i - 1].texture)
+						++drawRuns;
+				}
+			}
+
+			state.setItemsProcessed(state.getIterations() * quads.size());
+			state.setCounter("draw_runs", drawRuns);
+		});
+
+		// Streams the draw runs of a sorted batch through the renderer's ring, checking every allocation on the way
+		runner.add("Render/StreamRing" + suffix, [count](BenchmarkState& state)
+		{
+			mmw::QuadSorter sorter;
+			sorter.sort(createBenchmarkQuads(count));
+
+			// A small ring so the batch goes around it several times
+			mmw::StreamRing ring(4096, mmw::streamRegionCount);
+			const size_t quadCapacity = ring.getRegionCapacity() / 4;
+			size_t vertexCount = 0;
+
+			while (state.keepRunning())
+			{
+				for (const mmw::DrawRun& run : sorter.getRuns())
+				{
+					for (size_t first = run.first, last = run.first + run.count; first < last;)
+					{
+						const size_t vertices = std::min(last - first, quadCapacity) * 4;
+						const int region = ring.getRegion();
+						const mmw::StreamAllocation allocation = ring.allocate(vertices);
+
+						const size_t regionStart = allocation.region * ring.getRegionCapacity();
+						const bool expectedRegion = allocation.regionChanged
+							? allocation.previousRegion == region && allocation.region == (region + 1) % ring.getRegionCount() && allocation.offset == regionStart
+							: allocation.region == region;
+
+						if (!expectedRegion || allocation.offset < regionStart || allocation.offset + vertices > regionStart + ring.getRegionCapacity())
+						{
+							state.skipWithError("Stream allocation outside of its region");
+							return;
+						}
+
+						vertexCount += vertices;
+						first += vertices / 4;
+					}
+				}
+			}
+
+			state.setItemsProcessed(vertexCount);
+			state.setCounter("region_changes", static_cast<double>(ring.getRegionChanges()));
+		});
+	}
+
+	// A stereo tone as 16-bit wav, which both the full decode and the stream can read
+	static std::string createBenchmarkMusic(int seconds)
+	{
+		constexpr uint32_t sampleRate = 48000;
+		constexpr uint16_t channelCount = 2;
+		const uint32_t frameCount = sampleRate * seconds;
+		const uint32_t dataSize = frameCount * channelCount * sizeof(int16_t);
+
+		std::vector<int16_t> samples(static_cast<size_t>(frameCount) * channelCount);
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			const double time = static_cast<double>(frame) / sampleRate;
+			samples[frame * 2 + 0] = static_cast<int16_t>(std::sin(time * 440.0 * 6.283185307179586) * 12000.0);
+			samples[frame * 2 + 1] = static_cast<int16_t>(std::sin(time * 660.0 * 6.283185307179586) * 12000.0);
+		}
+
+		const std::string filename = getTemporaryFilename("wav");
+		std::ofstream file(filename, std::ios::binary);
+		auto write = [&file](const auto& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+		file.write("RIFF", 4);
+		write(static_cast<uint32_t>(36 + dataSize));
+		file.write("WAVEfmt ", 8);
+		write(static_cast<uint32_t>(16));
+		write(static_cast<uint16_t>(1));
+		write(channelCount);
+		write(sampleRate);
+		write(static_cast<uint32_t>(sampleRate * channelCount * sizeof(int16_t)));
+		write(static_cast<uint16_t>(channelCount * sizeof(int16_t)));
+		write(static_cast<uint16_t>(16));
+		file.write("data", 4);
+		write(dataSize);
+		file.write(reinterpret_cast<const char*>(samples.data()), dataSize);
+
+		return filename;
+	}
+
+	// Time until the music can be played and the memory it takes on the way, decoding the whole file or streaming it
+	static void addMusicBenchmarks(BenchmarkRunner& runner)
+	{
+		runner.add("Audio/LoadMusic/Decoded", [](BenchmarkState& state)
+		{
+			const std::string filename = createBenchmarkMusic(300);
+			size_t peakMemory{};
+
+			while (state.keepRunning())
+			{
+				Audio::SoundBuffer music{};
+				if (!Audio::decodeAudioFile(filename, music).isOk())
+				{
+					state.skipWithError("Failed to decode the music");
+					return;
+				}
+
+				peakMemory = music.peakMemory;
+				music.dispose();
+			}
+
+			state.setCounter("peak_memory_mb", peakMemory / (1024.0 * 1024.0));
+		});
+
+		runner.add("Audio/LoadMusic/Streamed", [](BenchmarkState& state)
+		{
+			const std::string filename = createBenchmarkMusic(300);
+			Audio::MusicStream music;
+			size_t peakMemory{};
+
+			while (state.keepRunning())
+			{
+				if (!music.open(filename).isOk())
+				{
+					state.skipWithError("Failed to open the music stream");
+					return;
+				}
+
+				// Playback can start once the first chunk is decoded
+				const auto waitStart = std::chrono::steady_clock::now();
+				while (music.getBufferedFrames() < Audio::MusicStream::chunkFrames && !music.isDecodeFinished())
+				{
+					if (std::chrono::steady_clock::now() - waitStart > std::chrono::seconds(10))
+					{
+						state.skipWithError("Timed out waiting for the music stream");
+						return;
+					}
+
+					std::this_thread::yield();
+				}
+
+				if (music.getBufferedFrames() == 0)
+				{
+					state.skipWithError("Failed to decode the music stream");
+					return;
+				}
+
+				peakMemory = music.getPeakMemory();
+				music.close();
+			}
+
+			state.setCounter("peak_memory_mb", peakMemory / (1024.0 * 1024.0));
+		});
+	}
+
+	// Ten minutes of 48kHz stereo noise with the extremes mixed in, since abs(-32768) is where a vectorized path could differ
+	static void createBenchmarkSoundBuffer(Audio::SoundBuffer& sound)
+	{
+		constexpr ma_uint32 sampleRate = 48000;
+		constexpr ma_uint32 channelCount = 2;
+		constexpr ma_uint64 frameCount = static_cast<ma_uint64>(sampleRate) * 600;
+
+		std::mt19937 rng(21);
+		std::uniform_int_distribution<int> sampleDistribution(INT16_MIN, INT16_MAX);
+
+		int16_t* samples = new int16_t[frameCount * channelCount];
+		for (size_t i = 0; i < frameCount * channelCount; ++i)
+			samples[i] = static_cast<int16_t>(i % 997 == 0 ? INT16_MIN : sampleDistribution(rng));
+
+		sound.initialize("benchmark", sampleRate, channelCount, frameCount, samples);
+	}
+
+	static size_t countMipMismatches(const Audio::WaveformMipChain& a, const Audio::WaveformMipChain& b)
+	{
+		size_t mismatches{};
+		for (size_t i = 0; i < Audio::WaveformMipChain::maxMipLevels; ++i)
+		{
+			const Audio::WaveformMip& mipA = a.mips[i];
+			const Audio::WaveformMip& mipB = b.mips[i];
+			if (mipA.powerOfTwoSampleCount != mipB.powerOfTwoSampleCount || mipA.absoluteSamples.size() != mipB.absoluteSamples.size())
+			{
+				mismatches++;
+				continue;
+			}
+
+			for (size_t sample = 0; sample < mipA.absoluteSamples.size(); ++sample)
+				mismatches += mipA.absoluteSamples[sample] != mipB.absoluteSamples[sample];
+		}
+
+		return mismatches;
+	}
+
+	// Building the waveform of a ten minute song one channel at a time versus both channels in one SIMD pass
+	static void addWaveformBenchmarks(BenchmarkRunner& runner)
+	{
+		runner.add("Audio/WaveformMips/Scalar", [](BenchmarkState& state)
+		{
+			Audio::SoundBuffer sound{};
+			createBenchmarkSoundBuffer(sound);
+			Audio::WaveformMipChain left, right;
+
+			while (state.keepRunning())
+			{
+				left.generateMipChainsFromSampleBuffer(sound, 0);
+				right.generateMipChainsFromSampleBuffer(sound, 1);
+			}
+
+			state.setItemsProcessed(state.getIterations() * static_cast<int64_t>(sound.frameCount));
+			sound.dispose();
+		});
+
+		runner.add("Audio/WaveformMips/SIMD", [](BenchmarkState& state)
+		{
+			Audio::SoundBuffer sound{};
+			createBenchmarkSoundBuffer(sound);
+			Audio::WaveformMipChain left, right;
+
+			while (state.keepRunning())
+				Audio::WaveformMipChain::generateMipChains(sound, left, right);
+
+			state.setItemsProcessed(state.getIterations() * static_cast<int64_t>(sound.frameCount));
+
+			// The mips must match the scalar ones sample for sample
+			Audio::WaveformMipChain scalarLeft, scalarRight;
+			scalarLeft.generateMipChainsFromSampleBuffer(sound, 0);
+			scalarRight.generateMipChainsFromSampleBuffer(sound, 1);
+			state.setCounter("mismatches", static_cast<double>(countMipMismatches(left, scalarLeft) + countMipMismatches(right, scalarRight)));
+			sound.dispose();
+		});
+
+		// Streamed music builds its mips while decoding the file instead of from the whole decoded buffer
+		runner.add("Audio/WaveformMips/File", [](BenchmarkState& state)
+		{
+			const std::string filename = createBenchmarkMusic(300);
+			Audio::WaveformMipChain left, right;
+
+			while (state.keepRunning())
+			{
+				if (!Audio::WaveformMipChain::generateMipChainsFromFile(filename, left, right).isOk())
+				{
+					state.skipWithError("Failed to decode the music");
+					return;
+				}
+			}
+
+			Audio::SoundBuffer sound{};
+			if (!Audio::decodeAudioFile(filename, sound).isOk())
+			{
+				state.skipWithError("Failed to decode the music");
+				return;
+			}
+
+			state.setItemsProcessed(state.getIterations() * static_cast<int64_t>(sound.frameCount));
+
+			// The mips must match the ones of the decoded buffer sample for sample
+			Audio::WaveformMipChain decodedLeft, decodedRight;
+			Audio::WaveformMipChain::generateMipChains(sound, decodedLeft, decodedRight);
+			state.setCounter("mismatches", static_cast<double>(countMipMismatches(left, decodedLeft) + countMipMismatches(right, decodedRight)));
+			sound.dispose();
+		});
+
+		// One channel of a timeline drawn at a zoom level, a pixel row per query
+		for (float zoom : { 4.0f, 1.0f, 0.25f })
+		{
+			const std::string suffix = "/" + std::to_string(static_cast<int>(zoom * 100));
+			constexpr int pixelCount = 20000;
+
+			runner.add("Audio/WaveformAmplitude/Average" + suffix, [zoom](BenchmarkState& state)
+			{
+				Audio::SoundBuffer sound{};
+				createBenchmarkSoundBuffer(sound);
+				Audio::WaveformMipChain left, right;
+				Audio::WaveformMipChain::generateMipChains(sound, left, right);
+				sound.dispose();
+
+				const double secondsPerPixel = 0.005 / zoom;
+				const Audio::WaveformMip& mip = left.findClosestMip(secondsPerPixel);
+				float amplitudeSum{};
+
+				while (state.keepRunning())
+				{
+					for (int pixel = 0; pixel < pixelCount; ++pixel)
+						amplitudeSum += left.getAmplitudeAt(mip, pixel * secondsPerPixel, secondsPerPixel);
+				}
+
+				state.setItemsProcessed(state.getIterations() * pixelCount);
+				state.setCounter("amplitude_sum", amplitudeSum);
+			});
+
+			runner.add("Audio/WaveformAmplitude/Peak" + suffix, [zoom](BenchmarkState& state)
+			{
+				Audio::SoundBuffer sound{};
+				createBenchmarkSoundBuffer(sound);
+				Audio::WaveformMipChain left, right;
+				Audio::WaveformMipChain::generateMipChains(sound, left, right);
+				sound.dispose();
+
+				const double secondsPerPixel = 0.005 / zoom;
+				const Audio::WaveformMip& mip = left.findPeakMip(secondsPerPixel);
+				float amplitudeSum{};
+
+				while (state.keepRunning())
+				{
+					for (int pixel = 0; pixel < pixelCount; ++pixel)
+						amplitudeSum += left.getPeakAt(mip, pixel * secondsPerPixel, secondsPerPixel).max;
+				}
+
+				state.setItemsProcessed(state.getIterations() * pixelCount);
+				state.setCounter("amplitude_sum", amplitudeSum);
+			});
+		}
+	}
+
+	// Opening a song the first time, decoding it and building the waveforms into an empty cache, against opening it again
+	static void addMusicCacheBenchmarks(BenchmarkRunner& runner)
+	{
+		runner.add("Audio/MusicCache/Miss", [](BenchmarkState& state)
+		{
+			const std::string filename = createBenchmarkMusic(300);
+			Audio::AudioCache cache;
+			cache.setDirectory(getTemporaryFilename("cache"));
+
+			while (state.keepRunning())
+			{
+				state.pauseTiming();
+				cache.clear();
+				state.resumeTiming();
+
+				Audio::AudioCacheKey key{};
+				Audio::SoundBuffer music{};
+				Audio::WaveformMipChain left, right;
+				if (!Audio::AudioCache::createKey(filename, key) || !Audio::decodeAudioFile(filename, music).isOk())
+				{
+					state.skipWithError("Failed to decode the music");
+					return;
+				}
+
+				Audio::WaveformMipChain::generateMipChains(music, left, right);
+				if (!cache.storeSamples(key, music) || !cache.storeWaveforms(key, left, right))
+				{
+					state.skipWithError("Failed to write the cache");
+					return;
+				}
+
+				music.dispose();
+			}
+
+			state.setCounter("cache_size_mb", cache.getSize() / (1024.0 * 1024.0));
+			cache.clear();
+		});
+
+		runner.add("Audio/MusicCache/Hit", [](BenchmarkState& state)
+		{
+			const std::string filename = createBenchmarkMusic(300);
+			Audio::AudioCache cache;
+			cache.setDirectory(getTemporaryFilename("cache"));
+			cache.clear();
+
+			Audio::AudioCacheKey key{};
+			Audio::SoundBuffer decoded{};
+			Audio::WaveformMipChain decodedLeft, decodedRight;
+			if (!Audio::AudioCache::createKey(filename, key) || !Audio::decodeAudioFile(filename, decoded).isOk())
+			{
+				state.skipWithError("Failed to decode the music");
+				return;
+			}
+
+			Audio::WaveformMipChain::generateMipChains(decoded, decodedLeft, decodedRight);
+			cache.storeSamples(key, decoded);
+			cache.storeWaveforms(key, decodedLeft, decodedRight);
+
+			size_t mismatches{};
+			while (state.keepRunning())
+			{
+				Audio::AudioCacheKey hitKey{};
+				Audio::SoundBuffer music{};
+				Audio::WaveformMipChain left, right;
+				if (!Audio::AudioCache::createKey(filename, hitKey) || !cache.loadSamples(hitKey, "benchmark", music) || !cache.loadWaveforms(hitKey, left, right))
+				{
+					state.skipWithError("Cache miss on a cached music");
+					return;
+				}
+
+				state.pauseTiming();
+				const size_t sampleCount = static_cast<size_t>(music.frameCount) * music.channelCount;
+				if (music.frameCount != decoded.frameCount || !std::equal(music.getSamples(), music.getSamples() + sampleCount, decoded.getSamples()))
+					mismatches++;
+
+				mismatches += countMipMismatches(left, decodedLeft) + countMipMismatches(right, decodedRight);
+				music.dispose();
+				state.resumeTiming();
+			}
+
+			state.setCounter("mismatches", static_cast<double>(mismatches));
+			decoded.dispose();
+			cache.clear();
+		});
+	}
+
+	void addEditorBenchmarks(BenchmarkRunner& runner, const std::string& appDir)
+	{
+		for (int size : benchmarkScoreSizes)
+			addPreviewBenchmarks(runner, size);
+
+		addParticleBenchmarks(runner, appDir);
+
+		for (int count : benchmarkQuadCounts)
+			addRenderBenchmarks(runner, count);
+
+		addMusicBenchmarks(runner);
+		addWaveformBenchmarks(runner);
+		addMusicCacheBenchmarks(runner);
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "Benchmark.h"
+
+namespace Debug
+{
+	/// <summary>
+	/// Adds the benchmarks of the editor's preview, rendering and audio, which only build with the editor:
+	/// preview draw data, particle updates, quad sorting, music loading, waveforms and the music cache
+	/// </summary>
+	void addEditorBenchmarks(BenchmarkRunner& runner, const std::string& appDir);
+}
@@ -0,0 +1,311 @@
+#include "EffectBaker.h"
+#include "EffectView.h"
+#include "ResourceManager.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace MikuMikuWorld::Effect
+{
+	static uint32_t packColor(const Color& color)
+	{
+		auto toByte = [](float value) { return static_cast<int>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f); };
+		return static_cast<uint32_t>(Color::rgbaToInt(toByte(color.r), toByte(color.g), toByte(color.b), toByte(color.a)));
+	}
+
+	EffectBaker::~EffectBaker()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+			++generation;
+		}
+
+		workAvailable.notify_all();
+		if (worker.joinable())
+			worker.join();
+	}
+
+	void EffectBaker::setMemoryLimit(size_t bytes)
+	{
+		if (bytes == memoryLimit)
+			return;
+
+		clear();
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		memoryLimit = bytes;
+		arena.reset(new uint8_t[bytes]);
+	}
+
+	void EffectBaker::request(std::vector<BakeNoteRequest> notes, const Camera& camera)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			pending.clear();
+			requestedNotes.clear();
+			for (auto& note : notes)
+			{
+				requestedNotes.insert(note.noteID);
+				if (bakedEffects.find(note.noteID) == bakedEffects.end())
+					pending.push_back(std::move(note));
+			}
+
+			this->camera = camera;
+			memoryFull = false;
+
+			if (!worker.joinable())
+				worker = std::thread(&EffectBaker::workerMain, this);
+		}
+
+		workAvailable.notify_one();
+	}
+
+	void EffectBaker::clear()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		++generation;
+		pending.clear();
+		requestedNotes.clear();
+		dropAll();
+
+		bakeFinished.wait(lock, [this] { return !baking; });
+	}
+
+	bool EffectBaker::isBaked(int noteID) const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return bakedEffects.find(noteID) != bakedEffects.end();
+	}
+
+	size_t EffectBaker::getBakedCount() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return bakedEffects.size();
+	}
+
+	size_t EffectBaker::getPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return pending.size();
+	}
+
+	size_t EffectBaker::getMemoryUsed() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return memoryUsed;
+	}
+
+	bool EffectBaker::isMemoryFull() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return memoryFull;
+	}
+
+	void EffectBaker::workerMain()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		while (true)
+		{
+			workAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+			if (stopping)
+				return;
+
+			BakeNoteRequest note = std::move(pending.front());
+			pending.pop_front();
+			if (bakedEffects.find(note.noteID) != bakedEffects.end())
+				continue;
+
+			const uint64_t startGeneration = generation;
+			const Camera bakeCamera = camera;
+			baking = true;
+			lock.unlock();
+
+			float start{};
+			const bool baked = bakeNote(note, bakeCamera, startGeneration, start);
+
+			lock.lock();
+			baking = false;
+			if (baked && generation == startGeneration)
+				storeNote(note.noteID, start);
+
+			bakeFinished.notify_all();
+		}
+	}
+
+	bool EffectBaker::bakeNote(const BakeNoteRequest& note, const Camera& camera, uint64_t startGeneration, float& start)
+	{
+		struct PlayingEffect
+		{
+			EmitterInstance root;
+			float end{};
+			uint16_t firstEmitter{};
+		};
+
+		std::vector<PlayingEffect> effects(note.plays.size());
+		bakedFrameStarts.clear();
+		bakedParticles.clear();
+		bakedEmitters.clear();
+
+		start = note.plays.empty() ? 0 : std::numeric_limits<float>::max();
+		float end = note.plays.empty() ? 0 : std::numeric_limits<float>::lowest();
+		for (size_t i = 0; i < note.plays.size(); i++)
+		{
+			const BakeEffectPlay& play = note.plays[i];
+			PlayingEffect& effect = effects[i];
+
+			effect.root = createEmitterInstance(play.particleId);
+			effect.root.init(ResourceManager::getParticleEffect(play.particleId), Transform{});
+
+			// Each effect gets its own seed so the effects repeated over the lanes of a note don't all look the same
+			effect.root.start(play.start, note.seed + static_cast<uint32_t>(i) * 0x9E3779B9u);
+			effect.end = play.end == -1 ? effect.root.maxDuration : play.end;
+			if (play.restart >= 0)
+				effect.end = std::min(effect.end, play.restart);
+			effect.firstEmitter = static_cast<uint16_t>(bakedEmitters.size());
+			addEmitters(effect.root);
+
+			start = std::min(start, play.start);
+			end = std::max(end, effect.end);
+		}
+
+		const int frameCount = std::clamp(static_cast<int>(std::ceil((end - start) * FRAME_RATE)), 0, MAX_FRAME_COUNT);
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			if (generation != startGeneration)
+				return false;
+
+			const float time = start + frame / FRAME_RATE;
+			bakedFrameStarts.push_back(static_cast<uint32_t>(bakedParticles.size()));
+
+			// Same as the preview, an effect stops being updated and drawn once it ends
+			for (size_t i = 0; i < effects.size(); i++)
+			{
+				PlayingEffect& effect = effects[i];
+				if (time >= effect.end)
+					continue;
+
+				effect.root.update(time, note.plays[i].offset, camera);
+
+				uint16_t emitterIndex = effect.firstEmitter;
+				addParticles(effect.root, note.plays[i], emitterIndex);
+			}
+		}
+
+		bakedFrameStarts.push_back(static_cast<uint32_t>(bakedParticles.size()));
+		return true;
+	}
+
+	void EffectBaker::addEmitters(const EmitterInstance& emitter)
+	{
+		const Particle& ref = ResourceManager::getParticleEffect(emitter.getRefID());
+		bakedEmitters.push_back({ ref.ID, ref.order <= UNDER_NOTE_ORDER_THRESHOLD });
+
+		for (const auto& child : emitter.children)
+			addEmitters(child);
+	}
+
+	void EffectBaker::addParticles(const EmitterInstance& emitter, const BakeEffectPlay& play, uint16_t& emitterIndex)
+	{
+		const BakedEmitter& bakedEmitter = bakedEmitters[emitterIndex];
+		if (bakedEmitter.underNotes ? play.underNotes : play.overNotes)
+		{
+			const Particle& ref = ResourceManager::getParticleEffect(bakedEmitter.refID);
+			const ParticleStore& particles = emitter.particles;
+			for (int i = 0; i < emitter.getAliveCount(); i++)
+			{
+				BakedParticle& particle = bakedParticles.emplace_back();
+				DirectX::XMStoreFloat4x3(&particle.matrix, particles.matrix[i]);
+				particle.color = packColor(getParticleColor(particles, ref, i));
+				particle.frame = static_cast<uint16_t>(std::clamp(getParticleFrame(particles, ref, i), 0, 0xFFFF));
+				particle.emitter = emitterIndex;
+			}
+		}
+
+		emitterIndex++;
+		for (const auto& child : emitter.children)
+			addParticles(child, play, emitterIndex);
+	}
+
+	void EffectBaker::storeNote(int noteID, float start)
+	{
+		const size_t frameStartsSize = bakedFrameStarts.size() * sizeof(uint32_t);
+		const size_t particlesSize = bakedParticles.size() * sizeof(BakedParticle);
+
+		size_t offset{};
+		if (!allocate(frameStartsSize + particlesSize, offset))
+		{
+			// Memory is full of notes that were asked for. Wait for the next request to make room.
+			memoryFull = true;
+			pending.clear();
+			return;
+		}
+
+		std::memcpy(arena.get() + offset, bakedFrameStarts.data(), frameStartsSize);
+		std::memcpy(arena.get() + offset + frameStartsSize, bakedParticles.data(), particlesSize);
+
+		BakedNoteEffects& effects = bakedEffects[noteID];
+		effects.noteID = noteID;
+		effects.start = start;
+		effects.frameCount = static_cast<int>(bakedFrameStarts.size()) - 1;
+		effects.offset = offset;
+		effects.size = frameStartsSize + particlesSize;
+		effects.emitters = bakedEmitters;
+
+		bakeOrder.push_back(noteID);
+		memoryUsed += effects.size;
+	}
+
+	bool EffectBaker::allocate(size_t size, size_t& offset)
+	{
+		if (size > memoryLimit)
+			return false;
+
+		if (head + size > memoryLimit)
+		{
+			// The notes after the head are the oldest ones, they go before wrapping around
+			while (!bakeOrder.empty() && bakedEffects.at(bakeOrder.front()).offset >= head)
+			{
+				if (!dropOldest())
+					return false;
+			}
+
+			head = 0;
+		}
+
+		while (!bakeOrder.empty())
+		{
+			const BakedNoteEffects& oldest = bakedEffects.at(bakeOrder.front());
+			if (oldest.offset >= head + size || oldest.offset + oldest.size <= head)
+				break;
+
+			if (!dropOldest())
+				return false;
+		}
+
+		offset = head;
+		head += size;
+		return true;
+	}
+
+	bool EffectBaker::dropOldest()
+	{
+		const int noteID = bakeOrder.front();
+		if (requestedNotes.find(noteID) != requestedNotes.end())
+			return false;
+
+		memoryUsed -= bakedEffects.at(noteID).size;
+		bakedEffects.erase(noteID);
+		bakeOrder.pop_front();
+		return true;
+	}
+
+	void EffectBaker::dropAll()
+	{
+		bakedEffects.clear();
+		bakeOrder.clear();
+		memoryUsed = 0;
+		head = 0;
+		memoryFull = false;
+	}
+}
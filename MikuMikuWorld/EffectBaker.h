@@ -0,0 +1,195 @@
+#pragma once
+#include "Particle.h"
+#include "Rendering/Camera.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MikuMikuWorld::Effect
+{
+	/// <summary>
+	/// One effect played by a note, placed and timed the way the preview plays it
+	/// </summary>
+	struct BakeEffectPlay
+	{
+		int particleId{};
+		Transform offset{};
+		float start{};
+		float end{ -1 };
+
+		// When the next note plays the same lane effect on the same lane. The preview restarts the lane's
+		// controller then, so the effect is cut off there instead of overlapping with the next one.
+		float restart{ -1 };
+
+		// Which of the preview's effect passes draw this effect
+		bool underNotes{};
+		bool overNotes{};
+	};
+
+	struct BakeNoteRequest
+	{
+		int noteID{};
+		uint32_t seed{};
+		std::vector<BakeEffectPlay> plays;
+	};
+
+	/// <summary>
+	/// A particle as it is drawn in one frame of a baked effect
+	/// </summary>
+	struct BakedParticle
+	{
+		DirectX::XMFLOAT4X3 matrix;
+		uint32_t color; // RGBA8
+		uint16_t frame;
+		uint16_t emitter;
+
+		inline Color getColor() const
+		{
+			return Color(static_cast<uint8_t>(color >> 24), static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 8), static_cast<uint8_t>(color));
+		}
+	};
+
+	struct BakedEmitter
+	{
+		int refID{};
+		bool underNotes{};
+	};
+
+	/// <summary>
+	/// The location of a note's baked frames in the baker's memory
+	/// </summary>
+	struct BakedNoteEffects
+	{
+		int noteID{};
+		float start{};
+		int frameCount{};
+		size_t offset{};
+		size_t size{};
+
+		// Emitters of all the note's effects, in the order they are drawn
+		std::vector<BakedEmitter> emitters;
+	};
+
+	/// <summary>
+	/// Simulates the effects of notes on a background thread and keeps the particles of every frame,
+	/// so the preview can show the effects at any time without simulating them.
+	/// Baked frames are kept in a fixed block of memory and the oldest notes are dropped to make room for new ones.
+	/// </summary>
+	class EffectBaker
+	{
+	public:
+		static constexpr float FRAME_RATE = 60.f;
+		static constexpr int MAX_FRAME_COUNT = 300;
+
+		EffectBaker() = default;
+		EffectBaker(const EffectBaker&) = delete;
+		EffectBaker& operator=(const EffectBaker&) = delete;
+		~EffectBaker();
+
+		/// <summary>
+		/// Changes the memory used for baked frames, dropping all baked notes if the size changes
+		/// </summary>
+		void setMemoryLimit(size_t bytes);
+
+		/// <summary>
+		/// Replaces the notes waiting to be baked. Notes are baked in the given order and the baked notes in
+		/// the request are never dropped to make room, so baking stops once memory is full of requested notes.
+		/// </summary>
+		void request(std::vector<BakeNoteRequest> notes, const Camera& camera);
+
+		/// <summary>
+		/// Drops all baked and pending notes, waiting for the note being baked to be abandoned
+		/// </summary>
+		void clear();
+
+		bool isBaked(int noteID) const;
+		size_t getBakedCount() const;
+		size_t getPendingCount() const;
+		size_t getMemoryUsed() const;
+		inline size_t getMemoryLimit() const { return memoryLimit; }
+		bool isMemoryFull() const;
+
+		/// <summary>
+		/// Calls func(effects, particles, count) with the frame at the given time of every note playing its effects,
+		/// in the order the effects started. The particles are only valid during the call.
+		/// </summary>
+		template <typename Func>
+		void forEachFrame(float time, Func&& func) const
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			activeEffects.clear();
+			for (const auto& [noteID, effects] : bakedEffects)
+			{
+				const int frame = getFrameIndex(effects, time);
+				if (frame >= 0 && frame < effects.frameCount)
+					activeEffects.push_back(&effects);
+			}
+
+			std::sort(activeEffects.begin(), activeEffects.end(), [](const BakedNoteEffects* e1, const BakedNoteEffects* e2)
+			{
+				return e1->start != e2->start ? e1->start < e2->start : e1->noteID < e2->noteID;
+			});
+
+			for (const BakedNoteEffects* effects : activeEffects)
+			{
+				const uint32_t* frameStarts = reinterpret_cast<const uint32_t*>(arena.get() + effects->offset);
+				const BakedParticle* particles = reinterpret_cast<const BakedParticle*>(frameStarts + effects->frameCount + 1);
+				const int frame = getFrameIndex(*effects, time);
+
+				func(*effects, particles + frameStarts[frame], static_cast<size_t>(frameStarts[frame + 1] - frameStarts[frame]));
+			}
+		}
+
+	private:
+		mutable std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable bakeFinished;
+		std::thread worker;
+		bool stopping{ false };
+		bool baking{ false };
+
+		// Incremented by clear so the worker can abandon the note it is baking
+		std::atomic<uint64_t> generation{};
+
+		std::deque<BakeNoteRequest> pending;
+		std::unordered_set<int> requestedNotes;
+		Camera camera;
+
+		// Baked notes are allocated one after another and wrap around to the start of the arena,
+		// so the notes in bakeOrder are also in the order of their memory after the head
+		std::unique_ptr<uint8_t[]> arena;
+		size_t memoryLimit{};
+		size_t memoryUsed{};
+		size_t head{};
+		bool memoryFull{ false };
+		std::unordered_map<int, BakedNoteEffects> bakedEffects;
+		std::deque<int> bakeOrder;
+		mutable std::vector<const BakedNoteEffects*> activeEffects;
+
+		// Used by the worker only
+		std::vector<uint32_t> bakedFrameStarts;
+		std::vector<BakedParticle> bakedParticles;
+		std::vector<BakedEmitter> bakedEmitters;
+
+		static inline int getFrameIndex(const BakedNoteEffects& effects, float time)
+		{
+			return time < effects.start ? -1 : static_cast<int>((time - effects.start) * FRAME_RATE);
+		}
+
+		void workerMain();
+		bool bakeNote(const BakeNoteRequest& note, const Camera& camera, uint64_t startGeneration, float& start);
+		void addEmitters(const EmitterInstance& emitter);
+		void addParticles(const EmitterInstance& emitter, const BakeEffectPlay& play, uint16_t& emitterIndex);
+		void storeNote(int noteID, float start);
+		bool allocate(size_t size, size_t& offset);
+		bool dropOldest();
+		void dropAll();
+	};
+}
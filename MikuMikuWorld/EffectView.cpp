@@ -3,12 +3,18 @@
 #include "ResourceManager.h"
 #include "ScoreContext.h"
 #include "ApplicationConfiguration.h"
+#include "Stopwatch.h"
+#include <cstring>
 
 namespace MikuMikuWorld::Effect
 {
-	constexpr int UNDER_NOTE_ORDER_THRESHOLD = 5;
 	constexpr float EFFECT_WIDTH_RATIO = 0.84f;
 
+	// Notes are baked from a second before the current time so scrubbing back still finds them
+	constexpr float BAKE_WINDOW_BEHIND = 1.f;
+	constexpr float BAKE_WINDOW_AHEAD = 3.f;
+	constexpr float BAKE_REQUEST_INTERVAL = 0.25f;
+
 	static const std::map<EffectType, int> effectPoolSizes =
 	{
 		{ fx_note_normal_gen, 6 },
@@ -21,6 +27,34 @@ namespace MikuMikuWorld::Effect
 		{ fx_note_critical_flick_flash, 6 },
 	};
 
+	static constexpr EffectType underNoteEffects[] =
+	{
+		fx_lane_critical,
+		fx_lane_critical_flick,
+		fx_lane_default,
+		fx_note_critical_flick_aura,
+		fx_note_critical_long_aura,
+		fx_note_critical_normal_aura,
+		fx_note_flick_aura,
+		fx_note_long_aura,
+		fx_note_normal_aura
+	};
+
+	static bool isUnderNoteEffect(EffectType type)
+	{
+		return std::find(std::begin(underNoteEffects), std::end(underNoteEffects), type) != std::end(underNoteEffects);
+	}
+
+	static bool isOverNoteEffect(EffectType type)
+	{
+		return type >= fx_note_normal_gen;
+	}
+
+	static uint32_t getNoteEffectSeed(const Note& note)
+	{
+		return static_cast<uint32_t>(note.tick) * 2654435761u ^ static_cast<uint32_t>(note.lane << 8 | note.width);
+	}
+
 	static float getEffectXPos(int lane, int width, bool flip)
 	{
 		if (flip)
@@ -44,7 +78,7 @@ namespace MikuMikuWorld::Effect
 		return std::make_pair(left, right);
 	}
 
-	static std::pair<float, float> getHoldSegmentBound(const Note& note, const Score& score, int curTick)
+	static std::pair<float, float> getHoldSegmentBound(const Note& note, const Score& score, const TempoMap& tempoMap, int curTick)
 	{
 		const HoldNote& holdNotes = score.holdNotes.at(note.ID);
 		auto curStepIt = std::lower_bound(holdNotes.steps.begin(), holdNotes.steps.end(), curTick, [&score](const HoldStep& step, int tick) { return score.notes.at(step.ID).tick < tick; });
@@ -61,9 +95,9 @@ namespace MikuMikuWorld::Effect
 		auto [leftStop, rightStop] = getNoteBound(endNote, config.pvMirrorScore);
 		auto easeFunc = getEaseFunction(startHoldStep.ease);
 
-		float start_tm = accumulateDuration(startNote.tick, TICKS_PER_BEAT, score.tempoChanges);
-		float end_tm = accumulateDuration(endNote.tick, TICKS_PER_BEAT, score.tempoChanges);
-		float current_tm = accumulateDuration(curTick, TICKS_PER_BEAT, score.tempoChanges);
+		float start_tm = tempoMap.ticksToSeconds(startNote.tick);
+		float end_tm = tempoMap.ticksToSeconds(endNote.tick);
+		float current_tm = tempoMap.ticksToSeconds(curTick);
 		float progress = unlerp(start_tm, end_tm, current_tm);
 
 		return std::make_pair(
@@ -72,7 +106,7 @@ namespace MikuMikuWorld::Effect
 		);
 	}
 
-	static std::pair<float, float> getHoldStepBound(const Note& note, const Score& score)
+	static std::pair<float, float> getHoldStepBound(const Note& note, const Score& score, const TempoMap& tempoMap)
 	{
 		auto& holdNotes = score.holdNotes.at(note.parentID);
 		int curStepIdx = findHoldStep(holdNotes, note.ID);
@@ -92,9 +126,9 @@ namespace MikuMikuWorld::Effect
 		const Note& endNote = score.notes.at(it == holdNotes.steps.end() ? holdNotes.end : it->ID);
 		auto [leftStop, rightStop] = getNoteBound(endNote, config.pvMirrorScore);
 
-		float start_tm = accumulateDuration(startNote.tick, TICKS_PER_BEAT, score.tempoChanges);
-		float end_tm = accumulateDuration(endNote.tick, TICKS_PER_BEAT, score.tempoChanges);
-		float current_tm = accumulateDuration(note.tick, TICKS_PER_BEAT, score.tempoChanges);
+		float start_tm = tempoMap.ticksToSeconds(startNote.tick);
+		float end_tm = tempoMap.ticksToSeconds(endNote.tick);
+		float current_tm = tempoMap.ticksToSeconds(note.tick);
 		float progress = unlerp(start_tm, end_tm, current_tm);
 
 		return std::make_pair(
@@ -103,6 +137,34 @@ namespace MikuMikuWorld::Effect
 		);
 	}
 
+	EmitterInstance createEmitterInstance(int particleId)
+	{
+		const Effect::Particle& p = ResourceManager::getParticleEffect(particleId);
+
+		EmitterInstance emitter{};
+		for (const int child : p.children)
+		{
+			emitter.children.emplace_back(createEmitterInstance(child));
+		}
+
+		return emitter;
+	}
+
+	int getParticleFrame(const ParticleStore& particles, const Particle& ref, size_t index)
+	{
+		float normalizedTime = particles.time[index] / particles.duration[index];
+
+		int frame = ref.textureSplitX * ref.textureSplitY * ref.startFrame.evaluate(particles.time[index], particles.spriteSheetLerpRatio[index]);
+		frame += ref.textureSplitX * ref.textureSplitY * ref.frameOverTime.evaluate(normalizedTime, particles.spriteSheetLerpRatio[index]);
+		return frame;
+	}
+
+	Color getParticleColor(const ParticleStore& particles, const Particle& ref, size_t index)
+	{
+		float normalizedTime = particles.time[index] / particles.duration[index];
+		return particles.startColor[index] * ref.colorOverLifetime.evaluate(normalizedTime, particles.colorLerpRatio[index]);
+	}
+
 	void ParticleController::play(const Note& note, float start, float end)
 	{
 		active = true;
@@ -137,34 +199,21 @@ namespace MikuMikuWorld::Effect
 		const Transform transform{};
 		for (auto& instance : pool)
 		{
-			instance.effectRoot = createEmitterFromParticle(particleId);
+			instance.effectRoot = createEmitterInstance(particleId);
 			instance.effectRoot.init(ref, transform);
 		}
 	}
 
-	EmitterInstance EffectPool::createEmitterFromParticle(int particleId)
-	{
-		const Effect::Particle& p = ResourceManager::getParticleEffect(particleId);
-
-		EmitterInstance emitter{};
-		for (const int child : p.children)
-		{
-			emitter.children.emplace_back(createEmitterFromParticle(child));
-		}
-
-		return emitter;
-	}
-
 	void EffectView::update(const ScoreContext& context)
 	{
 		const float currentTime = context.getTimeAtCurrentTick();
-		const int startTick = accumulateTicks(currentTime - 0.04f, TICKS_PER_BEAT, context.score.tempoChanges);
-		const int endTick = accumulateTicks(currentTime + 0.08f, TICKS_PER_BEAT, context.score.tempoChanges);
+		const int startTick = context.tempoMap.secondsToTicks(currentTime - 0.04f);
+		const int endTick = context.tempoMap.secondsToTicks(currentTime + 0.08f);
 
-		const auto& viewBoundary = context.scorePreviewDrawData.notesList.getTickRange(startTick, endTick);
+		context.scorePreviewDrawData.notesList.getTickRange(startTick, endTick, visibleNotes);
 		const auto& notesList = context.scorePreviewDrawData.notesList.getView();
 
-		for (int i : viewBoundary)
+		for (int i : visibleNotes)
 		{
 			const auto& drawingNote = notesList.at(i);
 			if (isNoteEffectPlayed(drawingNote.refID))
@@ -190,6 +239,7 @@ namespace MikuMikuWorld::Effect
 
 	void EffectView::init()
 	{
+		clearBakedEffects();
 		effectPools.clear();
 		for (int i = 0; i < fx_count; i++)
 		{
@@ -219,9 +269,35 @@ namespace MikuMikuWorld::Effect
 				controller.stop();
 
 		playedEffectsNoteIds.clear();
+		liveEffectsNoteIds.clear();
+	}
+
+	void EffectView::clearBakedEffects()
+	{
+		baker.clear();
+		bakedDrawGeneration = -1;
+		bakeRequested = false;
 	}
 
 	void EffectView::addNoteEffects(const Note& note, const ScoreContext& context, float time)
+	{
+		notePlays.clear();
+		getNoteEffectPlays(note, context, time, notePlays);
+
+		// Effects that stay in place are drawn from their baked frames. Notes reached before the baker
+		// got to them are played live and their baked frames are skipped until the next reset.
+		const bool baked = config.pvBakeEffects && baker.isBaked(note.ID);
+		if (config.pvBakeEffects && !baked)
+			liveEffectsNoteIds.insert(note.ID);
+
+		for (const EffectPlay& play : notePlays)
+		{
+			if (!baked || play.type >= fx_note_hold_aura)
+				playEffect(play, note);
+		}
+	}
+
+	void EffectView::getNoteEffectPlays(const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const
 	{
 		if (note.friction)
 		{
@@ -230,18 +306,18 @@ namespace MikuMikuWorld::Effect
 			{
 				traceEffect = note.critical ? fx_note_critical_flick_flash : fx_note_flick_flash;
 				if (note.critical)
-					addLaneEffect(fx_lane_critical_flick, note, context, time);
+					addLaneEffect(fx_lane_critical_flick, note, context, time, plays);
 			}
 			else
 			{
 				traceEffect = note.critical ? fx_note_critical_trace_aura : fx_note_trace_aura;
 			}
 
-			addEffect(traceEffect, note, context, time);
+			addEffect(traceEffect, note, context, time, plays);
 			if (note.getType() == NoteType::Hold)
 			{
-				addEffect(note.critical ? fx_note_critical_long_hold_gen : fx_note_long_hold_gen, note, context, time);
-				addAuraEffect(note.critical ? fx_note_critical_long_hold_gen_aura : fx_note_hold_aura, note, context, time);
+				addEffect(note.critical ? fx_note_critical_long_hold_gen : fx_note_long_hold_gen, note, context, time, plays);
+				addAuraEffect(note.critical ? fx_note_critical_long_hold_gen_aura : fx_note_hold_aura, note, context, time, plays);
 			}
 			return;
 		}
@@ -252,12 +328,12 @@ namespace MikuMikuWorld::Effect
 			EffectType gen{ note.critical ? fx_note_critical_flick_gen : fx_note_flick_gen };
 			EffectType flash{ note.critical ? fx_note_critical_flick_flash : fx_note_flick_flash };
 
-			addAuraEffect(aura, note, context, time);
-			addEffect(gen, note, context, time);
-			addEffect(flash, note, context, time);
+			addAuraEffect(aura, note, context, time, plays);
+			addEffect(gen, note, context, time, plays);
+			addEffect(flash, note, context, time, plays);
 
 			if (note.critical)
-				addLaneEffect(fx_lane_critical_flick, note, context, time);
+				addLaneEffect(fx_lane_critical_flick, note, context, time, plays);
 
 			return;
 		}
@@ -274,13 +350,13 @@ namespace MikuMikuWorld::Effect
 				EffectType gen{ note.critical ? fx_note_critical_long_gen : fx_note_long_gen };
 				EffectType lane{ note.critical ? fx_lane_critical : fx_lane_default };
 				
-				addAuraEffect(aura, note, context, time);
-				addEffect(gen, note, context, time);
-				addLaneEffect(lane, note, context, time);
+				addAuraEffect(aura, note, context, time, plays);
+				addEffect(gen, note, context, time, plays);
+				addLaneEffect(lane, note, context, time, plays);
 			}
 
-			addEffect(note.critical ? fx_note_critical_long_hold_gen : fx_note_long_hold_gen, note, context, time);
-			addAuraEffect(note.critical ? fx_note_critical_long_hold_gen_aura : fx_note_hold_aura, note, context, time);
+			addEffect(note.critical ? fx_note_critical_long_hold_gen : fx_note_long_hold_gen, note, context, time, plays);
+			addAuraEffect(note.critical ? fx_note_critical_long_hold_gen_aura : fx_note_hold_aura, note, context, time, plays);
 		}
 		else if (note.getType() == NoteType::HoldMid)
 		{
@@ -290,7 +366,7 @@ namespace MikuMikuWorld::Effect
 			if (step.type == HoldStepType::Hidden)
 				return;
 
-			addEffect(note.critical ? fx_note_critical_long_hold_via_aura : fx_note_long_hold_via_aura, note, context, time);
+			addEffect(note.critical ? fx_note_critical_long_hold_via_aura : fx_note_long_hold_via_aura, note, context, time, plays);
 		}
 		else if (note.getType() == NoteType::HoldEnd)
 		{
@@ -304,9 +380,9 @@ namespace MikuMikuWorld::Effect
 				EffectType gen{ note.critical ? fx_note_critical_long_gen : fx_note_long_gen };
 				EffectType lane{ note.critical ? fx_lane_critical : fx_lane_default };
 
-				addAuraEffect(aura, note, context, time);
-				addEffect(gen, note, context, time);
-				addLaneEffect(lane, note, context, time);
+				addAuraEffect(aura, note, context, time, plays);
+				addEffect(gen, note, context, time, plays);
+				addLaneEffect(lane, note, context, time, plays);
 			}
 		}
 		else
@@ -315,17 +391,14 @@ namespace MikuMikuWorld::Effect
 			EffectType gen{ note.critical ? fx_note_critical_normal_gen : fx_note_normal_gen };
 			EffectType lane{ note.critical ? fx_lane_critical : fx_lane_default };
 
-			addAuraEffect(aura, note, context, time);
-			addEffect(gen, note, context, time);
-			addLaneEffect(lane, note, context, time);
+			addAuraEffect(aura, note, context, time, plays);
+			addEffect(gen, note, context, time, plays);
+			addLaneEffect(lane, note, context, time, plays);
 		}
 	}
 
-	void EffectView::addEffect(EffectType effect, const Note& note, const ScoreContext& context, float time)
+	void EffectView::addEffect(EffectType effect, const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const
 	{
-		EffectPool& pool = effectPools[effect];
-		ParticleController& controller = pool.getNext();
-
 		float xPos = getEffectNoteCenter(note, config.pvMirrorScore);
 		float zRot = 0.f;
 		float start = time;
@@ -353,71 +426,174 @@ namespace MikuMikuWorld::Effect
 			const HoldStep& step = hold.steps[findHoldStep(hold, note.ID)];
 
 			float noteLeft{}, noteRight{};
-			std::tie(noteLeft, noteRight) = getHoldStepBound(note, context.score);
+			std::tie(noteLeft, noteRight) = getHoldStepBound(note, context.score, context.tempoMap);
 
 			xPos = noteLeft + (noteRight - noteLeft) / 2;
 		}
 		else if (effect == fx_note_critical_long_hold_gen || effect == fx_note_long_hold_gen)
 		{
 			const HoldNote& holdNote = context.score.holdNotes.at(note.ID);
-			start = accumulateDuration(note.tick, TICKS_PER_BEAT, context.score.tempoChanges);
-			end = accumulateDuration(context.score.notes.at(holdNote.end).tick, TICKS_PER_BEAT, context.score.tempoChanges);
+			start = context.tempoMap.ticksToSeconds(note.tick);
+			end = context.tempoMap.ticksToSeconds(context.score.notes.at(holdNote.end).tick);
 			if (abs(end - start) < 0.01f)
 				return;
 
 			float noteLeft{}, noteRight{};
-			std::tie(noteLeft, noteRight) = getHoldSegmentBound(note, context.score, context.currentTick);
+			std::tie(noteLeft, noteRight) = getHoldSegmentBound(note, context.score, context.tempoMap, context.currentTick);
 
 			xPos = noteLeft + (noteRight - noteLeft) / 2;
 		}
 
-		controller.worldOffset.position = DirectX::XMVectorSetX(controller.worldOffset.position, xPos * EFFECT_WIDTH_RATIO);
-		controller.worldOffset.rotation = DirectX::XMVectorSetZ(controller.worldOffset.rotation, zRot);
-		controller.play(note, start, end);
+		plays.push_back({ effect, -1, xPos * EFFECT_WIDTH_RATIO, zRot, start, end });
 	}
 
-	void EffectView::addAuraEffect(EffectType effect, const Note& note, const ScoreContext& context, float time)
+	void EffectView::addAuraEffect(EffectType effect, const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const
 	{
 		if (effect == fx_note_hold_aura || effect == fx_note_critical_long_hold_gen_aura)
 		{
 			const HoldNote& holdNote = context.score.holdNotes.at(note.ID);
-			float start = accumulateDuration(note.tick, TICKS_PER_BEAT, context.score.tempoChanges);
-			float end = accumulateDuration(context.score.notes.at(holdNote.end).tick, TICKS_PER_BEAT, context.score.tempoChanges);
+			float start = context.tempoMap.ticksToSeconds(note.tick);
+			float end = context.tempoMap.ticksToSeconds(context.score.notes.at(holdNote.end).tick);
 			if (abs(end - start) < 0.01f)
 				return;
 
 			float noteLeft{}, noteRight{};
-			std::tie(noteLeft, noteRight) = getHoldSegmentBound(note, context.score, context.currentTick);
-
-			ParticleController& controller = effectPools[effect].getNext();
-			controller.worldOffset.position = DirectX::XMVectorSetX(controller.worldOffset.position, noteLeft + (noteRight - noteLeft) / 2);
-			controller.play(note, start, end);
+			std::tie(noteLeft, noteRight) = getHoldSegmentBound(note, context.score, context.tempoMap, context.currentTick);
 
+			plays.push_back({ effect, -1, noteLeft + (noteRight - noteLeft) / 2, 0, start, end });
 			return;
 		}
 
-		EffectPool& pool = effectPools[effect];
 		for (int i = note.lane; i < note.lane + note.width; i++)
-		{
-			ParticleController& controller = pool.getNext();
-			controller.worldOffset.position = DirectX::XMVectorSetX(controller.worldOffset.position, getEffectXPos(i, 1, config.pvMirrorScore));
-			controller.play(note, time, -1);
-		}
+			plays.push_back({ effect, -1, getEffectXPos(i, 1, config.pvMirrorScore), 0, time, -1 });
 	}
 
-	void EffectView::addLaneEffect(EffectType effect, const Note& note, const ScoreContext& context, float time)
+	void EffectView::addLaneEffect(EffectType effect, const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const
 	{
-		EffectPool& pool = effectPools[effect];
 		for (int i = note.lane; i < note.lane + note.width; i++)
+			plays.push_back({ effect, i, getEffectXPos(i, 1, config.pvMirrorScore), 0, time, -1 });
+	}
+
+	void EffectView::playEffect(const EffectPlay& play, const Note& note)
+	{
+		EffectPool& pool = effectPools[play.type];
+		ParticleController& controller = play.lane >= 0 ? pool.pool[play.lane] : pool.getNext();
+
+		controller.worldOffset.position = DirectX::XMVectorSetX(controller.worldOffset.position, play.xPosition);
+		controller.worldOffset.rotation = DirectX::XMVectorSetZ(controller.worldOffset.rotation, play.zRotation);
+		controller.play(note, play.start, play.end);
+	}
+
+	void EffectView::updateBaking(const ScoreContext& context, const Camera& camera, float time)
+	{
+		if (!config.pvBakeEffects)
 		{
-			ParticleController& controller = pool.pool[i];
-			controller.worldOffset.position = DirectX::XMVectorSetX(controller.worldOffset.position, getEffectXPos(i, 1, config.pvMirrorScore));
-			controller.play(note, time, -1);
+			if (bakeRequested)
+				clearBakedEffects();
+
+			return;
+		}
+
+		baker.setMemoryLimit(static_cast<size_t>(std::max(config.pvEffectsBakeMemory, 1)) << 20);
+
+		// The baked frames depend on the notes, where they are drawn and how the particles face the camera
+		const Engine::DrawData& drawData = context.scorePreviewDrawData;
+		DirectX::XMFLOAT4X4 cameraView{};
+		DirectX::XMStoreFloat4x4(&cameraView, camera.getViewMatrix());
+		if (drawData.generation != bakedDrawGeneration || config.pvMirrorScore != bakedMirror ||
+			memcmp(&cameraView, &bakedCameraView, sizeof(cameraView)) != 0)
+		{
+			clearBakedEffects();
+			bakedDrawGeneration = drawData.generation;
+			bakedMirror = config.pvMirrorScore;
+			bakedCameraView = cameraView;
+		}
+
+		if (bakeRequested && std::abs(time - lastBakeRequestTime) < BAKE_REQUEST_INTERVAL)
+			return;
+
+		const int startTick = context.tempoMap.secondsToTicks(time - BAKE_WINDOW_BEHIND);
+		const int endTick = context.tempoMap.secondsToTicks(time + BAKE_WINDOW_AHEAD);
+		const auto& notesList = drawData.notesList.getView();
+
+		// Lane effects of the notes up to the longest effect after the window, to find where each one is restarted
+		for (auto& [lane, starts] : laneEffectStarts)
+			starts.clear();
+
+		const float laneWindowEnd = time + BAKE_WINDOW_AHEAD + EffectBaker::MAX_FRAME_COUNT / EffectBaker::FRAME_RATE;
+		drawData.notesList.getTickRange(startTick, context.tempoMap.secondsToTicks(laneWindowEnd), bakeWindowNotes);
+		for (int i : bakeWindowNotes)
+		{
+			const auto& drawingNote = notesList.at(i);
+			notePlays.clear();
+			getNoteEffectPlays(context.score.notes.at(drawingNote.refID), context, drawingNote.time, notePlays);
+			for (const EffectPlay& play : notePlays)
+			{
+				if (play.lane >= 0)
+					laneEffectStarts[{ play.type, play.lane }].push_back(play.start);
+			}
+		}
+
+		for (auto& [lane, starts] : laneEffectStarts)
+			std::sort(starts.begin(), starts.end());
+
+		drawData.notesList.getTickRange(startTick, endTick, bakeWindowNotes);
+
+		// Bake the notes closest to the current time first
+		std::sort(bakeWindowNotes.begin(), bakeWindowNotes.end(), [&notesList, time](int n1, int n2)
+		{
+			return std::abs(notesList.at(n1).time - time) < std::abs(notesList.at(n2).time - time);
+		});
+
+		std::vector<BakeNoteRequest> requests;
+		requests.reserve(bakeWindowNotes.size());
+		for (int i : bakeWindowNotes)
+		{
+			const auto& drawingNote = notesList.at(i);
+			const Note& note = context.score.notes.at(drawingNote.refID);
+
+			notePlays.clear();
+			getNoteEffectPlays(note, context, drawingNote.time, notePlays);
+
+			BakeNoteRequest& request = requests.emplace_back();
+			request.noteID = note.ID;
+			request.seed = getNoteEffectSeed(note);
+			for (const EffectPlay& play : notePlays)
+			{
+				if (play.type >= fx_note_hold_aura)
+					continue;
+
+				BakeEffectPlay& bakePlay = request.plays.emplace_back();
+				bakePlay.particleId = ResourceManager::getRootParticleIdByName(effectNames[static_cast<int>(play.type)]);
+				bakePlay.offset.position = DirectX::XMVectorSetX(bakePlay.offset.position, play.xPosition);
+				bakePlay.offset.rotation = DirectX::XMVectorSetZ(bakePlay.offset.rotation, play.zRotation);
+				bakePlay.start = play.start;
+				bakePlay.end = play.end;
+				if (play.lane >= 0)
+				{
+					const std::vector<float>& starts = laneEffectStarts[{ play.type, play.lane }];
+					auto next = std::upper_bound(starts.begin(), starts.end(), play.start);
+					if (next != starts.end())
+						bakePlay.restart = *next;
+				}
+				bakePlay.underNotes = isUnderNoteEffect(play.type);
+				bakePlay.overNotes = isOverNoteEffect(play.type);
+			}
 		}
+
+		baker.request(std::move(requests), camera);
+		lastBakeRequestTime = time;
+		bakeRequested = true;
 	}
 
 	void EffectView::updateEffects(const ScoreContext& context, const Camera& camera, float time)
 	{
+		updateBaking(context, camera, time);
+
+		Stopwatch updateTimer;
+		updatePool.setThreadCount(config.pvEffectsThreadCount > 0 ? config.pvEffectsThreadCount : ThreadPool::getDefaultThreadCount());
+		updatingControllers.clear();
+
 		for (size_t i = 0; i < fx_note_hold_aura; i++)
 		{
 			for (auto& controller : effectPools[static_cast<EffectType>(i)].pool)
@@ -426,7 +602,7 @@ namespace MikuMikuWorld::Effect
 					controller.active = false;
 
 				if (controller.active)
-					controller.effectRoot.update(time, controller.worldOffset, camera);
+					updatingControllers.push_back(&controller);
 			}
 		}
 
@@ -441,7 +617,7 @@ namespace MikuMikuWorld::Effect
 					continue;
 
 				float noteLeft{}, noteRight{};
-				std::tie(noteLeft, noteRight) = getHoldSegmentBound(context.score.notes.at(controller.refID), context.score, context.currentTick);
+				std::tie(noteLeft, noteRight) = getHoldSegmentBound(context.score.notes.at(controller.refID), context.score, context.tempoMap, context.currentTick);
 
 				if (static_cast<EffectType>(i) == fx_note_hold_aura ||
 					static_cast<EffectType>(i) == fx_note_critical_long_hold_gen_aura)
@@ -450,25 +626,25 @@ namespace MikuMikuWorld::Effect
 				}
 
 				controller.worldOffset.position = DirectX::XMVectorSetX(controller.worldOffset.position, (noteLeft + (noteRight - noteLeft) / 2) * EFFECT_WIDTH_RATIO);
-				controller.effectRoot.update(time, controller.worldOffset, camera);
+				updatingControllers.push_back(&controller);
 			}
 		}
+
+		// Only the emitters are updated in parallel. Every controller's offset is final by now and
+		// the effects are still drawn in pool order, so the result does not depend on the thread count.
+		updatePool.parallelFor(updatingControllers.size(), [this, time, &camera](size_t index)
+		{
+			ParticleController& controller = *updatingControllers[index];
+			controller.effectRoot.update(time, controller.worldOffset, camera);
+		});
+
+		updateTime = updateTimer.elapsed();
 	}
 
 	void EffectView::drawUnderNoteEffects(Renderer* renderer, float time)
 	{
-		static constexpr EffectType underNoteEffects[] =
-		{
-			fx_lane_critical,
-			fx_lane_critical_flick,
-			fx_lane_default,
-			fx_note_critical_flick_aura,
-			fx_note_critical_long_aura,
-			fx_note_critical_normal_aura,
-			fx_note_flick_aura,
-			fx_note_long_aura,
-			fx_note_normal_aura
-		};
+		if (config.pvBakeEffects)
+			drawBakedEffects(renderer, time, true);
 
 		for (auto& effect : underNoteEffects)
 		{
@@ -482,6 +658,9 @@ namespace MikuMikuWorld::Effect
 
 	void EffectView::drawEffects(Renderer* renderer, float time)
 	{
+		if (config.pvBakeEffects)
+			drawBakedEffects(renderer, time, false);
+
 		std::vector<ParticleController*> drawingControllers;
 		for (int i = 3; i < fx_count; i++)
 		{
@@ -519,22 +698,44 @@ namespace MikuMikuWorld::Effect
 			drawEffectsInternal(child, renderer, time);
 	}
 
-	void EffectView::drawParticles(const std::vector<ParticleInstance>& particles, const Particle& ref, size_t count, Renderer* renderer, float time) const
+	void EffectView::drawParticles(const ParticleStore& particles, const Particle& ref, size_t count, Renderer* renderer, float time) const
 	{
 		int flipUVs = ref.renderMode == RenderMode::StretchedBillboard ? 1 : 0;
 		float blend = ref.blend == BlendMode::Additive ? 1.f : 0.f;
 
 		for (size_t i = 0; i < count; i++)
 		{
-			const auto& p = particles.at(i);
-			float normalizedTime = p.time / p.duration;
+			int frame = getParticleFrame(particles, ref, i);
+			Color color = getParticleColor(particles, ref, i);
+
+			renderer->drawQuadWithBlend(particles.matrix[i], *effectsTex, ref.textureSplitX, ref.textureSplitY, frame, color, ref.order, blend, flipUVs);
+		}
+	}
+
+	void EffectView::drawBakedEffects(Renderer* renderer, float time, bool underNotes)
+	{
+		baker.forEachFrame(time, [this, renderer, underNotes](const BakedNoteEffects& effects, const BakedParticle* particles, size_t count)
+		{
+			if (liveEffectsNoteIds.find(effects.noteID) != liveEffectsNoteIds.end())
+				return;
 
-			int frame = ref.textureSplitX * ref.textureSplitY * ref.startFrame.evaluate(p.time, p.spriteSheetLerpRatio);
-			frame += ref.textureSplitX * ref.textureSplitY * ref.frameOverTime.evaluate(normalizedTime, p.spriteSheetLerpRatio);
+			bakedEmitterRefs.clear();
+			for (const BakedEmitter& emitter : effects.emitters)
+				bakedEmitterRefs.push_back(&ResourceManager::getParticleEffect(emitter.refID));
 
-			Color color = p.startColor * ref.colorOverLifetime.evaluate(normalizedTime, p.colorLerpRatio);
+			for (size_t i = 0; i < count; i++)
+			{
+				const BakedParticle& particle = particles[i];
+				if (effects.emitters[particle.emitter].underNotes != underNotes)
+					continue;
 
-			renderer->drawQuadWithBlend(p.matrix, *effectsTex, ref.textureSplitX, ref.textureSplitY, frame, color, ref.order, blend, flipUVs);
-		}
+				const Particle& ref = *bakedEmitterRefs[particle.emitter];
+				int flipUVs = ref.renderMode == RenderMode::StretchedBillboard ? 1 : 0;
+				float blend = ref.blend == BlendMode::Additive ? 1.f : 0.f;
+
+				renderer->drawQuadWithBlend(DirectX::XMLoadFloat4x3(&particle.matrix), *effectsTex,
+					ref.textureSplitX, ref.textureSplitY, particle.frame, particle.getColor(), ref.order, blend, flipUVs);
+			}
+		});
 	}
 }
\ No newline at end of file
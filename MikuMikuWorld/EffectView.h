@@ -2,8 +2,10 @@
 #include "Particle.h"
 #include "Rendering/Renderer.h"
 #include "Rendering/Camera.h"
+#include "ThreadPool.h"
+#include "EffectBaker.h"
 #include <map>
-#include <set>
+#include <unordered_set>
 
 namespace MikuMikuWorld
 {
@@ -91,6 +93,27 @@ namespace MikuMikuWorld::Effect
 		"fx_note_critical_long_hold_gen",
 	};
 
+	constexpr int UNDER_NOTE_ORDER_THRESHOLD = 5;
+
+	/// <summary>
+	/// An effect started by a note, with where and when the preview plays it
+	/// </summary>
+	struct EffectPlay
+	{
+		EffectType type{};
+
+		// Lane effects always play on the controller of their lane
+		int lane{ -1 };
+		float xPosition{};
+		float zRotation{};
+		float start{};
+		float end{ -1 };
+	};
+
+	EmitterInstance createEmitterInstance(int particleId);
+	int getParticleFrame(const ParticleStore& particles, const Particle& ref, size_t index);
+	Color getParticleColor(const ParticleStore& particles, const Particle& ref, size_t index);
+
 	struct ParticleController
 	{
 		int refID{};
@@ -124,17 +147,17 @@ namespace MikuMikuWorld::Effect
 		EffectType type{};
 		int count{};
 		int next{};
-
-		EmitterInstance createEmitterFromParticle(int particleId);
 	};
 
 	class EffectView
 	{
 	public:
 		void addNoteEffects(const Note& note, const ScoreContext& context, float time);
-		void addEffect(EffectType effect, const Note& note, const ScoreContext& context, float time);
-		void addAuraEffect(EffectType effect, const Note& note, const ScoreContext& context, float time);
-		void addLaneEffect(EffectType effect, const Note& note, const ScoreContext& context, float time);
+
+		/// <summary>
+		/// Gets the effects a note plays when hit at the given time, without playing them
+		/// </summary>
+		void getNoteEffectPlays(const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const;
 
 		void drawUnderNoteEffects(Renderer* renderer, float time);
 		void updateEffects(const ScoreContext& context, const Camera& camera, float time);
@@ -143,6 +166,11 @@ namespace MikuMikuWorld::Effect
 
 		void reset();
 
+		/// <summary>
+		/// Drops the baked effects. Must be called before the particle effects they were baked from are unloaded.
+		/// </summary>
+		void clearBakedEffects();
+
 		void init();
 		inline bool isInitialized() const { return initialized; }
 
@@ -151,14 +179,47 @@ namespace MikuMikuWorld::Effect
 			return playedEffectsNoteIds.find(noteId) != playedEffectsNoteIds.end();
 		}
 
+		inline int getUpdateThreadCount() const { return updatePool.getThreadCount(); }
+		inline int getUpdatedEffectCount() const { return static_cast<int>(updatingControllers.size()); }
+		inline double getUpdateTime() const { return updateTime; }
+		inline const EffectBaker& getBaker() const { return baker; }
+
 	private:
 		Texture* effectsTex{ nullptr };
 		bool initialized{ false };
 		std::map<EffectType, EffectPool> effectPools;
-		std::set<int> playedEffectsNoteIds;
+		std::unordered_set<int> playedEffectsNoteIds;
+		std::vector<int> visibleNotes;
+		std::vector<EffectPlay> notePlays;
+
+		// Active controllers are updated in parallel as their emitters share no state
+		ThreadPool updatePool;
+		std::vector<ParticleController*> updatingControllers;
+		double updateTime{};
+
+		// With baking enabled, effects that stay in place are drawn from frames simulated ahead of time.
+		// Hold effects follow the hold every frame and are always simulated.
+		EffectBaker baker;
+		std::unordered_set<int> liveEffectsNoteIds;
+		std::vector<int> bakeWindowNotes;
+		std::map<std::pair<EffectType, int>, std::vector<float>> laneEffectStarts;
+		std::vector<const Particle*> bakedEmitterRefs;
+		int bakedDrawGeneration{ -1 };
+		bool bakedMirror{};
+		DirectX::XMFLOAT4X4 bakedCameraView{};
+		float lastBakeRequestTime{};
+		bool bakeRequested{ false };
+
+		void addEffect(EffectType effect, const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const;
+		void addAuraEffect(EffectType effect, const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const;
+		void addLaneEffect(EffectType effect, const Note& note, const ScoreContext& context, float time, std::vector<EffectPlay>& plays) const;
+		void playEffect(const EffectPlay& play, const Note& note);
+
+		void updateBaking(const ScoreContext& context, const Camera& camera, float time);
+		void drawBakedEffects(Renderer* renderer, float time, bool underNotes);
 
 		void drawEffectsInternal(EmitterInstance& emitter, Renderer* renderer, float time) const;
 		void drawUnderNoteEffectsInternal(EmitterInstance& emitter, Renderer* renderer, float time) const;
-		void drawParticles(const std::vector<ParticleInstance>& particles, const Particle& ref, size_t count, Renderer* renderer, float time) const;
+		void drawParticles(const ParticleStore& particles, const Particle& ref, size_t count, Renderer* renderer, float time) const;
 	};
 }
\ No newline at end of file
@@ -1,12 +1,20 @@
 #include "File.h"
 #include "IO.h"
-#include <Windows.h>
 #include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
 #include <filesystem>
 #include <sstream>
 
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace IO
 {
 	FileDialogFilter mmwsFilter{ "MikuMikuWorld Score", "*.mmws" };
@@ -17,6 +25,16 @@ namespace IO
 	FileDialogFilter presetFilter{ "Notes Preset", "*.json" };
 	FileDialogFilter allFilter{ "All Files", "*.*" };
 
+	// Paths are UTF-8 outside of Windows, whatever the locale says
+	static std::filesystem::path toPath(const std::wstring& filename)
+	{
+#ifdef _WIN32
+		return std::filesystem::path(filename);
+#else
+		return std::filesystem::u8path(wideStringToMb(filename));
+#endif
+	}
+
 	File::File(const std::string& filename, FileMode mode)
 	{
 		stream = std::make_unique<std::fstream>();
@@ -61,7 +79,7 @@ namespace IO
 	void File::open(const std::wstring& filename, FileMode mode)
 	{
 		openFilenameW = filename;
-		stream->open(filename, getStreamMode(mode));
+		stream->open(toPath(filename), static_cast<std::ios_base::openmode>(getStreamMode(mode)));
 	}
 
 	void File::close()
@@ -163,6 +181,101 @@ namespace IO
 		}
 	}
 
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& filename)
+	{
+		close();
+
+		// Share deletes so the handle alone doesn't stop other code from removing the file
+		HANDLE file = CreateFileW(IO::mbToWideStr(filename).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+			NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		fileHandle = file;
+		mappingHandle = mapping;
+		data = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data)
+			UnmapViewOfFile(data);
+
+		if (mappingHandle)
+			CloseHandle(mappingHandle);
+
+		if (fileHandle)
+			CloseHandle(fileHandle);
+
+		fileHandle = mappingHandle = nullptr;
+		data = nullptr;
+		size = 0;
+	}
+#else
+	bool MappedFile::open(const std::string& filename)
+	{
+		close();
+
+		const int file = ::open(filename.c_str(), O_RDONLY);
+		if (file == -1)
+			return false;
+
+		struct stat fileStat{};
+		void* view = MAP_FAILED;
+		if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+			view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+		// The mapping keeps the file open by itself
+		::close(file);
+		if (view == MAP_FAILED)
+			return false;
+
+		data = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(fileStat.st_size);
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data)
+			munmap(const_cast<uint8_t*>(data), size);
+
+		data = nullptr;
+		size = 0;
+	}
+#endif
+
 	std::string File::getFilename(const std::string& filename)
 	{
 		size_t start = filename.find_last_of("\\/");
@@ -225,8 +338,7 @@ namespace IO
 
 	bool File::exists(const std::string& path)
 	{
-		std::wstring wPath = mbToWideStr(path);
-		return std::filesystem::exists(wPath);
+		return std::filesystem::exists(toPath(mbToWideStr(path)));
 	}
 
 	bool File::hasFileExtension(const std::string_view& filename, const std::string_view& extension)
@@ -234,6 +346,7 @@ namespace IO
 		return endsWith(filename, extension);
 	}
 
+#ifdef _WIN32
 	FileDialogResult FileDialog::showFileDialog(DialogType type, DialogSelectType selectType)
 	{
 		std::wstring wTitle = mbToWideStr(title);
@@ -310,6 +423,12 @@ namespace IO
 		filterIndex = ofn.nFilterIndex - 1;
 		return FileDialogResult::OK;
 	}
+#else
+	FileDialogResult FileDialog::showFileDialog(DialogType, DialogSelectType)
+	{
+		return FileDialogResult::Error;
+	}
+#endif
 
 	FileDialogResult FileDialog::openFile()
 	{
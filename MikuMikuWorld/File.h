@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -57,6 +59,32 @@ namespace IO
 		int getStreamMode(FileMode) const;
 	};
 
+	/// <summary>
+	/// A read-only view of a whole file mapped into memory. Pages are read from disk as they are touched
+	/// and belong to the OS file cache, so they don't count toward the process' own allocations.
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		bool open(const std::string& filename);
+		void close();
+
+		inline bool isOpen() const { return data != nullptr; }
+		inline const uint8_t* getData() const { return data; }
+		inline size_t getSize() const { return size; }
+
+	private:
+		void* fileHandle{ nullptr };
+		void* mappingHandle{ nullptr };
+		const uint8_t* data{ nullptr };
+		size_t size{};
+	};
+
 	enum class FileDialogResult : uint8_t
 	{
 		Error,
@@ -1,46 +1,242 @@
 #include "HistoryManager.h"
+#include <algorithm>
 
 namespace MikuMikuWorld
 {
-	Score HistoryManager::undo()
+	// Rough per node overhead of a std::map entry
+	constexpr size_t mapNodeOverhead = 4 * sizeof(void*);
+
+	static bool isSameNote(const Note& a, const Note& b)
 	{
-		History history = undoHistory.top();
-		redoHistory.push(history);
-		undoHistory.pop();
+		return a.getType() == b.getType() && a.ID == b.ID && a.parentID == b.parentID &&
+			a.tick == b.tick && a.lane == b.lane && a.width == b.width &&
+			a.critical == b.critical && a.friction == b.friction && a.flick == b.flick;
+	}
 
-		return history.prev;
+	static bool isSameStep(const HoldStep& a, const HoldStep& b)
+	{
+		return a.ID == b.ID && a.type == b.type && a.ease == b.ease;
 	}
 
-	Score HistoryManager::redo()
+	static bool isSameHold(const HoldNote& a, const HoldNote& b)
 	{
-		History history = redoHistory.top();
-		undoHistory.push(history);
-		redoHistory.pop();
+		return isSameStep(a.start, b.start) && a.end == b.end &&
+			a.startType == b.startType && a.endType == b.endType &&
+			std::equal(a.steps.begin(), a.steps.end(), b.steps.begin(), b.steps.end(), isSameStep);
+	}
 
-		return history.curr;
+	static bool isSameTempo(const std::vector<Tempo>& a, const std::vector<Tempo>& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](const Tempo& t1, const Tempo& t2) { return t1.tick == t2.tick && t1.bpm == t2.bpm; });
 	}
 
-	void HistoryManager::pushHistory(const std::string& description, const Score& prev, const Score& curr)
+	static bool isSameHiSpeed(const std::vector<HiSpeedChange>& a, const std::vector<HiSpeedChange>& b)
 	{
-		History history{ description, prev, curr };
-		pushHistory(history);
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+			[](const HiSpeedChange& h1, const HiSpeedChange& h2) { return h1.tick == h2.tick && h1.speed == h2.speed; });
 	}
 
-	void HistoryManager::pushHistory(const History& history)
+	static bool isSameEvents(const Score& a, const Score& b)
 	{
-		undoHistory.push(history);
-		
-		while (!redoHistory.empty())
-			redoHistory.pop();
+		return a.timeSignatures == b.timeSignatures &&
+			a.fever.startTick == b.fever.startTick && a.fever.endTick == b.fever.endTick &&
+			isSameTempo(a.tempoChanges, b.tempoChanges) &&
+			isSameHiSpeed(a.hiSpeedChanges, b.hiSpeedChanges) &&
+			std::equal(a.skills.begin(), a.skills.end(), b.skills.begin(), b.skills.end(),
+				[](const SkillTrigger& s1, const SkillTrigger& s2) { return s1.ID == s2.ID && s1.tick == s2.tick; });
 	}
 
-	void HistoryManager::clear()
+	static ScoreEvents getEvents(const Score& score)
+	{
+		return { score.tempoChanges, score.timeSignatures, score.hiSpeedChanges, score.skills, score.fever };
+	}
+
+	// Records the entries that were added, removed or modified between both maps
+	template <typename T, typename Compare>
+	static void diffMaps(const SlotMap<T>& prev, const SlotMap<T>& curr,
+		std::map<int, std::optional<T>>& undo, std::map<int, std::optional<T>>& redo, Compare isSame)
+	{
+		for (const auto& [id, value] : prev)
+		{
+			auto it = curr.find(id);
+			if (it == curr.end())
+			{
+				undo.emplace(id, value);
+				redo.emplace(id, std::nullopt);
+			}
+			else if (!isSame(value, it->second))
+			{
+				undo.emplace(id, value);
+				redo.emplace(id, it->second);
+			}
+		}
+
+		for (const auto& [id, value] : curr)
+		{
+			if (!prev.count(id))
+			{
+				undo.emplace(id, std::nullopt);
+				redo.emplace(id, value);
+			}
+		}
+	}
+
+	History createHistory(const std::string& description, const Score& prev, const Score& curr)
 	{
-		while (!undoHistory.empty())
-			undoHistory.pop();
+		History history{ description };
+		diffMaps(prev.notes, curr.notes, history.undo.notes, history.redo.notes, isSameNote);
+		diffMaps(prev.holdNotes, curr.holdNotes, history.undo.holdNotes, history.redo.holdNotes, isSameHold);
+
+		if (!isSameEvents(prev, curr))
+		{
+			history.undo.events = getEvents(prev);
+			history.redo.events = getEvents(curr);
+		}
 
-		while (!redoHistory.empty())
-			redoHistory.pop();
+		history.memoryUsage = sizeof(History) + description.capacity() + history.undo.memoryUsage() + history.redo.memoryUsage();
+		return history;
+	}
+
+	template <typename T>
+	static void diffPatches(const std::map<int, std::optional<T>>& before, const std::map<int, std::optional<T>>& after,
+		std::vector<int>& added, std::vector<int>& removed, std::vector<int>& modified)
+	{
+		for (const auto& [id, value] : after)
+		{
+			auto it = before.find(id);
+			if (it == before.end() || !it->second)
+				added.push_back(id);
+			else if (!value)
+				removed.push_back(id);
+			else
+				modified.push_back(id);
+		}
+	}
+
+	ScoreChangeSet createChangeSet(const ScorePatch& before, const ScorePatch& after)
+	{
+		ScoreChangeSet changes;
+		diffPatches(before.notes, after.notes, changes.addedNotes, changes.removedNotes, changes.modifiedNotes);
+		diffPatches(before.holdNotes, after.holdNotes, changes.addedHolds, changes.removedHolds, changes.modifiedHolds);
+
+		if (before.events && after.events)
+		{
+			changes.eventsChanged = true;
+			changes.tempoChanged = !isSameTempo(before.events->tempoChanges, after.events->tempoChanges) ||
+				!isSameHiSpeed(before.events->hiSpeedChanges, after.events->hiSpeedChanges);
+		}
+
+		return changes;
+	}
+
+	void ScorePatch::apply(Score& score) const
+	{
+		for (const auto& [id, note] : notes)
+		{
+			if (note)
+				score.notes.insert_or_assign(id, *note);
+			else
+				score.notes.erase(id);
+		}
+
+		for (const auto& [id, hold] : holdNotes)
+		{
+			if (hold)
+				score.holdNotes.insert_or_assign(id, *hold);
+			else
+				score.holdNotes.erase(id);
+		}
+
+		if (events)
+		{
+			score.tempoChanges = events->tempoChanges;
+			score.timeSignatures = events->timeSignatures;
+			score.hiSpeedChanges = events->hiSpeedChanges;
+			score.skills = events->skills;
+			score.fever = events->fever;
+		}
+	}
+
+	size_t ScorePatch::memoryUsage() const
+	{
+		size_t size = notes.size() * (sizeof(std::pair<int, std::optional<Note>>) + mapNodeOverhead);
+		for (const auto& [id, hold] : holdNotes)
+		{
+			size += sizeof(std::pair<int, std::optional<HoldNote>>) + mapNodeOverhead;
+			if (hold)
+				size += hold->steps.capacity() * sizeof(HoldStep);
+		}
+
+		if (events)
+		{
+			size += sizeof(ScoreEvents);
+			size += events->tempoChanges.capacity() * sizeof(Tempo);
+			size += events->timeSignatures.size() * (sizeof(std::pair<int, TimeSignature>) + mapNodeOverhead);
+			size += events->hiSpeedChanges.capacity() * sizeof(HiSpeedChange);
+			size += events->skills.capacity() * sizeof(SkillTrigger);
+		}
+
+		return size;
+	}
+
+	const History& HistoryManager::undo(Score& score)
+	{
+		redoHistory.push_back(std::move(undoHistory.back()));
+		undoHistory.pop_back();
+
+		const History& history = redoHistory.back();
+		history.undo.apply(score);
+		return history;
+	}
+
+	const History& HistoryManager::redo(Score& score)
+	{
+		undoHistory.push_back(std::move(redoHistory.back()));
+		redoHistory.pop_back();
+
+		const History& history = undoHistory.back();
+		history.redo.apply(score);
+		return history;
+	}
+
+	const History& HistoryManager::pushHistory(const std::string& description, const Score& prev, const Score& curr)
+	{
+		pushHistory(createHistory(description, prev, curr));
+		return undoHistory.back();
+	}
+
+	void HistoryManager::pushHistory(History history)
+	{
+		for (const History& entry : redoHistory)
+			memoryUsage -= entry.memoryUsage;
+		redoHistory.clear();
+
+		memoryUsage += history.memoryUsage;
+		undoHistory.push_back(std::move(history));
+		enforceMemoryBudget();
+	}
+
+	void HistoryManager::enforceMemoryBudget()
+	{
+		if (!memoryBudget)
+			return;
+
+		// Always keep the most recent entry so the last action can be undone
+		while (memoryUsage > memoryBudget && undoHistory.size() > 1)
+		{
+			memoryUsage -= undoHistory.front().memoryUsage;
+			undoHistory.pop_front();
+			++discardedCount;
+		}
+	}
+
+	void HistoryManager::clear()
+	{
+		undoHistory.clear();
+		redoHistory.clear();
+		memoryUsage = 0;
+		discardedCount = 0;
 	}
 
 	bool HistoryManager::hasUndo() const
@@ -65,11 +261,22 @@ namespace MikuMikuWorld
 
 	std::string HistoryManager::peekUndo() const
 	{
-		return undoHistory.size() ? undoHistory.top().description : "";
+		return undoHistory.size() ? undoHistory.back().description : "";
 	}
 
 	std::string HistoryManager::peekRedo() const
 	{
-		return redoHistory.size() ? redoHistory.top().description : "";
+		return redoHistory.size() ? redoHistory.back().description : "";
+	}
+
+	void HistoryManager::setMemoryBudget(size_t bytes)
+	{
+		memoryBudget = bytes;
+		enforceMemoryBudget();
+	}
+
+	HistoryStats HistoryManager::getStats() const
+	{
+		return { undoCount(), redoCount(), memoryUsage, memoryBudget, discardedCount };
 	}
-}
\ No newline at end of file
+}
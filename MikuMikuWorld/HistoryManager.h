@@ -1,38 +1,99 @@
 #pragma once
-#include <stack>
-#include <map>
+#include <deque>
 #include <map>
+#include <optional>
 #include <string>
 #include "Score.h"
 
 namespace MikuMikuWorld
 {
+	struct ScoreEvents
+	{
+		std::vector<Tempo> tempoChanges;
+		std::map<int, TimeSignature> timeSignatures;
+		std::vector<HiSpeedChange> hiSpeedChanges;
+		std::vector<SkillTrigger> skills;
+		Fever fever;
+	};
+
+	/// <summary>
+	/// The notes, holds and events that have to be written to a score to bring it to another state.
+	/// An empty optional means the note or hold does not exist in that state and should be erased.
+	/// </summary>
+	struct ScorePatch
+	{
+		std::map<int, std::optional<Note>> notes;
+		std::map<int, std::optional<HoldNote>> holdNotes;
+		std::optional<ScoreEvents> events;
+
+		void apply(Score& score) const;
+		size_t memoryUsage() const;
+		inline bool empty() const { return notes.empty() && holdNotes.empty() && !events; }
+	};
+
 	struct History
 	{
 		std::string description;
-		Score prev;
-		Score curr;
+		ScorePatch undo;
+		ScorePatch redo;
+		size_t memoryUsage{};
 	};
 
+	struct HistoryStats
+	{
+		int undoCount;
+		int redoCount;
+		size_t memoryUsage;
+		size_t memoryBudget;
+		int discardedCount;
+	};
+
+	History createHistory(const std::string& description, const Score& prev, const Score& curr);
+
+	/// <summary>
+	/// Lists the notes and holds changed by applying a patch, given the patch holding the values before it is applied
+	/// (the undo patch when redoing and the redo patch when undoing)
+	/// </summary>
+	ScoreChangeSet createChangeSet(const ScorePatch& before, const ScorePatch& after);
+
 	class HistoryManager
 	{
 	private:
-		std::stack<History> undoHistory;
-		std::stack<History> redoHistory;
+		std::deque<History> undoHistory;
+		std::deque<History> redoHistory;
+		size_t memoryUsage{};
+		size_t memoryBudget{};
+		int discardedCount{};
+
+		void enforceMemoryBudget();
 
 	public:
-		Score undo();
-		Score redo();
+		/// <summary>
+		/// Reverts the last change on the given score in place and returns the reverted entry
+		/// </summary>
+		const History& undo(Score& score);
+
+		/// <summary>
+		/// Re-applies the last undone change on the given score in place and returns the applied entry
+		/// </summary>
+		const History& redo(Score& score);
 
 		int undoCount() const;
 		int redoCount() const;
 		std::string peekUndo() const;
 		std::string peekRedo() const;
 
-		void pushHistory(const History& history);
-		void pushHistory(const std::string& description, const Score& prev, const Score& curr);
+		void pushHistory(History history);
+		const History& pushHistory(const std::string& description, const Score& prev, const Score& curr);
 		void clear();
 		bool hasUndo() const;
 		bool hasRedo() const;
+
+		/// <summary>
+		/// Sets the maximum memory in bytes used by the history. The oldest undo entries are discarded first.
+		/// A budget of 0 means no limit.
+		/// </summary>
+		void setMemoryBudget(size_t bytes);
+		HistoryStats getStats() const;
 	};
-}
\ No newline at end of file
+}
@@ -1,15 +1,22 @@
 #include "IO.h"
-#include <Windows.h>
 #include <algorithm>
 #include <zlib.h>
 #include <sstream>
 #include <cassert>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
 
 #undef min
 #undef max
+#else
+#include <iostream>
+#endif
 
 namespace IO
 {
+#ifdef _WIN32
 	MessageBoxResult messageBox(std::string title, std::string message, MessageBoxButtons buttons, MessageBoxIcon icon, void* parentWindow)
 	{
 		UINT flags = 0;
@@ -43,6 +50,14 @@ namespace IO
 		default:		return MessageBoxResult::None;
 		}
 	}
+#else
+	// Only the command line tools build on other platforms, so there is nobody to answer
+	MessageBoxResult messageBox(std::string title, std::string message, MessageBoxButtons, MessageBoxIcon, void*)
+	{
+		std::cerr << title << ": " << message << '\n';
+		return MessageBoxResult::None;
+	}
+#endif
 
 	char* reverse(char* str)
 	{
@@ -112,7 +127,7 @@ namespace IO
 		if (str.empty())
 			return false;
 
-		return std::all_of(str.begin() + (str.at(0) == '-' ? 1 : 0), str.end(), std::isdigit);
+		return std::all_of(str.begin() + (str.at(0) == '-' ? 1 : 0), str.end(), [](unsigned char c) { return std::isdigit(c) != 0; });
 	}
 
 	std::string trim(const std::string& line)
@@ -143,6 +158,7 @@ namespace IO
 		return values;
 	}
 
+#ifdef _WIN32
 	std::string wideStringToMb(const std::wstring& str)
 	{
 		int size = WideCharToMultiByte(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0, NULL, NULL);
@@ -160,6 +176,61 @@ namespace IO
 
 		return wResult;
 	}
+#else
+	// wchar_t holds a whole code point outside of Windows
+	std::string wideStringToMb(const std::wstring& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+		for (wchar_t c : str)
+		{
+			const uint32_t cp = static_cast<uint32_t>(c);
+			if (cp < 0x80)
+			{
+				result += static_cast<char>(cp);
+			}
+			else if (cp < 0x800)
+			{
+				result += static_cast<char>(0xC0 | (cp >> 6));
+				result += static_cast<char>(0x80 | (cp & 0x3F));
+			}
+			else if (cp < 0x10000)
+			{
+				result += static_cast<char>(0xE0 | (cp >> 12));
+				result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				result += static_cast<char>(0x80 | (cp & 0x3F));
+			}
+			else
+			{
+				result += static_cast<char>(0xF0 | (cp >> 18));
+				result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+				result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				result += static_cast<char>(0x80 | (cp & 0x3F));
+			}
+		}
+
+		return result;
+	}
+
+	std::wstring mbToWideStr(const std::string& str)
+	{
+		std::wstring result;
+		result.reserve(str.size());
+		for (size_t i = 0; i < str.size();)
+		{
+			const uint8_t lead = static_cast<uint8_t>(str[i]);
+			const size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+			uint32_t cp = length == 1 ? lead : lead & (0x3F >> (length - 1));
+			for (size_t j = 1; j < length && i + j < str.size(); ++j)
+				cp = (cp << 6) | (static_cast<uint8_t>(str[i + j]) & 0x3F);
+
+			result += static_cast<wchar_t>(cp);
+			i += length;
+		}
+
+		return result;
+	}
+#endif
 
 	std::string concat(const char* s1, const char* s2, const char* join)
 	{
@@ -184,8 +255,7 @@ namespace IO
 			if (dest.size() < stream->total_out)
 			{
 				size_t count = Z_CHUNK_SIZE - stream->avail_out;
-				for (size_t i = 0; i < count; i++)
-					dest.push_back(buf[i]);
+				dest.insert(dest.end(), buf.get(), buf.get() + count);
 			}
 
 		} while (result == Z_OK);
@@ -130,6 +130,120 @@ namespace MikuMikuWorld::Effect
 		return total;
 	}
 
+	static DirectX::XMVECTOR lerp4(DirectX::FXMVECTOR start, DirectX::FXMVECTOR end, DirectX::FXMVECTOR ratio)
+	{
+		// Same operation order as the scalar lerp so both give the same results
+		return DirectX::XMVectorAdd(start, DirectX::XMVectorMultiply(ratio, DirectX::XMVectorSubtract(end, start)));
+	}
+
+	static BakedCurve bakeCurve(const std::vector<KeyFrame>& keyframes, int resolution)
+	{
+		// Without a time range the curve is constant on either side of its keyframes, which is cheap enough as it is
+		BakedCurve baked;
+		if (resolution <= 0 || keyframes.size() < 2 || keyframes.rbegin()->time <= keyframes.begin()->time)
+			return baked;
+
+		const float length = keyframes.rbegin()->time - keyframes.begin()->time;
+		baked.start = keyframes.begin()->time;
+		baked.samplesPerUnit = resolution / length;
+		baked.values.resize(resolution + 1);
+		baked.areas.resize(resolution + 1);
+		for (int i = 0; i <= resolution; i++)
+		{
+			float time = i == resolution ? keyframes.rbegin()->time : baked.start + length * i / resolution;
+			baked.values[i] = evaluateCurve(keyframes, time);
+			baked.areas[i] = integrateCurve(keyframes, 0, time, 1);
+		}
+
+		return baked;
+	}
+
+	// Where the time falls in a table of the given size, clamped to its ends
+	static float getTablePosition(float start, float samplesPerUnit, size_t size, float time)
+	{
+		float position = (time - start) * samplesPerUnit;
+		if (!(position > 0))
+			return 0;
+
+		return std::min(position, static_cast<float>(size - 1));
+	}
+
+	static float sampleTable(const BakedCurve& baked, const std::vector<float>& table, float time)
+	{
+		float position = getTablePosition(baked.start, baked.samplesPerUnit, table.size(), time);
+		size_t index = std::min(static_cast<size_t>(position), table.size() - 2);
+		return lerp(table[index], table[index + 1], position - index);
+	}
+
+	static DirectX::XMVECTOR sampleTable4(const BakedCurve& baked, const std::vector<float>& table, DirectX::FXMVECTOR time)
+	{
+		const float lastIndex = static_cast<float>(table.size() - 1);
+		DirectX::XMVECTOR position = DirectX::XMVectorMultiply(
+			DirectX::XMVectorSubtract(time, DirectX::XMVectorReplicate(baked.start)), DirectX::XMVectorReplicate(baked.samplesPerUnit));
+		position = DirectX::XMVectorClamp(position, DirectX::XMVectorZero(), DirectX::XMVectorReplicate(lastIndex));
+
+		DirectX::XMVECTOR index = DirectX::XMVectorMin(DirectX::XMVectorTruncate(position), DirectX::XMVectorReplicate(lastIndex - 1));
+		DirectX::XMFLOAT4A indices;
+		DirectX::XMStoreFloat4A(&indices, index);
+
+		const size_t i[] = { static_cast<size_t>(indices.x), static_cast<size_t>(indices.y), static_cast<size_t>(indices.z), static_cast<size_t>(indices.w) };
+		return lerp4(
+			DirectX::XMVectorSet(table[i[0]], table[i[1]], table[i[2]], table[i[3]]),
+			DirectX::XMVectorSet(table[i[0] + 1], table[i[1] + 1], table[i[2] + 1], table[i[3] + 1]),
+			DirectX::XMVectorSubtract(position, index)
+		);
+	}
+
+	static float evaluateCurve(const std::vector<KeyFrame>& keyframes, const BakedCurve& baked, float time, float fallback)
+	{
+		return baked.isBaked() ? sampleTable(baked, baked.values, time) : evaluateCurve(keyframes, time, fallback);
+	}
+
+	static float integrateCurve(const std::vector<KeyFrame>& keyframes, const BakedCurve& baked, float from, float to, float scale)
+	{
+		if (!baked.isBaked())
+			return integrateCurve(keyframes, from, to, scale);
+
+		// Integrating before the first keyframe gives its value like the exact integration does
+		if (to < baked.start)
+			return keyframes.begin()->value;
+
+		return sampleTable(baked, baked.areas, to) * scale;
+	}
+
+	static DirectX::XMVECTOR evaluateCurve4(const std::vector<KeyFrame>& keyframes, const BakedCurve& baked, DirectX::FXMVECTOR time, float fallback)
+	{
+		if (baked.isBaked())
+			return sampleTable4(baked, baked.values, time);
+
+		DirectX::XMFLOAT4A times, result;
+		DirectX::XMStoreFloat4A(&times, time);
+		result.x = evaluateCurve(keyframes, times.x, fallback);
+		result.y = evaluateCurve(keyframes, times.y, fallback);
+		result.z = evaluateCurve(keyframes, times.z, fallback);
+		result.w = evaluateCurve(keyframes, times.w, fallback);
+		return DirectX::XMLoadFloat4A(&result);
+	}
+
+	static DirectX::XMVECTOR integrateCurve4(const std::vector<KeyFrame>& keyframes, const BakedCurve& baked, float from, DirectX::FXMVECTOR to, DirectX::FXMVECTOR scale)
+	{
+		if (baked.isBaked())
+		{
+			DirectX::XMVECTOR area = DirectX::XMVectorMultiply(sampleTable4(baked, baked.areas, to), scale);
+			return DirectX::XMVectorSelect(area, DirectX::XMVectorReplicate(keyframes.begin()->value),
+				DirectX::XMVectorLess(to, DirectX::XMVectorReplicate(baked.start)));
+		}
+
+		DirectX::XMFLOAT4A tos, scales, result;
+		DirectX::XMStoreFloat4A(&tos, to);
+		DirectX::XMStoreFloat4A(&scales, scale);
+		result.x = integrateCurve(keyframes, from, tos.x, scales.x);
+		result.y = integrateCurve(keyframes, from, tos.y, scales.y);
+		result.z = integrateCurve(keyframes, from, tos.z, scales.z);
+		result.w = integrateCurve(keyframes, from, tos.w, scales.w);
+		return DirectX::XMLoadFloat4A(&result);
+	}
+
 	int MinMaxColor::findKeyFrame(const std::vector<ColorKeyFrame>& keyframes, float time) const
 	{
 		int min = 0;
@@ -148,8 +262,19 @@ namespace MikuMikuWorld::Effect
 		return min;
 	}
 
-	Color MinMaxColor::at(const std::vector<ColorKeyFrame>& keyframes, float time) const
+	Color MinMaxColor::at(const std::vector<ColorKeyFrame>& keyframes, const BakedGradient& baked, float time) const
 	{
+		if (baked.isBaked())
+		{
+			float position = getTablePosition(baked.start, baked.samplesPerUnit, baked.colors.size(), time);
+			size_t index = std::min(static_cast<size_t>(position), baked.colors.size() - 2);
+			float ratio = position - index;
+
+			const Color& c1 = baked.colors[index];
+			const Color& c2 = baked.colors[index + 1];
+			return Color(lerp(c1.r, c2.r, ratio), lerp(c1.g, c2.g, ratio), lerp(c1.b, c2.b, ratio), lerp(c1.a, c2.a, ratio));
+		}
+
 		if (keyframes.empty())
 			return Color{ 1.0f, 1.0f, 1.0f, 1.0f };
 
@@ -186,11 +311,11 @@ namespace MikuMikuWorld::Effect
 		case MinMaxColorMode::Random:
 			return gradientMin[std::clamp(static_cast<size_t>(gradientMin.size() * lerpRatio), 0ull, gradientMin.size() - 1)].color;
 		case MinMaxColorMode::Gradient:
-			return at(gradientMin, time);
+			return at(gradientMin, bakedMin, time);
 		case MinMaxColorMode::TwoGradients:
 		{
-			const Color& c1 = at(gradientMin, time);
-			const Color& c2 = at(gradientMax, time);
+			const Color& c1 = at(gradientMin, bakedMin, time);
+			const Color& c2 = at(gradientMax, bakedMax, time);
 			return Color(
 				lerp(c1.r, c2.r, lerpRatio),
 				lerp(c1.g, c2.g, lerpRatio),
@@ -205,6 +330,7 @@ namespace MikuMikuWorld::Effect
 
 	void MinMaxColor::addKeyFrame(const ColorKeyFrame& k, MinMaxCurve curve)
 	{
+		bake(0);
 		switch (curve)
 		{
 		case MinMaxCurve::Min:
@@ -218,6 +344,7 @@ namespace MikuMikuWorld::Effect
 
 	void MinMaxColor::removeKeyFrame(size_t index, MinMaxCurve curve)
 	{
+		bake(0);
 		switch (curve)
 		{
 		case MinMaxCurve::Min:
@@ -234,6 +361,32 @@ namespace MikuMikuWorld::Effect
 		auto keyframeSortFn = [](const ColorKeyFrame& k1, const ColorKeyFrame& k2) { return k1.time <= k2.time; };
 		std::sort(gradientMin.begin(), gradientMin.end(), keyframeSortFn);
 		std::sort(gradientMax.begin(), gradientMax.end(), keyframeSortFn);
+		bake(0);
+	}
+
+	BakedGradient MinMaxColor::bakeGradient(const std::vector<ColorKeyFrame>& keyframes, int resolution) const
+	{
+		BakedGradient baked;
+		if (resolution <= 0 || keyframes.size() < 2 || keyframes.rbegin()->time <= keyframes.begin()->time)
+			return baked;
+
+		const float length = keyframes.rbegin()->time - keyframes.begin()->time;
+		baked.start = keyframes.begin()->time;
+		baked.samplesPerUnit = resolution / length;
+		baked.colors.resize(resolution + 1);
+		for (int i = 0; i <= resolution; i++)
+		{
+			float time = i == resolution ? keyframes.rbegin()->time : baked.start + length * i / resolution;
+			baked.colors[i] = at(keyframes, {}, time);
+		}
+
+		return baked;
+	}
+
+	void MinMaxColor::bake(int resolution)
+	{
+		bakedMin = bakeGradient(gradientMin, resolution);
+		bakedMax = bakeGradient(gradientMax, resolution);
 	}
 
 	float MinMax::evaluate(float time, float lerpRatio, float fallback) const
@@ -243,9 +396,9 @@ namespace MikuMikuWorld::Effect
 		case MinMaxMode::TwoConstants:
 			return lerp(min, max, lerpRatio);
 		case MinMaxMode::Curve:
-			return evaluateCurve(curveMin, time, fallback);
+			return evaluateCurve(curveMin, bakedMin, time, fallback);
 		case MinMaxMode::TwoCurves:
-			return lerp(evaluateCurve(curveMin, time, fallback), evaluateCurve(curveMax, time, fallback), lerpRatio);
+			return lerp(evaluateCurve(curveMin, bakedMin, time, fallback), evaluateCurve(curveMax, bakedMax, time, fallback), lerpRatio);
 		default:
 			return constant;
 		}
@@ -258,16 +411,51 @@ namespace MikuMikuWorld::Effect
 		case MinMaxMode::TwoConstants:
 			return lerp(min, max, lerpRatio) * ((to - from) * scale);
 		case MinMaxMode::Curve:
-			return integrateCurve(curveMin, from, to, scale);
+			return integrateCurve(curveMin, bakedMin, from, to, scale);
 		case MinMaxMode::TwoCurves:
-			return lerp(integrateCurve(curveMin, from, to, scale), integrateCurve(curveMax, from, to, scale), lerpRatio);
+			return lerp(integrateCurve(curveMin, bakedMin, from, to, scale), integrateCurve(curveMax, bakedMax, from, to, scale), lerpRatio);
 		default:
 			return constant * ((to - from) * scale);
 		}
 	}
 
+	DirectX::XMVECTOR MinMax::evaluate4(DirectX::FXMVECTOR time, DirectX::FXMVECTOR lerpRatio, float fallback) const
+	{
+		switch (mode)
+		{
+		case MinMaxMode::TwoConstants:
+			return lerp4(DirectX::XMVectorReplicate(min), DirectX::XMVectorReplicate(max), lerpRatio);
+		case MinMaxMode::Curve:
+			return evaluateCurve4(curveMin, bakedMin, time, fallback);
+		case MinMaxMode::TwoCurves:
+			return lerp4(evaluateCurve4(curveMin, bakedMin, time, fallback), evaluateCurve4(curveMax, bakedMax, time, fallback), lerpRatio);
+		default:
+			return DirectX::XMVectorReplicate(constant);
+		}
+	}
+
+	DirectX::XMVECTOR MinMax::integrate4(float from, DirectX::FXMVECTOR to, DirectX::FXMVECTOR scale, DirectX::FXMVECTOR lerpRatio) const
+	{
+		switch (mode)
+		{
+		case MinMaxMode::TwoConstants:
+		case MinMaxMode::Constant:
+		{
+			DirectX::XMVECTOR value = mode == MinMaxMode::Constant ? DirectX::XMVectorReplicate(constant) :
+				lerp4(DirectX::XMVectorReplicate(min), DirectX::XMVectorReplicate(max), lerpRatio);
+
+			return DirectX::XMVectorMultiply(value, DirectX::XMVectorMultiply(DirectX::XMVectorSubtract(to, DirectX::XMVectorReplicate(from)), scale));
+		}
+		case MinMaxMode::Curve:
+			return integrateCurve4(curveMin, bakedMin, from, to, scale);
+		default:
+			return lerp4(integrateCurve4(curveMin, bakedMin, from, to, scale), integrateCurve4(curveMax, bakedMax, from, to, scale), lerpRatio);
+		}
+	}
+
 	void MinMax::addKeyFrame(const KeyFrame& k, MinMaxCurve curve)
 	{
+		bake(0);
 		switch (curve)
 		{
 		case MinMaxCurve::Max:
@@ -281,6 +469,7 @@ namespace MikuMikuWorld::Effect
 
 	void MinMax::removeKeyFrame(size_t index, MinMaxCurve curve)
 	{
+		bake(0);
 		switch (curve)
 		{
 		case MinMaxCurve::Max:
@@ -297,5 +486,12 @@ namespace MikuMikuWorld::Effect
 		auto keyframeSortFn = [](const KeyFrame& k1, const KeyFrame& k2) { return k1.time <= k2.time; };
 		std::sort(curveMin.begin(), curveMin.end(), keyframeSortFn);
 		std::sort(curveMax.begin(), curveMax.end(), keyframeSortFn);
+		bake(0);
+	}
+
+	void MinMax::bake(int resolution)
+	{
+		bakedMin = bakeCurve(curveMin, resolution);
+		bakedMax = bakeCurve(curveMax, resolution);
 	}
 }
\ No newline at end of file
@@ -22,9 +22,44 @@ namespace MikuMikuWorld::Effect
 		float outWeight{};
 	};
 
+	/// <summary>
+	/// Four 3D vectors stored one component per vector, so they can be processed together
+	/// </summary>
+	struct Vector3x4
+	{
+		DirectX::XMVECTOR x, y, z;
+	};
+
 	float hermite(const KeyFrame& k1, const KeyFrame& k2, float ratio);
 	float hermiteArea(const KeyFrame& k1, const KeyFrame& k2, float ratio);
 
+	constexpr int DEFAULT_CURVE_BAKE_RESOLUTION = 256;
+
+	/// <summary>
+	/// A curve sampled at evenly spaced times between its first and last keyframe.
+	/// Sampling it takes an index and a lerp instead of a keyframe search and the hermite math.
+	/// </summary>
+	struct BakedCurve
+	{
+		float start{};
+		float samplesPerUnit{};
+		std::vector<float> values;
+
+		// Area under the curve since its start, which integrate scales
+		std::vector<float> areas;
+
+		inline bool isBaked() const { return !values.empty(); }
+	};
+
+	struct BakedGradient
+	{
+		float start{};
+		float samplesPerUnit{};
+		std::vector<Color> colors;
+
+		inline bool isBaked() const { return !colors.empty(); }
+	};
+
 	enum class MinMaxMode
 	{
 		/// <summary>
@@ -94,13 +129,27 @@ namespace MikuMikuWorld::Effect
 		float evaluate(float time, float lerpRatio, float fallback = 0.f) const;
 		float integrate(float from, float to, float scale, float lerpRatio, float fallback = 0.f) const;
 
+		/// <summary>
+		/// Evaluates four times with four lerp ratios at once. Constants are computed in vector registers and curves lane by lane.
+		/// </summary>
+		DirectX::XMVECTOR evaluate4(DirectX::FXMVECTOR time, DirectX::FXMVECTOR lerpRatio, float fallback = 0.f) const;
+		DirectX::XMVECTOR integrate4(float from, DirectX::FXMVECTOR to, DirectX::FXMVECTOR scale, DirectX::FXMVECTOR lerpRatio) const;
+
 		void addKeyFrame(const KeyFrame& k, MinMaxCurve curve = MinMaxCurve::Min);
 		void removeKeyFrame(size_t index, MinMaxCurve curve = MinMaxCurve::Min);
 
 		void sortKeyFrames();
+
+		/// <summary>
+		/// Samples the curves into tables of resolution + 1 entries that are used in place of the keyframes.
+		/// Editing the keyframes drops the tables, as does a resolution of 0.
+		/// </summary>
+		void bake(int resolution = DEFAULT_CURVE_BAKE_RESOLUTION);
 	private:
 		std::vector<KeyFrame> curveMin;
 		std::vector<KeyFrame> curveMax;
+		BakedCurve bakedMin;
+		BakedCurve bakedMax;
 	};
 
 	class MinMax3
@@ -145,6 +194,23 @@ namespace MikuMikuWorld::Effect
 				z.integrate(from, to, scale, lerpRatio.z)
 			);
 		}
+
+		inline Vector3x4 evaluate4(DirectX::FXMVECTOR time, DirectX::FXMVECTOR lerpRatio, float fallback = 0.f) const
+		{
+			return { x.evaluate4(time, lerpRatio, fallback), y.evaluate4(time, lerpRatio, fallback), z.evaluate4(time, lerpRatio, fallback) };
+		}
+
+		inline Vector3x4 integrate4(float from, DirectX::FXMVECTOR to, DirectX::FXMVECTOR scale, DirectX::FXMVECTOR lerpRatio) const
+		{
+			return { x.integrate4(from, to, scale, lerpRatio), y.integrate4(from, to, scale, lerpRatio), z.integrate4(from, to, scale, lerpRatio) };
+		}
+
+		inline void bake(int resolution = DEFAULT_CURVE_BAKE_RESOLUTION)
+		{
+			x.bake(resolution);
+			y.bake(resolution);
+			z.bake(resolution);
+		}
 	};
 
 	class MinMaxColor
@@ -163,11 +229,19 @@ namespace MikuMikuWorld::Effect
 		void removeKeyFrame(size_t index, MinMaxCurve curve);
 		
 		void sortKeyFrames();
+
+		/// <summary>
+		/// Samples the gradients into tables of resolution + 1 colors, like MinMax::bake
+		/// </summary>
+		void bake(int resolution = DEFAULT_CURVE_BAKE_RESOLUTION);
 	private:
-		Color at(const std::vector<ColorKeyFrame>& keyframes, float time) const;
+		Color at(const std::vector<ColorKeyFrame>& keyframes, const BakedGradient& baked, float time) const;
 		int findKeyFrame(const std::vector<ColorKeyFrame>& keyframes, float time) const;
+		BakedGradient bakeGradient(const std::vector<ColorKeyFrame>& keyframes, int resolution) const;
 
 		std::vector<ColorKeyFrame> gradientMin;
 		std::vector<ColorKeyFrame> gradientMax;
+		BakedGradient bakedMin;
+		BakedGradient bakedMax;
 	};
 }
\ No newline at end of file
@@ -1,11 +1,63 @@
 #include "NativeScoreSerializer.h"
+#include "IO.h"
+#include <algorithm>
 #include <stdexcept>
+#include <zlib.h>
 
 namespace MikuMikuWorld
 {
 	using namespace IO;
 
-	const int NativeScoreSerializer::SCORE_VERSION = 4;
+	const int NativeScoreSerializer::SCORE_VERSION = 5;
+
+	static constexpr uint32_t makeChunkType(const char (&name)[5])
+	{
+		return name[0] | (name[1] << 8) | (name[2] << 16) | (static_cast<uint32_t>(name[3]) << 24);
+	}
+
+	static constexpr uint32_t CHUNK_TYPE_METADATA = makeChunkType("META");
+	static constexpr uint32_t CHUNK_TYPE_EVENTS = makeChunkType("EVNT");
+	static constexpr uint32_t CHUNK_TYPE_TAPS = makeChunkType("TAPS");
+	static constexpr uint32_t CHUNK_TYPE_HOLDS = makeChunkType("HOLD");
+	static constexpr uint32_t CHUNK_TYPE_STEPS = makeChunkType("STEP");
+
+	static constexpr size_t minCompressedChunkSize = 256;
+
+	// Taps and holds are written in the order of their ticks to keep the tick deltas small
+	static std::vector<int> getTapOrder(const Score& score)
+	{
+		std::vector<int> taps;
+		for (int id : score.notes.getTickOrder())
+		{
+			if (score.notes.at(id).getType() == NoteType::Tap)
+				taps.push_back(id);
+		}
+
+		return taps;
+	}
+
+	static std::vector<int> getHoldOrder(const Score& score)
+	{
+		std::vector<int> holds;
+		for (int id : score.notes.getTickOrder())
+		{
+			if (score.notes.at(id).getType() == NoteType::Hold && score.holdNotes.find(id) != score.holdNotes.end())
+				holds.push_back(id);
+		}
+
+		return holds;
+	}
+
+	static inline bool isStepWritten(const Score& score, const HoldStep& step)
+	{
+		return score.notes.find(step.ID) != score.notes.end();
+	}
+
+	NativeScoreSerializer::NativeScoreSerializer(bool compressChunks) :
+		compressChunks{ compressChunks }
+	{
+
+	}
 
 	Note NativeScoreSerializer::readNote(NoteType type, IO::BinaryReader* reader)
 	{
@@ -152,149 +204,357 @@ namespace MikuMikuWorld
 		writer->writeInt32(score.fever.endTick);
 	}
 
-	void NativeScoreSerializer::serialize(const Score& score, std::string filename)
+	Note NativeScoreSerializer::readPackedNote(NoteType type, int previousTick, IO::BinaryReader* reader)
 	{
-		BinaryWriter writer(filename);
-		if (!writer.isStreamValid())
-			return;
-
-		// signature
-		writer.writeString("MMWS");
+		Note note(type);
+		note.tick = previousTick + reader->readVarInt32();
+		note.lane = reader->readVarInt32();
+		note.width = reader->readVarInt32();
 
-		// verison
-		writer.writeInt32(4);
+		if (!note.hasEase())
+			note.flick = (FlickType)reader->readByte();
 
-		// offsets address in order: metadata -> events -> taps -> holds
-		uint32_t offsetsAddress = writer.getStreamPosition();
-		writer.writeNull(sizeof(uint32_t) * 4);
+		unsigned int flags = reader->readByte();
+		note.critical = (bool)(flags & NOTE_CRITICAL);
+		note.friction = (bool)(flags & NOTE_FRICTION);
+		return note;
+	}
 
-		uint32_t metadataAddress = writer.getStreamPosition();
-		writeMetadata(score.metadata, &writer);
+	void NativeScoreSerializer::writePackedNote(const Note& note, int previousTick, IO::BinaryWriter* writer)
+	{
+		// Ticks are stored relative to the previous note, which keeps most of them to a single byte
+		writer->writeVarInt32(note.tick - previousTick);
+		writer->writeVarInt32(note.lane);
+		writer->writeVarInt32(note.width);
 
-		uint32_t eventsAddress = writer.getStreamPosition();
-		writeScoreEvents(score, &writer);
+		if (!note.hasEase())
+			writer->writeByte((uint8_t)note.flick);
 
-		uint32_t tapsAddress = writer.getStreamPosition();
-		writer.writeNull(sizeof(uint32_t));
+		unsigned int flags{};
+		if (note.critical) flags |= NOTE_CRITICAL;
+		if (note.friction) flags |= NOTE_FRICTION;
+		writer->writeByte(flags);
+	}
 
-		int noteCount = 0;
-		for (const auto& [id, note] : score.notes)
+	void NativeScoreSerializer::readTaps(Score& score, IO::BinaryReader* reader)
+	{
+		int previousTick = 0;
+		uint32_t noteCount = reader->readVarUInt32();
+		for (uint32_t i = 0; i < noteCount; ++i)
 		{
-			if (note.getType() != NoteType::Tap)
-				continue;
+			Note note = readPackedNote(NoteType::Tap, previousTick, reader);
+			note.ID = nextID++;
+			score.notes[note.ID] = note;
+			previousTick = note.tick;
+		}
+	}
 
-			writeNote(note, &writer);
-			++noteCount;
+	void NativeScoreSerializer::writeTaps(const Score& score, IO::BinaryWriter* writer)
+	{
+		const std::vector<int> taps = getTapOrder(score);
+		int previousTick = 0;
+		writer->writeVarUInt32(taps.size());
+		for (int id : taps)
+		{
+			const Note& note = score.notes.at(id);
+			writePackedNote(note, previousTick, writer);
+			previousTick = note.tick;
 		}
+	}
 
-		uint32_t holdsAddress = writer.getStreamPosition();
+	void NativeScoreSerializer::readHolds(Score& score, IO::BinaryReader* holdsReader, IO::BinaryReader* stepsReader)
+	{
+		int previousTick = 0;
+		uint32_t holdCount = holdsReader->readVarUInt32();
+		for (uint32_t i = 0; i < holdCount; ++i)
+		{
+			HoldNote hold;
+
+			unsigned int flags = holdsReader->readByte();
+			if (flags & HOLD_START_HIDDEN)
+				hold.startType = HoldNoteType::Hidden;
 
-		// write taps count
-		writer.seek(tapsAddress);
-		writer.writeInt32(noteCount);
-		writer.seek(holdsAddress);
+			if (flags & HOLD_END_HIDDEN)
+				hold.endType = HoldNoteType::Hidden;
+
+			if (flags & HOLD_GUIDE)
+				hold.startType = hold.endType = HoldNoteType::Guide;
 
-		writer.writeInt32(score.holdNotes.size());
-		for (const auto& [id, hold] : score.holdNotes)
+			Note start = readPackedNote(NoteType::Hold, previousTick, holdsReader);
+			start.ID = nextID++;
+			hold.start.ease = (EaseType)holdsReader->readByte();
+			hold.start.ID = start.ID;
+			score.notes[start.ID] = start;
+			previousTick = start.tick;
+
+			// steps are stored in their own chunk, in the same order as the holds
+			int stepTick = start.tick;
+			uint32_t stepCount = holdsReader->readVarUInt32();
+			hold.steps.reserve(stepCount);
+			for (uint32_t s = 0; s < stepCount; ++s)
+			{
+				Note mid = readPackedNote(NoteType::HoldMid, stepTick, stepsReader);
+				mid.ID = nextID++;
+				mid.parentID = start.ID;
+				score.notes[mid.ID] = mid;
+				stepTick = mid.tick;
+
+				HoldStep step{};
+				step.type = (HoldStepType)stepsReader->readByte();
+				step.ease = (EaseType)stepsReader->readByte();
+				step.ID = mid.ID;
+				hold.steps.push_back(step);
+			}
+
+			Note end = readPackedNote(NoteType::HoldEnd, start.tick, holdsReader);
+			end.ID = nextID++;
+			end.parentID = start.ID;
+			score.notes[end.ID] = end;
+
+			hold.end = end.ID;
+			score.holdNotes[start.ID] = hold;
+		}
+	}
+
+	void NativeScoreSerializer::writeHolds(const Score& score, IO::BinaryWriter* holdsWriter, IO::BinaryWriter* stepsWriter)
+	{
+		const std::vector<int> holds = getHoldOrder(score);
+		int previousTick = 0;
+		holdsWriter->writeVarUInt32(holds.size());
+		for (int id : holds)
 		{
+			const HoldNote& hold = score.holdNotes.at(id);
+
 			unsigned int flags{};
 			if (hold.startType == HoldNoteType::Guide) flags |= HOLD_GUIDE;
 			if (hold.startType == HoldNoteType::Hidden) flags |= HOLD_START_HIDDEN;
 			if (hold.endType == HoldNoteType::Hidden) flags |= HOLD_END_HIDDEN;
-			writer.writeInt32(flags);
+			holdsWriter->writeByte(flags);
 
-			// note data
 			const Note& start = score.notes.at(hold.start.ID);
-			writeNote(start, &writer);
-			writer.writeInt32((int)hold.start.ease);
+			writePackedNote(start, previousTick, holdsWriter);
+			holdsWriter->writeByte((uint8_t)hold.start.ease);
+			previousTick = start.tick;
 
-			// steps
-			int stepCount = hold.steps.size();
-			writer.writeInt32(stepCount);
+			std::vector<const HoldStep*> steps;
+			steps.reserve(hold.steps.size());
 			for (const auto& step : hold.steps)
 			{
-				const auto it = score.notes.find(step.ID);
-				if (it == score.notes.end())
-					continue;
-
-				const Note& mid = it->second;
-				writeNote(mid, &writer);
-				writer.writeInt32((int)step.type);
-				writer.writeInt32((int)step.ease);
+				if (isStepWritten(score, step))
+					steps.push_back(&step);
+			}
+
+			int stepTick = start.tick;
+			holdsWriter->writeVarUInt32(steps.size());
+			for (const HoldStep* step : steps)
+			{
+				const Note& mid = score.notes.at(step->ID);
+				writePackedNote(mid, stepTick, stepsWriter);
+				stepsWriter->writeByte((uint8_t)step->type);
+				stepsWriter->writeByte((uint8_t)step->ease);
+				stepTick = mid.tick;
 			}
 
-			// end
 			const Note& end = score.notes.at(hold.end);
-			writeNote(end, &writer);
+			writePackedNote(end, start.tick, holdsWriter);
 		}
+	}
 
-		// write offset addresses
-		writer.seek(offsetsAddress);
-		writer.writeInt32(metadataAddress);
-		writer.writeInt32(eventsAddress);
-		writer.writeInt32(tapsAddress);
-		writer.writeInt32(holdsAddress);
+	void NativeScoreSerializer::serialize(const Score& score, std::string filename)
+	{
+		writtenSize = writtenChecksum = 0;
+		BinaryWriter writer(filename);
+		if (!writer.isStreamValid())
+			return;
+
+		BinaryWriter metadataWriter, eventsWriter, tapsWriter, holdsWriter, stepsWriter;
+		writeMetadata(score.metadata, &metadataWriter);
+		writeScoreEvents(score, &eventsWriter);
+		writeTaps(score, &tapsWriter);
+		writeHolds(score, &holdsWriter, &stepsWriter);
+
+		const std::pair<uint32_t, const BinaryWriter*> chunks[] =
+		{
+			{ CHUNK_TYPE_METADATA, &metadataWriter },
+			{ CHUNK_TYPE_EVENTS, &eventsWriter },
+			{ CHUNK_TYPE_TAPS, &tapsWriter },
+			{ CHUNK_TYPE_HOLDS, &holdsWriter },
+			{ CHUNK_TYPE_STEPS, &stepsWriter }
+		};
+
+		// signature
+		writer.writeString("MMWS");
+
+		// version
+		writer.writeInt32(SCORE_VERSION);
+
+		// chunk directory, filled in once the chunks are written
+		const uint32_t chunkCount = sizeof(chunks) / sizeof(chunks[0]);
+		writer.writeInt32(chunkCount);
+
+		uint32_t directoryAddress = writer.getStreamPosition();
+		writer.writeNull(sizeof(ChunkEntry) * chunkCount);
+
+		std::vector<ChunkEntry> directory;
+		directory.reserve(chunkCount);
+		for (const auto& [type, chunkWriter] : chunks)
+		{
+			const std::vector<uint8_t>& data = chunkWriter->getBuffer();
+			ChunkEntry entry{ type, 0, static_cast<uint32_t>(writer.getStreamPosition()), static_cast<uint32_t>(data.size()), static_cast<uint32_t>(data.size()) };
+
+			// Small chunks are not worth the zlib header, and some data does not shrink at all
+			std::vector<uint8_t> compressed;
+			if (compressChunks && data.size() >= minCompressedChunkSize)
+				compressed = deflateGzip(data);
+
+			if (!compressed.empty() && compressed.size() < data.size())
+			{
+				entry.flags |= CHUNK_COMPRESSED;
+				entry.size = compressed.size();
+				writer.writeBytes(compressed);
+			}
+			else
+			{
+				writer.writeBytes(data);
+			}
+
+			directory.push_back(entry);
+		}
+
+		writer.seek(directoryAddress);
+		for (const ChunkEntry& entry : directory)
+		{
+			writer.writeInt32(entry.type);
+			writer.writeInt32(entry.flags);
+			writer.writeInt32(entry.offset);
+			writer.writeInt32(entry.size);
+			writer.writeInt32(entry.rawSize);
+		}
 
 		writer.flush();
 		writer.close();
+
+		const std::vector<uint8_t>& bytes = writer.getBuffer();
+		writtenSize = static_cast<uint32_t>(bytes.size());
+		writtenChecksum = crc32(0L, bytes.data(), static_cast<uInt>(bytes.size()));
 	}
 
-	Score NativeScoreSerializer::deserialize(std::string filename)
+	std::vector<int> NativeScoreSerializer::getNoteOrder(const Score& score)
 	{
-		Score score;
-		BinaryReader reader(filename);
-		if (!reader.isStreamValid())
-			return score;
+		std::vector<int> order = getTapOrder(score);
+		order.reserve(score.notes.size());
+		for (int id : getHoldOrder(score))
+		{
+			const HoldNote& hold = score.holdNotes.at(id);
+			order.push_back(id);
+			for (const HoldStep& step : hold.steps)
+			{
+				if (isStepWritten(score, step))
+					order.push_back(step.ID);
+			}
 
-		std::string signature = reader.readString();
-		if (signature != "MMWS")
-			throw std::runtime_error("Not a MMWS file.");
+			order.push_back(hold.end);
+		}
 
-		int version = reader.readInt32();
+		return order;
+	}
+
+	void NativeScoreSerializer::readChunkedScore(Score& score, IO::BinaryReader* reader)
+	{
+		// Entries are read one by one so a corrupted count runs into the end of the file instead of allocating it upfront
+		std::vector<ChunkEntry> directory;
+		uint32_t chunkCount = reader->readInt32();
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			ChunkEntry& entry = directory.emplace_back();
+			entry.type = reader->readInt32();
+			entry.flags = reader->readInt32();
+			entry.offset = reader->readInt32();
+			entry.size = reader->readInt32();
+			entry.rawSize = reader->readInt32();
+		}
+
+		// Chunks are only read when asked for, and unknown chunks from newer versions are ignored
+		auto readChunk = [&](uint32_t type) -> BinaryReader
+		{
+			auto it = std::find_if(directory.begin(), directory.end(), [type](const ChunkEntry& entry) { return entry.type == type; });
+			if (it == directory.end())
+				return BinaryReader(std::vector<uint8_t>{});
+
+			reader->seek(it->offset);
+			std::vector<uint8_t> data = reader->readBytes(it->size);
+			if (it->flags & CHUNK_COMPRESSED)
+				data = inflateGzip(data);
+
+			if (data.size() != it->rawSize)
+				throw std::runtime_error("Corrupted MMWS chunk.");
+
+			return BinaryReader(std::move(data));
+		};
 
+		BinaryReader metadataReader = readChunk(CHUNK_TYPE_METADATA);
+		if (metadataReader.getFileSize())
+			score.metadata = readMetadata(&metadataReader, SCORE_VERSION);
+
+		BinaryReader eventsReader = readChunk(CHUNK_TYPE_EVENTS);
+		if (eventsReader.getFileSize())
+			readScoreEvents(score, SCORE_VERSION, &eventsReader);
+
+		BinaryReader tapsReader = readChunk(CHUNK_TYPE_TAPS);
+		if (tapsReader.getFileSize())
+			readTaps(score, &tapsReader);
+
+		BinaryReader holdsReader = readChunk(CHUNK_TYPE_HOLDS);
+		BinaryReader stepsReader = readChunk(CHUNK_TYPE_STEPS);
+		if (holdsReader.getFileSize())
+			readHolds(score, &holdsReader, &stepsReader);
+	}
+
+	void NativeScoreSerializer::readLegacyScore(Score& score, int version, IO::BinaryReader* reader)
+	{
 		uint32_t metadataAddress{};
 		uint32_t eventsAddress{};
 		uint32_t tapsAddress{};
 		uint32_t holdsAddress{};
 		if (version > 2)
 		{
-			metadataAddress = reader.readInt32();
-			eventsAddress = reader.readInt32();
-			tapsAddress = reader.readInt32();
-			holdsAddress = reader.readInt32();
+			metadataAddress = reader->readInt32();
+			eventsAddress = reader->readInt32();
+			tapsAddress = reader->readInt32();
+			holdsAddress = reader->readInt32();
 
-			reader.seek(metadataAddress);
+			reader->seek(metadataAddress);
 		}
 
-		score.metadata = readMetadata(&reader, version);
+		score.metadata = readMetadata(reader, version);
 
 		if (version > 2)
-			reader.seek(eventsAddress);
+			reader->seek(eventsAddress);
 
-		readScoreEvents(score, version, &reader);
+		readScoreEvents(score, version, reader);
 
 		if (version > 2)
-			reader.seek(tapsAddress);
+			reader->seek(tapsAddress);
 
-		int noteCount = reader.readInt32();
+		int noteCount = reader->readInt32();
 		for (int i = 0; i < noteCount; ++i)
 		{
-			Note note = readNote(NoteType::Tap, &reader);
+			Note note = readNote(NoteType::Tap, reader);
 			note.ID = nextID++;
 			score.notes[note.ID] = note;
 		}
 
 		if (version > 2)
-			reader.seek(holdsAddress);
+			reader->seek(holdsAddress);
 
-		int holdCount = reader.readInt32();
+		int holdCount = reader->readInt32();
 		for (int i = 0; i < holdCount; ++i)
 		{
 			HoldNote hold;
 
 			unsigned int flags{};
 			if (version > 3)
-				flags = reader.readInt32();
+				flags = reader->readInt32();
 
 			if (flags & HOLD_START_HIDDEN)
 				hold.startType = HoldNoteType::Hidden;
@@ -305,29 +565,29 @@ namespace MikuMikuWorld
 			if (flags & HOLD_GUIDE)
 				hold.startType = hold.endType = HoldNoteType::Guide;
 
-			Note start = readNote(NoteType::Hold, &reader);
+			Note start = readNote(NoteType::Hold, reader);
 			start.ID = nextID++;
-			hold.start.ease = (EaseType)reader.readInt32();
+			hold.start.ease = (EaseType)reader->readInt32();
 			hold.start.ID = start.ID;
 			score.notes[start.ID] = start;
 
-			int stepCount = reader.readInt32();
+			int stepCount = reader->readInt32();
 			hold.steps.reserve(stepCount);
 			for (int i = 0; i < stepCount; ++i)
 			{
-				Note mid = readNote(NoteType::HoldMid, &reader);
+				Note mid = readNote(NoteType::HoldMid, reader);
 				mid.ID = nextID++;
 				mid.parentID = start.ID;
 				score.notes[mid.ID] = mid;
 
 				HoldStep step{};
-				step.type = (HoldStepType)reader.readInt32();
-				step.ease = (EaseType)reader.readInt32();
+				step.type = (HoldStepType)reader->readInt32();
+				step.ease = (EaseType)reader->readInt32();
 				step.ID = mid.ID;
 				hold.steps.push_back(step);
 			}
 
-			Note end = readNote(NoteType::HoldEnd, &reader);
+			Note end = readNote(NoteType::HoldEnd, reader);
 			end.ID = nextID++;
 			end.parentID = start.ID;
 			score.notes[end.ID] = end;
@@ -335,8 +595,26 @@ namespace MikuMikuWorld
 			hold.end = end.ID;
 			score.holdNotes[start.ID] = hold;
 		}
+	}
+
+	Score NativeScoreSerializer::deserialize(std::string filename)
+	{
+		Score score;
+		BinaryReader reader(filename);
+		if (!reader.isStreamValid())
+			return score;
+
+		std::string signature = reader.readString();
+		if (signature != "MMWS")
+			throw std::runtime_error("Not a MMWS file.");
+
+		int version = reader.readInt32();
+		if (version > 4)
+			readChunkedScore(score, &reader);
+		else
+			readLegacyScore(score, version, &reader);
 
 		reader.close();
 		return score;
 	}
-}
\ No newline at end of file
+}
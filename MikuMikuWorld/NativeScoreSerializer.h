@@ -22,6 +22,27 @@ namespace MikuMikuWorld
 			HOLD_GUIDE = 1 << 2
 		};
 
+		enum ChunkFlags
+		{
+			CHUNK_COMPRESSED = 1 << 0
+		};
+
+		/// <summary>
+		/// An entry of the chunk directory at the start of version 5 files
+		/// </summary>
+		struct ChunkEntry
+		{
+			uint32_t type;
+			uint32_t flags;
+			uint32_t offset;
+			uint32_t size;
+			uint32_t rawSize;
+		};
+
+		bool compressChunks;
+		uint32_t writtenSize{};
+		uint32_t writtenChecksum{};
+
 		Note readNote(NoteType type, IO::BinaryReader* reader);
 		void writeNote(const Note& note, IO::BinaryWriter* writer);
 		ScoreMetadata readMetadata(IO::BinaryReader* reader, int version);
@@ -29,9 +50,36 @@ namespace MikuMikuWorld
 		void readScoreEvents(Score& score, int version, IO::BinaryReader* reader);
 		void writeScoreEvents(const Score& score, IO::BinaryWriter* writer);
 
+		Note readPackedNote(NoteType type, int previousTick, IO::BinaryReader* reader);
+		void writePackedNote(const Note& note, int previousTick, IO::BinaryWriter* writer);
+		void readTaps(Score& score, IO::BinaryReader* reader);
+		void writeTaps(const Score& score, IO::BinaryWriter* writer);
+		void readHolds(Score& score, IO::BinaryReader* holdsReader, IO::BinaryReader* stepsReader);
+		void writeHolds(const Score& score, IO::BinaryWriter* holdsWriter, IO::BinaryWriter* stepsWriter);
+
+		void readChunkedScore(Score& score, IO::BinaryReader* reader);
+		void readLegacyScore(Score& score, int version, IO::BinaryReader* reader);
+
 	public:
 		static const int SCORE_VERSION;
+
+		/// <param name="compressChunks">Whether chunks that shrink with zlib are stored compressed</param>
+		NativeScoreSerializer(bool compressChunks = true);
+
 		void serialize(const Score& score, std::string filename) override;
 		Score deserialize(std::string filename) override;
+
+		/// <summary>
+		/// The size and CRC-32 of the file written by the last call to serialize, taken from the bytes still in memory
+		/// so the file doesn't have to be read back. The size is zero when the file could not be opened.
+		/// </summary>
+		inline uint32_t getWrittenSize() const { return writtenSize; }
+		inline uint32_t getWrittenChecksum() const { return writtenChecksum; }
+
+		/// <summary>
+		/// IDs of the notes in the order serialize writes them, leaving out notes that aren't written such as steps without a hold.
+		/// The order only depends on the notes' contents and the order of their IDs, so a score gives the same order as itself loaded back.
+		/// </summary>
+		static std::vector<int> getNoteOrder(const Score& score);
 	};
 }
\ No newline at end of file
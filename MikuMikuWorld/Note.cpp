@@ -6,8 +6,8 @@
 
 namespace MikuMikuWorld
 {
-	int nextID = 1;
-	int nextSkillID = 1;
+	thread_local int nextID = 1;
+	thread_local int nextSkillID = 1;
 
 	Note::Note(NoteType _type) :
 		type{ _type }, parentID{ -1 }, tick{ 0 }, lane{ 0 }, width{ 3 }, critical { false }, friction{ false }
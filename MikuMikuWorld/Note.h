@@ -56,7 +56,8 @@ namespace MikuMikuWorld
 		FlickArrow
 	};
 
-	extern int nextID;
+	// Thread local so scores can be loaded on several threads at once by the command line tool
+	extern thread_local int nextID;
 
 	class Note
 	{
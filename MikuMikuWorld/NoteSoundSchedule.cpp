@@ -0,0 +1,96 @@
+#include "NoteSoundSchedule.h"
+#include "Score.h"
+#include "Tempo.h"
+#include "Audio/Sound.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace MikuMikuWorld
+{
+	static Audio::SoundPool* findSoundPool(Audio::SoundEffectProfile& soundEffects, std::string_view name)
+	{
+		auto it = soundEffects.pool.find(name);
+		return it == soundEffects.pool.end() ? nullptr : it->second.get();
+	}
+
+	void NoteSoundSchedule::build(const Score& score, const TempoMap& tempoMap, Audio::SoundEffectProfile& soundEffects, int generation, size_t profile)
+	{
+		events.clear();
+		scoreGeneration = generation;
+		profileIndex = profile;
+
+		Audio::SoundPool* connectPool = findSoundPool(soundEffects, SE_CONNECT);
+		Audio::SoundPool* criticalConnectPool = findSoundPool(soundEffects, SE_CRITICAL_CONNECT);
+
+		try
+		{
+			for (const auto& [id, note] : score.notes)
+			{
+				const float time = tempoMap.ticksToSeconds(note.tick);
+				bool playSE = true;
+				if (note.getType() == NoteType::Hold)
+				{
+					const HoldNote& hold = score.holdNotes.at(note.ID);
+					playSE = hold.startType == HoldNoteType::Normal;
+
+					Audio::SoundPool* pool = note.critical ? criticalConnectPool : connectPool;
+					if (!hold.isGuide() && pool)
+						events.push_back({ time, static_cast<float>(tempoMap.ticksToSeconds(score.notes.at(hold.end).tick)), pool });
+				}
+				else if (note.getType() == NoteType::HoldEnd)
+				{
+					playSE = score.holdNotes.at(note.parentID).endType == HoldNoteType::Normal;
+				}
+
+				if (!playSE)
+					continue;
+
+				std::string_view se = getNoteSE(note, score);
+				Audio::SoundPool* pool = se.empty() ? nullptr : findSoundPool(soundEffects, se);
+				if (pool)
+					events.push_back({ time, -1, pool });
+			}
+		}
+		catch (const std::out_of_range&)
+		{
+			// Inconsistent score, nothing can be played from it
+			events.clear();
+		}
+
+		std::sort(events.begin(), events.end(), [](const NoteSoundEvent& a, const NoteSoundEvent& b)
+		{
+			if (a.time != b.time)
+				return a.time < b.time;
+
+			if (a.isHoldConnect() != b.isHoldConnect())
+				return !a.isHoldConnect();
+
+			if (a.pool != b.pool)
+				return std::less<Audio::SoundPool*>()(a.pool, b.pool);
+
+			return a.endTime < b.endTime;
+		});
+
+		// Overlapping hold connects have different ends and are extended by the sound pool instead
+		events.erase(std::unique(events.begin(), events.end(), [](const NoteSoundEvent& a, const NoteSoundEvent& b)
+		{
+			return a.time == b.time && a.pool == b.pool && !a.isHoldConnect() && !b.isHoldConnect();
+		}), events.end());
+	}
+
+	void NoteSoundSchedule::clear()
+	{
+		events.clear();
+		scoreGeneration = -1;
+		profileIndex = 0;
+	}
+
+	size_t NoteSoundSchedule::findFirstEvent(float time) const
+	{
+		return std::lower_bound(events.begin(), events.end(), time, [](const NoteSoundEvent& event, float time)
+		{
+			return event.time < time;
+		}) - events.begin();
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Audio
+{
+	class SoundPool;
+	struct SoundEffectProfile;
+}
+
+namespace MikuMikuWorld
+{
+	struct Score;
+	class TempoMap;
+
+	struct NoteSoundEvent
+	{
+		float time;
+
+		// Hold connects loop until the hold ends, every other sound plays once
+		float endTime;
+		Audio::SoundPool* pool;
+
+		constexpr bool isHoldConnect() const { return endTime >= 0; }
+	};
+
+	/// <summary>
+	/// Every sound effect of the score in the order they play, with their sound pools already looked up
+	/// so playback only advances a cursor through the list instead of searching the notes each frame.
+	/// Notes sharing a tick and a sound effect are merged into one event.
+	/// </summary>
+	class NoteSoundSchedule
+	{
+	private:
+		std::vector<NoteSoundEvent> events;
+		int scoreGeneration{ -1 };
+		size_t profileIndex{};
+
+	public:
+		/// <summary>
+		/// Rebuilds the schedule from the score. The generation and profile index identify what it was built from for isBuiltFor.
+		/// </summary>
+		void build(const Score& score, const TempoMap& tempoMap, Audio::SoundEffectProfile& soundEffects, int generation, size_t profile);
+		void clear();
+
+		inline bool isBuiltFor(int generation, size_t profile) const { return scoreGeneration == generation && profileIndex == profile; }
+		inline const std::vector<NoteSoundEvent>& getEvents() const { return events; }
+
+		/// <summary>
+		/// Returns the index of the first event playing at or after the given time
+		/// </summary>
+		size_t findFirstEvent(float time) const;
+	};
+}
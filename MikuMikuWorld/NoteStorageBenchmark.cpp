@@ -0,0 +1,73 @@
+#include "NoteStorageBenchmark.h"
+#include "Score.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <map>
+#include <random>
+
+namespace mmw = MikuMikuWorld;
+
+namespace Debug
+{
+	// Keeps the compiler from discarding the benchmarked loops
+	static volatile long long benchmarkSink;
+
+	template <typename Container>
+	static NoteStorageTimings measure(const Container& notes, const std::vector<int>& lookupOrder)
+	{
+		constexpr int iterations = 10;
+		NoteStorageTimings timings{};
+		mmw::Stopwatch stopwatch;
+
+		long long sum = 0;
+		stopwatch.reset();
+		for (int i = 0; i < iterations; ++i)
+			for (const auto& [id, note] : notes)
+				sum += note.tick + note.lane;
+		timings.iterate = stopwatch.elapsed() * 1000 / iterations;
+
+		stopwatch.reset();
+		for (int i = 0; i < iterations; ++i)
+			for (int id : lookupOrder)
+				sum += notes.at(id).tick;
+		timings.lookup = stopwatch.elapsed() * 1000 / iterations;
+
+		stopwatch.reset();
+		for (int i = 0; i < iterations; ++i)
+		{
+			Container copy = notes;
+			sum += copy.size();
+		}
+		timings.copy = stopwatch.elapsed() * 1000 / iterations;
+
+		benchmarkSink = sum;
+		return timings;
+	}
+
+	NoteStorageBenchmarkResult benchmarkNoteStorage(int noteCount, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<int> tickDistribution(0, noteCount * 60);
+		std::uniform_int_distribution<int> laneDistribution(mmw::MIN_LANE, mmw::MAX_LANE - 2);
+
+		std::map<int, mmw::Note> map;
+		mmw::SlotMap<mmw::Note> slotMap;
+		slotMap.reserve(noteCount);
+
+		std::vector<int> lookupOrder;
+		lookupOrder.reserve(noteCount);
+
+		for (int id = 1; id <= noteCount; ++id)
+		{
+			mmw::Note note(mmw::NoteType::Tap, tickDistribution(random), laneDistribution(random), 3);
+			note.ID = id;
+
+			map[id] = note;
+			slotMap[id] = note;
+			lookupOrder.push_back(id);
+		}
+
+		std::shuffle(lookupOrder.begin(), lookupOrder.end(), random);
+		return { noteCount, measure(map, lookupOrder), measure(slotMap, lookupOrder) };
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+namespace Debug
+{
+	struct NoteStorageTimings
+	{
+		// Milliseconds spent on each operation
+		double iterate;
+		double lookup;
+		double copy;
+	};
+
+	struct NoteStorageBenchmarkResult
+	{
+		int noteCount;
+		NoteStorageTimings map;
+		NoteStorageTimings slotMap;
+	};
+
+	/// <summary>
+	/// Compares iterating, looking up notes by ID and copying a score's notes when stored in a std::map and in a SlotMap
+	/// </summary>
+	NoteStorageBenchmarkResult benchmarkNoteStorage(int noteCount, unsigned int seed = 0);
+}
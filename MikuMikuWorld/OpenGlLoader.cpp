@@ -4,6 +4,7 @@
 #include "Application.h"
 #include "ApplicationConfiguration.h"
 #include "UI.h"
+#include "Rendering/VertexBuffer.h"
 #include "stb_image.h"
 
 namespace MikuMikuWorld
@@ -100,6 +101,10 @@ namespace MikuMikuWorld
 			return Result(ResultStatus::Error, "Failed to fetch OpenGL proc address.");
 		}
 
+		// Lets the renderer keep its vertex stream mapped, otherwise it maps each write
+		if (glfwExtensionSupported("GL_ARB_buffer_storage"))
+			glBufferStorageProc = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(glfwGetProcAddress("glBufferStorage"));
+
 		glfwSwapInterval(config.vsync);
 		if (config.maximized && !config.fullScreen)
 			glfwMaximizeWindow(window);
@@ -8,8 +8,6 @@ namespace MikuMikuWorld::Effect
 	constexpr float GRAVITY = 9.81f; // Based on default Physics3D
 	constexpr float BILLBOARD_SCALE = 0.71f; // Estimated
 
-	static std::knuth_b rand_engine;
-
 	static DirectX::XMVECTOR quaternionFromZYX(const DirectX::XMVECTOR& euler)
 	{
 		float xRad = DirectX::XMConvertToRadians(DirectX::XMVectorGetX(euler));
@@ -156,7 +154,7 @@ namespace MikuMikuWorld::Effect
 		for (int i = 0; i < count; i++)
 		{
 			int instanceIndex = findFirstDeadParticle(time);
-			if (!isArrayIndexInBounds(instanceIndex, particles))
+			if (instanceIndex < 0 || instanceIndex >= static_cast<int>(particles.size()))
 				return;
 
 			if (i % 4 == 0)
@@ -260,9 +258,9 @@ namespace MikuMikuWorld::Effect
 				float y = sinf(arc) * radius * DirectX::XMVectorGetY(ref.emission.transform.scale);
 				float z = ref.emission.emitFrom == EmitFrom::Volume ? lerp(0, length, shapeRandomSetY[randomSetIndex]) : 0;
 
-				float xRandom = lerp(-ref.emission.randomizeDirection, ref.emission.randomizeDirection, globalRandom.get());
-				float yRandom = lerp(-ref.emission.randomizeDirection, ref.emission.randomizeDirection, globalRandom.get());
-				float zRandom = lerp(-ref.emission.randomizeDirection, ref.emission.randomizeDirection, globalRandom.get());
+				float xRandom = lerp(-ref.emission.randomizeDirection, ref.emission.randomizeDirection, particleRandom.get());
+				float yRandom = lerp(-ref.emission.randomizeDirection, ref.emission.randomizeDirection, particleRandom.get());
+				float zRandom = lerp(-ref.emission.randomizeDirection, ref.emission.randomizeDirection, particleRandom.get());
 
 				emitPosition = DirectX::XMVectorAdd(DirectX::XMVectorSet(x, y, z, 0), DirectX::XMVectorSet(xRandom, yRandom, zRandom, 0));
 				DirectX::XMVECTOR positionNormalized = DirectX::XMVectorSetZ(DirectX::XMVector3Normalize(emitPosition), cosf(angle));
@@ -350,43 +348,13 @@ namespace MikuMikuWorld::Effect
 
 			direction = DirectX::XMVector3Normalize(direction);
 
-			ParticleInstance& instance = particles[instanceIndex];
-			instance.alive = true;
-			instance.transform.position = emitPosition;
-			if (ref.renderMode == RenderMode::Billboard && ref.alignment == AlignmentMode::View)
-				instance.transform.rotation = DirectX::XMLoadFloat3(&startRotation);
-			else
-				instance.transform.rotation = DirectX::XMVectorNegate(DirectX::XMLoadFloat3(&startRotation));
-
-			instance.duration = ref.startLifeTime.evaluate(a);
-			instance.spriteSheetLerpRatio = a;
-			instance.gravityLerpRatio = d;
-
-			instance.startColor = ref.startColor.evaluate(d);
-			instance.colorLerpRatio = d;
-
-			instance.direction = direction;
-			instance.speed = length;
-			instance.startTime = time;
-			instance.time = 0;
-			instance.accumulateVelocityLimit = DirectX::XMVectorZero();
-
-			instance.velocityLerpRatio =
-			{
-				velocityRandomSetX[randomSetIndex],
-				velocityRandomSetY[randomSetIndex],
-				velocityRandomSetZ[randomSetIndex],
-			};
-
-			instance.limitVelocityLerpRatio = velocityRandomSetX[randomSetIndex];
-			instance.forceLerpRatio = velocityRandomSetX[randomSetIndex];
-
-			instance.rotationLerpRatio = e;
-			instance.sizeLerpRatio = sizeRandomSet[randomSetIndex];
+			DirectX::XMVECTOR particleRotation = DirectX::XMLoadFloat3(&startRotation);
+			if (ref.renderMode != RenderMode::Billboard || ref.alignment != AlignmentMode::View)
+				particleRotation = DirectX::XMVectorNegate(particleRotation);
 
 			DirectX::XMFLOAT3 startSize = ref.startSize.is3D ?
 				ref.startSize.evaluate(0, { c, cy, 1 }, 1) : ref.startSize.evaluate(0, c, 1);
-			instance.transform.scale = DirectX::XMVectorMultiply(ref.transform.scale, DirectX::XMLoadFloat3(&startSize));
+			DirectX::XMVECTOR particleScale = DirectX::XMVectorMultiply(ref.transform.scale, DirectX::XMLoadFloat3(&startSize));
 
 			// world transform will be included during emission for world space
 			// for local space, the world transform will be included during particle update 
@@ -397,13 +365,46 @@ namespace MikuMikuWorld::Effect
 				worldOffset *= DirectX::XMMatrixRotationQuaternion(qShift);
 				worldOffset *= DirectX::XMMatrixTranslationFromVector(worldTransform.position);
 
-				instance.transform.position = DirectX::XMVector3Transform(instance.transform.position, worldOffset);
-				instance.transform.rotation = DirectX::XMVectorAdd(instance.transform.rotation, worldTransform.rotation);
-				instance.direction = DirectX::XMVector3Rotate(instance.direction, qShift);
+				emitPosition = DirectX::XMVector3Transform(emitPosition, worldOffset);
+				particleRotation = DirectX::XMVectorAdd(particleRotation, worldTransform.rotation);
+				direction = DirectX::XMVector3Rotate(direction, qShift);
 			}
 
-			std::bernoulli_distribution flipRotationRoll(ref.flipRotation);
-			instance.flipRotation = flipRotationRoll(rand_engine);
+			const size_t index = instanceIndex;
+			particles.positionX[index] = DirectX::XMVectorGetX(emitPosition);
+			particles.positionY[index] = DirectX::XMVectorGetY(emitPosition);
+			particles.positionZ[index] = DirectX::XMVectorGetZ(emitPosition);
+			particles.rotationX[index] = DirectX::XMVectorGetX(particleRotation);
+			particles.rotationY[index] = DirectX::XMVectorGetY(particleRotation);
+			particles.rotationZ[index] = DirectX::XMVectorGetZ(particleRotation);
+			particles.scaleX[index] = DirectX::XMVectorGetX(particleScale);
+			particles.scaleY[index] = DirectX::XMVectorGetY(particleScale);
+			particles.scaleZ[index] = DirectX::XMVectorGetZ(particleScale);
+			particles.directionX[index] = DirectX::XMVectorGetX(direction);
+			particles.directionY[index] = DirectX::XMVectorGetY(direction);
+			particles.directionZ[index] = DirectX::XMVectorGetZ(direction);
+			particles.velocityLimitX[index] = particles.velocityLimitY[index] = particles.velocityLimitZ[index] = 0;
+
+			particles.duration[index] = ref.startLifeTime.evaluate(a);
+			particles.spriteSheetLerpRatio[index] = a;
+			particles.gravityLerpRatio[index] = d;
+
+			particles.startColor[index] = ref.startColor.evaluate(d);
+			particles.colorLerpRatio[index] = d;
+
+			particles.speed[index] = length;
+			particles.startTime[index] = time;
+			particles.time[index] = 0;
+
+			// Only the first component of the velocity random set is used by the simulation
+			particles.velocityLerpRatio[index] = velocityRandomSetX[randomSetIndex];
+			particles.limitVelocityLerpRatio[index] = velocityRandomSetX[randomSetIndex];
+			particles.forceLerpRatio[index] = velocityRandomSetX[randomSetIndex];
+
+			particles.rotationLerpRatio[index] = e;
+			particles.sizeLerpRatio[index] = sizeRandomSet[randomSetIndex];
+
+			particles.rotationFactor[index] = particleRandom.get() < ref.flipRotation ? -1.f : 1.f;
 			aliveCount++;
 		}
 	}
@@ -456,30 +457,41 @@ namespace MikuMikuWorld::Effect
 	}
 
 	void EmitterInstance::start(float time)
+	{
+		start(time, globalRandom);
+	}
+
+	void EmitterInstance::start(float time, uint32_t seed)
+	{
+		Random random;
+		random.setSeed(seed);
+		start(time, random);
+	}
+
+	void EmitterInstance::start(float time, Random& random)
 	{
 		const Particle& ref = ResourceManager::getParticleEffect(refID);
 
 		uint32_t seed = ref.randomSeed;
 		if (ref.useAutoRandomSeed)
-			seed = globalRandom.get() * std::numeric_limits<uint32_t>::max();
+			seed = random.get() * std::numeric_limits<uint32_t>::max();
 
 		initialRandom.setSeed(seed);
 		shapeRandom4.setSeed(seed);
 		velocityRandom.setSeed(seed);
 		sizeRandom.setSeed(seed);
+		particleRandom.setSeed(seed);
 
-		float emissionRandom = globalRandom.get();
-		float arcSpeedRandom = globalRandom.get();
+		float emissionRandom = random.get();
+		float arcSpeedRandom = random.get();
 
 		startTime = time + ref.startDelay.evaluate(0, emissionRandom);
 		rateOverTime = ref.emission.rateOverTime.evaluate(0, emissionRandom);
 		arcSpeed = arcSpeedRandom;
 
 		int maxParticleCount = getMaxParticleCount();
-		particles.reserve(maxParticleCount);
-		
 		if (maxParticleCount > particles.size())
-			particles.insert(particles.end(), maxParticleCount - particles.size(), {});
+			particles.resize(maxParticleCount);
 
 		for (auto& burst : bursts)
 			burst.nextCyclesResetTime = startTime + ref.duration;
@@ -488,7 +500,7 @@ namespace MikuMikuWorld::Effect
 
 		for (auto& child : children)
 		{
-			child.start(time);
+			child.start(time, random);
 			maxDuration = std::max(maxDuration, child.maxDuration);
 		}
 	}
@@ -508,9 +520,6 @@ namespace MikuMikuWorld::Effect
 			burst.nextCyclesResetTime = 0;
 		}
 
-		for (auto& p : particles)
-			p.alive = false;
-
 		if (allChildren)
 		{
 			for (auto& child : children)
@@ -562,8 +571,104 @@ namespace MikuMikuWorld::Effect
 		), velocitySignVector);
 	}
 
+	template <typename Func>
+	void ParticleStore::forEachArray(Func&& func)
+	{
+		for (auto* values : {
+			&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &scaleX, &scaleY, &scaleZ,
+			&directionX, &directionY, &directionZ, &velocityLimitX, &velocityLimitY, &velocityLimitZ,
+			&startTime, &time, &duration, &speed, &deltaTime, &velocityLerpRatio, &gravityLerpRatio, &spriteSheetLerpRatio,
+			&sizeLerpRatio, &colorLerpRatio, &limitVelocityLerpRatio, &forceLerpRatio, &rotationLerpRatio, &rotationFactor })
+		{
+			func(*values);
+		}
+
+		func(startColor);
+		func(matrix);
+	}
+
+	void ParticleStore::resize(size_t count)
+	{
+		// Padding lanes are simulated along with the last particles, so they must hold valid numbers
+		const size_t paddedCount = (count + 3) & ~size_t{ 3 };
+		forEachArray([paddedCount](auto& values) { values.resize(paddedCount); });
+		std::fill(duration.begin() + this->count, duration.end(), 1.f);
+		std::fill(rotationFactor.begin() + this->count, rotationFactor.end(), 1.f);
+		this->count = count;
+	}
+
+	void ParticleStore::swap(size_t a, size_t b)
+	{
+		forEachArray([a, b](auto& values) { std::swap(values[a], values[b]); });
+	}
+
+	void EmitterInstance::updateParticleTimes(float t)
+	{
+		for (int i = 0; i < aliveCount; i++)
+		{
+			float dt = t - particles.startTime[i] - particles.time[i];
+			particles.time[i] = t - particles.startTime[i];
+			particles.deltaTime[i] = dt;
+
+			float normalizedTime = particles.time[i] / particles.duration[i];
+			if (normalizedTime < 0)
+				continue;
+
+			if (particles.time[i] >= particles.duration[i])
+			{
+				particles.swap(i, aliveCount - 1);
+				aliveCount--;
+
+				i--;
+			}
+		}
+	}
+
+	// The components of four matrix rows, one vector per component
+	struct MatrixRow4
+	{
+		DirectX::XMVECTOR x, y, z, w;
+	};
+
+	// Multiplies a row of four matrices with a matrix shared by all of them
+	static MatrixRow4 multiplyRow(const MatrixRow4& row, const DirectX::XMFLOAT4X4& m)
+	{
+		MatrixRow4 result{};
+		DirectX::XMVECTOR* components[] = { &result.x, &result.y, &result.z, &result.w };
+		for (int c = 0; c < 4; c++)
+		{
+			DirectX::XMVECTOR value = DirectX::XMVectorMultiply(row.x, DirectX::XMVectorReplicate(m.m[0][c]));
+			value = DirectX::XMVectorMultiplyAdd(row.y, DirectX::XMVectorReplicate(m.m[1][c]), value);
+			value = DirectX::XMVectorMultiplyAdd(row.z, DirectX::XMVectorReplicate(m.m[2][c]), value);
+			*components[c] = DirectX::XMVectorMultiplyAdd(row.w, DirectX::XMVectorReplicate(m.m[3][c]), value);
+		}
+
+		return result;
+	}
+
+	// Rotates four vectors by a rotation shared by all of them
+	static Vector3x4 rotateVectors(const Vector3x4& v, const DirectX::XMFLOAT4X4& m)
+	{
+		MatrixRow4 row = multiplyRow({ v.x, v.y, v.z, DirectX::XMVectorZero() }, m);
+		return { row.x, row.y, row.z };
+	}
+
+	static DirectX::XMVECTOR load4(const std::vector<float>& values, int index)
+	{
+		return DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4*>(values.data() + index));
+	}
+
+	static void store4(std::vector<float>& values, int index, DirectX::FXMVECTOR value)
+	{
+		DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(values.data() + index), value);
+	}
+
 	void EmitterInstance::updateParticles(const Particle& ref, float t, const Transform& worldTransform, const Camera& camera)
 	{
+		updateParticleTimes(t);
+		if (aliveCount == 0)
+			return;
+
 		const DirectX::XMMATRIX& inverseView = camera.getInverseViewMatrix();
 		DirectX::XMVECTOR qLocal = quaternionFromZYX(baseTransform.rotation);
 		DirectX::XMVECTOR qShift = quaternionFromZYX(worldTransform.rotation);
@@ -578,142 +683,353 @@ namespace MikuMikuWorld::Effect
 
 		const bool isViewAligned = ref.renderMode == RenderMode::Billboard && ref.alignment == AlignmentMode::View;
 		const bool isWorldAligned = ref.renderMode == RenderMode::Billboard && ref.alignment == AlignmentMode::World;
+		const bool isStretched = ref.renderMode == RenderMode::StretchedBillboard;
+		const bool isHorizontal = ref.renderMode == RenderMode::HorizontalBillboard;
+		const bool isLocalSpace = ref.simulationSpace == TransformSpace::Local;
+
+		// Apparently, the transform scale affects velocity too
+		// Need to make sure hierarchy scale affects velocity too
+		DirectX::XMVECTOR hierarchyScale = DirectX::XMVectorSplatOne();
+		DirectX::XMVECTOR velocityScale = ref.transform.scale;
+		if (ref.scalingMode == ScalingMode::Hierarchy)
+		{
+			hierarchyScale = baseTransform.scale;
+			velocityScale = DirectX::XMVectorMultiply(velocityScale, baseTransform.scale);
+		}
 
-
-		for (int i = 0; i < aliveCount; i++)
+		DirectX::XMMATRIX directionMatrix = DirectX::XMMatrixIdentity();
+		if (isViewAligned || ref.renderMode == RenderMode::VerticalBillboard)
 		{
-			float dt = t - particles[i].startTime - particles[i].time;
-			particles[i].time = t - particles[i].startTime;
-			float normalizedTime = particles[i].time / particles[i].duration;
+			// TODO: figure out the correct matrix for vertical billboards
+			directionMatrix = inverseView;
+		}
 
-			if (normalizedTime < 0)
-				continue;
+		const float billboardScale = isHorizontal || ref.renderMode == RenderMode::VerticalBillboard ? BILLBOARD_SCALE : 1.f;
 
-			if (particles[i].time >= particles[i].duration)
-			{
-				particles[i].alive = false;
-				std::swap(particles[i], particles[aliveCount - 1]);
-				aliveCount--;
+		DirectX::XMFLOAT4X4 localRotationMatrix, directionMatrix4, worldOffsetMatrix;
+		DirectX::XMStoreFloat4x4(&localRotationMatrix, DirectX::XMMatrixRotationQuaternion(qLocal));
+		DirectX::XMStoreFloat4x4(&directionMatrix4, directionMatrix);
+		DirectX::XMStoreFloat4x4(&worldOffsetMatrix, worldOffset);
 
-				i--;
-				continue;
-			}
+		const DirectX::XMVECTOR zero = DirectX::XMVectorZero();
+		const DirectX::XMVECTOR laneIndices = DirectX::XMVectorSet(0, 1, 2, 3);
+		const DirectX::XMVECTOR degreesToRadians = DirectX::XMVectorReplicate(DirectX::XM_PI / 180.0f);
 
-			auto& p = particles[i];
+		// Four particles per iteration. The arrays are padded, so the lanes past the alive particles are
+		// simulated too but never written back.
+		for (int i = 0; i < aliveCount; i += 4)
+		{
+			DirectX::XMVECTOR time = load4(particles.time, i);
+			DirectX::XMVECTOR duration = load4(particles.duration, i);
+			DirectX::XMVECTOR dt = load4(particles.deltaTime, i);
+			DirectX::XMVECTOR normalizedTime = DirectX::XMVectorDivide(time, duration);
+
+			// Particles whose start time has not been reached yet are left as they are
+			DirectX::XMVECTOR aliveLanes = DirectX::XMVectorLess(laneIndices, DirectX::XMVectorReplicate(static_cast<float>(aliveCount - i)));
+			DirectX::XMVECTOR activeLanes = DirectX::XMVectorAndCInt(aliveLanes, DirectX::XMVectorLess(normalizedTime, zero));
+			uint32_t active[4];
+			DirectX::XMStoreInt4(active, activeLanes);
+			if (!(active[0] | active[1] | active[2] | active[3]))
+				continue;
 
-			DirectX::XMVECTOR currentRotation = isViewAligned || isWorldAligned ? p.transform.rotation : DirectX::XMVectorAdd(rotation, p.transform.rotation);
-			if (ref.rotationOverLifetime.enabled)
+			Vector3x4 currentRotation{ load4(particles.rotationX, i), load4(particles.rotationY, i), load4(particles.rotationZ, i) };
+			if (!isViewAligned && !isWorldAligned)
 			{
-				DirectX::XMFLOAT3 temp = ref.rotationOverLifetime.integrate(0, normalizedTime, p.duration, p.rotationLerpRatio);
-				currentRotation = DirectX::XMVectorSubtract(currentRotation, DirectX::XMLoadFloat3(&temp));
+				currentRotation.x = DirectX::XMVectorAdd(DirectX::XMVectorSplatX(rotation), currentRotation.x);
+				currentRotation.y = DirectX::XMVectorAdd(DirectX::XMVectorSplatY(rotation), currentRotation.y);
+				currentRotation.z = DirectX::XMVectorAdd(DirectX::XMVectorSplatZ(rotation), currentRotation.z);
 			}
 
-			// Apparently, the transform scale affects velocity too
-			// Need to make sure hierarchy scale affects velocity too
-			DirectX::XMVECTOR currentScale = p.transform.scale;
-			DirectX::XMVECTOR velocityScale = ref.transform.scale;
-			if (ref.scalingMode == ScalingMode::Hierarchy)
+			if (ref.rotationOverLifetime.enabled)
 			{
-				currentScale = DirectX::XMVectorMultiply(currentScale, baseTransform.scale);
-				velocityScale = DirectX::XMVectorMultiply(velocityScale, baseTransform.scale);
+				Vector3x4 rol = ref.rotationOverLifetime.integrate4(0, normalizedTime, duration, load4(particles.rotationLerpRatio, i));
+				currentRotation.x = DirectX::XMVectorSubtract(currentRotation.x, rol.x);
+				currentRotation.y = DirectX::XMVectorSubtract(currentRotation.y, rol.y);
+				currentRotation.z = DirectX::XMVectorSubtract(currentRotation.z, rol.z);
 			}
 
+			Vector3x4 currentScale{
+				DirectX::XMVectorMultiply(load4(particles.scaleX, i), DirectX::XMVectorSplatX(hierarchyScale)),
+				DirectX::XMVectorMultiply(load4(particles.scaleY, i), DirectX::XMVectorSplatY(hierarchyScale)),
+				DirectX::XMVectorMultiply(load4(particles.scaleZ, i), DirectX::XMVectorSplatZ(hierarchyScale))
+			};
+
 			if (ref.sizeOverLifetime.enabled)
 			{
-				DirectX::XMFLOAT3 sol = ref.sizeOverLifetime.evaluate(normalizedTime, p.sizeLerpRatio, 1.f);
-				currentScale = DirectX::XMVectorMultiply(currentScale, DirectX::XMLoadFloat3(&sol));
+				Vector3x4 sol = ref.sizeOverLifetime.evaluate4(normalizedTime, load4(particles.sizeLerpRatio, i), 1.f);
+				currentScale.x = DirectX::XMVectorMultiply(currentScale.x, sol.x);
+				currentScale.y = DirectX::XMVectorMultiply(currentScale.y, sol.y);
+				currentScale.z = DirectX::XMVectorMultiply(currentScale.z, sol.z);
 			}
 
-			DirectX::XMVECTOR currentVelocity{};
+			const DirectX::XMVECTOR velocityLerpRatio = load4(particles.velocityLerpRatio, i);
+			Vector3x4 currentVelocity{ zero, zero, zero };
 			if (ref.velocityOverLifetime.enabled)
 			{
-				DirectX::XMFLOAT3 vol = ref.velocityOverLifetime.evaluate(normalizedTime, p.velocityLerpRatio.x);
-				DirectX::XMVECTOR vol1 = DirectX::XMLoadFloat3(&vol);
+				Vector3x4 vol = ref.velocityOverLifetime.evaluate4(normalizedTime, velocityLerpRatio);
 				if (ref.velocitySpace == TransformSpace::Local)
-				{
-					vol1 = DirectX::XMVector3Rotate(vol1, qLocal);
-				}
-				currentVelocity = DirectX::XMVectorAdd(currentVelocity, vol1);
+					vol = rotateVectors(vol, localRotationMatrix);
+
+				currentVelocity = vol;
 			}
 
 			if (ref.forceOverLifetime.enabled)
 			{
-				DirectX::XMFLOAT3 fol = ref.forceOverLifetime.integrate(0, normalizedTime, p.duration, p.forceLerpRatio);
-				DirectX::XMVECTOR fol1 = DirectX::XMLoadFloat3(&fol);
+				Vector3x4 fol = ref.forceOverLifetime.integrate4(0, normalizedTime, duration, load4(particles.forceLerpRatio, i));
 				if (ref.forceSpace == TransformSpace::Local)
+					fol = rotateVectors(fol, localRotationMatrix);
+
+				currentVelocity.x = DirectX::XMVectorAdd(currentVelocity.x, fol.x);
+				currentVelocity.y = DirectX::XMVectorAdd(currentVelocity.y, fol.y);
+				currentVelocity.z = DirectX::XMVectorAdd(currentVelocity.z, fol.z);
+			}
+
+			DirectX::XMVECTOR speed = load4(particles.speed, i);
+			DirectX::XMVECTOR speedModifier = ref.speedModifier.evaluate4(normalizedTime, velocityLerpRatio, 1.f);
+			currentVelocity.x = DirectX::XMVectorMultiply(DirectX::XMVectorMultiplyAdd(load4(particles.directionX, i), speed, currentVelocity.x), speedModifier);
+			currentVelocity.y = DirectX::XMVectorMultiply(DirectX::XMVectorMultiplyAdd(load4(particles.directionY, i), speed, currentVelocity.y), speedModifier);
+			currentVelocity.z = DirectX::XMVectorMultiply(DirectX::XMVectorMultiplyAdd(load4(particles.directionZ, i), speed, currentVelocity.z), speedModifier);
+
+			DirectX::XMVECTOR gravityModifier = ref.gravityModifier.evaluate4(normalizedTime, load4(particles.gravityLerpRatio, i));
+			DirectX::XMVECTOR gravity = DirectX::XMVectorMultiply(DirectX::XMVectorScale(gravityModifier, GRAVITY), time);
+			currentVelocity.x = DirectX::XMVectorMultiply(currentVelocity.x, DirectX::XMVectorSplatX(velocityScale));
+			currentVelocity.y = DirectX::XMVectorMultiplyAdd(currentVelocity.y, DirectX::XMVectorSplatY(velocityScale), DirectX::XMVectorNegate(gravity));
+			currentVelocity.z = DirectX::XMVectorMultiply(currentVelocity.z, DirectX::XMVectorSplatZ(velocityScale));
+
+			if (ref.limitVelocityOverLifetime.enabled)
+			{
+				// The velocity limit accumulates per particle and depends on each particle's time step, so it is applied lane by lane
+				Vector3x4 velocityLimit = ref.limitVelocityOverLifetime.evaluate4(normalizedTime, load4(particles.limitVelocityLerpRatio, i));
+				for (int lane = 0; lane < 4; lane++)
 				{
-					fol1 = DirectX::XMVector3Rotate(fol1, qLocal);
+					if (!active[lane])
+						continue;
+
+					const int index = i + lane;
+					DirectX::XMVECTOR accumulator = DirectX::XMVectorSet(particles.velocityLimitX[index], particles.velocityLimitY[index], particles.velocityLimitZ[index], 0);
+					DirectX::XMVECTOR velocity = DirectX::XMVectorSet(DirectX::XMVectorGetByIndex(currentVelocity.x, lane),
+						DirectX::XMVectorGetByIndex(currentVelocity.y, lane), DirectX::XMVectorGetByIndex(currentVelocity.z, lane), 0);
+					DirectX::XMFLOAT3 limit(DirectX::XMVectorGetByIndex(velocityLimit.x, lane),
+						DirectX::XMVectorGetByIndex(velocityLimit.y, lane), DirectX::XMVectorGetByIndex(velocityLimit.z, lane));
+
+					velocity = limitVelocity(velocity, limit, accumulator, ref.limitVelocityDampen, particles.deltaTime[index]);
+
+					particles.velocityLimitX[index] = DirectX::XMVectorGetX(accumulator);
+					particles.velocityLimitY[index] = DirectX::XMVectorGetY(accumulator);
+					particles.velocityLimitZ[index] = DirectX::XMVectorGetZ(accumulator);
+					currentVelocity.x = DirectX::XMVectorSetByIndex(currentVelocity.x, DirectX::XMVectorGetX(velocity), lane);
+					currentVelocity.y = DirectX::XMVectorSetByIndex(currentVelocity.y, DirectX::XMVectorGetY(velocity), lane);
+					currentVelocity.z = DirectX::XMVectorSetByIndex(currentVelocity.z, DirectX::XMVectorGetZ(velocity), lane);
 				}
-				currentVelocity = DirectX::XMVectorAdd(currentVelocity, fol1);
 			}
 
-			float speedModifier = ref.speedModifier.evaluate(normalizedTime, p.velocityLerpRatio.x, 1.f);
-			currentVelocity = DirectX::XMVectorMultiplyAdd(p.direction, DirectX::XMVectorReplicate(p.speed), currentVelocity);
-			currentVelocity = DirectX::XMVectorMultiply(currentVelocity, DirectX::XMVectorReplicate(speedModifier));
+			Vector3x4 position{
+				DirectX::XMVectorSelect(load4(particles.positionX, i), DirectX::XMVectorAdd(DirectX::XMVectorMultiply(currentVelocity.x, dt), load4(particles.positionX, i)), activeLanes),
+				DirectX::XMVectorSelect(load4(particles.positionY, i), DirectX::XMVectorAdd(DirectX::XMVectorMultiply(currentVelocity.y, dt), load4(particles.positionY, i)), activeLanes),
+				DirectX::XMVectorSelect(load4(particles.positionZ, i), DirectX::XMVectorAdd(DirectX::XMVectorMultiply(currentVelocity.z, dt), load4(particles.positionZ, i)), activeLanes)
+			};
+			store4(particles.positionX, i, position.x);
+			store4(particles.positionY, i, position.y);
+			store4(particles.positionZ, i, position.z);
 
-			float gravity = GRAVITY * ref.gravityModifier.evaluate(normalizedTime, p.gravityLerpRatio) * p.time;
-			DirectX::XMVECTOR gravityVector = DirectX::XMVectorSet(0, -gravity, 0, 0);
-			currentVelocity = DirectX::XMVectorMultiplyAdd(currentVelocity, velocityScale, gravityVector);
-			
-			if (ref.limitVelocityOverLifetime.enabled)
+			const DirectX::XMVECTOR rotationFactor = load4(particles.rotationFactor, i);
+			if (isHorizontal)
 			{
-				DirectX::XMFLOAT3 velocityLimit = ref.limitVelocityOverLifetime.evaluate(normalizedTime, p.limitVelocityLerpRatio);
-				currentVelocity = limitVelocity(currentVelocity, velocityLimit, p.accumulateVelocityLimit, ref.limitVelocityDampen, dt);
+				currentRotation.x = DirectX::XMVectorScale(rotationFactor, 90.f);
+				currentRotation.y = zero;
 			}
 
-			p.transform.position = DirectX::XMVectorAdd(
-				DirectX::XMVectorMultiply(currentVelocity, DirectX::XMVectorReplicate(dt)),
-				p.transform.position
-			);
+			currentRotation.x = DirectX::XMVectorMultiply(currentRotation.x, rotationFactor);
+			currentRotation.y = DirectX::XMVectorMultiply(currentRotation.y, rotationFactor);
+			currentRotation.z = DirectX::XMVectorMultiply(currentRotation.z, rotationFactor);
 
-			float rotationFactor = p.flipRotation ? -1 : 1;
+			if (isStretched)
+			{
+				// The direction matrix of stretched billboards depends on each particle's velocity
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (!active[lane])
+						continue;
+
+					DirectX::XMVECTOR scale = DirectX::XMVectorSet(DirectX::XMVectorGetByIndex(currentScale.x, lane),
+						DirectX::XMVectorGetByIndex(currentScale.y, lane), DirectX::XMVectorGetByIndex(currentScale.z, lane), 0);
+					DirectX::XMVECTOR velocity = DirectX::XMVectorSet(DirectX::XMVectorGetByIndex(currentVelocity.x, lane),
+						DirectX::XMVectorGetByIndex(currentVelocity.y, lane), DirectX::XMVectorGetByIndex(currentVelocity.z, lane), 0);
+					DirectX::XMVECTOR particleRotation = DirectX::XMVectorSet(DirectX::XMVectorGetByIndex(currentRotation.x, lane),
+						DirectX::XMVectorGetByIndex(currentRotation.y, lane), DirectX::XMVectorGetByIndex(currentRotation.z, lane), 0);
+					DirectX::XMVECTOR particlePosition = DirectX::XMVectorSet(DirectX::XMVectorGetByIndex(position.x, lane),
+						DirectX::XMVectorGetByIndex(position.y, lane), DirectX::XMVectorGetByIndex(position.z, lane), 1);
+
+					DirectX::XMMATRIX m4Rotation = DirectX::XMMatrixRotationQuaternion(quaternionFromZYX(particleRotation));
+					DirectX::XMMATRIX stretchMatrix = rotateToDirection(ref, velocity, scale) * DirectX::XMMatrixInverse(nullptr, m4Rotation);
+
+					DirectX::XMMATRIX& matrix = particles.matrix[i + lane];
+					matrix = DirectX::XMMatrixScalingFromVector(DirectX::XMVectorSetY(scale, 1.f));
+					matrix *= DirectX::XMMatrixTranslationFromVector(DirectX::XMVectorMultiply(pivot, scale));
+					matrix *= stretchMatrix;
+					matrix *= m4Rotation;
+					matrix *= DirectX::XMMatrixTranslationFromVector(particlePosition);
+
+					if (isLocalSpace)
+						matrix *= worldOffset;
+				}
+
+				continue;
+			}
+
+			// scale * translation(pivot) * direction, built directly from the rows of the direction matrix
+			const Vector3x4 pivotOffset{
+				DirectX::XMVectorMultiply(DirectX::XMVectorSplatX(pivot), currentScale.x),
+				DirectX::XMVectorMultiply(DirectX::XMVectorSplatY(pivot), currentScale.y),
+				DirectX::XMVectorMultiply(DirectX::XMVectorSplatZ(pivot), currentScale.z)
+			};
+
+			const DirectX::XMVECTOR scales[] = {
+				DirectX::XMVectorScale(currentScale.x, billboardScale),
+				DirectX::XMVectorScale(currentScale.y, billboardScale),
+				DirectX::XMVectorScale(currentScale.z, billboardScale)
+			};
 
-			p.matrix = DirectX::XMMatrixIdentity();
-			DirectX::XMMATRIX directionMatrix = DirectX::XMMatrixIdentity();
-			DirectX::XMVECTOR pivotScale = currentScale;
-			switch (ref.renderMode)
+			MatrixRow4 rows[4];
+			for (int r = 0; r < 3; r++)
 			{
-			case RenderMode::Billboard:
-				switch (ref.alignment)
+				const float* d = directionMatrix4.m[r];
+				rows[r] = {
+					DirectX::XMVectorScale(scales[r], d[0]), DirectX::XMVectorScale(scales[r], d[1]),
+					DirectX::XMVectorScale(scales[r], d[2]), DirectX::XMVectorScale(scales[r], d[3])
+				};
+			}
+			rows[3] = multiplyRow({ pivotOffset.x, pivotOffset.y, pivotOffset.z, DirectX::XMVectorSplatOne() }, directionMatrix4);
+
+			// Rotation matrix of the ZYX euler angles
+			DirectX::XMVECTOR sx, cx, sy, cy, sz, cz;
+			DirectX::XMVectorSinCos(&sx, &cx, DirectX::XMVectorMultiply(currentRotation.x, degreesToRadians));
+			DirectX::XMVectorSinCos(&sy, &cy, DirectX::XMVectorMultiply(currentRotation.y, degreesToRadians));
+			DirectX::XMVectorSinCos(&sz, &cz, DirectX::XMVectorMultiply(currentRotation.z, degreesToRadians));
+
+			const DirectX::XMVECTOR czsy = DirectX::XMVectorMultiply(cz, sy);
+			const DirectX::XMVECTOR szsy = DirectX::XMVectorMultiply(sz, sy);
+			const DirectX::XMVECTOR r[3][3] = {
 				{
-				case AlignmentMode::View:
-					directionMatrix = inverseView;
-					break;
+					DirectX::XMVectorMultiply(cz, cy),
+					DirectX::XMVectorMultiplyAdd(sz, cx, DirectX::XMVectorMultiply(czsy, sx)),
+					DirectX::XMVectorNegativeMultiplySubtract(czsy, cx, DirectX::XMVectorMultiply(sz, sx))
+				},
+				{
+					DirectX::XMVectorNegate(DirectX::XMVectorMultiply(sz, cy)),
+					DirectX::XMVectorNegativeMultiplySubtract(szsy, sx, DirectX::XMVectorMultiply(cz, cx)),
+					DirectX::XMVectorMultiplyAdd(cz, sx, DirectX::XMVectorMultiply(szsy, cx))
+				},
+				{
+					sy,
+					DirectX::XMVectorNegate(DirectX::XMVectorMultiply(cy, sx)),
+					DirectX::XMVectorMultiply(cy, cx)
 				}
-				break;
-			case RenderMode::StretchedBillboard:
-				directionMatrix = rotateToDirection(ref, currentVelocity, currentScale);
-				currentScale = DirectX::XMVectorSetY(currentScale, 1.f);
-				break;
-			case RenderMode::HorizontalBillboard:
-				currentRotation = DirectX::XMVectorSetX(currentRotation, 90.f * rotationFactor);
-				currentRotation = DirectX::XMVectorSetY(currentRotation, 0);
-				currentScale = DirectX::XMVectorScale(currentScale, BILLBOARD_SCALE);
-				break;
-			case RenderMode::VerticalBillboard:
-				// TODO: figure out the correct matrix for this
-				directionMatrix = inverseView;
-				currentScale = DirectX::XMVectorScale(currentScale, BILLBOARD_SCALE);
-				break;
+			};
+
+			for (MatrixRow4& row : rows)
+			{
+				// * rotation * translation(position)
+				MatrixRow4 rotated{};
+				DirectX::XMVECTOR* components[] = { &rotated.x, &rotated.y, &rotated.z };
+				const DirectX::XMVECTOR* translation[] = { &position.x, &position.y, &position.z };
+				for (int c = 0; c < 3; c++)
+				{
+					DirectX::XMVECTOR value = DirectX::XMVectorMultiply(row.x, r[0][c]);
+					value = DirectX::XMVectorMultiplyAdd(row.y, r[1][c], value);
+					value = DirectX::XMVectorMultiplyAdd(row.z, r[2][c], value);
+					*components[c] = DirectX::XMVectorMultiplyAdd(row.w, *translation[c], value);
+				}
+				rotated.w = row.w;
+
+				row = isLocalSpace ? multiplyRow(rotated, worldOffsetMatrix) : rotated;
+			}
+
+			// Transpose the rows of four matrices into four matrices
+			DirectX::XMMATRIX transposed[4];
+			for (int row = 0; row < 4; row++)
+				transposed[row] = DirectX::XMMatrixTranspose(DirectX::XMMATRIX(rows[row].x, rows[row].y, rows[row].z, rows[row].w));
+
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (!active[lane])
+					continue;
+
+				DirectX::XMMATRIX& matrix = particles.matrix[i + lane];
+				for (int row = 0; row < 4; row++)
+					matrix.r[row] = transposed[row].r[lane];
 			}
+		}
+	}
 
-			if (p.flipRotation)
-				currentRotation = DirectX::XMVectorNegate(currentRotation);
+	DirectX::XMMATRIX EmitterInstance::calculateParticleMatrix(const Particle& ref, int index, const Transform& worldTransform, const Camera& camera) const
+	{
+		const float time = particles.time[index];
+		const float duration = particles.duration[index];
+		const float normalizedTime = time / duration;
+		const bool isViewAligned = ref.renderMode == RenderMode::Billboard && ref.alignment == AlignmentMode::View;
+		const bool isWorldAligned = ref.renderMode == RenderMode::Billboard && ref.alignment == AlignmentMode::World;
 
-			p.matrix *= DirectX::XMMatrixScalingFromVector(currentScale);
-			p.matrix *= DirectX::XMMatrixTranslationFromVector(DirectX::XMVectorMultiply(pivot, pivotScale));
-			DirectX::XMMATRIX m4Rotation = DirectX::XMMatrixRotationQuaternion(quaternionFromZYX(currentRotation));
+		DirectX::XMVECTOR currentRotation = DirectX::XMVectorSet(particles.rotationX[index], particles.rotationY[index], particles.rotationZ[index], 0);
+		if (!isViewAligned && !isWorldAligned)
+			currentRotation = DirectX::XMVectorAdd(DirectX::XMVectorAdd(baseTransform.rotation, ref.transform.rotation), currentRotation);
 
-			if (ref.renderMode == RenderMode::StretchedBillboard)
-				directionMatrix *= DirectX::XMMatrixInverse(nullptr, m4Rotation);
+		if (ref.rotationOverLifetime.enabled)
+		{
+			DirectX::XMFLOAT3 rol = ref.rotationOverLifetime.integrate(0, normalizedTime, duration, particles.rotationLerpRatio[index]);
+			currentRotation = DirectX::XMVectorSubtract(currentRotation, DirectX::XMLoadFloat3(&rol));
+		}
 
-			p.matrix *= directionMatrix;
-			p.matrix *= m4Rotation;
-			p.matrix *= DirectX::XMMatrixTranslationFromVector(p.transform.position);
+		DirectX::XMVECTOR currentScale = DirectX::XMVectorSet(particles.scaleX[index], particles.scaleY[index], particles.scaleZ[index], 0);
+		if (ref.scalingMode == ScalingMode::Hierarchy)
+			currentScale = DirectX::XMVectorMultiply(currentScale, baseTransform.scale);
 
-			if (ref.simulationSpace == TransformSpace::Local)
-				p.matrix *= worldOffset;
+		if (ref.sizeOverLifetime.enabled)
+		{
+			DirectX::XMFLOAT3 sol = ref.sizeOverLifetime.evaluate(normalizedTime, particles.sizeLerpRatio[index], 1.f);
+			currentScale = DirectX::XMVectorMultiply(currentScale, DirectX::XMLoadFloat3(&sol));
 		}
+
+		DirectX::XMMATRIX directionMatrix = DirectX::XMMatrixIdentity();
+		DirectX::XMVECTOR pivotScale = currentScale;
+		switch (ref.renderMode)
+		{
+		case RenderMode::Billboard:
+			if (ref.alignment == AlignmentMode::View)
+				directionMatrix = camera.getInverseViewMatrix();
+			break;
+		case RenderMode::HorizontalBillboard:
+			currentRotation = DirectX::XMVectorSetX(currentRotation, 90.f * particles.rotationFactor[index]);
+			currentRotation = DirectX::XMVectorSetY(currentRotation, 0);
+			currentScale = DirectX::XMVectorScale(currentScale, BILLBOARD_SCALE);
+			break;
+		case RenderMode::VerticalBillboard:
+			directionMatrix = camera.getInverseViewMatrix();
+			currentScale = DirectX::XMVectorScale(currentScale, BILLBOARD_SCALE);
+			break;
+		default:
+			break;
+		}
+
+		currentRotation = DirectX::XMVectorScale(currentRotation, particles.rotationFactor[index]);
+
+		DirectX::XMMATRIX matrix = DirectX::XMMatrixScalingFromVector(currentScale);
+		matrix *= DirectX::XMMatrixTranslationFromVector(DirectX::XMVectorMultiply(DirectX::XMVectorSet(ref.pivot.x, ref.pivot.y, ref.pivot.z, 1.f), pivotScale));
+		matrix *= directionMatrix;
+		matrix *= DirectX::XMMatrixRotationQuaternion(quaternionFromZYX(currentRotation));
+		matrix *= DirectX::XMMatrixTranslationFromVector(DirectX::XMVectorSet(particles.positionX[index], particles.positionY[index], particles.positionZ[index], 1.f));
+
+		if (ref.simulationSpace == TransformSpace::Local)
+		{
+			DirectX::XMMATRIX worldOffset = DirectX::XMMatrixIdentity();
+			if (ref.name == "aura")
+				worldOffset *= DirectX::XMMatrixScalingFromVector(worldTransform.scale);
+			worldOffset *= DirectX::XMMatrixRotationQuaternion(quaternionFromZYX(worldTransform.rotation));
+			worldOffset *= DirectX::XMMatrixTranslationFromVector(worldTransform.position);
+			matrix *= worldOffset;
+		}
+
+		return matrix;
 	}
 
 	void EmitterInstance::update(float t, const Transform& worldTransform, const Camera& camera)
@@ -269,30 +269,56 @@ namespace MikuMikuWorld::Effect
 		std::vector<int> children;
 	};
 
-	struct ParticleInstance
+	/// <summary>
+	/// The particles of an emitter with one array per component, so the simulation can load the same
+	/// component of four consecutive particles into one vector. The arrays are padded to a multiple of four.
+	/// Alive particles are kept at the front of the arrays.
+	/// </summary>
+	class ParticleStore
 	{
-		DirectX::XMMATRIX matrix{};
-		Transform transform;
-		DirectX::XMVECTOR direction{};
-		DirectX::XMVECTOR accumulateVelocityLimit{};
-		float startTime{};
-		float time{};
-		float duration{};
+	public:
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> rotationX, rotationY, rotationZ;
+		std::vector<float> scaleX, scaleY, scaleZ;
+		std::vector<float> directionX, directionY, directionZ;
+		std::vector<float> velocityLimitX, velocityLimitY, velocityLimitZ;
+
+		std::vector<float> startTime;
+		std::vector<float> time;
+		std::vector<float> duration;
+		std::vector<float> speed;
+
+		/// <summary>
+		/// The time elapsed since the previous update, only valid during an update
+		/// </summary>
+		std::vector<float> deltaTime;
+
+		std::vector<float> velocityLerpRatio;
+		std::vector<float> gravityLerpRatio;
+		std::vector<float> spriteSheetLerpRatio;
+		std::vector<float> sizeLerpRatio;
+		std::vector<float> colorLerpRatio;
+		std::vector<float> limitVelocityLerpRatio;
+		std::vector<float> forceLerpRatio;
+		std::vector<float> rotationLerpRatio;
+
+		/// <summary>
+		/// -1 for particles with flipped rotation, 1 otherwise
+		/// </summary>
+		std::vector<float> rotationFactor;
 
-		DirectX::XMFLOAT3 velocityLerpRatio{};
-		float gravityLerpRatio{};
-		float spriteSheetLerpRatio{};
-		float sizeLerpRatio{};
-		float colorLerpRatio{};
-		float limitVelocityLerpRatio{};
-		float forceLerpRatio{};
-		float rotationLerpRatio{};
+		std::vector<Color> startColor;
+		std::vector<DirectX::XMMATRIX> matrix;
 
-		float speed{};
-		Color startColor{ 1.f, 1.f, 1.f, 1.f };
+		inline size_t size() const { return count; }
+		void resize(size_t count);
+		void swap(size_t a, size_t b);
 
-		bool flipRotation{};
-		bool alive{ false };
+	private:
+		size_t count{};
+
+		template <typename Func>
+		void forEachArray(Func&& func);
 	};
 
 	struct BurstInstance
@@ -365,13 +391,22 @@ namespace MikuMikuWorld::Effect
 		RandN4 sizeRandom;
 		RandN4 velocityRandom;
 
+		// Seeded with the other generators so emitters never share random state and can be updated in parallel
+		Random particleRandom;
+
 		std::vector<BurstInstance> bursts;
-		std::vector<ParticleInstance> particles;
+		ParticleStore particles;
 		std::vector<EmitterInstance> children;
 
 		void emit(const Transform& worldTransform, const Particle& ref, float time, int count);
 		void update(float time, const Transform& worldTransform, const Camera& camera);
 		void start(float time);
+
+		/// <summary>
+		/// Starts the emitter with random values drawn from the given seed instead of the global generator,
+		/// so an emitter started with the same seed always plays the same way
+		/// </summary>
+		void start(float time, uint32_t seed);
 		void stop(bool allChildren);
 		void init(const Particle& ref, const Transform& transform);
 
@@ -387,6 +422,13 @@ namespace MikuMikuWorld::Effect
 		/// <returns>The number of alive particles</returns>
 		inline int getAliveCount() const { return aliveCount; }
 
+		/// <summary>
+		/// Builds the matrix of an alive particle one particle at a time with quaternion rotations, the way the simulation did
+		/// before it processed four particles at once. Used to check the matrices of the last update against.
+		/// Stretched billboards are not supported since their matrices are already built one particle at a time.
+		/// </summary>
+		DirectX::XMMATRIX calculateParticleMatrix(const Particle& ref, int index, const Transform& worldTransform, const Camera& camera) const;
+
 	private:
 		int refID{};
 
@@ -395,10 +437,17 @@ namespace MikuMikuWorld::Effect
 		/// </summary>
 		int aliveCount{};
 
+		void start(float time, Random& random);
+
 		int findFirstDeadParticle(float time) const;
 		int getMaxParticleCount() const;
 
 		void updateEmission(const Particle& ref, const Transform& worldTransform, float time);
 		void updateParticles(const Particle& ref, float t, const Transform& worldTransform, const Camera& camera);
+
+		/// <summary>
+		/// Removes the particles that reached the end of their lifetime and advances the time of the others
+		/// </summary>
+		void updateParticleTimes(float t);
 	};
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <climits>
+#include <limits>
 #include <queue>
 #include <stdexcept>
 #include "PreviewData.h"
@@ -16,70 +18,196 @@ namespace MikuMikuWorld::Engine
 		EaseType ease;
 	};
 
-	static void addHoldNote(DrawData& drawData, const HoldNote& holdNote, Score const &score);
+	static void addHoldNote(DrawData& drawData, const HoldNote& holdNote, Score const &score, TempoMap const &tempoMap);
 
-	void DrawData::calculateDrawData(Score const &score)
+	static bool addNote(DrawData& drawData, const Note& note, Score const& score, TempoMap const& tempoMap)
+	{
+		drawData.maxTicks = std::max(note.tick, drawData.maxTicks);
+		NoteType type = note.getType();
+		switch (type)
+		{
+		case NoteType::Hold:
+			drawData.notesList.add(score.holdNotes.at(note.ID), score, tempoMap);
+			break;
+		default:
+			drawData.notesList.add(note, tempoMap);
+		}
+
+		if (type == NoteType::HoldMid ||
+			type == NoteType::Hold && score.holdNotes.at(note.ID).startType != HoldNoteType::Normal ||
+			(type == NoteType::HoldEnd && score.holdNotes.at(note.parentID).endType != HoldNoteType::Normal))
+			return false;
+
+		auto visual_tm = getNoteVisualTime(note, tempoMap, drawData.noteSpeed);
+		drawData.drawingNotes.push_back(DrawingNote{ note.ID, note.tick, getNoteCenter(note), visual_tm });
+		return true;
+	}
+
+	// Adds a simultaneous line for every tick with more than one note at different lanes.
+	// Only the given ticks are considered unless ticks is null.
+	static void addSimultaneousLines(DrawData& drawData, TempoMap const& tempoMap, const std::unordered_set<int>* ticks)
+	{
+		std::map<int, Range> simBuilder;
+		for (const auto& note : drawData.drawingNotes)
+		{
+			if (ticks && ticks->find(note.tick) == ticks->end())
+				continue;
+
+			// Find the max and min lane within the same height (visual_tm.max)
+			auto&& [it, has_emplaced] = simBuilder.try_emplace(note.tick, Range{ note.center, note.center });
+			auto& x_range = it->second;
+			if (has_emplaced)
+				continue;
+			if (note.center < x_range.min)
+				x_range.min = note.center;
+			if (note.center > x_range.max)
+				x_range.max = note.center;
+		}
+
+		float noteDuration = getNoteDuration(drawData.noteSpeed);
+		for (const auto& [line_tick, x_range] : simBuilder)
+		{
+			if (x_range.min != x_range.max)
+			{
+				double targetTime = tempoMap.ticksToScaledSeconds(line_tick);
+				drawData.drawingLines.push_back(DrawingLine{ line_tick, x_range, Range{ targetTime - noteDuration, targetTime } });
+			}
+		}
+	}
+
+	void DrawData::calculateDrawData(Score const &score, TempoMap const &tempoMap)
 	{
 		this->clear();
+		fullUpdateCount++;
+		lastUpdateIncremental = false;
 		try
 		{
 			this->noteSpeed = config.pvNoteSpeed;
-			std::map<int, Range> simBuilder;
 			for (auto rit = score.notes.rbegin(), rend = score.notes.rend(); rit != rend; rit++)
+				addNote(*this, rit->second, score, tempoMap);
+
+			addSimultaneousLines(*this, tempoMap, nullptr);
+
+			for (auto rit = score.holdNotes.rbegin(), rend = score.holdNotes.rend(); rit != rend; rit++)
 			{
-				auto& [id, note] = *rit;
-				maxTicks = std::max(note.tick, maxTicks);
-				NoteType type = note.getType();
-				switch (type)
-				{
-				case NoteType::Hold:
-					notesList.add(score.holdNotes.at(id), score);
-					break;
-				default:
-					notesList.add(note, score);
-				}
+				addHoldNote(*this, rit->second, score, tempoMap);
+			}
 
-				if (type == NoteType::HoldMid ||
-					type == NoteType::Hold && score.holdNotes.at(id).startType != HoldNoteType::Normal ||
-					(type == NoteType::HoldEnd && score.holdNotes.at(note.parentID).endType != HoldNoteType::Normal))
+			notesList.explicitSort();
+			sortDrawingEntries(0, 0, 0, 0);
+		}
+		catch(const std::out_of_range& ex)
+		{
+			this->clear();
+		}
+	}
+
+	void DrawData::updateDrawData(Score const& score, TempoMap const& tempoMap, ScoreChangeSet const& changes)
+	{
+		if (changes.tempoChanged || noteSpeed != config.pvNoteSpeed)
+		{
+			calculateDrawData(score, tempoMap);
+			return;
+		}
+
+		try
+		{
+			std::unordered_set<int> noteIDs, holdIDs;
+			for (const auto* ids : { &changes.addedNotes, &changes.removedNotes, &changes.modifiedNotes })
+				noteIDs.insert(ids->begin(), ids->end());
+			for (const auto* ids : { &changes.addedHolds, &changes.removedHolds, &changes.modifiedHolds })
+				holdIDs.insert(ids->begin(), ids->end());
+
+			// A changed hold note moves its whole hold, and a changed hold redraws all of its notes
+			for (int id : noteIDs)
+			{
+				auto it = score.notes.find(id);
+				if (it == score.notes.end())
 					continue;
-					
-				auto visual_tm = getNoteVisualTime(note, score, noteSpeed);
-				drawingNotes.push_back(DrawingNote{note.ID, visual_tm});
-
-				// Find the max and min lane within the same height (visual_tm.max)
-				float center = getNoteCenter(note);
-				auto&& [it, has_emplaced] = simBuilder.try_emplace(note.tick, Range{center, center});
-				auto& x_range = it->second;
-				if (has_emplaced)
+
+				NoteType type = it->second.getType();
+				if (type == NoteType::Hold)
+					holdIDs.insert(id);
+				else if (type == NoteType::HoldMid || type == NoteType::HoldEnd)
+					holdIDs.insert(it->second.parentID);
+			}
+
+			for (int id : holdIDs)
+			{
+				auto it = score.holdNotes.find(id);
+				if (it == score.holdNotes.end())
 					continue;
-				if (center < x_range.min)
-					x_range.min = center;
-				if (center > x_range.max)
-					x_range.max = center;
-				continue;
+
+				noteIDs.insert(it->second.start.ID);
+				noteIDs.insert(it->second.end);
+				for (const HoldStep& step : it->second.steps)
+					noteIDs.insert(step.ID);
 			}
 
-			float noteDuration = getNoteDuration(noteSpeed);
-			for (const auto& [line_tick, x_range] : simBuilder)
+			if (noteIDs.empty() && holdIDs.empty())
+				return;
+
+			// Remove stale entries, remembering which simultaneous lines may have changed
+			std::unordered_set<int> lineTicks;
+			drawingNotes.erase(std::remove_if(drawingNotes.begin(), drawingNotes.end(), [&](const DrawingNote& note)
 			{
-				if (x_range.min != x_range.max)
-				{
-					double targetTime = accumulateScaledDuration(line_tick, TICKS_PER_BEAT, score.tempoChanges, score.hiSpeedChanges);
-					drawingLines.push_back(DrawingLine{ x_range, Range{ targetTime - getNoteDuration(noteSpeed), targetTime } });
-				}
+				if (noteIDs.find(note.refID) == noteIDs.end())
+					return false;
+
+				lineTicks.insert(note.tick);
+				return true;
+			}), drawingNotes.end());
+
+			drawingHoldTicks.erase(std::remove_if(drawingHoldTicks.begin(), drawingHoldTicks.end(),
+				[&holdIDs](const DrawingHoldTick& tick) { return holdIDs.find(tick.holdID) != holdIDs.end(); }), drawingHoldTicks.end());
+
+			drawingHoldSegments.erase(std::remove_if(drawingHoldSegments.begin(), drawingHoldSegments.end(),
+				[&holdIDs](const DrawingHoldSegment& segment) { return holdIDs.find(segment.holdID) != holdIDs.end(); }), drawingHoldSegments.end());
+
+			const bool removedMaxTick = notesList.remove(noteIDs) >= maxTicks;
+
+			// Add back the notes and holds that still exist
+			const size_t sortedCount = notesList.size();
+			const size_t sortedNotes = drawingNotes.size();
+			const size_t sortedHoldTicks = drawingHoldTicks.size();
+			const size_t sortedHoldSegments = drawingHoldSegments.size();
+			for (int id : noteIDs)
+			{
+				auto it = score.notes.find(id);
+				if (it != score.notes.end() && addNote(*this, it->second, score, tempoMap))
+					lineTicks.insert(it->second.tick);
 			}
 
-			for (auto rit = score.holdNotes.rbegin(), rend = score.holdNotes.rend(); rit != rend; rit++)
+			for (int id : holdIDs)
 			{
-				addHoldNote(*this, rit->second, score);
+				auto it = score.holdNotes.find(id);
+				if (it != score.holdNotes.end())
+					addHoldNote(*this, it->second, score, tempoMap);
 			}
 
-			notesList.explicitSort();
+			notesList.mergeSorted(sortedCount);
+
+			drawingLines.erase(std::remove_if(drawingLines.begin(), drawingLines.end(),
+				[&lineTicks](const DrawingLine& line) { return lineTicks.find(line.tick) != lineTicks.end(); }), drawingLines.end());
+			const size_t sortedLines = drawingLines.size();
+			addSimultaneousLines(*this, tempoMap, &lineTicks);
+
+			sortDrawingEntries(sortedNotes, sortedLines, sortedHoldTicks, sortedHoldSegments);
+
+			if (removedMaxTick)
+			{
+				maxTicks = 1;
+				for (const auto& [id, note] : score.notes)
+					maxTicks = std::max(note.tick, maxTicks);
+			}
+
+			effectView.reset();
+			incrementalUpdateCount++;
+			lastUpdateIncremental = true;
 		}
-		catch(const std::out_of_range& ex)
+		catch (const std::out_of_range&)
 		{
-			this->clear();
+			calculateDrawData(score, tempoMap);
 		}
 	}
 
@@ -93,20 +221,121 @@ namespace MikuMikuWorld::Engine
 		notesList.clear();
 		effectView.reset();
 
+		notesTimeline.clear();
+		linesTimeline.clear();
+		holdTicksTimeline.clear();
+		holdSegmentsTimeline.clear();
+		holdSegmentsMinHeadTimes.clear();
+		generation++;
+
 		maxTicks = 1;
 	}
 
-	void addHoldNote(DrawData &drawData, const HoldNote &holdNote, Score const &score)
+	template <typename T, typename Key>
+	static void mergeSortedEntries(std::vector<T>& entries, size_t sortedCount, Key key)
+	{
+		auto compare = [&key](const T& a, const T& b) { return key(a) < key(b); };
+		auto middle = entries.begin() + sortedCount;
+		std::stable_sort(middle, entries.end(), compare);
+		std::inplace_merge(entries.begin(), middle, entries.end(), compare);
+	}
+
+	template <typename T>
+	static void buildVisualTimeline(DrawingTimeline& timeline, const std::vector<T>& entries)
+	{
+		timeline.clear();
+		for (const T& entry : entries)
+			timeline.add(entry.visualTime.min, entry.visualTime.max);
+	}
+
+	void DrawData::sortDrawingEntries(size_t sortedNotes, size_t sortedLines, size_t sortedHoldTicks, size_t sortedHoldSegments)
+	{
+		auto visualStart = [](const auto& entry) { return entry.visualTime.min; };
+		mergeSortedEntries(drawingNotes, sortedNotes, visualStart);
+		mergeSortedEntries(drawingLines, sortedLines, visualStart);
+		mergeSortedEntries(drawingHoldTicks, sortedHoldTicks, visualStart);
+		mergeSortedEntries(drawingHoldSegments, sortedHoldSegments, [](const DrawingHoldSegment& segment) { return segment.startTime; });
+
+		buildVisualTimeline(notesTimeline, drawingNotes);
+		buildVisualTimeline(linesTimeline, drawingLines);
+		buildVisualTimeline(holdTicksTimeline, drawingHoldTicks);
+
+		holdSegmentsTimeline.clear();
+		for (const DrawingHoldSegment& segment : drawingHoldSegments)
+			holdSegmentsTimeline.add(segment.startTime, segment.endTime);
+
+		holdSegmentsMinHeadTimes.resize(drawingHoldSegments.size());
+		double minHeadTime = std::numeric_limits<double>::infinity();
+		for (size_t i = drawingHoldSegments.size(); i-- > 0;)
+		{
+			const DrawingHoldSegment& segment = drawingHoldSegments[i];
+			minHeadTime = std::min({ minHeadTime, segment.headTime, segment.tailTime });
+			holdSegmentsMinHeadTimes[i] = minHeadTime;
+		}
+
+		generation++;
+	}
+
+	void DrawingTimeline::clear()
+	{
+		starts.clear();
+		maxEnds.clear();
+	}
+
+	void DrawingTimeline::add(double start, double end)
+	{
+		starts.push_back(start);
+		maxEnds.push_back(maxEnds.empty() ? end : std::max(maxEnds.back(), end));
+	}
+
+	// Moves index forward past the values matching pred, which must hold for a prefix of the values.
+	// Walks a few entries first since the cursor usually moves by a handful of entries per frame.
+	template <typename Pred>
+	static size_t advanceCursor(const std::vector<double>& values, size_t index, Pred pred)
+	{
+		constexpr size_t maxSteps = 16;
+		const size_t stepLimit = std::min(values.size(), index + maxSteps);
+		while (index < stepLimit && pred(values[index]))
+			index++;
+
+		if (index < stepLimit || index == values.size())
+			return index;
+
+		return std::partition_point(values.begin() + index, values.end(), pred) - values.begin();
+	}
+
+	std::pair<size_t, size_t> DrawingTimelineCursor::seek(const DrawingTimeline& timeline, double time, int generation)
+	{
+		auto endedBefore = [time](double end) { return end < time; };
+		auto startedBy = [time](double start) { return start <= time; };
+
+		if (generation != this->generation || time < this->time)
+		{
+			first = std::partition_point(timeline.maxEnds.begin(), timeline.maxEnds.end(), endedBefore) - timeline.maxEnds.begin();
+			last = std::partition_point(timeline.starts.begin(), timeline.starts.end(), startedBy) - timeline.starts.begin();
+		}
+		else
+		{
+			first = advanceCursor(timeline.maxEnds, first, endedBefore);
+			last = advanceCursor(timeline.starts, last, startedBy);
+		}
+
+		this->time = time;
+		this->generation = generation;
+		return { first, last };
+	}
+
+	void addHoldNote(DrawData &drawData, const HoldNote &holdNote, Score const &score, TempoMap const &tempoMap)
 	{
 		float noteDuration = getNoteDuration(drawData.noteSpeed);
 		const Note& startNote = score.notes.at(holdNote.start.ID), endNote = score.notes.at(holdNote.end);
-		float activeTime = accumulateDuration(startNote.tick, TICKS_PER_BEAT, score.tempoChanges);
+		float activeTime = tempoMap.ticksToSeconds(startNote.tick);
 		float startTime = activeTime;
-		float endTime = accumulateDuration(endNote.tick, TICKS_PER_BEAT, score.tempoChanges);
+		float endTime = tempoMap.ticksToSeconds(endNote.tick);
 
 		DrawingHoldStep head = {
 			startNote.tick,
-			accumulateScaledDuration(startNote.tick, TICKS_PER_BEAT, score.tempoChanges, score.hiSpeedChanges),
+			tempoMap.ticksToScaledSeconds(startNote.tick),
 			Engine::laneToLeft(startNote.lane),
 			Engine::laneToLeft(startNote.lane) + startNote.width,
 			holdNote.start.ease
@@ -120,14 +349,15 @@ namespace MikuMikuWorld::Engine
 			auto easeFunction = getEaseFunction(head.ease);
 			DrawingHoldStep tail = {
 				tailNote.tick,
-				accumulateScaledDuration(tailNote.tick, TICKS_PER_BEAT, score.tempoChanges, score.hiSpeedChanges),
+				tempoMap.ticksToScaledSeconds(tailNote.tick),
 				Engine::laneToLeft(tailNote.lane),
 				Engine::laneToLeft(tailNote.lane) + tailNote.width,
 				tailStep.ease
 			};
-			float endTime = accumulateDuration(tailNote.tick, TICKS_PER_BEAT, score.tempoChanges);
+			float endTime = tempoMap.ticksToSeconds(tailNote.tick);
 			drawData.drawingHoldSegments.push_back(DrawingHoldSegment {
-				holdNote.end, 
+				holdNote.start.ID,
+				holdNote.end,
 				head.ease,
 				holdNote.isGuide(),
 				tailIdx,
@@ -145,11 +375,12 @@ namespace MikuMikuWorld::Engine
 				const Note& skipNote = score.notes.at(skipStep.ID);
 				if (skipNote.tick > tail.tick)
 					break;
-				double tickTime = accumulateScaledDuration(skipNote.tick, TICKS_PER_BEAT, score.tempoChanges, score.hiSpeedChanges);
+				double tickTime = tempoMap.ticksToScaledSeconds(skipNote.tick);
 				double tick_t = unlerpD(head.time, tail.time, tickTime);
 				float skipLeft = easeFunction(head.left, tail.left, tick_t);
 				float skipRight = easeFunction(head.right, tail.right, tick_t);
 				drawData.drawingHoldTicks.push_back(DrawingHoldTick{
+					holdNote.start.ID,
 					skipStep.ID,
 					skipLeft + (skipRight - skipLeft) / 2,
 					Range{tickTime - noteDuration, tickTime}
@@ -158,8 +389,9 @@ namespace MikuMikuWorld::Engine
 			}
 			if (tailStep.type != HoldStepType::Hidden)
 			{
-				double tickTime = accumulateScaledDuration(tailNote.tick, TICKS_PER_BEAT, score.tempoChanges, score.hiSpeedChanges);
+				double tickTime = tempoMap.ticksToScaledSeconds(tailNote.tick);
 				drawData.drawingHoldTicks.push_back(DrawingHoldTick{
+					holdNote.start.ID,
 					tailNote.ID,
 					getNoteCenter(tailNote),
 					{tickTime - noteDuration, tickTime}
@@ -170,31 +402,40 @@ namespace MikuMikuWorld::Engine
 		}
 	}
 
+	// endTick < tick: hack used to keep drawing holds no matter which end is held on the timeline
+	static int getIndexedEndTick(const DrawingNoteTime& note)
+	{
+		return note.endTick < note.tick ? INT_MAX : note.endTick;
+	}
+
 	void SortedDrawingNotesList::add(DrawingNoteTime note)
 	{
 		notes.push_back(note);
+		indexDirty = true;
 	}
 
-	void SortedDrawingNotesList::add(const Note& note, const Score& score)
+	void SortedDrawingNotesList::add(const Note& note, const TempoMap& tempoMap)
 	{
-		float time = accumulateDuration(note.tick, TICKS_PER_BEAT, score.tempoChanges);
+		float time = tempoMap.ticksToSeconds(note.tick);
 		notes.push_back({note.ID, note.tick, note.tick, note.lane, time, time});
+		indexDirty = true;
 	}
 
-	void SortedDrawingNotesList::add(const HoldNote& hold, const Score& score)
+	void SortedDrawingNotesList::add(const HoldNote& hold, const Score& score, const TempoMap& tempoMap)
 	{
 		const Note& startNote = score.notes.at(hold.start.ID);
 		const Note& endNote = score.notes.at(hold.end);
 
-		float startTime = accumulateDuration(startNote.tick, TICKS_PER_BEAT, score.tempoChanges);
-		float endTime = accumulateDuration(endNote.tick, TICKS_PER_BEAT, score.tempoChanges);
+		float startTime = tempoMap.ticksToSeconds(startNote.tick);
+		float endTime = tempoMap.ticksToSeconds(endNote.tick);
 
 		notes.push_back({ startNote.ID, startNote.tick, endNote.tick, startNote.lane, startTime, endTime });
+		indexDirty = true;
 	}
 
-	void SortedDrawingNotesList::updateNote(int index, const Note& note, const Score& score)
+	void SortedDrawingNotesList::updateNote(int index, const Note& note, const TempoMap& tempoMap)
 	{
-		float time = accumulateDuration(note.tick, TICKS_PER_BEAT, score.tempoChanges);
+		float time = tempoMap.ticksToSeconds(note.tick);
 		notes.at(index).lane = note.lane;
 		notes.at(index).tick = note.tick;
 		notes.at(index).time = time;
@@ -204,15 +445,18 @@ namespace MikuMikuWorld::Engine
 			notes.at(index).endTick = note.tick;
 			notes.at(index).endTime = time;
 		}
+		updateIndex(index);
 		
 		if (note.getType() == NoteType::HoldEnd)
 		{
-			for (auto& target : notes)
+			for (size_t i = 0; i < notes.size(); ++i)
 			{
+				auto& target = notes[i];
 				if (target.refID == note.parentID)
 				{
 					target.endTick = note.tick;
 					target.endTime = time;
+					updateIndex(i);
 					break;
 				}
 			}
@@ -222,6 +466,7 @@ namespace MikuMikuWorld::Engine
 	void SortedDrawingNotesList::clear()
 	{
 		notes.clear();
+		indexDirty = true;
 	}
 
 	void SortedDrawingNotesList::explicitSort()
@@ -230,6 +475,36 @@ namespace MikuMikuWorld::Engine
 		{
 			return a.tick == b.tick ? a.lane < b.lane : a.tick < b.tick;
 		});
+		indexDirty = true;
+	}
+
+	int SortedDrawingNotesList::remove(const std::unordered_set<int>& noteIDs)
+	{
+		int maxTick = -1;
+		notes.erase(std::remove_if(notes.begin(), notes.end(), [&](const DrawingNoteTime& note)
+		{
+			if (noteIDs.find(note.refID) == noteIDs.end())
+				return false;
+
+			maxTick = std::max({ maxTick, note.tick, note.endTick });
+			return true;
+		}), notes.end());
+
+		indexDirty = true;
+		return maxTick;
+	}
+
+	void SortedDrawingNotesList::mergeSorted(size_t sortedCount)
+	{
+		auto compare = [](const auto& a, const auto& b)
+		{
+			return a.tick == b.tick ? a.lane < b.lane : a.tick < b.tick;
+		};
+
+		auto middle = notes.begin() + std::min(sortedCount, notes.size());
+		std::sort(middle, notes.end(), compare);
+		std::inplace_merge(notes.begin(), middle, notes.end(), compare);
+		indexDirty = true;
 	}
 
 	void SortedDrawingNotesList::reserve(size_t capacity)
@@ -242,23 +517,70 @@ namespace MikuMikuWorld::Engine
 		return notes;
 	}
 
-	std::vector<int> SortedDrawingNotesList::getTickRange(int from, int to) const
+	void SortedDrawingNotesList::getTickRange(int from, int to, std::vector<int>& result) const
 	{
-		// TODO: Improve this such that we don't have to backtrack through all of the notes
-		// to find hold notes in range
+		result.clear();
+		if (notes.empty())
+			return;
+
+		if (indexDirty)
+			buildIndex();
+
+		auto first = std::lower_bound(notes.begin(), notes.end(), from, [](const auto& note, int val) { return note.tick < val; });
 		auto cutoff = std::upper_bound(notes.begin(), notes.end(), to, [](int val, const auto& note) { return val < note.tick; });
+		first = std::min(first, cutoff);
+
+		// Entries starting before the range only overlap it if they end inside or after it
+		const size_t firstIndex = std::distance(notes.begin(), first);
+		if (firstIndex)
+			collectOverlapping(1, 0, treeLeaves - 1, firstIndex - 1, from, result);
+
+		for (auto it = first; it != cutoff; ++it)
+			result.push_back(std::distance(notes.begin(), it));
+	}
+
+	void SortedDrawingNotesList::buildIndex() const
+	{
+		treeLeaves = 1;
+		while (treeLeaves < notes.size())
+			treeLeaves <<= 1;
+
+		maxEndTree.assign(treeLeaves * 2, INT_MIN);
+		for (size_t i = 0; i < notes.size(); ++i)
+			maxEndTree[treeLeaves + i] = getIndexedEndTick(notes[i]);
 
-		std::vector<int> result;
-		result.reserve(std::distance(notes.begin(), cutoff) + 1);
+		for (size_t node = treeLeaves - 1; node > 0; --node)
+			maxEndTree[node] = std::max(maxEndTree[node * 2], maxEndTree[node * 2 + 1]);
+
+		indexDirty = false;
+	}
+
+	void SortedDrawingNotesList::updateIndex(size_t index)
+	{
+		// A pending rebuild will pick up the change anyway
+		if (indexDirty || index >= notes.size())
+			return;
+
+		size_t node = treeLeaves + index;
+		maxEndTree[node] = getIndexedEndTick(notes[index]);
+		for (node /= 2; node > 0; node /= 2)
+			maxEndTree[node] = std::max(maxEndTree[node * 2], maxEndTree[node * 2 + 1]);
+	}
+
+	void SortedDrawingNotesList::collectOverlapping(size_t node, size_t nodeFirst, size_t nodeLast, size_t last, int from, std::vector<int>& result) const
+	{
+		if (nodeFirst > last || maxEndTree[node] < from)
+			return;
 
-		for (auto it = notes.begin(); it != cutoff; ++it)
+		if (nodeFirst == nodeLast)
 		{
-			// it->endTick < it->tick: hack used to keep drawing holds no matter which end is held on the timeline
-			if (it->endTick >= from || it->endTick < it->tick)
-				result.push_back(std::distance(notes.begin(), it));
+			result.push_back(nodeFirst);
+			return;
 		}
 
-		return result;
+		const size_t middle = nodeFirst + (nodeLast - nodeFirst) / 2;
+		collectOverlapping(node * 2, nodeFirst, middle, last, from, result);
+		collectOverlapping(node * 2 + 1, middle + 1, nodeLast, last, from, result);
 	}
 
 	int SortedDrawingNotesList::binarySearch(int targetTick) const
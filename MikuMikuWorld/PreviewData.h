@@ -1,5 +1,6 @@
 #pragma once
 #include <random>
+#include <unordered_set>
 #include "Score.h"
 #include "Math.h"
 #include "EffectView.h"
@@ -16,17 +17,21 @@ namespace MikuMikuWorld::Engine
 	struct DrawingNote
 	{
 		int refID;
+		int tick;
+		float center;
 		Range visualTime;
 	};
 
 	struct DrawingLine
 	{
+		int tick;
 		Range xPos;
 		Range visualTime;
 	};
 
 	struct DrawingHoldTick
 	{
+		int holdID;
 		int refID;
 		float center;
 		Range visualTime;
@@ -34,6 +39,7 @@ namespace MikuMikuWorld::Engine
 
 	struct DrawingHoldSegment
 	{
+		int holdID;
 		int endID;
 		EaseType ease;
 		bool isGuide;
@@ -45,6 +51,39 @@ namespace MikuMikuWorld::Engine
 		double activeTime;
 	};
 
+	/// <summary>
+	/// The visibility intervals of a list of draw entries sorted by the time they become visible.
+	/// The running maximum of the end times lets a cursor skip every entry that stopped being visible before a given time.
+	/// </summary>
+	struct DrawingTimeline
+	{
+		std::vector<double> starts;
+		std::vector<double> maxEnds;
+
+		void clear();
+		void add(double start, double end);
+	};
+
+	/// <summary>
+	/// Remembers the range of entries found by the last seek, so moving forward in time only steps over
+	/// the entries that appeared or disappeared since. Seeking backwards, seeking into rebuilt draw data
+	/// or jumping far ahead falls back to a binary search.
+	/// </summary>
+	class DrawingTimelineCursor
+	{
+	public:
+		/// <summary>
+		/// Returns the range [first, last) of entries that may be visible at the given time. Entries before
+		/// first stopped being visible before it and entries from last onwards start after it.
+		/// </summary>
+		std::pair<size_t, size_t> seek(const DrawingTimeline& timeline, double time, int generation);
+
+	private:
+		size_t first{}, last{};
+		double time{};
+		int generation{ -1 };
+	};
+
 	struct DrawingNoteTime
 	{
 		int refID;
@@ -59,22 +98,48 @@ namespace MikuMikuWorld::Engine
 	{
 	public:
 		void add(DrawingNoteTime note);
-		void add(const Note& note, const Score& score);
-		void add(const HoldNote& hold, const Score& score);
+		void add(const Note& note, const TempoMap& tempoMap);
+		void add(const HoldNote& hold, const Score& score, const TempoMap& tempoMap);
 		void clear();
 		void reserve(size_t capacity);
 
 		void explicitSort();
 
-		std::vector<int> getTickRange(int from, int to) const;
+		/// <summary>
+		/// Removes the entries of the given notes and returns the largest tick among the removed entries, or -1
+		/// </summary>
+		int remove(const std::unordered_set<int>& noteIDs);
+
+		/// <summary>
+		/// Sorts the entries added after the given count and merges them into the already sorted entries
+		/// </summary>
+		void mergeSorted(size_t sortedCount);
+		inline size_t size() const { return notes.size(); }
+
+		/// <summary>
+		/// Writes the indices of the entries overlapping [from, to] to result in list order, replacing its contents.
+		/// Entries starting inside the range are a contiguous run found by binary search, and the longer entries
+		/// starting before it are found through the max end tick index, so the cost does not grow with the entries before the range.
+		/// </summary>
+		void getTickRange(int from, int to, std::vector<int>& result) const;
 
 		const std::vector<DrawingNoteTime>& getView() const;
 
-		void updateNote(int index, const Note& note, const Score& score);
+		void updateNote(int index, const Note& note, const TempoMap& tempoMap);
 
 	private:
 		int binarySearch(int targetTick) const;
 		std::vector<DrawingNoteTime> notes;
+
+		// Segment tree over the entries holding the largest end tick of each subtree.
+		// Rebuilt lazily on the next query after the list is reordered.
+		mutable std::vector<int> maxEndTree;
+		mutable size_t treeLeaves{};
+		mutable bool indexDirty{ true };
+
+		void buildIndex() const;
+		void updateIndex(size_t index);
+		void collectOverlapping(size_t node, size_t nodeFirst, size_t nodeLast, size_t last, int from, std::vector<int>& result) const;
 	};
 
 	struct DrawData
@@ -86,10 +151,39 @@ namespace MikuMikuWorld::Engine
 		std::vector<DrawingHoldTick> drawingHoldTicks;
 		std::vector<DrawingHoldSegment> drawingHoldSegments;
 
+		// Each list is sorted by the time its entries become visible: visual time for notes, lines and hold ticks,
+		// and start time for hold segments, which stay visible until they end
+		DrawingTimeline notesTimeline;
+		DrawingTimeline linesTimeline;
+		DrawingTimeline holdTicksTimeline;
+		DrawingTimeline holdSegmentsTimeline;
+
+		// Smallest visual head time of each hold segment and every segment after it
+		std::vector<double> holdSegmentsMinHeadTimes;
+
+		// Incremented whenever the lists change so cursors over them know to search again
+		int generation{};
+
 		SortedDrawingNotesList notesList;
 		Effect::EffectView effectView;
 
+		int fullUpdateCount{};
+		int incrementalUpdateCount{};
+		bool lastUpdateIncremental{};
+
 		void clear();
-		void calculateDrawData(Score const& score);
+		void calculateDrawData(Score const& score, TempoMap const& tempoMap);
+
+		/// <summary>
+		/// Rebuilds only the entries of the notes and holds in the change set, along with the simultaneous lines at their ticks.
+		/// Falls back to calculateDrawData when tempo or hi-speed changes were edited.
+		/// </summary>
+		void updateDrawData(Score const& score, TempoMap const& tempoMap, ScoreChangeSet const& changes);
+
+	private:
+		/// <summary>
+		/// Sorts the entries added after the given counts, merges them into the already sorted entries and rebuilds the timelines
+		/// </summary>
+		void sortDrawingEntries(size_t sortedNotes, size_t sortedLines, size_t sortedHoldTicks, size_t sortedHoldSegments);
 	};
 }
\ No newline at end of file
@@ -31,9 +31,9 @@ namespace MikuMikuWorld
 
 namespace MikuMikuWorld::Engine
 {
-	Range getNoteVisualTime(Note const& note, Score const& score, float noteSpeed)
+	Range getNoteVisualTime(Note const& note, TempoMap const& tempoMap, float noteSpeed)
 	{
-		double targetTime = accumulateScaledDuration(note.tick, TICKS_PER_BEAT, score.tempoChanges, score.hiSpeedChanges);
+		double targetTime = tempoMap.ticksToScaledSeconds(note.tick);
 		return {targetTime - getNoteDuration(noteSpeed), targetTime};
 	}
 
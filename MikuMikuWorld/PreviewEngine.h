@@ -64,7 +64,7 @@ namespace MikuMikuWorld::Engine
 	std::array<DirectX::XMFLOAT4, 4> perspectiveQuadvPos(float leftStart, float leftStop, float rightStart, float rightStop, float top, float bottom);
 	std::array<DirectX::XMFLOAT4, 4> quadUV(const Sprite& sprite, const Texture& texture);
 
-	Range getNoteVisualTime(Note const& note, Score const& score, float noteSpeed);
+	Range getNoteVisualTime(Note const& note, TempoMap const& tempoMap, float noteSpeed);
 
 	/// General helper functions for fixed values in the engine
 	static inline float getNoteDuration(float noteSpeed)
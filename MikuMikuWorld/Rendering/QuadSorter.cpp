@@ -0,0 +1,147 @@
+#include "QuadSorter.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace MikuMikuWorld
+{
+	void QuadSorter::sort(const std::vector<Quad<Vertex>>& quads)
+	{
+		entries.resize(quads.size());
+		for (size_t i = 0; i < quads.size(); i++)
+		{
+			// Flipping the sign bit orders the signed z indices as unsigned keys
+			entries[i] = { static_cast<uint32_t>(quads[i].zIndex) ^ 0x80000000u, static_cast<uint32_t>(i) };
+		}
+
+		vertices.clear();
+		runs.clear();
+		if (entries.empty())
+			return;
+
+		radixSort();
+
+		for (size_t first = 0; first < entries.size();)
+		{
+			size_t last = first + 1;
+			while (last < entries.size() && entries[last].key == entries[first].key)
+				last++;
+
+			groupByTexture(quads, first, last);
+			first = last;
+		}
+
+		vertices.resize(entries.size() * 4);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const Quad<Vertex>& quad = quads[entries[i].index];
+			std::copy(quad.vertices, quad.vertices + 4, vertices.begin() + i * 4);
+
+			if (runs.empty() || runs.back().texture != quad.texture)
+				runs.push_back({ quad.texture, i, 0 });
+
+			runs.back().count++;
+		}
+	}
+
+	void QuadSorter::radixSort()
+	{
+		constexpr int digitCount = 4;
+		uint32_t counts[digitCount][256]{};
+		for (const SortEntry& entry : entries)
+		{
+			for (int digit = 0; digit < digitCount; digit++)
+				counts[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+		}
+
+		sortBuffer.resize(entries.size());
+		for (int digit = 0; digit < digitCount; digit++)
+		{
+			const int shift = digit * 8;
+
+			// Skip the pass if every key has the same digit, as most z indices only differ in a few bits
+			if (counts[digit][(entries[0].key >> shift) & 0xFF] == entries.size())
+				continue;
+
+			uint32_t offsets[256];
+			uint32_t offset = 0;
+			for (int i = 0; i < 256; i++)
+			{
+				offsets[i] = offset;
+				offset += counts[digit][i];
+			}
+
+			for (const SortEntry& entry : entries)
+				sortBuffer[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+
+			entries.swap(sortBuffer);
+		}
+	}
+
+	QuadSorter::QuadBounds QuadSorter::getQuadBounds(const Quad<Vertex>& quad)
+	{
+		QuadBounds bounds{ FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX, true };
+		for (const Vertex& vertex : quad.vertices)
+		{
+			DirectX::XMFLOAT3 position;
+			DirectX::XMStoreFloat3(&position, vertex.position);
+
+			bounds.left = std::min(bounds.left, position.x);
+			bounds.right = std::max(bounds.right, position.x);
+			bounds.bottom = std::min(bounds.bottom, position.y);
+			bounds.top = std::max(bounds.top, position.y);
+			bounds.flat &= position.z == 0;
+		}
+
+		return bounds;
+	}
+
+	bool QuadSorter::overlaps(const QuadBounds& b1, const QuadBounds& b2)
+	{
+		if (!b1.flat || !b2.flat)
+			return true;
+
+		return b1.left < b2.right && b2.left < b1.right && b1.bottom < b2.top && b2.bottom < b1.top;
+	}
+
+	void QuadSorter::groupByTexture(const std::vector<Quad<Vertex>>& quads, size_t first, size_t last)
+	{
+		const size_t count = last - first;
+		if (count < 2 || count > MAX_GROUPED_QUADS)
+			return;
+
+		const int firstTexture = quads[entries[first].index].texture;
+		if (std::all_of(entries.begin() + first, entries.begin() + last,
+			[&quads, firstTexture](const SortEntry& entry) { return quads[entry.index].texture == firstTexture; }))
+			return;
+
+		sortBuffer.assign(entries.begin() + first, entries.begin() + last);
+		bounds.clear();
+		remaining.clear();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bounds.push_back(getQuadBounds(quads[sortBuffer[i].index]));
+			remaining.push_back(i);
+		}
+
+		// Take the quads with the texture of the first remaining quad, unless they have to stay
+		// behind a quad with another texture they overlap, and repeat with the quads left behind
+		size_t output = first;
+		while (!remaining.empty())
+		{
+			const int texture = quads[sortBuffer[remaining.front()].index].texture;
+			deferred.clear();
+			for (uint32_t i : remaining)
+			{
+				const bool canMove = quads[sortBuffer[i].index].texture == texture &&
+					std::none_of(deferred.begin(), deferred.end(), [this, i](uint32_t other) { return overlaps(bounds[i], bounds[other]); });
+
+				if (canMove)
+					entries[output++] = sortBuffer[i];
+				else
+					deferred.push_back(i);
+			}
+
+			remaining.swap(deferred);
+		}
+	}
+}
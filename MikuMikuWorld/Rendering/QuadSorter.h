@@ -0,0 +1,65 @@
+#pragma once
+#include "Quad.h"
+#include <cstdint>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// <summary>
+	/// A range of sorted quads drawn with the same texture
+	/// </summary>
+	struct DrawRun
+	{
+		int texture;
+		size_t first;
+		size_t count;
+	};
+
+	/// <summary>
+	/// Orders the quads of a render batch for drawing without touching any GL state.
+	/// Quads are radix sorted by z index, keeping the order they were pushed in for equal z indices.
+	/// Within equal z indices, quads are grouped by texture when the quads they move past don't overlap them.
+	/// </summary>
+	class QuadSorter
+	{
+	public:
+		// Longer runs of equal z indices are left in push order as grouping them costs quadratic time
+		static constexpr size_t MAX_GROUPED_QUADS = 64;
+
+		void sort(const std::vector<Quad<Vertex>>& quads);
+
+		/// <summary>
+		/// The vertices of the sorted quads, so the vertices of a draw run can be copied at once
+		/// </summary>
+		inline const std::vector<Vertex>& getVertices() const { return vertices; }
+		inline const std::vector<DrawRun>& getRuns() const { return runs; }
+
+	private:
+		struct SortEntry
+		{
+			uint32_t key;
+			uint32_t index;
+		};
+
+		struct QuadBounds
+		{
+			float left, right, bottom, top;
+
+			// Overlap is only tested for quads lying in the z = 0 plane
+			bool flat;
+		};
+
+		std::vector<SortEntry> entries;
+		std::vector<SortEntry> sortBuffer;
+		std::vector<uint32_t> remaining;
+		std::vector<uint32_t> deferred;
+		std::vector<QuadBounds> bounds;
+		std::vector<Vertex> vertices;
+		std::vector<DrawRun> runs;
+
+		void radixSort();
+		static QuadBounds getQuadBounds(const Quad<Vertex>& quad);
+		static bool overlaps(const QuadBounds& b1, const QuadBounds& b2);
+		void groupByTexture(const std::vector<Quad<Vertex>>& quads, size_t first, size_t last);
+	};
+}
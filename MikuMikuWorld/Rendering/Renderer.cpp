@@ -5,7 +5,7 @@
 
 namespace MikuMikuWorld
 {
-	Renderer::Renderer() : vBuffer{ maxQuads }, mvBuffer{ 24 }
+	Renderer::Renderer() : vBuffer{ streamRegionVertices, streamRegionCount }, mvBuffer{ 24 }
 	{
 		vBuffer.setup();
 		mvBuffer.setup();
@@ -258,31 +258,34 @@ namespace MikuMikuWorld
 
 		if (quads.size())
 		{
-			std::stable_sort(quads.begin(), quads.end(),
-				[](const Quad<Vertex>& q1, const Quad<Vertex>& q2) {return q1.zIndex < q2.zIndex; });
-			
+			quadSorter.sort(quads);
+			const std::vector<Vertex>& vertices = quadSorter.getVertices();
+			const size_t quadCapacity = vBuffer.getCapacity() / 4;
+
 			vBuffer.bind();
-			bindTexture(quads[0].texture);
-			int vertexCount = 0;
-	
-			for (const auto& q : quads)
+			for (const DrawRun& run : quadSorter.getRuns())
 			{
-				if (texID != q.texture || vertexCount + 4 >= vBuffer.getCapacity())
+				bindTexture(run.texture);
+
+				// Runs longer than the buffer are drawn in parts
+				for (size_t first = run.first, last = run.first + run.count; first < last;)
 				{
-					vBuffer.uploadBuffer();
+					const size_t count = std::min(last - first, quadCapacity);
+					if (vBuffer.isStreaming())
+					{
+						vBuffer.streamBuffer(vertices.data() + first * 4, count * 4);
+					}
+					else
+					{
+						vBuffer.resetBufferPos();
+						vBuffer.pushBuffer(vertices.data() + first * 4, count * 4);
+						vBuffer.uploadBuffer();
+					}
 					vBuffer.flushBuffer();
-					vBuffer.resetBufferPos();
-					vertexCount = 0;
-	
-					bindTexture(q.texture);
+
+					first += count;
 				}
-	
-				vBuffer.pushBuffer(q);
-				vertexCount += 4;
 			}
-	
-			vBuffer.uploadBuffer();
-			vBuffer.flushBuffer();
 		}
 
 		if (mQuads.size())
@@ -4,6 +4,7 @@
 #include "Texture.h"
 #include "AnchorType.h"
 #include "VertexBuffer.h"
+#include "QuadSorter.h"
 #include <vector>
 #include <array>
 
@@ -11,6 +12,10 @@ namespace MikuMikuWorld
 {
 	constexpr size_t maxQuads = 1500;
 
+	// Sorted quads are streamed through a ring of regions so a frame rarely waits on the draws of the previous ones
+	constexpr size_t streamRegionVertices = 1 << 16;
+	constexpr int streamRegionCount = 3;
+
 	class Renderer
 	{
 	private:
@@ -22,6 +27,7 @@ namespace MikuMikuWorld
 
 		VertexBuffer<Vertex> vBuffer;
 		std::vector<Quad<Vertex>> quads;
+		QuadSorter quadSorter;
 
 		VertexBuffer<MaskVertex> mvBuffer;
 		std::vector<Quad<MaskVertex>> mQuads;
@@ -0,0 +1,39 @@
+#include "StreamRing.h"
+#include <algorithm>
+#include <cassert>
+
+namespace MikuMikuWorld
+{
+	StreamRing::StreamRing(size_t regionCapacity, int regionCount) :
+		regionCapacity{ regionCapacity }, regionCount{ std::max(regionCount, 1) }
+	{
+	}
+
+	StreamAllocation StreamRing::allocate(size_t count)
+	{
+		assert(count <= regionCapacity && "Stream allocation larger than a region");
+
+		StreamAllocation allocation{};
+		allocation.previousRegion = allocation.region = region;
+		if (regionPos + count > regionCapacity)
+		{
+			region = (region + 1) % regionCount;
+			regionPos = 0;
+			regionChanges++;
+
+			allocation.regionChanged = true;
+			allocation.region = region;
+		}
+
+		allocation.offset = region * regionCapacity + regionPos;
+		regionPos += count;
+		return allocation;
+	}
+
+	void StreamRing::reset()
+	{
+		region = 0;
+		regionPos = 0;
+		regionChanges = 0;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+
+namespace MikuMikuWorld
+{
+	struct StreamAllocation
+	{
+		size_t offset{};
+
+		// The allocation didn't fit in what was left of the previous region and starts the next one
+		bool regionChanged{ false };
+		int previousRegion{};
+		int region{};
+	};
+
+	/// <summary>
+	/// Hands out ranges of a ring buffer split into equally sized regions without touching any GL state.
+	/// Each allocation is contiguous within one region. The caller fences a region when it is left
+	/// and waits for the fence of a region before writing to it again.
+	/// </summary>
+	class StreamRing
+	{
+	public:
+		StreamRing(size_t regionCapacity, int regionCount);
+
+		/// <summary>
+		/// Reserves count elements, at most the capacity of one region
+		/// </summary>
+		StreamAllocation allocate(size_t count);
+		void reset();
+
+		inline size_t getRegionCapacity() const { return regionCapacity; }
+		inline int getRegionCount() const { return regionCount; }
+		inline size_t getCapacity() const { return regionCapacity * regionCount; }
+		inline int getRegion() const { return region; }
+		inline size_t getRegionChanges() const { return regionChanges; }
+
+	private:
+		size_t regionCapacity;
+		int regionCount;
+		int region{};
+		size_t regionPos{};
+		size_t regionChanges{};
+	};
+}
@@ -1,8 +1,22 @@
 #pragma once
 #include "Quad.h"
+#include "StreamRing.h"
+#include <memory>
+#include <vector>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
 
 namespace MikuMikuWorld
 {
+	typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+	// glBufferStorage (OpenGL 4.4 or GL_ARB_buffer_storage) isn't part of the 3.3 loader.
+	// It is loaded after the context is created and stays null when the driver doesn't support it.
+	inline PFNGLBUFFERSTORAGEPROC glBufferStorageProc{ nullptr };
+
 	template<typename VertexType>
 	class VertexBuffer
 	{
@@ -17,20 +31,42 @@ namespace MikuMikuWorld
 		unsigned int vbo;
 		unsigned int ebo;
 
+		// Streaming mode writes vertices straight to a ring in GPU memory instead of the CPU buffer
+		std::unique_ptr<StreamRing> stream;
+		std::vector<GLsync> fences;
+		VertexType* mappedBuffer{ nullptr };
+		int baseVertex{ 0 };
+
+		void waitForRegion(int region);
+		void writeStream(size_t offset, const VertexType* vertices, int count);
+
 	public:
-		VertexBuffer(int _capacity);
+		/// <summary>
+		/// With streamRegions > 0 the buffer streams vertices through a ring of that many regions,
+		/// each holding _capacity vertices
+		/// </summary>
+		VertexBuffer(int _capacity, int streamRegions = 0);
 		~VertexBuffer();
 
 		void setup();
 		void dispose();
 		void bind() const;
 		void pushBuffer(const Quad<VertexType>& q);
+		void pushBuffer(const VertexType* vertices, int count);
 		void resetBufferPos();
 		void uploadBuffer();
+
+		/// <summary>
+		/// Writes the vertices to the next free range of the stream ring, replacing the buffer's contents for flushBuffer
+		/// </summary>
+		void streamBuffer(const VertexType* vertices, int count);
 		void flushBuffer();
 		void flushBuffer(int bufPos, int bufSize);
 		int getCapacity() const;
 		int getSize() const;
+
+		inline bool isStreaming() const { return stream != nullptr; }
+		inline bool isPersistentlyMapped() const { return mappedBuffer != nullptr; }
 	};
 }
 
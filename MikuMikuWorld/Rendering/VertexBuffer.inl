@@ -1,15 +1,22 @@
 #include "VertexBuffer.h"
 #include "glad/glad.h"
+#include <cstring>
 
 namespace MikuMikuWorld
 {
 	template<typename VertexType>
-	VertexBuffer<VertexType>::VertexBuffer(int _capacity) :
+	VertexBuffer<VertexType>::VertexBuffer(int _capacity, int streamRegions) :
 		vertexCapcity{ _capacity }, bufferPos{ 0 }, vao{ 0 }, vbo{ 0 }, ebo{ 0 }
 	{
 		buffer = nullptr;
 		indices = nullptr;
 		indexCapacity = (vertexCapcity * 6) / 4;
+
+		if (streamRegions > 0)
+		{
+			stream = std::make_unique<StreamRing>(vertexCapcity, streamRegions);
+			fences.resize(streamRegions, nullptr);
+		}
 	}
 
 	template<typename VertexType>
@@ -21,7 +28,9 @@ namespace MikuMikuWorld
 	template<typename VertexType>
 	void VertexBuffer<VertexType>::setup()
 	{
-		buffer = new VertexType[vertexCapcity];
+		if (!stream)
+			buffer = new VertexType[vertexCapcity];
+
 		indices = new int[indexCapacity];
 
 		size_t offset = 0;
@@ -45,7 +54,32 @@ namespace MikuMikuWorld
 		glGenBuffers(1, &ebo);
 
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, vertexCapcity * sizeof(VertexType), NULL, GL_DYNAMIC_DRAW);
+		if (stream)
+		{
+			const size_t streamSize = stream->getCapacity() * sizeof(VertexType);
+			if (glBufferStorageProc)
+			{
+				// Map the whole ring once and keep it mapped, writes are then plain copies
+				const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorageProc(GL_ARRAY_BUFFER, streamSize, NULL, flags);
+				mappedBuffer = static_cast<VertexType*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, streamSize, flags));
+
+				if (!mappedBuffer)
+				{
+					// Buffer storage is immutable, start over with a buffer that can be mapped per write
+					glDeleteBuffers(1, &vbo);
+					glGenBuffers(1, &vbo);
+					glBindBuffer(GL_ARRAY_BUFFER, vbo);
+				}
+			}
+
+			if (!mappedBuffer)
+				glBufferData(GL_ARRAY_BUFFER, streamSize, NULL, GL_STREAM_DRAW);
+		}
+		else
+		{
+			glBufferData(GL_ARRAY_BUFFER, vertexCapcity * sizeof(VertexType), NULL, GL_DYNAMIC_DRAW);
+		}
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * sizeof(unsigned int), indices, GL_STATIC_DRAW);
@@ -61,6 +95,23 @@ namespace MikuMikuWorld
 	{
 		delete[] buffer;
 		delete[] indices;
+		buffer = nullptr;
+		indices = nullptr;
+
+		for (GLsync& fence : fences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+
+			fence = nullptr;
+		}
+
+		if (stream)
+			stream->reset();
+
+		// Deleting the buffer also unmaps it
+		mappedBuffer = nullptr;
+		baseVertex = 0;
 
 		glDeleteVertexArrays(1, &vao);
 		glDeleteBuffers(1, &vbo);
@@ -93,6 +144,13 @@ namespace MikuMikuWorld
 		bufferPos += 4;
 	}
 
+	template<typename VertexType>
+	void VertexBuffer<VertexType>::pushBuffer(const VertexType* vertices, int count)
+	{
+		std::memcpy(buffer + bufferPos, vertices, count * sizeof(VertexType));
+		bufferPos += count;
+	}
+
 	template<typename VertexType>
 	void VertexBuffer<VertexType>::resetBufferPos()
 	{
@@ -106,11 +164,75 @@ namespace MikuMikuWorld
 		glBufferSubData(GL_ARRAY_BUFFER, 0, size, buffer);
 	}
 
+	template<typename VertexType>
+	void VertexBuffer<VertexType>::streamBuffer(const VertexType* vertices, int count)
+	{
+		const StreamAllocation allocation = stream->allocate(count);
+		if (allocation.regionChanged)
+		{
+			// The draws of the region being left are done once this fence is signaled
+			fences[allocation.previousRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			waitForRegion(allocation.region);
+		}
+
+		writeStream(allocation.offset, vertices, count);
+		baseVertex = static_cast<int>(allocation.offset);
+		bufferPos = count;
+	}
+
+	template<typename VertexType>
+	void VertexBuffer<VertexType>::waitForRegion(int region)
+	{
+		GLsync& fence = fences[region];
+		if (!fence)
+			return;
+
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		GLenum result = glClientWaitSync(fence, flags, 1000000);
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(fence, 0, 1000000);
+
+		// A failed wait says nothing about the region, so wait for all the queued draws before writing over it
+		if (result == GL_WAIT_FAILED)
+			glFinish();
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	template<typename VertexType>
+	void VertexBuffer<VertexType>::writeStream(size_t offset, const VertexType* vertices, int count)
+	{
+		const size_t size = count * sizeof(VertexType);
+		if (mappedBuffer)
+		{
+			std::memcpy(mappedBuffer + offset, vertices, size);
+			return;
+		}
+
+		// The fences keep the GPU off the range, so the driver doesn't need to synchronize the mapping
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+		void* range = glMapBufferRange(GL_ARRAY_BUFFER, offset * sizeof(VertexType), size, flags);
+		if (range)
+		{
+			std::memcpy(range, vertices, size);
+
+			// Unmapping fails when the buffer's contents are lost, e.g. on a display mode change
+			if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE)
+				return;
+		}
+
+		glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(VertexType), size, vertices);
+	}
+
 	template<typename VertexType>
 	void VertexBuffer<VertexType>::flushBuffer()
 	{
 		size_t numIndices = (bufferPos / 4) * 6;
-		glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
+		if (stream)
+			glDrawElementsBaseVertex(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0, baseVertex);
+		else
+			glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
 	}
 
     template <typename VertexType>
@@ -1,6 +1,7 @@
 #include "ResourceManager.h"
 #include "IO.h"
 #include "MinMax.h"
+#include "ApplicationConfiguration.h"
 #include <sstream>
 
 using namespace nlohmann;
@@ -185,6 +186,7 @@ namespace MikuMikuWorld
 		}
 
 		minmax.sortKeyFrames();
+		minmax.bake(config.pvEffectsCurveResolution);
 		return minmax;
 	}
 
@@ -235,6 +237,7 @@ namespace MikuMikuWorld
 		}
 
 		minmax.sortKeyFrames();
+		minmax.bake(config.pvEffectsCurveResolution);
 		return minmax;
 	}
 
@@ -1,13 +1,14 @@
 #pragma once
 #include "Note.h"
 #include "Tempo.h"
+#include "SlotMap.h"
 #include <string>
 #include <map>
 #include <vector>
 
 namespace MikuMikuWorld
 {
-	extern int nextSkillID;
+	extern thread_local int nextSkillID;
 
 	struct SkillTrigger
 	{
@@ -40,8 +41,8 @@ namespace MikuMikuWorld
 	struct Score
 	{
 		ScoreMetadata metadata;
-		std::map<int, Note> notes;
-		std::map<int, HoldNote> holdNotes;
+		SlotMap<Note> notes;
+		SlotMap<HoldNote> holdNotes;
 		std::vector<Tempo> tempoChanges;
 		std::map<int, TimeSignature> timeSignatures;
 		std::vector<HiSpeedChange> hiSpeedChanges;
@@ -50,4 +51,21 @@ namespace MikuMikuWorld
 
 		Score();
 	};
+
+	/// <summary>
+	/// IDs of the notes and holds touched by an edit. Holds are identified by their start note's ID.
+	/// </summary>
+	struct ScoreChangeSet
+	{
+		std::vector<int> addedNotes;
+		std::vector<int> removedNotes;
+		std::vector<int> modifiedNotes;
+		std::vector<int> addedHolds;
+		std::vector<int> removedHolds;
+		std::vector<int> modifiedHolds;
+
+		// Tempo or hi-speed changes were edited, which moves every note in time
+		bool tempoChanged{};
+		bool eventsChanged{};
+	};
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "ScoreBenchmarks.h"
+#include "ScoreGenerator.h"
+#include "NativeScoreSerializer.h"
+#include "SusSerializer.h"
+#include "SonolusSerializer.h"
+#include "HistoryManager.h"
+#include "ScoreStats.h"
+#include "NoteSoundSchedule.h"
+#include "Audio/Sound.h"
+#include "Constants.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace mmw = MikuMikuWorld;
+
+namespace Debug
+{
+	// Keeps the compiler from discarding the benchmarked work
+	static volatile double benchmarkSink;
+
+	static constexpr const char* benchmarkFormats[] = { "mmws", "sus", "json" };
+
+	mmw::Score createBenchmarkScore(int noteCount)
+	{
+		mmw::ScoreGeneratorOptions options{};
+		options.seed = noteCount;
+		options.tapCount = noteCount;
+		options.holdCount = noteCount / 10;
+		options.guideCount = noteCount / 50;
+		options.stepsPerEase = 1;
+		options.tempoChangeCount = noteCount / 100;
+		options.hiSpeedChangeCount = noteCount / 100;
+		options.timeSignatureChangeCount = noteCount / 500;
+
+		// Restart the IDs so every run creates the same score
+		mmw::resetNextID();
+		return mmw::generateScore(options);
+	}
+
+	static std::unique_ptr<mmw::ScoreSerializer> createSerializer(const std::string& format)
+	{
+		if (format == "mmws")
+			return std::make_unique<mmw::NativeScoreSerializer>();
+		if (format == "sus")
+			return std::make_unique<mmw::SusSerializer>();
+
+		return std::make_unique<mmw::SonolusSerializer>(std::make_unique<mmw::PySekaiEngine>(), false);
+	}
+
+	std::string getTemporaryFilename(const std::string& format)
+	{
+		return (std::filesystem::temp_directory_path() / ("mmw_benchmark." + format)).u8string();
+	}
+
+	static void addSerializerBenchmarks(BenchmarkRunner& runner, const std::string& format, int size)
+	{
+		const std::string suffix = format + "/" + std::to_string(size);
+		runner.add("Serialize/" + suffix, [format, size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			const std::string filename = getTemporaryFilename(format);
+			auto serializer = createSerializer(format);
+
+			while (state.keepRunning())
+				serializer->serialize(score, filename);
+
+			state.setItemsProcessed(state.getIterations() * score.notes.size());
+		});
+
+		// Sonolus level data can only be exported
+		if (format == "json")
+			return;
+
+		runner.add("Deserialize/" + suffix, [format, size](BenchmarkState& state)
+		{
+			const std::string filename = getTemporaryFilename(format);
+			auto serializer = createSerializer(format);
+			serializer->serialize(createBenchmarkScore(size), filename);
+
+			size_t noteCount = 0;
+			while (state.keepRunning())
+			{
+				state.pauseTiming();
+				mmw::resetNextID();
+				state.resumeTiming();
+
+				noteCount = serializer->deserialize(filename).notes.size();
+			}
+
+			state.setItemsProcessed(state.getIterations() * noteCount);
+		});
+	}
+
+	static void addScoreSizeBenchmarks(BenchmarkRunner& runner, int size)
+	{
+		const std::string suffix = "/" + std::to_string(size);
+		runner.add("CalculateStats" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			mmw::ScoreStats stats;
+
+			while (state.keepRunning())
+				stats.calculateStats(score);
+
+			benchmarkSink = stats.getTotal();
+			state.setItemsProcessed(state.getIterations() * score.notes.size());
+		});
+
+		runner.add("UpdateStats" + suffix, [size](BenchmarkState& state)
+		{
+			mmw::Score score = createBenchmarkScore(size);
+			mmw::HistoryManager history;
+			mmw::ScoreStats stats;
+			stats.calculateStats(score);
+
+			std::vector<int> noteIDs;
+			for (const auto& [id, note] : score.notes)
+				noteIDs.push_back(id);
+
+			size_t nextNote = 0;
+			while (state.keepRunning())
+			{
+				state.pauseTiming();
+				mmw::Score prev = score;
+				mmw::Note& note = score.notes.at(noteIDs[nextNote++ % noteIDs.size()]);
+				note.tick += mmw::TICKS_PER_BEAT;
+				const mmw::History& entry = history.pushHistory("Benchmark", prev, score);
+				const mmw::ScoreChangeSet changes = mmw::createChangeSet(entry.undo, entry.redo);
+				state.resumeTiming();
+
+				stats.updateStats(score, changes);
+			}
+
+			benchmarkSink = stats.getCombo();
+		});
+
+		runner.add("History/PushUndoRedo" + suffix, [size](BenchmarkState& state)
+		{
+			mmw::Score score = createBenchmarkScore(size);
+			mmw::HistoryManager history;
+			history.setMemoryBudget(64 * 1024 * 1024);
+
+			std::vector<int> noteIDs;
+			for (const auto& [id, note] : score.notes)
+				noteIDs.push_back(id);
+
+			size_t nextNote = 0;
+			while (state.keepRunning())
+			{
+				state.pauseTiming();
+				mmw::Score prev = score;
+				mmw::Note& note = score.notes.at(noteIDs[nextNote++ % noteIDs.size()]);
+				note.critical = !note.critical;
+				state.resumeTiming();
+
+				history.pushHistory("Benchmark", prev, score);
+				history.undo(score);
+				history.redo(score);
+			}
+		});
+
+		runner.add("Tempo/Build" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			mmw::TempoMap tempoMap;
+
+			while (state.keepRunning())
+				tempoMap.build(score.tempoChanges, score.hiSpeedChanges, mmw::TICKS_PER_BEAT);
+
+			state.setItemsProcessed(state.getIterations() * (score.tempoChanges.size() + score.hiSpeedChanges.size()));
+		});
+
+		runner.add("Tempo/Convert" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			const mmw::TempoMap tempoMap(score.tempoChanges, score.hiSpeedChanges, mmw::TICKS_PER_BEAT);
+
+			std::vector<int> ticks;
+			for (const auto& [id, note] : score.notes)
+				ticks.push_back(note.tick);
+
+			double sum = 0;
+			while (state.keepRunning())
+			{
+				for (int tick : ticks)
+					sum += tempoMap.secondsToTicks(tempoMap.ticksToSeconds(tick)) + tempoMap.ticksToScaledSeconds(tick);
+			}
+
+			benchmarkSink = sum;
+			state.setItemsProcessed(state.getIterations() * ticks.size());
+		});
+	}
+
+	// Stand-ins for the sound pools of a profile, only used to tell the sound effects apart
+	static Audio::SoundEffectProfile createBenchmarkSoundEffects()
+	{
+		Audio::SoundEffectProfile soundEffects;
+		for (const char* name : mmw::SE_NAMES)
+			soundEffects.pool.emplace(name, std::make_unique<Audio::SoundPool>());
+
+		return soundEffects;
+	}
+
+	float getNoteSoundsDuration(const mmw::Score& score, const mmw::TempoMap& tempoMap)
+	{
+		int lastTick = 0;
+		for (const auto& [id, note] : score.notes)
+			lastTick = std::max(lastTick, note.tick);
+
+		return tempoMap.ticksToSeconds(lastTick) + 1.0f;
+	}
+
+	static void addNoteSoundBenchmarks(BenchmarkRunner& runner, int size)
+	{
+		const std::string suffix = "/" + std::to_string(size);
+
+		runner.add("Playback/NoteSounds/Schedule" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			const mmw::TempoMap tempoMap(score.tempoChanges, score.hiSpeedChanges, mmw::TICKS_PER_BEAT);
+			const float duration = getNoteSoundsDuration(score, tempoMap);
+			Audio::SoundEffectProfile soundEffects = createBenchmarkSoundEffects();
+			mmw::NoteSoundSchedule schedule;
+			schedule.build(score, tempoMap, soundEffects, 0, 0);
+
+			const std::vector<mmw::NoteSoundEvent>& events = schedule.getEvents();
+			int64_t frames = 0, sounds = 0;
+			uint64_t allocations = 0;
+			while (state.keepRunning())
+			{
+				size_t cursor = schedule.findFirstEvent(0);
+				for (float time = 0; time < duration; time += noteSoundFrameTime, frames++)
+				{
+					const uint64_t allocationsBefore = getThreadAllocationCount();
+					for (; cursor < events.size() && events[cursor].time - noteSoundLookAhead < time; cursor++)
+					{
+						if (!events[cursor].isHoldConnect())
+							sounds++;
+					}
+
+					allocations += getThreadAllocationCount() - allocationsBefore;
+				}
+			}
+
+			state.setItemsProcessed(frames);
+			state.setCounter("sounds", static_cast<double>(sounds) / state.getIterations());
+			if (allocationCountingEnabled)
+				state.setCounter("allocations_per_frame", static_cast<double>(allocations) / std::max<int64_t>(frames, 1));
+
+			// Playback runs this every frame on the UI thread, which must not touch the heap once the schedule is built
+			if (allocations > 0)
+				state.skipWithError("Playback frames allocated " + std::to_string(allocations) + " times");
+		});
+
+		runner.add("Playback/NoteSounds/Build" + suffix, [size](BenchmarkState& state)
+		{
+			const mmw::Score score = createBenchmarkScore(size);
+			const mmw::TempoMap tempoMap(score.tempoChanges, score.hiSpeedChanges, mmw::TICKS_PER_BEAT);
+			Audio::SoundEffectProfile soundEffects = createBenchmarkSoundEffects();
+			mmw::NoteSoundSchedule schedule;
+
+			int generation = 0;
+			while (state.keepRunning())
+				schedule.build(score, tempoMap, soundEffects, generation++, 0);
+
+			if (schedule.getEvents().empty())
+				state.skipWithError("No sound effects were scheduled");
+
+			state.setItemsProcessed(state.getIterations() * score.notes.size());
+		});
+	}
+
+	void addScoreBenchmarks(BenchmarkRunner& runner)
+	{
+		for (int size : benchmarkScoreSizes)
+		{
+			for (const char* format : benchmarkFormats)
+				addSerializerBenchmarks(runner, format, size);
+
+			addScoreSizeBenchmarks(runner, size);
+			addNoteSoundBenchmarks(runner, size);
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Benchmark.h"
+#include "Score.h"
+#include "Tempo.h"
+
+namespace Debug
+{
+	constexpr int benchmarkScoreSizes[] = { 1000, 10000 };
+
+	// Playback is simulated at 60 frames per second with the timeline's audio look ahead
+	constexpr float noteSoundFrameTime = 1.0f / 60.0f;
+	constexpr float noteSoundLookAhead = 0.05f;
+
+	/// <summary>
+	/// Generates the same score of the given size on every run, for benchmarks to work on
+	/// </summary>
+	MikuMikuWorld::Score createBenchmarkScore(int noteCount);
+	std::string getTemporaryFilename(const std::string& format);
+
+	/// <summary>
+	/// Seconds from the start of the score until a second after its last note
+	/// </summary>
+	float getNoteSoundsDuration(const MikuMikuWorld::Score& score, const MikuMikuWorld::TempoMap& tempoMap);
+
+	/// <summary>
+	/// Adds the benchmarks of the score pipeline that build on every platform, run on generated scores of several sizes:
+	/// serializing and deserializing every format, note stats, history, tempo conversion and the note sounds schedule
+	/// </summary>
+	void addScoreBenchmarks(BenchmarkRunner& runner);
+}
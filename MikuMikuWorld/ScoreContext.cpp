@@ -3,6 +3,7 @@
 #include "Utilities.h"
 #include "UI.h"
 #include "Clipboard.h"
+#include "ApplicationConfiguration.h"
 #include <vector>
 
 using json = nlohmann::json;
@@ -526,20 +527,21 @@ namespace MikuMikuWorld
 			return;
 
 		Score prev = score;
-		Note& note1 = score.notes[*selectedNotes.begin()];
-		Note& note2 = score.notes[*std::next(selectedNotes.begin())];
+
+		// Both notes are erased below, and inserting the new mid notes may move the notes in storage, so work on copies
+		const Note note1 = score.notes.at(*selectedNotes.begin());
+		const Note note2 = score.notes.at(*std::next(selectedNotes.begin()));
 		
-		Note& earlierNote = note1.getType() == NoteType::HoldEnd ? note1 : note2;
-		Note& laterNote = note1.getType() == NoteType::HoldEnd ? note2 : note1;
+		const Note& earlierNote = note1.getType() == NoteType::HoldEnd ? note1 : note2;
+		const Note& laterNote = note1.getType() == NoteType::HoldEnd ? note2 : note1;
 
 		HoldNote& earlierHold = score.holdNotes[earlierNote.parentID];
 		HoldNote& laterHold = score.holdNotes[laterNote.ID];
 		
 		earlierHold.end = laterHold.end;
-		laterNote.parentID = earlierHold.start.ID;
 
 		// We need to determine whether the new end will be critical
-		Note& earlierHoldStart = score.notes.at(earlierHold.start.ID);
+		const Note earlierHoldStart = score.notes.at(earlierHold.start.ID);
 		Note& laterHoldEnd = score.notes.at(score.holdNotes.at(laterNote.ID).end);
 		if (earlierHoldStart.critical)
 			laterHoldEnd.critical = true;
@@ -655,14 +657,20 @@ namespace MikuMikuWorld
 	{
 		if (history.hasUndo())
 		{
-			score = history.undo();
+			const History& entry = history.undo(score);
+			journal.append(entry.undo);
 			clearSelection();
 
 			UI::setWindowTitle((workingData.filename.size() ? File::getFilename(workingData.filename) : windowUntitled) + "*");
 			upToDate = false;
 
-			scoreStats.calculateStats(score);
-			scorePreviewDrawData.calculateDrawData(score);
+			updateTempoMap();
+			if (entry.undo.events && entry.undo.events->timeSignatures != entry.redo.events->timeSignatures)
+				updateMeasureIndex();
+
+			const ScoreChangeSet changes = createChangeSet(entry.redo, entry.undo);
+			scoreStats.updateStats(score, changes);
+			scorePreviewDrawData.updateDrawData(score, tempoMap, changes);
 		}
 	}
 
@@ -670,28 +678,70 @@ namespace MikuMikuWorld
 	{
 		if (history.hasRedo())
 		{
-			score = history.redo();
+			const History& entry = history.redo(score);
+			journal.append(entry.redo);
 			clearSelection();
 
 			UI::setWindowTitle((workingData.filename.size() ? File::getFilename(workingData.filename) : windowUntitled) + "*");
 			upToDate = false;
 
-			scoreStats.calculateStats(score);
-			scorePreviewDrawData.calculateDrawData(score);
+			updateTempoMap();
+			if (entry.undo.events && entry.undo.events->timeSignatures != entry.redo.events->timeSignatures)
+				updateMeasureIndex();
+
+			const ScoreChangeSet changes = createChangeSet(entry.undo, entry.redo);
+			scoreStats.updateStats(score, changes);
+			scorePreviewDrawData.updateDrawData(score, tempoMap, changes);
 		}
 	}
 
 	void ScoreContext::pushHistory(std::string description, const Score& prev, const Score& curr)
 	{
-		history.pushHistory(description, prev, curr);
+		history.setMemoryBudget(static_cast<size_t>(std::max(config.historyMemoryBudget, 0)) * 1024 * 1024);
+		const History& entry = history.pushHistory(description, prev, curr);
+		journal.append(entry.redo);
 
 		UI::setWindowTitle((workingData.filename.size() ? File::getFilename(workingData.filename) : windowUntitled) + "*");
-		scoreStats.calculateStats(score);
-		scorePreviewDrawData.calculateDrawData(score);
+		updateTempoMap();
+		if (prev.timeSignatures != curr.timeSignatures)
+			updateMeasureIndex();
+
+		const ScoreChangeSet changes = createChangeSet(entry.undo, entry.redo);
+		scoreStats.updateStats(score, changes);
+		scorePreviewDrawData.updateDrawData(score, tempoMap, changes);
 
 		upToDate = false;
 	}
 
+	void ScoreContext::updateTempoMap()
+	{
+		tempoMap.build(score.tempoChanges, score.hiSpeedChanges, TICKS_PER_BEAT);
+	}
+
+	void ScoreContext::updateMeasureIndex()
+	{
+		measureIndex.build(score.timeSignatures, TICKS_PER_BEAT);
+	}
+
+	void ScoreContext::generateWaveforms(bool force)
+	{
+		const Audio::AudioCacheKey& cacheKey = audio.getMusicCacheKey();
+		if (!force && audio.musicCache.loadWaveforms(cacheKey, waveformL, waveformR))
+			return;
+
+		if (!audio.isMusicStreaming())
+		{
+			Audio::WaveformMipChain::generateMipChains(audio.musicBuffer, waveformL, waveformR);
+		}
+		else
+		{
+			// The stream only keeps a couple of seconds of samples, so the mips are built while decoding instead of from the whole file
+			Audio::WaveformMipChain::generateMipChainsFromFile(workingData.musicFilename, waveformL, waveformR);
+		}
+
+		audio.musicCache.storeWaveforms(cacheKey, waveformL, waveformR);
+	}
+
 	int ScoreContext::minTickFromSelection() const
 	{
 		int minTick = score.notes.at(*std::min_element(selectedNotes.begin(), selectedNotes.end(),
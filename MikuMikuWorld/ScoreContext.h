@@ -2,6 +2,7 @@
 #include "Score.h"
 #include "ScoreStats.h"
 #include "HistoryManager.h"
+#include "EditJournal.h"
 #include "Audio/AudioManager.h"
 #include "Audio/Waveform.h"
 #include "JsonIO.h"
@@ -54,8 +55,8 @@ namespace MikuMikuWorld
 
 	struct PasteData
 	{
-		std::map<int, Note> notes;
-		std::map<int, HoldNote> holds;
+		SlotMap<Note> notes;
+		SlotMap<HoldNote> holds;
 		bool pasting{ false };
 		int minTick{};
 		int offsetTicks{};
@@ -72,9 +73,12 @@ namespace MikuMikuWorld
 		ScoreContext& operator= (const ScoreContext&) = delete;
 
 		Score score;
+		TempoMap tempoMap;
+		MeasureIndex measureIndex;
 		EditorScoreData workingData;
 		ScoreStats scoreStats;
 		HistoryManager history;
+		EditJournal journal;
 		Audio::AudioManager audio;
 		PasteData pasteData{};
 		std::unordered_set<int> selectedNotes;
@@ -101,9 +105,15 @@ namespace MikuMikuWorld
 
 		double getTimeAtCurrentTick() const
 		{
-			return accumulateDuration(currentTick, TICKS_PER_BEAT, score.tempoChanges);
+			return tempoMap.ticksToSeconds(currentTick);
 		}
 
+		/// <summary>
+		/// Builds the waveforms of the loaded music, decoding the whole music file again when it is streamed.
+		/// Waveforms found in the music cache are read from it instead, unless force is set.
+		/// </summary>
+		void generateWaveforms(bool force = false);
+
 		int minTickFromSelection() const;
 		bool selectionHasEase() const;
 		bool selectionHasStep() const;
@@ -137,6 +147,8 @@ namespace MikuMikuWorld
 
 		void undo();
 		void redo();
+		void updateTempoMap();
+		void updateMeasureIndex();
 		void pushHistory(std::string description, const Score& prev, const Score& current);
 	};
 }
@@ -42,9 +42,13 @@ namespace MikuMikuWorld
 		timeline.setZoom(config.zoom);
 
 		autoSavePath = Application::getAppDir() + "auto_save";
+		context.audio.musicCache.setDirectory(Application::getAppDir() + "cache\\music");
 		autoSaveTimer.reset();
 
 		preview.loadNoteEffects(context.scorePreviewDrawData.effectView);
+
+		untitledJournalFilename = Application::getAppDir() + "recovery\\untitled" + MMWS_EXTENSION;
+		openJournal();
 	}
 
 	void ScoreEditor::writeSettings()
@@ -59,6 +63,15 @@ namespace MikuMikuWorld
 
 	void ScoreEditor::uninitialize()
 	{
+		if (autoSaveFuture.valid())
+			autoSaveFuture.wait();
+
+		// Keep the journal of unsaved edits if the application is closing because of an error
+		if (isUpToDate())
+			context.journal.discard();
+		else
+			context.journal.close();
+
 		context.audio.uninitializeAudioEngine();
 		timeline.background.dispose();
 	}
@@ -155,6 +168,16 @@ namespace MikuMikuWorld
 			settingsWindow.isEffectProfileChangePending = false;
 		}
 
+		if (settingsWindow.isClearMusicCachePending)
+		{
+			// Entries may still be written while music loads
+			if (loadMusicFuture.valid())
+				loadMusicFuture.get();
+
+			context.audio.musicCache.clear();
+			settingsWindow.isClearMusicCachePending = false;
+		}
+
 		if (propertiesWindow.isPendingLoadMusic)
 		{
 			asyncLoadMusic(propertiesWindow.pendingLoadMusicFilename);
@@ -162,12 +185,19 @@ namespace MikuMikuWorld
 			propertiesWindow.pendingLoadMusicFilename.clear();
 		}
 
-		if (config.autoSaveEnabled && autoSaveTimer.elapsedMinutes() >= config.autoSaveInterval)
+		// The snapshot is written on a worker thread from a copy of the score and swapped in once it is done
+		context.journal.update();
+		if (context.journal.needsCompaction())
 		{
-			autoSave();
-			autoSaveTimer.reset();
+			context.score.metadata = context.workingData.toScoreMetadata();
+			context.journal.compact(context.score);
 		}
 
+		updateAutoSaveStatus();
+		// An auto save that can't start yet because the previous one is still being written is retried next frame
+		if (config.autoSaveEnabled && autoSaveTimer.elapsedMinutes() >= config.autoSaveInterval && autoSave())
+			autoSaveTimer.reset();
+
 		if (recentFileNotFoundDialog.update() == DialogResult::Yes)
 		{
 			if (isArrayIndexInBounds(recentFileNotFoundDialog.removeIndex, config.recentFiles))
@@ -264,6 +294,9 @@ namespace MikuMikuWorld
 		timeline.setPlaying(context, false);
 
 		context.score = {};
+		resetNextID();
+		context.updateTempoMap();
+		context.updateMeasureIndex();
 		context.workingData = {};
 		context.history.clear();
 		context.scoreStats.reset();
@@ -277,6 +310,7 @@ namespace MikuMikuWorld
 		context.upToDate = true; 
 
 		UI::setWindowTitle(windowUntitled);
+		openJournal();
 	}
 
 	void ScoreEditor::loadScore(std::string filename)
@@ -294,7 +328,11 @@ namespace MikuMikuWorld
 		context.waveformL.clear();
 		context.waveformR.clear();
 		
-		Result result = context.audio.loadMusic(filename);
+		context.audio.musicCache.setEnabled(config.cacheMusic);
+		context.audio.musicCache.setSamplesEnabled(config.cacheDecodedMusic);
+		context.audio.musicCache.setSizeLimit(static_cast<uint64_t>(config.musicCacheSize) * 1024 * 1024);
+
+		Result result = context.audio.loadMusic(filename, config.streamMusic);
 		if (result.isOk() || filename.empty())
 		{
 			context.workingData.musicFilename = filename;
@@ -311,8 +349,7 @@ namespace MikuMikuWorld
 			IO::messageBox(APP_NAME, errorMessage, IO::MessageBoxButtons::Ok, IO::MessageBoxIcon::Error, Application::windowState.windowHandle);
 		}
 		
-		context.waveformL.generateMipChainsFromSampleBuffer(context.audio.musicBuffer, 0);
-		context.waveformR.generateMipChainsFromSampleBuffer(context.audio.musicBuffer, 1);
+		context.generateWaveforms();
 
 		if (timeline.isPlaying())
 		{
@@ -362,10 +399,15 @@ namespace MikuMikuWorld
 		try
 		{
 			context.score.metadata = context.workingData.toScoreMetadata();
-			NativeScoreSerializer().serialize(context.score, filename);
+			NativeScoreSerializer serializer;
+			serializer.serialize(context.score, filename);
 
 			UI::setWindowTitle(IO::File::getFilename(filename));
 			context.upToDate = true;
+
+			// The journal starts from the file just written, checksummed from the bytes the serializer still holds
+			context.journal.discard();
+			context.journal.beginFromFile(context.score, filename, serializer.getWrittenSize(), serializer.getWrittenChecksum());
 		}
 		catch (const std::exception& err)
 		{
@@ -604,10 +646,25 @@ namespace MikuMikuWorld
 			ImGui::EndMenu();
 		}
 
+		std::string fps;
+		float fpsWidth = 0;
+		if (config.showFPS)
+		{
+			fps = IO::formatString("%.3fms (%.1fFPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+			fpsWidth = ImGui::CalcTextSize(fps.c_str()).x;
+		}
+
+		// auto save status goes left of the FPS counter
+		if (const char* autoSaveText = getAutoSaveStatusText())
+		{
+			float spacing = config.showFPS ? ImGui::GetStyle().ItemSpacing.x * 2 : 0.0f;
+			ImGui::SetCursorPosX(ImGui::GetWindowSize().x - fpsWidth - spacing - ImGui::CalcTextSize(autoSaveText).x - ImGui::GetStyle().WindowPadding.x);
+			ImGui::TextDisabled("%s", autoSaveText);
+		}
+
 		if (config.showFPS)
 		{
-			std::string fps = IO::formatString("%.3fms (%.1fFPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-			ImGui::SetCursorPosX(ImGui::GetWindowSize().x - ImGui::CalcTextSize(fps.c_str()).x - ImGui::GetStyle().WindowPadding.x);
+			ImGui::SetCursorPosX(ImGui::GetWindowSize().x - fpsWidth - ImGui::GetStyle().WindowPadding.x);
 			ImGui::Text(fps.c_str());
 		}
 
@@ -700,24 +757,146 @@ namespace MikuMikuWorld
 		ShellExecuteW(0, 0, L"https://github.com/crash5band/MikuMikuWorld/wiki", 0, 0, SW_SHOW);
 	}
 
-	void ScoreEditor::autoSave()
+	// Auto save files in the directory, oldest first
+	static std::vector<std::filesystem::directory_entry> getAutoSaveFiles(const std::wstring& directory)
 	{
-		std::wstring wAutoSaveDir = IO::mbToWideStr(autoSavePath);
-		std::filesystem::create_directory(wAutoSaveDir);
-
-		context.score.metadata = context.workingData.toScoreMetadata();
-		NativeScoreSerializer().serialize(context.score, autoSavePath + "\\mmw_auto_save_" + Utilities::getCurrentDateTime() + MMWS_EXTENSION);
-		
-		int mmwsCount = 0;
-		for (const auto& file : std::filesystem::directory_iterator(wAutoSaveDir))
+		std::vector<std::filesystem::directory_entry> files;
+		std::error_code error;
+		for (const auto& file : std::filesystem::directory_iterator(directory, error))
 		{
 			std::string extension = file.path().extension().string();
 			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-			mmwsCount += static_cast<int>(extension == MMWS_EXTENSION);
+			if (extension == MMWS_EXTENSION)
+				files.push_back(file);
+		}
+
+		std::sort(files.begin(), files.end(), [](const auto& f1, const auto& f2) {
+			return f1.last_write_time() < f2.last_write_time();
+		});
+
+		return files;
+	}
+
+	static int deleteOldAutoSaveFiles(const std::wstring& directory, int count)
+	{
+		std::vector<std::filesystem::directory_entry> files = getAutoSaveFiles(directory);
+		int deleteCount = std::min(static_cast<int>(files.size()), count);
+		for (int i = 0; i < deleteCount; i++)
+		{
+			std::error_code error;
+			std::filesystem::remove(files[i], error);
+		}
+
+		return deleteCount;
+	}
+
+	// Runs on the auto save worker, so it may only touch its arguments
+	static bool writeAutoSave(const Score& score, const std::string& directory, const std::string& filename, int maxCount)
+	{
+		std::wstring wDirectory = IO::mbToWideStr(directory);
+		std::error_code error;
+		std::filesystem::create_directory(wDirectory, error);
+
+		// Write a temporary file and rename it once complete so a crash never leaves a truncated auto save behind
+		const std::filesystem::path path = IO::mbToWideStr(directory + "\\" + filename);
+		std::filesystem::path tempPath = path;
+		tempPath += L".tmp";
+
+		try
+		{
+			NativeScoreSerializer().serialize(score, IO::wideStringToMb(tempPath.wstring()));
+		}
+		catch (const std::exception&)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		if (!std::filesystem::exists(tempPath, error) || std::filesystem::file_size(tempPath, error) == 0)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		// Remove temporary files left by an auto save that was interrupted
+		for (const auto& file : std::filesystem::directory_iterator(wDirectory, error))
+		{
+			if (file.path().extension() == L".tmp")
+			{
+				std::error_code removeError;
+				std::filesystem::remove(file, removeError);
+			}
+		}
+
+		int mmwsCount = static_cast<int>(getAutoSaveFiles(wDirectory).size());
+		if (mmwsCount > maxCount)
+			deleteOldAutoSaveFiles(wDirectory, mmwsCount - maxCount);
+
+		return true;
+	}
+
+	bool ScoreEditor::autoSave()
+	{
+		// Never start a second auto save while the previous one is still being written
+		if (isAutoSaving())
+			return false;
+
+		updateAutoSaveStatus();
+
+		context.score.metadata = context.workingData.toScoreMetadata();
+		autoSaveStatus = AutoSaveStatus::Saving;
+		autoSaveFuture = std::async(std::launch::async,
+			[score = context.score, directory = autoSavePath, filename = "mmw_auto_save_" + Utilities::getCurrentDateTime() + MMWS_EXTENSION, maxCount = config.autoSaveMaxCount]()
+		{
+			return writeAutoSave(score, directory, filename, maxCount);
+		});
+
+		return true;
+	}
+
+	bool ScoreEditor::isAutoSaving() const
+	{
+		return autoSaveFuture.valid() && autoSaveFuture.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+	}
+
+	void ScoreEditor::updateAutoSaveStatus()
+	{
+		if (!autoSaveFuture.valid() || isAutoSaving())
+			return;
+
+		try
+		{
+			autoSaveStatus = autoSaveFuture.get() ? AutoSaveStatus::Saved : AutoSaveStatus::Failed;
+		}
+		catch (const std::exception&)
+		{
+			autoSaveStatus = AutoSaveStatus::Failed;
+		}
+
+		autoSaveStatusTimer.reset();
+	}
+
+	const char* ScoreEditor::getAutoSaveStatusText() const
+	{
+		constexpr double savedStatusDuration = 5.0;
+		switch (autoSaveStatus)
+		{
+		case AutoSaveStatus::Saving:
+			return getString("auto_saving");
+		case AutoSaveStatus::Saved:
+			return autoSaveStatusTimer.elapsed() < savedStatusDuration ? getString("auto_save_complete") : nullptr;
+		case AutoSaveStatus::Failed:
+			return getString("auto_save_failed");
+		default:
+			return nullptr;
 		}
-		
-		if (mmwsCount > config.autoSaveMaxCount)
-			deleteOldAutoSave(mmwsCount - config.autoSaveMaxCount);
 	}
 
 	int ScoreEditor::deleteOldAutoSave(int count)
@@ -726,27 +905,93 @@ namespace MikuMikuWorld
 		if (!std::filesystem::exists(wAutoSaveDir))
 			return 0;
 
-		// get mmws files
-		using entry = std::filesystem::directory_entry;
-		std::vector<entry> deleteFiles;
-		for (const auto& file : std::filesystem::directory_iterator(wAutoSaveDir))
+		return deleteOldAutoSaveFiles(wAutoSaveDir, count);
+	}
+
+	std::string ScoreEditor::getJournaledFilename() const
+	{
+		return context.workingData.filename.empty() ? untitledJournalFilename : context.workingData.filename;
+	}
+
+	void ScoreEditor::startJournal()
+	{
+		context.journal.discard();
+		context.score.metadata = context.workingData.toScoreMetadata();
+
+		// A score that matches its file can use it as the base of the journal instead of writing a snapshot
+		if (context.upToDate && !context.workingData.filename.empty())
+			context.journal.beginFromFile(context.score, context.workingData.filename);
+		else
+			context.journal.beginFromSnapshot(context.score, getJournaledFilename());
+	}
+
+	void ScoreEditor::openJournal()
+	{
+		// The journal of the previous score holds edits that were either saved or discarded
+		context.journal.discard();
+
+		const std::string filename = getJournaledFilename();
+		if (EditJournal::hasRecovery(filename))
 		{
-			std::string extension = file.path().extension().string();
-			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
-			if (extension == MMWS_EXTENSION)
-				deleteFiles.push_back(file);
+			IO::MessageBoxResult result = IO::messageBox(
+				APP_NAME,
+				IO::formatString("%s\n%s: %s", getString("recover_unsaved_changes"), getString("score_file"), filename.c_str()),
+				IO::MessageBoxButtons::YesNo,
+				IO::MessageBoxIcon::Question,
+				Application::windowState.windowHandle
+			);
+
+			if (result == IO::MessageBoxResult::Yes)
+			{
+				try
+				{
+					loadRecoveredScore(EditJournal::recover(filename));
+				}
+				catch (const std::exception& err)
+				{
+					// Keep the unrecoverable journal around instead of overwriting it with a new one
+					EditJournal::setAside(filename);
+					IO::messageBox(
+						APP_NAME,
+						IO::formatString("%s\n%s: %s", getString("error_recover_unsaved_changes"), getString("error"), err.what()),
+						IO::MessageBoxButtons::Ok,
+						IO::MessageBoxIcon::Error,
+						Application::windowState.windowHandle
+					);
+				}
+			}
 		}
 
-		// sort files by modification date
-		std::sort(deleteFiles.begin(), deleteFiles.end(), [](const entry& f1, const entry& f2) {
-			return f1.last_write_time() < f2.last_write_time();
-		});
+		startJournal();
+	}
 
-		int deleteCount = std::min(static_cast<int>(deleteFiles.size()), count);
-		for (int i = 0; i < deleteCount; i++)
-			std::filesystem::remove(deleteFiles[i]);
-		
-		return deleteCount;
+	void ScoreEditor::discardJournal()
+	{
+		context.journal.discard();
+	}
+
+	void ScoreEditor::loadRecoveredScore(Score score)
+	{
+		const std::string previousMusicFilename = context.workingData.musicFilename;
+
+		context.clearSelection();
+		context.history.clear();
+		context.score = std::move(score);
+		context.workingData = EditorScoreData(context.score.metadata, context.workingData.filename);
+
+		if (context.workingData.musicFilename != previousMusicFilename)
+			asyncLoadMusic(context.workingData.musicFilename);
+		context.audio.setMusicOffset(0, context.workingData.musicOffset);
+
+		context.updateTempoMap();
+		context.updateMeasureIndex();
+		context.scoreStats.calculateStats(context.score);
+		context.scorePreviewDrawData.calculateDrawData(context.score, context.tempoMap);
+		timeline.calculateMaxOffsetFromScore(context.score);
+
+		// The recovered edits have not been saved to the score file yet
+		UI::setWindowTitle((context.workingData.filename.size() ? IO::File::getFilename(context.workingData.filename) : windowUntitled) + "*");
+		context.upToDate = false;
 	}
 
 	void ScoreEditor::loadPresets()
@@ -7,6 +7,14 @@
 
 namespace MikuMikuWorld
 {
+	enum class AutoSaveStatus
+	{
+		None,
+		Saving,
+		Saved,
+		Failed
+	};
+
 	class ScoreEditor
 	{
 	private:
@@ -29,6 +37,14 @@ namespace MikuMikuWorld
 
 		Stopwatch autoSaveTimer;
 		std::string autoSavePath;
+
+		// Auto saves are written on a worker thread from a copy of the score, one at a time
+		std::future<bool> autoSaveFuture{};
+		AutoSaveStatus autoSaveStatus{ AutoSaveStatus::None };
+		Stopwatch autoSaveStatusTimer;
+
+		// Untitled scores are journaled as if they were saved here
+		std::string untitledJournalFilename;
 		bool showImGuiDemoWindow{false};
 
 		std::future<void> loadMusicFuture{};
@@ -36,6 +52,11 @@ namespace MikuMikuWorld
 		std::future<void> importPresetFuture{};
 
 		bool save(std::string filename);
+		void updateAutoSaveStatus();
+		const char* getAutoSaveStatusText() const;
+		std::string getJournaledFilename() const;
+		void startJournal();
+		void loadRecoveredScore(Score score);
 
 	public:
 		ScoreEditor();
@@ -50,8 +71,16 @@ namespace MikuMikuWorld
 		void exportScore();
 		bool saveAs();
 		bool trySave(std::string);
-		void autoSave();
+		bool autoSave();
 		int deleteOldAutoSave(int count);
+		bool isAutoSaving() const;
+
+		/// <summary>
+		/// Replaces the journal of the previous score with one for the current score,
+		/// first offering to recover the edits left in an existing journal by a crash
+		/// </summary>
+		void openJournal();
+		void discardJournal();
 		size_t updateRecentFilesList(const std::string& entry);
 
 		void drawMenubar();
@@ -102,7 +102,7 @@ namespace MikuMikuWorld
 		ImGui::PopStyleColor(3);
 
 		bool highlight = activated || ImGui::IsItemHovered() || ImGui::IsItemActive();
-		drawEvents.push({ timelineX, {posX, posY}, itemSize + ImVec2{1, 0}, txtSize, color, txt, highlight, enabled });
+		drawEvents.push_back({ timelineX, {posX, posY}, itemSize + ImVec2{1, 0}, txtSize, color, txt, highlight, enabled });
 		eventControlCursor[tracks] = std::make_pair(minCursor, maxCursor);
 
 		return activated;
@@ -262,14 +262,14 @@ namespace MikuMikuWorld
 		maxOffset = std::max(offset, std::max(10000.0f, (maxTick + extraOffset) * unitHeight));
 	}
 
-	int ScoreEditorTimeline::getStopTick(const Score& score) const
+	int ScoreEditorTimeline::getStopTick(const ScoreContext& context) const
 	{
 		int maxTick = 0;
-		for (const auto& [id, note] : score.notes)
+		for (const auto& [id, note] : context.score.notes)
 			maxTick = std::max(maxTick, note.tick);
 
-		int maxMeasure = accumulateMeasures(maxTick, TICKS_PER_BEAT, score.timeSignatures) + 1;
-		return measureToTicks(maxMeasure, TICKS_PER_BEAT, score.timeSignatures);
+		int maxMeasure = context.measureIndex.ticksToMeasure(maxTick) + 1;
+		return context.measureIndex.measureToTicks(maxMeasure);
 	}
 
 	float ScoreEditorTimeline::getStopTime(const ScoreContext& context)
@@ -281,7 +281,7 @@ namespace MikuMikuWorld
 		else
 		{
 			if (stopTime < 0.0f)
-				stopTime = accumulateDuration(getStopTick(context.score), TICKS_PER_BEAT, context.score.tempoChanges);
+				stopTime = context.tempoMap.ticksToSeconds(getStopTick(context));
 
 			return stopTime;
 		}
@@ -528,53 +528,23 @@ namespace MikuMikuWorld
 			// Draw measures
 			int firstTick = std::max(0, positionToTick(visualOffset - size.y));
 			int lastTick = positionToTick(visualOffset);
-			int measure = accumulateMeasures(firstTick, TICKS_PER_BEAT, context.score.timeSignatures);
-			firstTick = measureToTicks(measure, TICKS_PER_BEAT, context.score.timeSignatures);
+			int measure = context.measureIndex.ticksToMeasure(firstTick);
+			firstTick = context.measureIndex.measureToTicks(measure);
 
-			int tsIndex = findTimeSignature(measure, context.score.timeSignatures);
-			int ticksPerMeasure = beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-			int beatTicks = ticksPerMeasure / context.score.timeSignatures[tsIndex].numerator;
+			// Lines are snapped to the sub-division grid to prevent them from jumping around
 			int subdivision = TICKS_PER_BEAT / (division / 4);
-
-			// Snap to the sub-division before the current measure to prevent the lines from jumping around
-			for (int tick = firstTick - (firstTick % subdivision); tick <= lastTick; tick += subdivision)
+			for (const GridLine& line : context.measureIndex.gridLines(firstTick, lastTick, subdivision))
 			{
-				const int y = position.y - tickToPosition(tick) + visualOffset;
-				int currentMeasure = accumulateMeasures(tick, TICKS_PER_BEAT, context.score.timeSignatures);
-
-				// Time signature changes on current measure
-				if (context.score.timeSignatures.find(currentMeasure) != context.score.timeSignatures.end() && currentMeasure != tsIndex)
-				{
-					tsIndex = currentMeasure;
-					ticksPerMeasure = beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-					beatTicks = ticksPerMeasure / context.score.timeSignatures[tsIndex].numerator;
-
-					// Snap to sub-division again on time signature change
-					tick = measureToTicks(currentMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
-					tick -= tick % subdivision;
-				}
-
-				// Determine whether the tick is a beat relative to its measure's tick
-				int measureTicks = measureToTicks(currentMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
-
-				if (!((tick - measureTicks) % beatTicks))
+				const int y = position.y - tickToPosition(line.tick) + visualOffset;
+				if (line.beat)
 					drawList->AddLine(ImVec2(x1, y), ImVec2(x2, y), divColor1, primaryLineThickness);
 				else if (division < 192)
 					drawList->AddLine(ImVec2(x1, y), ImVec2(x2, y), divColor2, secondaryLineThickness);
 			}
 
-			tsIndex = findTimeSignature(measure, context.score.timeSignatures);
-			ticksPerMeasure = beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-
 			// Overdraw one measure to make sure the measure string is always visible
-			for (int tick = firstTick; tick < lastTick + ticksPerMeasure; tick += ticksPerMeasure)
+			for (int tick = firstTick; tick < lastTick + context.measureIndex.getTicksPerMeasure(measure); tick = context.measureIndex.measureToTicks(measure))
 			{
-				if (context.score.timeSignatures.find(measure) != context.score.timeSignatures.end())
-				{
-					tsIndex = measure;
-					ticksPerMeasure = beatsPerMeasure(context.score.timeSignatures[tsIndex]) * TICKS_PER_BEAT;
-				}
-
 				std::string measureStr = std::to_string(measure);
 				const float txtPos = x1 - MEASURE_WIDTH - (ImGui::CalcTextSize(measureStr.c_str()).x * 0.5f);
 				const int y = position.y - tickToPosition(tick) + visualOffset;
@@ -625,7 +595,7 @@ namespace MikuMikuWorld
 			// Update time signature changes
 			for (auto& [measure, ts] : context.score.timeSignatures)
 			{
-				if (timeSignatureControl(ts.numerator, ts.denominator, measureToTicks(ts.measure, TICKS_PER_BEAT, context.score.timeSignatures), !playing))
+				if (timeSignatureControl(ts.numerator, ts.denominator, context.measureIndex.measureToTicks(ts.measure), !playing))
 				{
 					eventEdit.editIndex = measure;
 					eventEdit.editTimeSignatureNumerator = ts.numerator;
@@ -651,8 +621,8 @@ namespace MikuMikuWorld
 			// Update song boundaries
 			if (context.audio.isMusicInitialized())
 			{
-				int startTick = accumulateTicks(context.workingData.musicOffset / 1000, TICKS_PER_BEAT, context.score.tempoChanges);
-				int endTick = accumulateTicks(context.audio.getMusicEndTime(), TICKS_PER_BEAT, context.score.tempoChanges);
+				int startTick = context.tempoMap.secondsToTicks(context.workingData.musicOffset / 1000);
+				int endTick = context.tempoMap.secondsToTicks(context.audio.getMusicEndTime());
 
 				float x = getTimelineEndX();
 				float y1 = position.y - tickToPosition(startTick) + visualOffset;
@@ -686,8 +656,8 @@ namespace MikuMikuWorld
 
 			while (!drawEvents.empty())
 			{
-				drawEventControl(drawEvents.top());
-				drawEvents.pop();
+				drawEventControl(drawEvents.back());
+				drawEvents.pop_back();
 			}
 
 			// Update cursor tick after determining whether a note is hovered
@@ -700,7 +670,7 @@ namespace MikuMikuWorld
 			}
 
 			// Selection boxes
-			std::vector<int> viewBoundary = context.scorePreviewDrawData.notesList.getTickRange(firstTick, lastTick + ticksPerMeasure);
+			context.scorePreviewDrawData.notesList.getTickRange(firstTick, lastTick + context.measureIndex.getTicksPerMeasure(measure), viewBoundary);
 			const auto& notesList = context.scorePreviewDrawData.notesList.getView();
 			for (int i : viewBoundary)
 			{
@@ -787,7 +757,7 @@ namespace MikuMikuWorld
 			if (activated)
 			{
 				gotoMeasure = std::clamp(gotoMeasure, 0, 999);
-				context.currentTick = measureToTicks(gotoMeasure, TICKS_PER_BEAT, context.score.timeSignatures);
+				context.currentTick = context.measureIndex.measureToTicks(gotoMeasure);
 				offset = std::max(minOffset, tickToPosition(context.currentTick) + (size.y * (1.0f - config.cursorPositionThreshold)));
 			}
 
@@ -808,9 +778,9 @@ namespace MikuMikuWorld
 			ImGui::SeparatorEx(ImGuiSeparatorFlags_Vertical);
 			ImGui::SameLine();
 
-			int currentMeasure = accumulateMeasures(context.currentTick, TICKS_PER_BEAT, context.score.timeSignatures);
-			const TimeSignature& ts = context.score.timeSignatures[findTimeSignature(currentMeasure, context.score.timeSignatures)];
-			const Tempo& tempo = getTempoAt(context.currentTick, context.score.tempoChanges);
+			int currentMeasure = context.measureIndex.ticksToMeasure(context.currentTick);
+			const TimeSignature& ts = context.score.timeSignatures[context.measureIndex.findSignatureMeasure(currentMeasure)];
+			const Tempo& tempo = context.tempoMap.getTempoAt(context.currentTick);
 
 			int hiSpeed = findHighSpeedChange(context.currentTick, context.score.hiSpeedChanges);
 			float speed = (hiSpeed == -1 ? 1.0f : context.score.hiSpeedChanges[hiSpeed].speed);
@@ -853,7 +823,7 @@ namespace MikuMikuWorld
 				config.returnToLastSelectedTickOnPause = prevPauseBehaviour;
 			}
 
-			context.currentTick = accumulateTicks(time, TICKS_PER_BEAT, context.score.tempoChanges);
+			context.currentTick = context.tempoMap.secondsToTicks(time);
 
 			float cursorY = tickToPosition(context.currentTick);
 			if (config.followCursorInPlayback)
@@ -869,7 +839,7 @@ namespace MikuMikuWorld
 		}
 		else
 		{
-			time = accumulateDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges);
+			time = context.tempoMap.ticksToSeconds(context.currentTick);
 		}
 	}
 
@@ -894,7 +864,7 @@ namespace MikuMikuWorld
 		Stopwatch renderTimer{};
 		renderTimer.reset();
 
-		std::vector<int> viewBoundary = context.scorePreviewDrawData.notesList.getTickRange(startTick, endTick);
+		context.scorePreviewDrawData.notesList.getTickRange(startTick, endTick, viewBoundary);
 		const auto& notesList = context.scorePreviewDrawData.notesList.getView();
 
 		slidePathFramebuffer->bind();
@@ -924,7 +894,7 @@ namespace MikuMikuWorld
 		{
 			Note& note = context.score.notes.at(notesList.at(*it).refID);
 			if (updateNote(context, edit, note))
-				context.scorePreviewDrawData.notesList.updateNote(*it, note, context.score);
+				context.scorePreviewDrawData.notesList.updateNote(*it, note, context.tempoMap);
 
 			if (note.getType() == NoteType::Hold)
 			{
@@ -1080,7 +1050,7 @@ namespace MikuMikuWorld
 		}
 		else if (currentMode == TimelineMode::InsertTimeSign)
 		{
-			int measure = accumulateMeasures(hoverTick, TICKS_PER_BEAT, context.score.timeSignatures);
+			int measure = context.measureIndex.ticksToMeasure(hoverTick);
 			if (context.score.timeSignatures.find(measure) != context.score.timeSignatures.end())
 				return;
 
@@ -1141,11 +1111,8 @@ namespace MikuMikuWorld
 		}
 		else if (inputFever.startTick == inputFever.endTick)
 		{
-			int currentMeasure = accumulateMeasures(tick, TICKS_PER_BEAT, context.score.timeSignatures);
-			const TimeSignature& ts = context.score.timeSignatures.at(findTimeSignature(currentMeasure, context.score.timeSignatures));
-
-			int ticksPerMeasure = beatsPerMeasure(ts) * TICKS_PER_BEAT;
-			inputFever.endTick += ticksPerMeasure;
+			int currentMeasure = context.measureIndex.ticksToMeasure(tick);
+			inputFever.endTick += context.measureIndex.getTicksPerMeasure(currentMeasure);
 		}
 
 		Score prev = context.score;
@@ -1591,7 +1558,7 @@ namespace MikuMikuWorld
 		return isAnyChange;
 	}
 
-	void ScoreEditorTimeline::drawHoldCurve(const HoldNote& hold, const std::map<int, Note>& notes, Renderer* renderer, const Color& tint, const int offsetTicks, const int offsetLane)
+	void ScoreEditorTimeline::drawHoldCurve(const HoldNote& hold, const SlotMap<Note>& notes, Renderer* renderer, const Color& tint, const int offsetTicks, const int offsetLane)
 	{
 		const Note& start = notes.at(hold.start.ID);
 		const Note& end = notes.at(hold.end);
@@ -1710,7 +1677,7 @@ namespace MikuMikuWorld
 		}
 	}
 
-	void ScoreEditorTimeline::drawHoldNote(const std::map<int, Note>& notes, const HoldNote& note, Renderer* renderer,
+	void ScoreEditorTimeline::drawHoldNote(const SlotMap<Note>& notes, const HoldNote& note, Renderer* renderer,
 		const Color& tint, const int offsetTicks, const int offsetLane)
 	{
 		const Note& start = notes.at(note.start.ID);
@@ -2301,6 +2268,39 @@ namespace MikuMikuWorld
 			ImGui::Text("Render Time: %.3fms", renderStats.getRenderCpuTime() * 1000.0f);
 		}
 
+		if (ImGui::CollapsingHeader("History", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			const HistoryStats stats = context.history.getStats();
+			ImGui::Text("Undo entries: %d\nRedo entries: %d\nDiscarded entries: %d", stats.undoCount, stats.redoCount, stats.discardedCount);
+			ImGui::Text("Memory usage: %.2f KiB / %.2f KiB", stats.memoryUsage / 1024.0, stats.memoryBudget / 1024.0);
+		}
+
+		if (ImGui::CollapsingHeader("Preview Draw Data", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			const Engine::DrawData& drawData = context.scorePreviewDrawData;
+			ImGui::Text("Full updates: %d\nIncremental updates: %d", drawData.fullUpdateCount, drawData.incrementalUpdateCount);
+			ImGui::Text("Last update: %s", drawData.lastUpdateIncremental ? "Incremental" : "Full");
+		}
+
+		if (ImGui::CollapsingHeader("Note Storage"))
+		{
+			if (ImGui::Button("Run benchmark"))
+			{
+				noteStorageBenchmarks.clear();
+				for (int noteCount : { 10000, 50000, 200000 })
+					noteStorageBenchmarks.push_back(Debug::benchmarkNoteStorage(noteCount));
+			}
+
+			for (const auto& result : noteStorageBenchmarks)
+			{
+				ImGui::Text("%d notes (ms, std::map / SlotMap)", result.noteCount);
+				ImGui::Text("Iterate: %.3f / %.3f\nLookup: %.3f / %.3f\nCopy: %.3f / %.3f",
+					result.map.iterate, result.slotMap.iterate,
+					result.map.lookup, result.slotMap.lookup,
+					result.map.copy, result.slotMap.copy);
+			}
+		}
+
 		if (ImGui::CollapsingHeader("Hover Note", ImGuiTreeNodeFlags_DefaultOpen))
 		{
 			ImGui::Text("Hovering note ID: %d", hoveringNote);
@@ -2410,83 +2410,34 @@ namespace MikuMikuWorld
 		if (!playing)
 			return;
 
-		static auto singleNoteSEFunc = [&context, this](const Note& note, float notePlayTime)
-		{
-			bool playSE = true;
-			if (note.getType() == NoteType::Hold)
-			{
-				playSE = context.score.holdNotes.at(note.ID).startType == HoldNoteType::Normal;
-			}
-			else if (note.getType() == NoteType::HoldEnd)
-			{
-				playSE = context.score.holdNotes.at(note.parentID).endType == HoldNoteType::Normal;
-			}
-
-			if (playSE)
-			{
-				std::string_view se = getNoteSE(note, context.score);
-				std::string key = std::to_string(note.tick) + "-" + se.data();
-				if (!se.empty() && (playingNoteSounds.find(key) == playingNoteSounds.end()))
-				{
-					context.audio.playSoundEffect(se.data(), notePlayTime, -1, time);
-					playingNoteSounds.insert(key);
-				}
-			}
-		};
-
-		static auto holdNoteSEFunc = [&context, this](const Note& note, float startTime)
+		const float lookAhead = audioLookAhead * playbackSpeed;
+		const int generation = context.scorePreviewDrawData.generation;
+		const size_t profile = context.audio.getSoundEffectsProfileIndex();
+		if (!noteSounds.isBuiltFor(generation, profile))
 		{
-			int endTick = context.score.notes.at(context.score.holdNotes.at(note.ID).end).tick;
-			float endTime = accumulateDuration(endTick, TICKS_PER_BEAT, context.score.tempoChanges);
-
-			float adjustedEndTime = endTime - playStartTime;
-			context.audio.playSoundEffect(note.critical ? SE_CRITICAL_CONNECT : SE_CONNECT, startTime, adjustedEndTime, time);
-		};
+			noteSounds.build(context.score, context.tempoMap, context.audio.getSoundEffectsProfile(), generation, profile);
 
+			// Skip the sounds already played before the score changed
+			noteSoundCursor = noteSounds.findFirstEvent(timeLastFrame + lookAhead);
+		}
 
-		playingNoteSounds.clear();
-
-		float currentTime = context.getTimeAtCurrentTick();
-		const int currentTick = context.currentTick;
-		const int fromTick = accumulateTicks(std::max(currentTime - 1.f, 0.f), TICKS_PER_BEAT, context.score.tempoChanges);
-		const int toTick = accumulateTicks(currentTime + 1.f, TICKS_PER_BEAT, context.score.tempoChanges);
-		
-		std::vector<int> viewBoundary = context.scorePreviewDrawData.notesList.getTickRange(fromTick, toTick);
-		const auto& notesList = context.scorePreviewDrawData.notesList.getView();
-
-		for (int i : viewBoundary)
+		const std::vector<NoteSoundEvent>& events = noteSounds.getEvents();
+		if (time == playStartTime)
 		{
-			const auto& drawingNote = notesList.at(i);
-			const int id = drawingNote.refID;
-
-			float noteTime = drawingNote.time;
-			float notePlayTime = noteTime - playStartTime;
-			float offsetNoteTime = noteTime - (audioLookAhead * playbackSpeed);
-
-			if (offsetNoteTime >= timeLastFrame && offsetNoteTime < time)
+			// Playback just started, resume the holds it started in
+			noteSoundCursor = noteSounds.findFirstEvent(time);
+			for (size_t i = 0; i < noteSoundCursor; i++)
 			{
-				const Note& note = context.score.notes.at(id);
-				singleNoteSEFunc(note, notePlayTime);
-				if (note.getType() == NoteType::Hold && !context.score.holdNotes.at(note.ID).isGuide())
-					holdNoteSEFunc(note, notePlayTime);
+				if (events[i].isHoldConnect() && events[i].endTime > time)
+					context.audio.playSoundEffect(events[i].pool, 0.0f, events[i].endTime - playStartTime, time);
 			}
-			else if (time == playStartTime)
-			{
-				const Note& note = context.score.notes.at(id);
-
-				// Playback just started
-				if (noteTime >= time && offsetNoteTime < time)
-					singleNoteSEFunc(note, notePlayTime);
+		}
 
-				// Playback started mid-hold
-				if (note.getType() == NoteType::Hold && !context.score.holdNotes.at(note.ID).isGuide())
-				{
-					int endTick = context.score.notes.at(context.score.holdNotes.at(note.ID).end).tick;
-					float endTime = accumulateDuration(endTick, TICKS_PER_BEAT, context.score.tempoChanges);
-					if ((noteTime - time) <= audioLookAhead && endTime > time)
-						holdNoteSEFunc(note, std::max(0.0f, notePlayTime));
-				}
-			}
+		for (; noteSoundCursor < events.size() && events[noteSoundCursor].time - lookAhead < time; noteSoundCursor++)
+		{
+			const NoteSoundEvent& event = events[noteSoundCursor];
+			const float endTime = event.isHoldConnect() ? event.endTime - playStartTime : -1;
+			context.audio.playSoundEffect(event.pool, event.time - playStartTime, endTime, time);
 		}
 	}
 
@@ -2498,6 +2449,8 @@ namespace MikuMikuWorld
 
 		constexpr ImU32 waveformColorL = 0x80646464;
 		constexpr ImU32 waveformColorR = 0x80585858;
+		constexpr ImU32 waveformRmsColorL = 0xA0A8A8A8;
+		constexpr ImU32 waveformRmsColorR = 0xA09C9C9C;
 
 		// Ideally this should be calculated based on the current BPM
 		const double secondsPerPixel = waveformSecondsPerPixel / zoom;
@@ -2514,24 +2467,31 @@ namespace MikuMikuWorld
 				continue;
 
 			const ImU32 waveformColor = rightChannel ? waveformColorR : waveformColorL;
-			const Audio::WaveformMip& mip = waveform.findClosestMip(secondsPerPixel);
+			const ImU32 waveformRmsColor = rightChannel ? waveformRmsColorR : waveformRmsColorL;
+			const Audio::WaveformMip& mip = waveform.findPeakMip(secondsPerPixel);
+			const float maxBarWidth = std::min(laneWidth * 6, 180.0f);
 
 			for (int y = visualOffset - size.y; y < visualOffset; y += 1)
 			{
 				int tick = positionToTick(y);
 
 				// Small accuracy loss by converting to ticks but shouldn't be too noticeable
-				const double secondsAtPixel = accumulateDuration(tick, TICKS_PER_BEAT, context.score.tempoChanges) - musicOffsetInSeconds;
+				const double secondsAtPixel = context.tempoMap.ticksToSeconds(tick) - musicOffsetInSeconds;
 				const bool outOfBounds = secondsAtPixel < 0 || secondsAtPixel > waveform.durationInSeconds;
 
-				float amplitude = std::max(waveform.getAmplitudeAt(mip, secondsAtPixel, secondsPerPixel), 0.0f);
-				float barValue = outOfBounds ? 0.0f : (amplitude * std::min(laneWidth * 6, 180.0f));
+				const Audio::WaveformPeak peak = outOfBounds ? Audio::WaveformPeak{} : waveform.getPeakAt(mip, secondsAtPixel, secondsPerPixel);
+				float peakValue = std::max(peak.max, 0.0f) * maxBarWidth;
+				float rmsValue = std::max(peak.rms, 0.0f) * maxBarWidth;
 				float rectYPosition = floorf(position.y + visualOffset - y);
 
 				// WARNING: A thickness of 0.5 or less does not draw with integrated graphics (optimization? limitation?)
-				ImVec2 p1(timelineMidPosition - std::max(0.75f, barValue), rectYPosition);
-				ImVec2 p2(timelineMidPosition + std::max(0.75f, barValue), rectYPosition);
+				ImVec2 p1(timelineMidPosition - std::max(0.75f, peakValue), rectYPosition);
+				ImVec2 p2(timelineMidPosition + std::max(0.75f, peakValue), rectYPosition);
 				drawList->AddLine(p1, p2, waveformColor, 0.75f);
+
+				// The RMS always lies inside the peak, so it is drawn brighter over it to make the louder parts stand out
+				if (rmsValue > 0.75f)
+					drawList->AddLine(ImVec2(timelineMidPosition - rmsValue, rectYPosition), ImVec2(timelineMidPosition + rmsValue, rectYPosition), waveformRmsColor, 0.75f);
 			}
 		}
 	}
@@ -6,6 +6,8 @@
 #include "TimelineMode.h"
 #include "Background.h"
 #include "RenderDebugStats.h"
+#include "NoteStorageBenchmark.h"
+#include "NoteSoundSchedule.h"
 
 namespace MikuMikuWorld
 {
@@ -162,12 +164,15 @@ namespace MikuMikuWorld
 		} noteTransformOrigin;
 
 		std::map<int, std::pair<float, float>> eventControlCursor;
-		std::stack<EventControlDrawData> drawEvents;
+		std::vector<EventControlDrawData> drawEvents;
 		std::vector<StepDrawData> drawSteps;
-		std::unordered_set<std::string> playingNoteSounds;
+		std::vector<int> viewBoundary;
+		NoteSoundSchedule noteSounds;
+		size_t noteSoundCursor{};
 		static constexpr float audioLookAhead = 0.05f;
 
 		Debug::DebugRenderStats renderStats;
+		std::vector<Debug::NoteStorageBenchmarkResult> noteStorageBenchmarks;
 
 		void updateScrollbar();
 		void updateScrollingPosition();
@@ -175,9 +180,9 @@ namespace MikuMikuWorld
 		void drawWaveform(const ScoreContext& context);
 		void drawFeverLine(const Fever& fever);
 
-		void drawHoldCurve(const HoldNote& hold, const std::map<int, Note>& notes, Renderer* renderer, const Color& tint, const int offsetTick = 0, const int offsetLane = 0);
+		void drawHoldCurve(const HoldNote& hold, const SlotMap<Note>& notes, Renderer* renderer, const Color& tint, const int offsetTick = 0, const int offsetLane = 0);
 		void drawHoldCurvePart(const Note& n1, const Note& n2, EaseType ease, bool isGuide, Renderer* renderer, const Color& tint, const int offsetTick = 0, const int offsetLane = 0);
-		void drawHoldNote(const std::map<int, Note>& notes, const HoldNote& note, Renderer* renderer, const Color& tint, const int offsetTicks = 0, const int offsetLane = 0);
+		void drawHoldNote(const SlotMap<Note>& notes, const HoldNote& note, Renderer* renderer, const Color& tint, const int offsetTicks = 0, const int offsetLane = 0);
 		void drawHoldMid(Note& note, HoldStepType type, Renderer* renderer, const Color& tint);
 		void drawOutline(const StepDrawData& data);
 		void drawFlickArrow(const Note& note, Renderer* renderer, const Color& tint, const int offsetTick = 0, const int offsetLane = 0);
@@ -209,7 +214,7 @@ namespace MikuMikuWorld
 
 		void contextMenu(ScoreContext& context);
 
-		int getStopTick(const Score& score) const;
+		int getStopTick(const ScoreContext& context) const;
 		float getStopTime(const ScoreContext& context);
 
 	public:
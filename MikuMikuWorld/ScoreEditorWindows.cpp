@@ -564,7 +564,10 @@ namespace MikuMikuWorld
 				{
 					UI::beginPropertyColumns();
 					UI::addReadOnlyProperty("Music Initialized", boolToString(context.audio.isMusicInitialized()));
-					UI::addReadOnlyProperty("Music Filename", context.audio.musicBuffer.name);
+					UI::addReadOnlyProperty("Music Filename", context.audio.isMusicStreaming() ? context.audio.musicStream.getName() : context.audio.musicBuffer.name);
+					UI::addReadOnlyProperty("Music Streaming", boolToString(context.audio.isMusicStreaming()));
+					UI::addReadOnlyProperty("Music Mapped", boolToString(context.audio.isMusicMapped()));
+					UI::addReadOnlyProperty("Music Cache Key", context.audio.getMusicCacheKey().isValid() ? context.audio.getMusicCacheKey().toString() : "None");
 
 					float musicTime = context.audio.getMusicPosition(), musicLength = context.audio.getMusicLength();
 					int musicTimeSeconds = static_cast<int>(musicTime), musicLengthSeconds = static_cast<int>(musicLength);
@@ -573,9 +576,16 @@ namespace MikuMikuWorld
 						musicLengthSeconds, static_cast<int>((musicLength - musicLengthSeconds) * 100)
 					));
 
-					UI::addReadOnlyProperty("Sample Rate", context.audio.musicBuffer.sampleRate);
+					UI::addReadOnlyProperty("Sample Rate", context.audio.isMusicStreaming() ? context.audio.musicStream.getSampleRate() : context.audio.musicBuffer.sampleRate);
 					UI::addReadOnlyProperty("Effective Sample Rate", context.audio.musicBuffer.effectiveSampleRate);
-					UI::addReadOnlyProperty("Channel Count", context.audio.musicBuffer.channelCount);
+					UI::addReadOnlyProperty("Channel Count", context.audio.isMusicStreaming() ? context.audio.musicStream.getChannelCount() : context.audio.musicBuffer.channelCount);
+					UI::addReadOnlyProperty("Music Memory", IO::formatString("%.2f MB", context.audio.getMusicMemory() / (1024.0 * 1024.0)));
+					UI::addReadOnlyProperty("Music Peak Memory", IO::formatString("%.2f MB", context.audio.getMusicPeakMemory() / (1024.0 * 1024.0)));
+					if (context.audio.isMusicStreaming())
+					{
+						UI::addReadOnlyProperty("Buffered Frames", context.audio.musicStream.getBufferedFrames());
+						UI::addReadOnlyProperty("Underrun Frames", context.audio.musicStream.getUnderrunFrames());
+					}
 					UI::endPropertyColumns();
 				}
 
@@ -592,8 +602,7 @@ namespace MikuMikuWorld
 
 					if (ImGui::Button("Re-Generate Waveform", { -1, UI::btnSmall.y }))
 					{
-						context.waveformL.generateMipChainsFromSampleBuffer(context.audio.musicBuffer, 0);
-						context.waveformR.generateMipChainsFromSampleBuffer(context.audio.musicBuffer, 1);
+						context.generateWaveforms(true);
 					}
 				}
 
@@ -668,11 +677,57 @@ namespace MikuMikuWorld
 				timeline.debug(context);
 				ImGui::TreePop();
 			}
+
+			if (ImGui::TreeNodeEx("Preview", treeNodeFlags))
+			{
+				updateEffectsDebug(context);
+				ImGui::TreePop();
+			}
 		}
 
 		ImGui::End();
 	}
 
+	void DebugWindow::updateEffectsDebug(ScoreContext& context)
+	{
+		const Effect::EffectView& effectView = context.scorePreviewDrawData.effectView;
+		const float updateTime = effectView.getUpdateTime() * 1000;
+		effectUpdateTimes[effectUpdateTimeOffset] = updateTime;
+		effectUpdateTimeOffset = (effectUpdateTimeOffset + 1) % arrayLength(effectUpdateTimes);
+
+		if (!ImGui::CollapsingHeader("Effects", ImGuiTreeNodeFlags_DefaultOpen))
+			return;
+
+		float averageTime = 0, maxTime = 0;
+		for (float time : effectUpdateTimes)
+		{
+			averageTime += time;
+			maxTime = std::max(maxTime, time);
+		}
+		averageTime /= arrayLength(effectUpdateTimes);
+
+		UI::beginPropertyColumns();
+		UI::addSliderProperty("Update Threads", config.pvEffectsThreadCount, 0, std::thread::hardware_concurrency(), config.pvEffectsThreadCount ? "%d" : "Auto");
+		UI::addReadOnlyProperty("Active Threads", effectView.getUpdateThreadCount());
+		UI::addReadOnlyProperty("Updated Effects", effectView.getUpdatedEffectCount());
+		UI::addReadOnlyProperty("Update Time", IO::formatString("%.3fms (avg %.3fms, max %.3fms)", updateTime, averageTime, maxTime));
+		UI::endPropertyColumns();
+
+		ImGui::PlotLines("##effect_update_times", effectUpdateTimes, arrayLength(effectUpdateTimes),
+			effectUpdateTimeOffset, NULL, 0, FLT_MAX, { -1, 60 });
+
+		const Effect::EffectBaker& baker = effectView.getBaker();
+		const float megabyte = 1024 * 1024;
+		UI::beginPropertyColumns();
+		UI::addCheckboxProperty("Bake Effects", config.pvBakeEffects);
+		UI::addSliderProperty("Bake Memory", config.pvEffectsBakeMemory, 16, 1024, "%d MB");
+		UI::addReadOnlyProperty("Baked Notes", static_cast<int>(baker.getBakedCount()));
+		UI::addReadOnlyProperty("Pending Notes", static_cast<int>(baker.getPendingCount()));
+		UI::addReadOnlyProperty("Baked Memory", IO::formatString("%.1f/%.1f MB%s",
+			baker.getMemoryUsed() / megabyte, baker.getMemoryLimit() / megabyte, baker.isMemoryFull() ? " (full)" : ""));
+		UI::endPropertyColumns();
+	}
+
 	void SettingsWindow::updateKeyConfig(MultiInputBinding* bindings[], int count)
 	{
 		ImVec2 size = ImVec2(-1, ImGui::GetContentRegionAvail().y * 0.7);
@@ -910,6 +965,13 @@ namespace MikuMikuWorld
 						UI::endPropertyColumns();
 					}
 
+					if (ImGui::CollapsingHeader(getString("history"), ImGuiTreeNodeFlags_DefaultOpen))
+					{
+						UI::beginPropertyColumns();
+						UI::addIntProperty(getString("history_memory_budget"), config.historyMemoryBudget);
+						UI::endPropertyColumns();
+					}
+
 					if (ImGui::CollapsingHeader(getString("theme"), ImGuiTreeNodeFlags_DefaultOpen))
 					{
 						UI::beginPropertyColumns();
@@ -1024,7 +1086,14 @@ namespace MikuMikuWorld
 					{
 						UI::beginPropertyColumns();
 						UI::addSelectProperty(getString("notes_se"), config.seProfileIndex, Audio::soundEffectsProfileNames, Audio::soundEffectsProfileCount);
+						UI::addCheckboxProperty(getString("stream_music"), config.streamMusic);
+						UI::addCheckboxProperty(getString("cache_music"), config.cacheMusic);
+						UI::addCheckboxProperty(getString("cache_decoded_music"), config.cacheDecodedMusic);
+						UI::addIntProperty(getString("music_cache_size"), config.musicCacheSize, 0, 65536);
 						UI::endPropertyColumns();
+
+						if (ImGui::Button(getString("clear_music_cache"), { -1, UI::btnSmall.y }))
+							isClearMusicCachePending = true;
 					}
 
 					if (ImGui::CollapsingHeader(getString("background"), ImGuiTreeNodeFlags_DefaultOpen))
@@ -1152,6 +1221,7 @@ namespace MikuMikuWorld
 						UI::addCheckboxProperty(getString("flicks_animation"), config.pvFlickAnimation);
 						UI::addCheckboxProperty(getString("holds_animation"), config.pvHoldAnimation);
 						UI::addCheckboxProperty(getString("simultaneous_lines"), config.pvSimultaneousLine);
+						UI::addCheckboxProperty(getString("bake_effects"), config.pvBakeEffects);
 						ImGui::Separator();
 
 						float hold_alpha = config.pvHoldAlpha * 100.f;
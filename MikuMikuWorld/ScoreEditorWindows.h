@@ -62,6 +62,13 @@ namespace MikuMikuWorld
 
 	class DebugWindow
 	{
+	private:
+		// Effect update times of the most recent frames in milliseconds
+		float effectUpdateTimes[120]{};
+		int effectUpdateTimeOffset{};
+
+		void updateEffectsDebug(ScoreContext& context);
+
 	public:
 		void update(ScoreContext& context, ScoreEditorTimeline& timeline);
 	};
@@ -83,6 +90,7 @@ namespace MikuMikuWorld
 		bool open = false;
 		bool isBackgroundChangePending = false;
 		bool isEffectProfileChangePending = false;
+		bool isClearMusicCachePending = false;
 		DialogResult update();
 	};
 
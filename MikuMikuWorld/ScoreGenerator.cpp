@@ -0,0 +1,171 @@
+#include "ScoreGenerator.h"
+#include "Constants.h"
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+
+namespace MikuMikuWorld
+{
+	// The standard distributions are implementation defined, so map the engine's output ourselves
+	// to get the same scores from every standard library
+	class GeneratorRandom
+	{
+	private:
+		std::mt19937 engine;
+
+	public:
+		GeneratorRandom(unsigned int seed) : engine{ seed } {}
+
+		int range(int min, int max)
+		{
+			return min + static_cast<int>(engine() % static_cast<unsigned int>(max - min + 1));
+		}
+
+		bool chance(float ratio)
+		{
+			return engine() < ratio * static_cast<float>(std::mt19937::max());
+		}
+	};
+
+	static constexpr int generatorSnap = TICKS_PER_BEAT / 4;
+
+	struct GeneratorState
+	{
+		const ScoreGeneratorOptions& options;
+		GeneratorRandom random;
+
+		// Lanes taken by the notes at each tick so no notes overlap
+		std::unordered_map<int, uint16_t> occupiedLanes;
+	};
+
+	static Note createNote(NoteType type, int tick, int lane, int width)
+	{
+		Note note(type, tick, lane, width);
+		note.ID = nextID++;
+		return note;
+	}
+
+	static Note createNote(NoteType type, int tick, GeneratorState& state)
+	{
+		for (;; tick += generatorSnap)
+		{
+			uint16_t& occupied = state.occupiedLanes[tick];
+			for (int attempt = 0; attempt < 4; ++attempt)
+			{
+				int width = state.random.range(MIN_NOTE_WIDTH, 6);
+				int lane = state.random.range(MIN_LANE, MAX_LANE - width + 1);
+				uint16_t lanes = ((1 << width) - 1) << lane;
+				if (!(occupied & lanes))
+				{
+					occupied |= lanes;
+					return createNote(type, tick, lane, width);
+				}
+			}
+
+			// Hold steps have to stay between their neighbours, so take any free lane instead of moving to the next tick
+			// and only overlap other notes when the whole tick is taken
+			if (type == NoteType::HoldMid)
+			{
+				for (int lane = MIN_LANE; lane <= MAX_LANE; ++lane)
+				{
+					if (!(occupied & (1 << lane)))
+					{
+						occupied |= 1 << lane;
+						return createNote(type, tick, lane, 1);
+					}
+				}
+
+				return createNote(type, tick, state.random.range(MIN_LANE, MAX_LANE), 1);
+			}
+		}
+	}
+
+	static void addHold(Score& score, int startTick, int stepCount, HoldNoteType holdType, GeneratorState& state)
+	{
+		const bool guide = holdType == HoldNoteType::Guide;
+		const int stepTicks = state.random.range(1, 4) * generatorSnap;
+
+		Note start = createNote(NoteType::Hold, startTick, state);
+		start.critical = state.random.chance(state.options.criticalRatio);
+
+		HoldNote hold{ { start.ID, HoldStepType::Normal, static_cast<EaseType>(state.random.range(0, 2)) }, {}, -1, holdType, holdType };
+		hold.steps.reserve(stepCount);
+		for (int i = 0; i < stepCount; ++i)
+		{
+			Note step = createNote(NoteType::HoldMid, start.tick + (i + 1) * stepTicks, state);
+			step.critical = start.critical;
+			step.parentID = start.ID;
+			score.notes[step.ID] = step;
+
+			const EaseType ease = static_cast<EaseType>(i % static_cast<int>(EaseType::EaseTypeCount));
+			const HoldStepType type = guide ? HoldStepType::Hidden : static_cast<HoldStepType>(state.random.range(0, 2));
+			hold.steps.push_back({ step.ID, type, ease });
+		}
+
+		Note end = createNote(NoteType::HoldEnd, start.tick + (stepCount + 1) * stepTicks, state);
+		end.critical = start.critical;
+		end.parentID = start.ID;
+		if (!guide && state.random.chance(state.options.flickRatio))
+			end.flick = static_cast<FlickType>(state.random.range(1, 3));
+
+		hold.end = end.ID;
+		score.notes[start.ID] = start;
+		score.notes[end.ID] = end;
+		score.holdNotes[start.ID] = std::move(hold);
+	}
+
+	Score generateScore(const ScoreGeneratorOptions& options)
+	{
+		GeneratorState state{ options, GeneratorRandom(options.seed) };
+		GeneratorRandom& random = state.random;
+		Score score;
+		score.metadata.title = "Generated score";
+		score.metadata.author = "MikuMikuWorld";
+
+		const int entryCount = options.tapCount + options.holdCount + options.guideCount;
+		const int measureCount = std::max(1, (entryCount + options.notesPerMeasure - 1) / std::max(options.notesPerMeasure, 1));
+		const int snapCount = measureCount * TICKS_PER_BEAT * 4 / generatorSnap;
+
+		score.notes.reserve(options.tapCount + (options.holdCount + options.guideCount) * (options.stepsPerEase * 3 + 2));
+		score.holdNotes.reserve(options.holdCount + options.guideCount);
+
+		for (int i = 0; i < options.tapCount; ++i)
+		{
+			Note note = createNote(NoteType::Tap, random.range(0, snapCount - 1) * generatorSnap, state);
+			note.critical = random.chance(options.criticalRatio);
+			note.friction = random.chance(options.traceRatio);
+			if (random.chance(options.flickRatio))
+				note.flick = static_cast<FlickType>(random.range(1, 3));
+
+			score.notes[note.ID] = note;
+		}
+
+		const int stepCount = options.stepsPerEase * static_cast<int>(EaseType::EaseTypeCount);
+		for (int i = 0; i < options.holdCount; ++i)
+			addHold(score, random.range(0, snapCount - 1) * generatorSnap, stepCount, HoldNoteType::Normal, state);
+
+		for (int i = 0; i < options.guideCount; ++i)
+			addHold(score, random.range(0, snapCount - 1) * generatorSnap, stepCount, HoldNoteType::Guide, state);
+
+		// Spread the events evenly so every part of the score is affected by them
+		const int lengthTicks = snapCount * generatorSnap;
+		score.tempoChanges.clear();
+		score.tempoChanges.emplace_back(0, static_cast<float>(random.range(60, 240)));
+		for (int i = 1; i <= options.tempoChangeCount; ++i)
+			score.tempoChanges.emplace_back(lengthTicks / (options.tempoChangeCount + 1) * i / generatorSnap * generatorSnap,
+				static_cast<float>(random.range(60, 240)));
+
+		for (int i = 0; i < options.hiSpeedChangeCount; ++i)
+			score.hiSpeedChanges.push_back({ lengthTicks / options.hiSpeedChangeCount * i / generatorSnap * generatorSnap,
+				random.range(1, 8) * 0.25f });
+
+		for (int i = 1; i <= options.timeSignatureChangeCount; ++i)
+		{
+			const int measure = measureCount * i / (options.timeSignatureChangeCount + 1);
+			if (measure > 0)
+				score.timeSignatures[measure] = { measure, random.range(2, 7), random.chance(0.5f) ? 4 : 8 };
+		}
+
+		return score;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Score.h"
+
+namespace MikuMikuWorld
+{
+	struct ScoreGeneratorOptions
+	{
+		unsigned int seed{};
+
+		// Single notes. Flicks and traces are taken from the tap count.
+		int tapCount{ 1000 };
+		float flickRatio{ 0.2f };
+		float traceRatio{ 0.1f };
+		float criticalRatio{ 0.1f };
+
+		// Every hold gets this many steps of each ease type
+		int holdCount{ 100 };
+		int stepsPerEase{ 1 };
+		int guideCount{ 20 };
+
+		// Number of notes and holds placed in a measure on average, which decides the length of the score
+		int notesPerMeasure{ 16 };
+
+		int tempoChangeCount{ 0 };
+		int hiSpeedChangeCount{ 0 };
+		int timeSignatureChangeCount{ 0 };
+	};
+
+	/// <summary>
+	/// Builds a valid score with the requested amount of notes and events.
+	/// The same options always produce the same score, on every platform.
+	/// </summary>
+	Score generateScore(const ScoreGeneratorOptions& options);
+}
@@ -288,7 +288,7 @@ namespace MikuMikuWorld
 			// SFX and music updates are handled in the timeline
 			return;
 		if (context.scorePreviewDrawData.noteSpeed != config.pvNoteSpeed)
-			context.scorePreviewDrawData.calculateDrawData(context.score);
+			context.scorePreviewDrawData.calculateDrawData(context.score, context.tempoMap);
 		ImVec2 size = ImGui::GetContentRegionAvail() - ImVec2{ this->getScrollbarWidth(), 0 }; // Reserve space for the scrollbar
 		ImVec2 position = ImGui::GetCursorScreenPos();
 		ImRect boundaries = ImRect(position, position + size);
@@ -446,6 +446,7 @@ namespace MikuMikuWorld
 		size_t effectCount = arrayLength(Effect::effectNames);
 
 		// Cleanup. We don't want all profiles and their resources loaded in memory
+		effectView.clearBakedEffects();
 		ResourceManager::removeAllParticleEffects();
 		int texIndex = ResourceManager::getTextureByFilename(oldEffectsDir + "tex_note_common_all_v2.png");
 		if (texIndex > -1)
@@ -577,12 +578,14 @@ namespace MikuMikuWorld
 
 	void ScorePreviewWindow::drawNotes(const ScoreContext& context, Renderer *renderer)
 	{
-		double current_tm = accumulateDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges);
-		double scaled_tm = accumulateScaledDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
+		double current_tm = context.tempoMap.ticksToSeconds(context.currentTick);
+		double scaled_tm = context.tempoMap.ticksToScaledSeconds(context.currentTick);
 		const auto& drawData = context.scorePreviewDrawData;
-	
-		for (auto& note : drawData.drawingNotes)
+		const auto [first, last] = notesCursor.seek(drawData.notesTimeline, scaled_tm, drawData.generation);
+
+		for (size_t i = first; i < last; ++i)
 		{
+			const auto& note = drawData.drawingNotes[i];
 			if (scaled_tm < note.visualTime.min || scaled_tm > note.visualTime.max)
 				continue;
 			const Note& noteData = context.score.notes.at(note.refID);
@@ -603,8 +606,9 @@ namespace MikuMikuWorld
 
 		if (noteSkins.getItemIndex(NoteSkinItem::Notes) == -1)
 			return;
-		double scaled_tm = accumulateScaledDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
-		const auto& drawData = context.scorePreviewDrawData.drawingLines;
+		double scaled_tm = context.tempoMap.ticksToScaledSeconds(context.currentTick);
+		const auto& drawData = context.scorePreviewDrawData;
+		const auto [first, last] = linesCursor.seek(drawData.linesTimeline, scaled_tm, drawData.generation);
 
 		const Texture& texture = getNoteTexture();
 		size_t sprIndex = SPR_SIMULTANEOUS_CONNECTION;
@@ -617,8 +621,9 @@ namespace MikuMikuWorld
 		const SpriteTransform& lineTransform = ResourceManager::spriteTransforms[transIndex];
 		const float noteTop = 1. + Engine::getNoteHeight(), noteBottom = 1. - Engine::getNoteHeight();
 
-		for (auto& line : drawData)
+		for (size_t i = first; i < last; ++i)
 		{
+			const auto& line = drawData.drawingLines[i];
 			if (scaled_tm < line.visualTime.min || scaled_tm > line.visualTime.max)
 				continue;
 			float noteLeft = line.xPos.min, noteRight = line.xPos.max;
@@ -635,14 +640,17 @@ namespace MikuMikuWorld
 	{
 		if (noteSkins.getItemIndex(NoteSkinItem::Notes) == -1)
 			return;
-		double scaled_tm = accumulateScaledDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
+		double scaled_tm = context.tempoMap.ticksToScaledSeconds(context.currentTick);
 		const float notesHeight = Engine::getNoteHeight() * 1.3f;
 		const float w = notesHeight / scaledAspectRatio;
 		const float noteTop = 1. + notesHeight, noteBottom = 1. - notesHeight;
 		const Texture& texture = getNoteTexture();
+		const auto& drawData = context.scorePreviewDrawData;
+		const auto [first, last] = holdTicksCursor.seek(drawData.holdTicksTimeline, scaled_tm, drawData.generation);
 
-		for (auto& tick : context.scorePreviewDrawData.drawingHoldTicks)
+		for (size_t i = first; i < last; ++i)
 		{
+			const auto& tick = drawData.drawingHoldTicks[i];
 			if (scaled_tm < tick.visualTime.min || scaled_tm > tick.visualTime.max)
 				continue;
 			int sprIndex = getNoteSpriteIndex(context.score.notes.at(tick.refID));
@@ -668,16 +676,23 @@ namespace MikuMikuWorld
 
 	void ScorePreviewWindow::drawHoldCurves(const ScoreContext& context, Renderer* renderer)
 	{
-		const float total_tm = accumulateDuration(context.scorePreviewDrawData.maxTicks, TICKS_PER_BEAT, context.score.tempoChanges);
-		const double current_tm = accumulateDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges);
-		const double current_stm = accumulateScaledDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
+		const float total_tm = context.tempoMap.ticksToSeconds(context.scorePreviewDrawData.maxTicks);
+		const double current_tm = context.tempoMap.ticksToSeconds(context.currentTick);
+		const double current_stm = context.tempoMap.ticksToScaledSeconds(context.currentTick);
 		const float noteDuration = Engine::getNoteDuration(config.pvNoteSpeed);
 		const double visible_stm = current_stm + noteDuration;
 		const float mirror = config.pvMirrorScore ? -1 : 1;
 		const auto& drawData = context.scorePreviewDrawData;
 
-		for (auto& segment : drawData.drawingHoldSegments)
+		// Segments before split have started and are drawn until they end.
+		// The ones after it are only drawn once their head comes into view.
+		const auto [first, split] = holdSegmentsCursor.seek(drawData.holdSegmentsTimeline, current_tm, drawData.generation);
+		for (size_t segmentIndex = first; segmentIndex < drawData.drawingHoldSegments.size(); ++segmentIndex)
 		{
+			if (segmentIndex >= split && drawData.holdSegmentsMinHeadTimes[segmentIndex] > visible_stm)
+				break;
+
+			const auto& segment = drawData.drawingHoldSegments[segmentIndex];
 			if ((std::min(segment.headTime, segment.tailTime) > visible_stm && segment.startTime > current_tm) || current_tm >= segment.endTime)
 				continue;
 
@@ -744,8 +759,8 @@ namespace MikuMikuWorld
 				double headProgress = segment.tailStepIndex / totalJoints;
 				double tailProgress = (segment.tailStepIndex + 1) / totalJoints;
 
-				double holdStart_stm = accumulateScaledDuration(holdStart.tick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
-				double holdEnd_stm = accumulateScaledDuration(holdEnd.tick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
+				double holdStart_stm = context.tempoMap.ticksToScaledSeconds(holdStart.tick);
+				double holdEnd_stm = context.tempoMap.ticksToScaledSeconds(holdEnd.tick);
 				
 				if (!isSegmentActivated)
 				{
@@ -1045,11 +1060,11 @@ namespace MikuMikuWorld
 
 		ImGui::SeparatorEx(ImGuiSeparatorFlags_Horizontal);
 
-		float currentTm = accumulateDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges);
-		double currentScaledTm = accumulateScaledDuration(context.currentTick, TICKS_PER_BEAT, context.score.tempoChanges, context.score.hiSpeedChanges);
-		int currentMeasure = accumulateMeasures(context.currentTick, TICKS_PER_BEAT, context.score.timeSignatures);
-		const TimeSignature& ts = context.score.timeSignatures[findTimeSignature(currentMeasure, context.score.timeSignatures)];
-		const Tempo& tempo = getTempoAt(context.currentTick, context.score.tempoChanges);
+		float currentTm = context.tempoMap.ticksToSeconds(context.currentTick);
+		double currentScaledTm = context.tempoMap.ticksToScaledSeconds(context.currentTick);
+		int currentMeasure = context.measureIndex.ticksToMeasure(context.currentTick);
+		const TimeSignature& ts = context.score.timeSignatures[context.measureIndex.findSignatureMeasure(currentMeasure)];
+		const Tempo& tempo = context.tempoMap.getTempoAt(context.currentTick);
 		int hiSpeedIdx = findHighSpeedChange(context.currentTick, context.score.hiSpeedChanges);
 		float speed = (hiSpeedIdx == -1 ? 1.0f : context.score.hiSpeedChanges[hiSpeedIdx].speed);
 
@@ -1098,7 +1113,7 @@ namespace MikuMikuWorld
 		ImVec2 scrollContentSize = ImGui::GetContentRegionAvail();
 		ImVec2 scrollMaxSize = ImGui::GetWindowContentRegionMax();
 		int maxTicks = std::max(context.scorePreviewDrawData.maxTicks, 1);
-		float scrollRatio = std::min(Engine::getNoteDuration(config.pvNoteSpeed) / accumulateDuration(context.scorePreviewDrawData.maxTicks, TICKS_PER_BEAT, context.score.tempoChanges), 1.f);
+		float scrollRatio = std::min(Engine::getNoteDuration(config.pvNoteSpeed) / static_cast<float>(context.tempoMap.ticksToSeconds(context.scorePreviewDrawData.maxTicks)), 1.f);
 		float progress = 1.f - std::min(float(context.currentTick) / maxTicks, 1.f);
 		float handleHeight = std::max(20.f, scrollContentSize.y * scrollRatio);
 		
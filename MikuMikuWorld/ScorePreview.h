@@ -53,6 +53,12 @@ namespace MikuMikuWorld
 
 		mutable bool fullWindow{};
 
+		// The entries drawn in the last frame, so the next frame starts searching from them
+		Engine::DrawingTimelineCursor notesCursor;
+		Engine::DrawingTimelineCursor linesCursor;
+		Engine::DrawingTimelineCursor holdTicksCursor;
+		Engine::DrawingTimelineCursor holdSegmentsCursor;
+
 		const Texture& getNoteTexture();
 
 		void drawNoteBase(Renderer* renderer, const Note& note, float left, float right, float y, float zScalar = 1);
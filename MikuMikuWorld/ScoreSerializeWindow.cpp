@@ -63,7 +63,7 @@ namespace MikuMikuWorld
 			serializer = std::make_unique<NativeScoreSerializer>();
 			break;
 		case SerializeFormat::SusFormat:
-			serializer = std::make_unique<SusSerializer>();
+			serializer = std::make_unique<SusSerializer>("This file was generated by " APP_NAME " " + Application::getAppVersion());
 			break;
 		case SerializeFormat::LvlDataFormat:
 			serializer = std::make_unique<SonolusSerializer>(std::make_unique<PySekaiEngine>(), IO::endsWith(filename, GZ_JSON_EXTENSION));
@@ -216,6 +216,11 @@ namespace MikuMikuWorld
 	{
 		if (deserializer && !filename.empty())
 		{
+			// The loaded score replaces the current one, so its IDs can start over. The notes are indexed by
+			// their IDs, so this keeps the score and its copies as small as its notes rather than the whole session.
+			const int previousNextID = nextID;
+			resetNextID();
+
 			try
 			{
 				score = deserializer->deserialize(filename);
@@ -229,6 +234,8 @@ namespace MikuMikuWorld
 			}
 			catch (std::exception& error)
 			{
+				// The current score stays open
+				nextID = previousNextID;
 				errorMessage = IO::formatString(
 					"%s\n"
 				    "%s: %s\n"
@@ -352,8 +359,10 @@ namespace MikuMikuWorld
 			editor.asyncLoadMusic(context.workingData.musicFilename);
 			context.audio.setMusicOffset(0, context.workingData.musicOffset);
 
+			context.updateTempoMap();
+			context.updateMeasureIndex();
 			context.scoreStats.calculateStats(context.score);
-			context.scorePreviewDrawData.calculateDrawData(context.score);
+			context.scorePreviewDrawData.calculateDrawData(context.score, context.tempoMap);
 			timeline.calculateMaxOffsetFromScore(context.score);
 
 			UI::setWindowTitle((context.workingData.filename.size() ? IO::File::getFilename(context.workingData.filename) : windowUntitled));
@@ -361,6 +370,7 @@ namespace MikuMikuWorld
 			if (!controller->getFilename().empty())
 				editor.updateRecentFilesList(controller->getFilename());
 
+			editor.openJournal();
 			controller.reset();
 			break;
 		default:
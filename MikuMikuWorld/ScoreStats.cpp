@@ -2,9 +2,21 @@
 #include "Score.h"
 #include "Constants.h"
 #include <algorithm>
+#include <cassert>
+#include <unordered_set>
 
 namespace MikuMikuWorld
 {
+	enum NoteCategory : uint8_t
+	{
+		NOTE_COUNTED = 1 << 0,
+		NOTE_TAP = 1 << 1,
+		NOTE_FLICK = 1 << 2,
+		NOTE_HOLD = 1 << 3,
+		NOTE_STEP = 1 << 4,
+		NOTE_TRACE = 1 << 5
+	};
+
 	ScoreStats::ScoreStats()
 	{
 		reset();
@@ -19,78 +31,177 @@ namespace MikuMikuWorld
 	void ScoreStats::resetCounts()
 	{
 		taps = flicks = holds = steps = traces = total = 0;
+		noteCategories.clear();
 	}
 
 	void ScoreStats::resetCombo()
 	{
-		combo = 0;
+		combo = holdComboTotal = 0;
+		holdCombo.clear();
 	}
 
-	void ScoreStats::calculateStats(const Score& score)
+	uint8_t ScoreStats::getNoteCategories(const Note& note)
 	{
-		taps = std::count_if(score.notes.begin(), score.notes.end(), [](const auto& n)
-		{
-			const Note& note = n.second;
-			return note.getType() == NoteType::Tap && !note.isFlick() && !note.friction;
-		});
+		uint8_t categories = NOTE_COUNTED;
+		if (note.getType() == NoteType::Tap && !note.isFlick() && !note.friction) categories |= NOTE_TAP;
+		if (note.getType() == NoteType::Hold) categories |= NOTE_HOLD;
+		if (note.getType() == NoteType::HoldMid) categories |= NOTE_STEP;
+		if (note.isFlick()) categories |= NOTE_FLICK;
+		if (note.friction) categories |= NOTE_TRACE;
+		return categories;
+	}
+
+	void ScoreStats::countNote(const Note& note)
+	{
+		if (note.ID < 0)
+			return;
 
-		holds = std::count_if(score.notes.begin(), score.notes.end(),
-			[](const auto& n) { return n.second.getType() == NoteType::Hold; });
+		if (noteCategories.size() <= static_cast<size_t>(note.ID))
+			noteCategories.resize(note.ID + 1);
 
-		steps = std::count_if(score.notes.begin(), score.notes.end(),
-			[](const auto& n) { return n.second.getType() == NoteType::HoldMid; });
+		const uint8_t categories = getNoteCategories(note);
+		noteCategories[note.ID] = categories;
 
-		flicks = std::count_if(score.notes.begin(), score.notes.end(),
-			[](const auto& n) { return n.second.isFlick(); });
+		taps += (categories & NOTE_TAP) != 0;
+		flicks += (categories & NOTE_FLICK) != 0;
+		holds += (categories & NOTE_HOLD) != 0;
+		steps += (categories & NOTE_STEP) != 0;
+		traces += (categories & NOTE_TRACE) != 0;
+		total++;
+	}
 
-		traces = std::count_if(score.notes.begin(), score.notes.end(),
-			[](const auto& n) { return n.second.friction; });
+	void ScoreStats::uncountNote(int id)
+	{
+		if (id < 0 || static_cast<size_t>(id) >= noteCategories.size() || !noteCategories[id])
+			return;
+
+		const uint8_t categories = noteCategories[id];
+		noteCategories[id] = 0;
+
+		taps -= (categories & NOTE_TAP) != 0;
+		flicks -= (categories & NOTE_FLICK) != 0;
+		holds -= (categories & NOTE_HOLD) != 0;
+		steps -= (categories & NOTE_STEP) != 0;
+		traces -= (categories & NOTE_TRACE) != 0;
+		total--;
+	}
+
+	void ScoreStats::calculateStats(const Score& score)
+	{
+		resetCounts();
+		for (const auto& [id, note] : score.notes)
+			countNote(note);
 
-		total = score.notes.size();
 		calculateCombo(score);
 	}
 
-	void ScoreStats::calculateCombo(const Score& score)
+	void ScoreStats::updateStats(const Score& score, const ScoreChangeSet& changes)
 	{
-		resetCombo();
-		combo = score.notes.size();
+		for (int id : changes.removedNotes)
+			uncountNote(id);
 
-		constexpr int halfBeat = TICKS_PER_BEAT / 2;
-		for (const auto& [id, hold] : score.holdNotes)
+		// Holds whose combo may have changed: the holds themselves, and the holds of any edited hold note
+		std::unordered_set<int> changedHolds;
+		changedHolds.insert(changes.removedHolds.begin(), changes.removedHolds.end());
+		changedHolds.insert(changes.addedHolds.begin(), changes.addedHolds.end());
+		changedHolds.insert(changes.modifiedHolds.begin(), changes.modifiedHolds.end());
+
+		for (const std::vector<int>* ids : { &changes.modifiedNotes, &changes.addedNotes })
 		{
-			if (hold.isGuide())
+			for (int id : *ids)
 			{
-				// Guide holds are not included
-				combo -= 2 + hold.steps.size();
-				continue;
+				uncountNote(id);
+				const Note& note = score.notes.at(id);
+				countNote(note);
+
+				if (note.getType() == NoteType::Hold)
+					changedHolds.insert(id);
+				else if (note.getType() == NoteType::HoldMid || note.getType() == NoteType::HoldEnd)
+					changedHolds.insert(note.parentID);
 			}
+		}
+
+		for (int id : changedHolds)
+			updateHoldCombo(score, id);
+
+		combo = total + holdComboTotal;
+
+#ifdef _DEBUG
+		// Validate against a full recount
+		ScoreStats expected;
+		expected.calculateStats(score);
+		assert(taps == expected.taps && flicks == expected.flicks && holds == expected.holds && steps == expected.steps
+			&& traces == expected.traces && total == expected.total && combo == expected.combo);
+#endif
+	}
+
+	void ScoreStats::updateHoldCombo(const Score& score, int id)
+	{
+		auto cached = holdCombo.find(id);
+		if (cached != holdCombo.end())
+		{
+			holdComboTotal -= cached->second;
+			holdCombo.erase(cached);
+		}
+
+		auto hold = score.holdNotes.find(id);
+		if (hold == score.holdNotes.end())
+			return;
 
-			// Hidden hold starts and ends do not count towards combo
-			if (hold.startType != HoldNoteType::Normal)
-				combo--;
-			
-			if (hold.endType != HoldNoteType::Normal)
-				combo--;
+		const int holdComboCount = calculateHoldCombo(score, hold->second);
+		holdCombo[id] = holdComboCount;
+		holdComboTotal += holdComboCount;
+	}
+
+	int ScoreStats::calculateHoldCombo(const Score& score, const HoldNote& hold)
+	{
+		constexpr int halfBeat = TICKS_PER_BEAT / 2;
+		if (hold.isGuide())
+		{
+			// Guide holds are not included
+			return -(2 + static_cast<int>(hold.steps.size()));
+		}
 
-			combo -= std::count_if(hold.steps.begin(), hold.steps.end(),
-				[](const HoldStep& step) { return step.type == HoldStepType::Hidden; });
+		int holdComboCount = 0;
 
-			int startTick = score.notes.at(id).tick;
-			int endTick = score.notes.at(hold.end).tick;
-			int eigthTick = startTick;
+		// Hidden hold starts and ends do not count towards combo
+		if (hold.startType != HoldNoteType::Normal)
+			holdComboCount--;
 
-			eigthTick += halfBeat;
-			if (eigthTick % halfBeat)
-				eigthTick -= (eigthTick % halfBeat);
+		if (hold.endType != HoldNoteType::Normal)
+			holdComboCount--;
 
-			// hold <= 1/8th long
-			if (eigthTick == startTick || eigthTick == endTick)
-				continue;
+		holdComboCount -= std::count_if(hold.steps.begin(), hold.steps.end(),
+			[](const HoldStep& step) { return step.type == HoldStepType::Hidden; });
 
-			if (endTick % halfBeat)
-				endTick += halfBeat - (endTick % halfBeat);
+		int startTick = score.notes.at(hold.start.ID).tick;
+		int endTick = score.notes.at(hold.end).tick;
+		int eigthTick = startTick;
 
-			combo += (endTick - eigthTick) / halfBeat;
+		eigthTick += halfBeat;
+		if (eigthTick % halfBeat)
+			eigthTick -= (eigthTick % halfBeat);
+
+		// hold <= 1/8th long
+		if (eigthTick == startTick || eigthTick == endTick)
+			return holdComboCount;
+
+		if (endTick % halfBeat)
+			endTick += halfBeat - (endTick % halfBeat);
+
+		return holdComboCount + (endTick - eigthTick) / halfBeat;
+	}
+
+	void ScoreStats::calculateCombo(const Score& score)
+	{
+		resetCombo();
+		for (const auto& [id, hold] : score.holdNotes)
+		{
+			const int holdComboCount = calculateHoldCombo(score, hold);
+			holdCombo[id] = holdComboCount;
+			holdComboTotal += holdComboCount;
 		}
+
+		combo = static_cast<int>(score.notes.size()) + holdComboTotal;
 	}
 }
@@ -1,21 +1,48 @@
 #pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 namespace MikuMikuWorld
 {
 	struct Score;
+	struct ScoreChangeSet;
+	class HoldNote;
+	class Note;
 
 	class ScoreStats
 	{
 	private:
 		int taps, flicks, holds, steps, traces, total, combo;
 
+		// The categories each note was counted in and the combo each hold adds on top of its notes,
+		// so an edit only has to recount the notes and holds it changed
+		std::vector<uint8_t> noteCategories;
+		std::unordered_map<int, int> holdCombo;
+		int holdComboTotal;
+
 		void resetCounts();
 		void resetCombo();
 
+		static uint8_t getNoteCategories(const Note& note);
+		static int calculateHoldCombo(const Score& score, const HoldNote& hold);
+		void countNote(const Note& note);
+		void uncountNote(int id);
+		void updateHoldCombo(const Score& score, int id);
+
 	public:
 		ScoreStats();
 
+		/// <summary>
+		/// Recounts every note and hold of the score
+		/// </summary>
 		void calculateStats(const Score& score);
+
+		/// <summary>
+		/// Recounts only the notes and holds changed by an edit. The stats must be up to date with the score before the edit.
+		/// </summary>
+		void updateStats(const Score& score, const ScoreChangeSet& changes);
+
 		void calculateCombo(const Score& score);
 		void reset();
 
@@ -27,4 +54,4 @@ namespace MikuMikuWorld
 		int getTotal() const { return total; }
 		int getCombo() const { return combo; }
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// <summary>
+	/// Map from non-negative IDs to values stored contiguously in a dense slot array.
+	/// Exposes the subset of the std::map interface used by the score, but iterates in slot order instead of ID order.
+	/// Erasing moves the last slot into the freed one, so iterators and references are invalidated by insertions and erasures.
+	/// </summary>
+	template <typename T>
+	class SlotMap
+	{
+	public:
+		using value_type = std::pair<int, T>;
+		using iterator = typename std::vector<value_type>::iterator;
+		using const_iterator = typename std::vector<value_type>::const_iterator;
+		using reverse_iterator = typename std::vector<value_type>::reverse_iterator;
+		using const_reverse_iterator = typename std::vector<value_type>::const_reverse_iterator;
+
+	private:
+		static constexpr int npos = -1;
+
+		std::vector<value_type> slots;
+
+		// Slot of every ID, indexed by the ID itself. IDs are handed out sequentially and restart
+		// whenever a score is created or loaded, so this stays about as large as the score.
+		std::vector<int> slotIndices;
+
+		mutable std::vector<int> tickOrder;
+
+		// The tick of every slot when the order was last sorted. Values are changed in place through the
+		// non-const accessors, so the order is only sorted again when one of these no longer matches.
+		mutable std::vector<int> sortedTicks;
+		mutable bool tickOrderDirty{ true };
+
+		inline int getSlot(int id) const
+		{
+			return id >= 0 && static_cast<size_t>(id) < slotIndices.size() ? slotIndices[id] : npos;
+		}
+
+		inline iterator slotIterator(int slot)
+		{
+			return slot == npos ? slots.end() : slots.begin() + slot;
+		}
+
+		inline iterator invalidateOrder(int slot)
+		{
+			tickOrderDirty = true;
+			return slotIterator(slot);
+		}
+
+		bool ticksChanged() const
+		{
+			for (size_t i = 0; i < slots.size(); ++i)
+				if (slots[i].second.tick != sortedTicks[i])
+					return true;
+
+			return false;
+		}
+
+		iterator insertSlot(int id, T value)
+		{
+			if (id < 0)
+				throw std::out_of_range("SlotMap IDs must be non-negative");
+
+			if (static_cast<size_t>(id) >= slotIndices.size())
+				slotIndices.resize(std::max(static_cast<size_t>(id) + 1, slotIndices.size() * 2), npos);
+
+			slotIndices[id] = static_cast<int>(slots.size());
+			slots.emplace_back(id, std::move(value));
+			return invalidateOrder(slotIndices[id]);
+		}
+
+	public:
+		inline size_t size() const { return slots.size(); }
+		inline bool empty() const { return slots.empty(); }
+
+		inline iterator begin() { return slots.begin(); }
+		inline iterator end() { return slots.end(); }
+		inline const_iterator begin() const { return slots.begin(); }
+		inline const_iterator end() const { return slots.end(); }
+		inline reverse_iterator rbegin() { return slots.rbegin(); }
+		inline reverse_iterator rend() { return slots.rend(); }
+		inline const_reverse_iterator rbegin() const { return slots.rbegin(); }
+		inline const_reverse_iterator rend() const { return slots.rend(); }
+
+		inline iterator find(int id) { return slotIterator(getSlot(id)); }
+		inline const_iterator find(int id) const
+		{
+			int slot = getSlot(id);
+			return slot == npos ? slots.end() : slots.begin() + slot;
+		}
+
+		inline size_t count(int id) const { return getSlot(id) != npos; }
+
+		T& at(int id)
+		{
+			iterator it = find(id);
+			if (it == slots.end())
+				throw std::out_of_range("Invalid SlotMap ID");
+
+			return it->second;
+		}
+
+		const T& at(int id) const
+		{
+			const_iterator it = find(id);
+			if (it == slots.end())
+				throw std::out_of_range("Invalid SlotMap ID");
+
+			return it->second;
+		}
+
+		T& operator[](int id)
+		{
+			iterator it = find(id);
+			return it != slots.end() ? it->second : insertSlot(id, T{})->second;
+		}
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			iterator it = find(value.first);
+			if (it != slots.end())
+				return { it, false };
+
+			return { insertSlot(value.first, value.second), true };
+		}
+
+		std::pair<iterator, bool> emplace(int id, T value)
+		{
+			return insert({ id, std::move(value) });
+		}
+
+		std::pair<iterator, bool> insert_or_assign(int id, T value)
+		{
+			iterator it = find(id);
+			if (it != slots.end())
+			{
+				it->second = std::move(value);
+				return { it, false };
+			}
+
+			return { insertSlot(id, std::move(value)), true };
+		}
+
+		size_t erase(int id)
+		{
+			int slot = getSlot(id);
+			if (slot == npos)
+				return 0;
+
+			erase(slots.begin() + slot);
+			return 1;
+		}
+
+		/// <summary>
+		/// Erases the value at the given position and returns the position of the value moved into its slot
+		/// </summary>
+		iterator erase(const_iterator position)
+		{
+			const int slot = static_cast<int>(std::distance(slots.cbegin(), position));
+			slotIndices[slots[slot].first] = npos;
+
+			if (static_cast<size_t>(slot) + 1 != slots.size())
+			{
+				slots[slot] = std::move(slots.back());
+				slotIndices[slots[slot].first] = slot;
+			}
+
+			slots.pop_back();
+			return invalidateOrder(slot < static_cast<int>(slots.size()) ? slot : npos);
+		}
+
+		void clear()
+		{
+			slots.clear();
+			slotIndices.clear();
+			tickOrder.clear();
+			sortedTicks.clear();
+			tickOrderDirty = true;
+		}
+
+		void reserve(size_t capacity)
+		{
+			slots.reserve(capacity);
+		}
+
+		/// <summary>
+		/// Returns the IDs of all values sorted by tick. Only available for values with a tick field.
+		/// The order is sorted again lazily after an insertion, an erasure or a change to any tick.
+		/// </summary>
+		const std::vector<int>& getTickOrder() const
+		{
+			if (tickOrderDirty || ticksChanged())
+			{
+				tickOrder.resize(slots.size());
+				for (size_t i = 0; i < slots.size(); ++i)
+					tickOrder[i] = static_cast<int>(i);
+
+				std::sort(tickOrder.begin(), tickOrder.end(), [this](int a, int b)
+				{
+					const auto& n1 = slots[a];
+					const auto& n2 = slots[b];
+					return n1.second.tick == n2.second.tick ? n1.first < n2.first : n1.second.tick < n2.second.tick;
+				});
+
+				for (int& id : tickOrder)
+					id = slots[id].first;
+
+				sortedTicks.resize(slots.size());
+				for (size_t i = 0; i < slots.size(); ++i)
+					sortedTicks[i] = slots[i].second.tick;
+
+				tickOrderDirty = false;
+			}
+
+			return tickOrder;
+		}
+	};
+}
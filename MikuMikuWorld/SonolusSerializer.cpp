@@ -2,9 +2,6 @@
 #include "Constants.h"
 #include "IO.h"
 #include "File.h"
-#include "Application.h"
-#include "ApplicationConfiguration.h"
-#include "Colors.h"
 
 #ifdef _DEBUG
 #define PRINT_DEBUG(...) \
@@ -254,9 +251,11 @@ namespace MikuMikuWorld
 			levelData.entities.emplace_back(toSpeedChangeEntity(speed, defaultGroupName)).name = std::move(entName);
 		}
 
+		// The notes are stored in edit order, export them by tick so the output only depends on the score
 		std::multimap<TickType, size_t> simBuilder;
-		for (const auto& [id, note] : score.notes)
+		for (int id : score.notes.getTickOrder())
 		{
+			const Note& note = score.notes.at(id);
 			if (note.getType() != NoteType::Tap) continue;
 			simBuilder.emplace(note.tick, levelData.entities.size());
 			levelData.entities.emplace_back(toNoteEntity(note, getTapNoteArchetype(note), defaultGroupName));
@@ -264,8 +263,12 @@ namespace MikuMikuWorld
 
 		std::vector<size_t> entityJoints;
 		std::vector<std::pair<size_t, size_t>> attachEntities;
-		for (const auto& [id, hold] : score.holdNotes)
+		for (int id : score.notes.getTickOrder())
 		{
+			auto holdIt = score.holdNotes.find(id);
+			if (score.notes.at(id).getType() != NoteType::Hold || holdIt == score.holdNotes.end()) continue;
+
+			const HoldNote& hold = holdIt->second;
 			entityJoints.clear();
 			attachEntities.clear();
 
@@ -38,29 +38,12 @@ namespace MikuMikuWorld
 
 	int SusExporter::getTicksFromMeasure(int measure)
 	{
-		int barLengthIndex = 0;
-		for (int i = barLengthTicks.size() - 1; i >= 0; --i)
-		{
-			if (barLengthTicks[i].barLength.bar <= measure)
-				barLengthIndex = std::max(0, i);
-		}
-
-		const BarLengthTicks& blt = barLengthTicks[barLengthIndex];
-		int measureDiff = measure - blt.barLength.bar;
-		int ticksPerMeasure = blt.barLength.length * ticksPerBeat;
-		return blt.ticks + (measureDiff * ticksPerMeasure);
+		return measureIndex.measureToTicks(measure);
 	}
 
 	int SusExporter::getMeasureFromTicks(int ticks)
 	{
-		for (const auto& [barLength, barTicks] : barLengthTicks)
-		{
-			if (ticks >= barTicks)
-				return barLength.bar + ((float)(ticks - barTicks) / (float)ticksPerBeat / barLength.length);
-		}
-
-		// no time signatures
-		return 0;
+		return measureIndex.ticksToMeasure(ticks);
 	}
 
 	void SusExporter::appendSlideData(const SUSNoteStream& slides, const std::string& infoPrefix)
@@ -81,20 +64,16 @@ namespace MikuMikuWorld
 
 	void SusExporter::appendData(int tick, std::string info, std::string data)
 	{
-		for (const auto& [barLength, barTicks] : barLengthTicks)
-		{
-			if (tick >= barTicks)
-			{
-				int currentMeasure = barLength.bar + ((float)(tick - barTicks) / (float)ticksPerBeat / barLength.length);
-				MeasureMap& measureMap = measuresMap[currentMeasure];
-				measureMap.measure = currentMeasure;
-
-				NoteMap& map = measureMap.notesMap[info];
-				map.data.push_back(NoteMap::RawData{ tick - barTicks, data });
-				map.ticksPerMeasure = barLength.length * ticksPerBeat;
-				break;
-			}
-		}
+		if (tick < 0)
+			return;
+
+		int currentMeasure = getMeasureFromTicks(tick);
+		MeasureMap& measureMap = measuresMap[currentMeasure];
+		measureMap.measure = currentMeasure;
+
+		NoteMap& map = measureMap.notesMap[info];
+		map.data.push_back(NoteMap::RawData{ tick - getTicksFromMeasure(currentMeasure), data });
+		map.ticksPerMeasure = measureIndex.getTicksPerMeasure(currentMeasure);
 	}
 
 	void SusExporter::appendNoteData(const SUSNote& note, const std::string infoPrefix, const std::string channel)
@@ -233,7 +212,6 @@ namespace MikuMikuWorld
 			[](const auto& a, const auto& b) { return a[0].tick < b[0].tick; });
 
 		measuresMap.clear();
-		barLengthTicks.clear();
 		int baseMeasure = 0;
 
 		// Write time signatures
@@ -252,19 +230,9 @@ namespace MikuMikuWorld
 
 		lines.push_back("");
 
-		int totalTicks = 0;
-		for (int i = 0; i < barLengths.size(); ++i)
-		{
-			int next = 0;
-			if (i + 1 < barLengths.size())
-				next = barLengths[i + 1].bar;
-
-			int startTick = totalTicks;
-			totalTicks += (next - barLengths[i].bar) * barLengths[i].length * ticksPerBeat;
-			barLengthTicks.push_back({ barLengths[i], startTick });
-		}
-
-		std::reverse(barLengthTicks.begin(), barLengthTicks.end());
+		measureIndex.clear();
+		for (const auto& barLength : barLengths)
+			measureIndex.append(barLength.bar, barLength.length * ticksPerBeat, ticksPerBeat);
 
 		std::map<float, std::string> bpmIdentifiers;
 		for (const auto& bpm : bpms)
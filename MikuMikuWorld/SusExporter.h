@@ -4,6 +4,7 @@
 #include <vector>
 #include "IO.h"
 #include "SUS.h"
+#include "Tempo.h"
 
 namespace MikuMikuWorld
 {
@@ -86,18 +87,12 @@ namespace MikuMikuWorld
 		std::map<std::string, NoteMap> notesMap;
 	};
 
-	struct BarLengthTicks
-	{
-		BarLength barLength;
-		int ticks;
-	};
-
 	class SusExporter
 	{
 	private:
 		int ticksPerBeat;
 		std::map<int, MeasureMap> measuresMap;
-		std::vector<BarLengthTicks> barLengthTicks;
+		MeasureIndex measureIndex;
 
 		int getMeasureFromTicks(int ticks);
 		int getTicksFromMeasure(int measure);
@@ -2,6 +2,9 @@
 #include "SusExporter.h"
 #include "SusParser.h"
 #include "SUS.h"
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace MikuMikuWorld
 {	
@@ -133,8 +136,8 @@ namespace MikuMikuWorld
 			}
 		}
 
-		std::map<int, Note> notes;
-		std::map<int, HoldNote> holds;
+		SlotMap<Note> notes;
+		SlotMap<HoldNote> holds;
 		std::vector<SkillTrigger> skills;
 		Fever fever{ -1, -1 };
 
@@ -313,8 +316,8 @@ namespace MikuMikuWorld
 
 		Score score;
 		score.metadata = metadata;
-		score.notes = notes;
-		score.holdNotes = holds;
+		score.notes = std::move(notes);
+		score.holdNotes = std::move(holds);
 		score.tempoChanges = tempos;
 		score.timeSignatures = timeSignatures;
 		score.hiSpeedChanges = hiSpeedChanges;
@@ -335,9 +338,11 @@ namespace MikuMikuWorld
 		std::vector<BarLength> barlengths;
 		std::vector<HiSpeed> hiSpeeds;
 
+		// The notes are stored in edit order, export them by tick so the output only depends on the score
 		std::unordered_set<std::string> criticalKeys;
-		for (const auto& [id, note] : score.notes)
+		for (int id : score.notes.getTickOrder())
 		{
+			const Note& note = score.notes.at(id);
 			if (note.getType() == NoteType::Tap)
 			{
 				int type = note.friction ? 5 : 1;
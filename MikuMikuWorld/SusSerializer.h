@@ -1,6 +1,5 @@
 #pragma once
 #include "ScoreSerializer.h"
-#include "Application.h"
 
 namespace MikuMikuWorld
 {
@@ -20,9 +19,8 @@ namespace MikuMikuWorld
         SUS scoreToSus(const Score& score);
 
     public:
-        SusSerializer()
+        SusSerializer(std::string exportComment = {}) : exportComment(std::move(exportComment))
         {
-            exportComment = "This file was generated by " APP_NAME " " + Application::getAppVersion();
         }
 
         void serialize(const Score& score, std::string filename) override;
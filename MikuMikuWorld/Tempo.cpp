@@ -2,6 +2,7 @@
 #include "Score.h"
 #include "Constants.h"
 #include <algorithm>
+#include <cmath>
 
 namespace MikuMikuWorld
 {
@@ -196,4 +197,259 @@ namespace MikuMikuWorld
 
 		return std::max(tick, 0);
 	}
-}
\ No newline at end of file
+
+	TempoMap::TempoMap()
+		: TempoMap({}, {}, TICKS_PER_BEAT)
+	{
+	}
+
+	TempoMap::TempoMap(const std::vector<Tempo>& tempos, const std::vector<HiSpeedChange>& hiSpeeds, int beatTicks)
+	{
+		build(tempos, hiSpeeds, beatTicks);
+	}
+
+	void TempoMap::build(const std::vector<Tempo>& tempos, const std::vector<HiSpeedChange>& hiSpeeds, int _beatTicks)
+	{
+		beatTicks = _beatTicks;
+		tempoPoints.clear();
+		scaledPoints.clear();
+
+		std::vector<Tempo> sortedTempos = tempos;
+		if (sortedTempos.empty())
+			sortedTempos.push_back(Tempo());
+
+		std::stable_sort(sortedTempos.begin(), sortedTempos.end(),
+			[](const Tempo& a, const Tempo& b) { return a.tick < b.tick; });
+
+		tempoPoints.reserve(sortedTempos.size());
+		double time = 0;
+		for (size_t i = 0; i < sortedTempos.size(); ++i)
+		{
+			if (i > 0)
+				time += (sortedTempos[i].tick - sortedTempos[i - 1].tick) * (60.0 / sortedTempos[i - 1].bpm / beatTicks);
+
+			tempoPoints.push_back({ sortedTempos[i], time });
+		}
+
+		std::vector<HiSpeedChange> sortedSpeeds = hiSpeeds;
+		std::stable_sort(sortedSpeeds.begin(), sortedSpeeds.end(),
+			[](const HiSpeedChange& a, const HiSpeedChange& b) { return a.tick < b.tick; });
+
+		// Scaled time starts at tick 0 with the first tempo and a speed of 1x,
+		// then gets a break point at every tempo or hi-speed change after that
+		scaledPoints.reserve(sortedTempos.size() + sortedSpeeds.size() + 1);
+		scaledPoints.push_back({ 0, sortedTempos.front().bpm, 1.0f, 0.0 });
+
+		size_t nextTempo = 1, nextSpeed = 0;
+		while (nextSpeed < sortedSpeeds.size() && sortedSpeeds[nextSpeed].tick <= 0)
+			scaledPoints.back().speed = sortedSpeeds[nextSpeed++].speed;
+
+		while (nextTempo < sortedTempos.size() || nextSpeed < sortedSpeeds.size())
+		{
+			int tempoTick = nextTempo < sortedTempos.size() ? sortedTempos[nextTempo].tick : INT32_MAX;
+			int speedTick = nextSpeed < sortedSpeeds.size() ? sortedSpeeds[nextSpeed].tick : INT32_MAX;
+			int tick = std::min(tempoTick, speedTick);
+
+			const ScaledPoint& prev = scaledPoints.back();
+			ScaledPoint point = prev;
+			point.tick = tick;
+			point.scaledTime = prev.scaledTime + (tick - prev.tick) * (60.0 / prev.bpm / beatTicks) * prev.speed;
+
+			while (nextTempo < sortedTempos.size() && sortedTempos[nextTempo].tick == tick)
+				point.bpm = sortedTempos[nextTempo++].bpm;
+			while (nextSpeed < sortedSpeeds.size() && sortedSpeeds[nextSpeed].tick == tick)
+				point.speed = sortedSpeeds[nextSpeed++].speed;
+
+			if (tick == prev.tick)
+				scaledPoints.back() = point;
+			else
+				scaledPoints.push_back(point);
+		}
+	}
+
+	size_t TempoMap::findTempoIndex(int tick) const
+	{
+		auto it = std::upper_bound(tempoPoints.begin(), tempoPoints.end(), tick,
+			[](int tick, const TempoPoint& point) { return tick < point.tempo.tick; });
+
+		return it == tempoPoints.begin() ? 0 : std::distance(tempoPoints.begin(), it) - 1;
+	}
+
+	double TempoMap::ticksToSeconds(int tick) const
+	{
+		const TempoPoint& point = tempoPoints[findTempoIndex(tick)];
+		return point.time + (tick - point.tempo.tick) * (60.0 / point.tempo.bpm / beatTicks);
+	}
+
+	int TempoMap::secondsToTicks(double seconds) const
+	{
+		auto it = std::upper_bound(tempoPoints.begin(), tempoPoints.end(), seconds,
+			[](double seconds, const TempoPoint& point) { return seconds < point.time; });
+
+		const TempoPoint& point = it == tempoPoints.begin() ? tempoPoints.front() : *std::prev(it);
+
+		double ticks = (seconds - point.time) / (60.0 / point.tempo.bpm / beatTicks);
+
+		// Times before the first tempo truncate towards zero like accumulateTicks did
+		if (ticks < 0)
+			return point.tempo.tick + static_cast<int>(ticks);
+
+		// Small bias so that converting a tick to seconds and back lands on the same tick
+		return point.tempo.tick + static_cast<int>(std::floor(ticks + 1e-6));
+	}
+
+	double TempoMap::ticksToScaledSeconds(int tick) const
+	{
+		if (tick <= 0)
+			return 0;
+
+		auto it = std::upper_bound(scaledPoints.begin(), scaledPoints.end(), tick,
+			[](int tick, const ScaledPoint& point) { return tick < point.tick; });
+
+		const ScaledPoint& point = *std::prev(it);
+		return point.scaledTime + (tick - point.tick) * (60.0 / point.bpm / beatTicks) * point.speed;
+	}
+
+	const Tempo& TempoMap::getTempoAt(int tick) const
+	{
+		return tempoPoints[findTempoIndex(tick)].tempo;
+	}
+
+	MeasureIndex::MeasureIndex()
+		: MeasureIndex({ { 0, TimeSignature{ 0, 4, 4 } } }, TICKS_PER_BEAT)
+	{
+	}
+
+	MeasureIndex::MeasureIndex(const std::map<int, TimeSignature>& ts, int beatTicks)
+	{
+		build(ts, beatTicks);
+	}
+
+	void MeasureIndex::clear()
+	{
+		segments.clear();
+	}
+
+	void MeasureIndex::build(const std::map<int, TimeSignature>& ts, int beatTicks)
+	{
+		clear();
+		segments.reserve(ts.size());
+		for (const auto& [measure, signature] : ts)
+		{
+			int ticksPerMeasure = beatsPerMeasure(signature) * beatTicks;
+			append(measure, ticksPerMeasure, ticksPerMeasure / std::max(1, signature.numerator));
+		}
+	}
+
+	void MeasureIndex::append(int measure, int ticksPerMeasure, int beatTicks)
+	{
+		int tick = 0;
+		if (!segments.empty())
+		{
+			const Segment& last = segments.back();
+			tick = last.tick + (measure - last.measure) * last.ticksPerMeasure;
+		}
+
+		segments.push_back({ measure, tick, std::max(1, ticksPerMeasure), std::max(1, beatTicks) });
+	}
+
+	const MeasureIndex::Segment& MeasureIndex::findSegmentByMeasure(int measure) const
+	{
+		auto it = std::upper_bound(segments.begin(), segments.end(), measure,
+			[](int measure, const Segment& segment) { return measure < segment.measure; });
+
+		return it == segments.begin() ? segments.front() : *std::prev(it);
+	}
+
+	const MeasureIndex::Segment& MeasureIndex::findSegmentByTick(int tick) const
+	{
+		auto it = std::upper_bound(segments.begin(), segments.end(), tick,
+			[](int tick, const Segment& segment) { return tick < segment.tick; });
+
+		return it == segments.begin() ? segments.front() : *std::prev(it);
+	}
+
+	int MeasureIndex::measureToTicks(int measure) const
+	{
+		if (segments.empty())
+			return 0;
+
+		const Segment& segment = findSegmentByMeasure(measure);
+		return segment.tick + (measure - segment.measure) * segment.ticksPerMeasure;
+	}
+
+	int MeasureIndex::ticksToMeasure(int tick) const
+	{
+		if (segments.empty())
+			return 0;
+
+		const Segment& segment = findSegmentByTick(tick);
+		return segment.measure + (tick - segment.tick) / segment.ticksPerMeasure;
+	}
+
+	int MeasureIndex::getTicksPerMeasure(int measure) const
+	{
+		return segments.empty() ? 0 : findSegmentByMeasure(measure).ticksPerMeasure;
+	}
+
+	int MeasureIndex::findSignatureMeasure(int measure) const
+	{
+		return segments.empty() ? 0 : findSegmentByMeasure(measure).measure;
+	}
+
+	MeasureIndex::GridLineRange MeasureIndex::gridLines(int firstTick, int lastTick, int subdivision) const
+	{
+		return GridLineRange(this, firstTick, lastTick, subdivision);
+	}
+
+	MeasureIndex::GridLineIterator::GridLineIterator()
+		: index{ nullptr }, segment{ 0 }, subdivision{ 1 }, lastTick{ 0 }, line{ INT32_MAX, 0, false }
+	{
+	}
+
+	MeasureIndex::GridLineIterator::GridLineIterator(const MeasureIndex* index, int firstTick, int lastTick, int subdivision)
+		: index{ index }, segment{ 0 }, subdivision{ std::max(1, subdivision) }, lastTick{ lastTick }, line{}
+	{
+		line.tick = firstTick - (firstTick % this->subdivision);
+		if (line.tick > lastTick || index->segments.empty())
+		{
+			line.tick = INT32_MAX;
+			return;
+		}
+
+		auto it = std::upper_bound(index->segments.begin(), index->segments.end(), line.tick,
+			[](int tick, const Segment& segment) { return tick < segment.tick; });
+		segment = it == index->segments.begin() ? 0 : std::distance(index->segments.begin(), it) - 1;
+		resolve();
+	}
+
+	void MeasureIndex::GridLineIterator::resolve()
+	{
+		const std::vector<Segment>& segments = index->segments;
+		while (segment + 1 < segments.size() && segments[segment + 1].tick <= line.tick)
+			++segment;
+
+		const Segment& current = segments[segment];
+		int measureOffset = (line.tick - current.tick) / current.ticksPerMeasure;
+		int measureTick = current.tick + measureOffset * current.ticksPerMeasure;
+
+		line.measure = current.measure + measureOffset;
+		line.beat = (line.tick - measureTick) % current.beatTicks == 0;
+	}
+
+	MeasureIndex::GridLineIterator& MeasureIndex::GridLineIterator::operator++()
+	{
+		line.tick += subdivision;
+		if (line.tick > lastTick)
+			line.tick = INT32_MAX;
+		else
+			resolve();
+
+		return *this;
+	}
+
+	MeasureIndex::GridLineRange::GridLineRange(const MeasureIndex* index, int firstTick, int lastTick, int subdivision)
+		: first(index, firstTick, lastTick, subdivision), last()
+	{
+	}
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include <map>
 
@@ -11,6 +12,13 @@ namespace MikuMikuWorld
 		int measure;
 		int numerator;
 		int denominator;
+
+		inline bool operator==(const TimeSignature& other) const
+		{
+			return measure == other.measure && numerator == other.numerator && denominator == other.denominator;
+		}
+
+		inline bool operator!=(const TimeSignature& other) const { return !(*this == other); }
 	};
 
 	struct Tempo
@@ -39,4 +47,136 @@ namespace MikuMikuWorld
 	const Tempo& getTempoAt(int tick, const std::vector<Tempo>& tempos);
 	int findTimeSignature(int measure, const std::map<int, TimeSignature>& ts);
 	int findHighSpeedChange(int tick, const std::vector<HiSpeedChange>& hiSpeeds);
-}
\ No newline at end of file
+
+	/// <summary>
+	/// Prefix-summed view of a score's tempo and hi-speed changes.
+	/// Build it once whenever the tempo or hi-speed changes are edited, then convert between ticks and seconds in O(log n).
+	/// </summary>
+	class TempoMap
+	{
+	private:
+		struct TempoPoint
+		{
+			Tempo tempo;
+			double time;
+		};
+
+		struct ScaledPoint
+		{
+			int tick;
+			float bpm;
+			float speed;
+			double scaledTime;
+		};
+
+		int beatTicks;
+		std::vector<TempoPoint> tempoPoints;
+		std::vector<ScaledPoint> scaledPoints;
+
+		size_t findTempoIndex(int tick) const;
+
+	public:
+		TempoMap();
+		TempoMap(const std::vector<Tempo>& tempos, const std::vector<HiSpeedChange>& hiSpeeds, int beatTicks);
+
+		void build(const std::vector<Tempo>& tempos, const std::vector<HiSpeedChange>& hiSpeeds, int beatTicks);
+
+		double ticksToSeconds(int tick) const;
+		int secondsToTicks(double seconds) const;
+		double ticksToScaledSeconds(int tick) const;
+
+		const Tempo& getTempoAt(int tick) const;
+		inline int getBeatTicks() const { return beatTicks; }
+	};
+
+	struct GridLine
+	{
+		int tick;
+		int measure;
+		bool beat;
+	};
+
+	/// <summary>
+	/// Measure start ticks of every time signature segment, so measure/tick conversions are a binary search.
+	/// Only needs to be rebuilt when the time signatures change.
+	/// </summary>
+	class MeasureIndex
+	{
+	private:
+		struct Segment
+		{
+			int measure;
+			int tick;
+			int ticksPerMeasure;
+			int beatTicks;
+		};
+
+		std::vector<Segment> segments;
+
+		const Segment& findSegmentByMeasure(int measure) const;
+		const Segment& findSegmentByTick(int tick) const;
+
+	public:
+		/// <summary>
+		/// Walks the lines of a sub-division grid in tick order, flagging the ones that fall on a beat.
+		/// Lines are placed on multiples of the sub-division so they match snapTick.
+		/// </summary>
+		class GridLineIterator
+		{
+		private:
+			const MeasureIndex* index;
+			size_t segment;
+			int subdivision;
+			int lastTick;
+			GridLine line;
+
+			void resolve();
+
+		public:
+			/// <summary>
+			/// Constructs the past-the-end iterator
+			/// </summary>
+			GridLineIterator();
+			GridLineIterator(const MeasureIndex* index, int firstTick, int lastTick, int subdivision);
+
+			inline const GridLine& operator*() const { return line; }
+			inline const GridLine* operator->() const { return &line; }
+			inline bool operator!=(const GridLineIterator& other) const { return line.tick != other.line.tick; }
+			GridLineIterator& operator++();
+		};
+
+		class GridLineRange
+		{
+		private:
+			GridLineIterator first, last;
+
+		public:
+			GridLineRange(const MeasureIndex* index, int firstTick, int lastTick, int subdivision);
+
+			inline GridLineIterator begin() const { return first; }
+			inline GridLineIterator end() const { return last; }
+		};
+
+		MeasureIndex();
+		MeasureIndex(const std::map<int, TimeSignature>& ts, int beatTicks);
+
+		void clear();
+		void build(const std::map<int, TimeSignature>& ts, int beatTicks);
+
+		/// <summary>
+		/// Appends a segment starting at the given measure. Segments must be appended in increasing measure order.
+		/// </summary>
+		void append(int measure, int ticksPerMeasure, int beatTicks);
+
+		int measureToTicks(int measure) const;
+		int ticksToMeasure(int tick) const;
+		int getTicksPerMeasure(int measure) const;
+
+		/// <summary>
+		/// Returns the measure of the time signature change that is active at the given measure
+		/// </summary>
+		int findSignatureMeasure(int measure) const;
+
+		GridLineRange gridLines(int firstTick, int lastTick, int subdivision) const;
+	};
+}
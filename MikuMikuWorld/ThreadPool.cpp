@@ -0,0 +1,162 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace MikuMikuWorld
+{
+	ThreadPool::ThreadPool(int threadCount)
+	{
+		startWorkers(std::max(threadCount, 1));
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		stopWorkers();
+	}
+
+	int ThreadPool::getDefaultThreadCount()
+	{
+		return std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+	}
+
+	void ThreadPool::setThreadCount(int count)
+	{
+		count = std::max(count, 1);
+		if (count == getThreadCount())
+			return;
+
+		stopWorkers();
+		startWorkers(count);
+	}
+
+	void ThreadPool::startWorkers(int count)
+	{
+		stopping = false;
+		for (int i = 0; i < count; ++i)
+			queues.push_back(std::make_unique<WorkQueue>());
+
+		// The first queue belongs to the thread calling parallelFor.
+		// Workers are handed the current generation so ones started after earlier loops only wake up for the next one
+		for (int i = 1; i < count; ++i)
+			workers.emplace_back(&ThreadPool::workerMain, this, i, jobGeneration);
+	}
+
+	void ThreadPool::stopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+		}
+
+		workAvailable.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+
+		workers.clear();
+		queues.clear();
+	}
+
+	void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+	{
+		if (count == 0)
+			return;
+
+		if (workers.empty() || count == 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+				func(i);
+
+			return;
+		}
+
+		{
+			// The job is published before any queue has work, so a thread that finds an index always has the job to run it with
+			std::lock_guard<std::mutex> lock{ mutex };
+			job = &func;
+			busyWorkers = static_cast<int>(workers.size());
+
+			const size_t queueCount = queues.size();
+			for (size_t i = 0; i < queueCount; ++i)
+			{
+				std::lock_guard<std::mutex> queueLock{ queues[i]->mutex };
+				queues[i]->begin = count * i / queueCount;
+				queues[i]->end = count * (i + 1) / queueCount;
+			}
+
+			++jobGeneration;
+		}
+
+		workAvailable.notify_all();
+		runQueue(0);
+
+		std::unique_lock<std::mutex> lock{ mutex };
+		workFinished.wait(lock, [this] { return busyWorkers == 0; });
+		job = nullptr;
+	}
+
+	void ThreadPool::workerMain(int index, uint64_t lastGeneration)
+	{
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				workAvailable.wait(lock, [this, lastGeneration] { return stopping || jobGeneration != lastGeneration; });
+				if (stopping)
+					return;
+
+				lastGeneration = jobGeneration;
+			}
+
+			runQueue(index);
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (--busyWorkers == 0)
+				workFinished.notify_one();
+		}
+	}
+
+	void ThreadPool::runQueue(int index)
+	{
+		size_t item{};
+		while (popIndex(index, item) || (steal(index) && popIndex(index, item)))
+			(*job)(item);
+	}
+
+	bool ThreadPool::popIndex(int index, size_t& item)
+	{
+		WorkQueue& queue = *queues[index];
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		if (queue.begin >= queue.end)
+			return false;
+
+		item = queue.begin++;
+		return true;
+	}
+
+	bool ThreadPool::steal(int index)
+	{
+		const int queueCount = getThreadCount();
+		for (int offset = 1; offset < queueCount; ++offset)
+		{
+			WorkQueue& victim = *queues[(index + offset) % queueCount];
+			size_t begin{}, end{};
+			{
+				std::lock_guard<std::mutex> lock{ victim.mutex };
+				if (victim.begin >= victim.end)
+					continue;
+
+				// Take the back half, leaving the front to the owner which is working through it
+				end = victim.end;
+				begin = victim.end - (victim.end - victim.begin + 1) / 2;
+				victim.end = begin;
+			}
+
+			WorkQueue& queue = *queues[index];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			queue.begin = begin;
+			queue.end = end;
+			return true;
+		}
+
+		return false;
+	}
+}
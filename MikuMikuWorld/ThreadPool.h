@@ -0,0 +1,67 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MikuMikuWorld
+{
+	/// <summary>
+	/// A fixed set of worker threads that run the iterations of a loop in parallel.
+	/// Every thread starts on its own share of the iterations, and once it runs out it steals half of
+	/// what is left of another thread's share, so loops with uneven iterations still keep all threads busy.
+	/// </summary>
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(int threadCount = 1);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		/// <summary>
+		/// Changes the number of threads running each loop, counting the thread that starts it
+		/// </summary>
+		void setThreadCount(int count);
+		inline int getThreadCount() const { return static_cast<int>(queues.size()); }
+
+		/// <summary>
+		/// Calls func once for every index in [0, count) and returns after all calls have finished.
+		/// The calling thread takes part in the loop, and func must not throw.
+		/// </summary>
+		void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+		/// <summary>
+		/// One thread per core, leaving a core for the audio thread
+		/// </summary>
+		static int getDefaultThreadCount();
+
+	private:
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			size_t begin{};
+			size_t end{};
+		};
+
+		std::vector<std::thread> workers;
+		std::vector<std::unique_ptr<WorkQueue>> queues;
+
+		std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable workFinished;
+		const std::function<void(size_t)>* job{ nullptr };
+		uint64_t jobGeneration{};
+		int busyWorkers{};
+		bool stopping{ false };
+
+		void startWorkers(int count);
+		void stopWorkers();
+		void workerMain(int index, uint64_t lastGeneration);
+		void runQueue(int index);
+		bool popIndex(int index, size_t& item);
+		bool steal(int index);
+	};
+}
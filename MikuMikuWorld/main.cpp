@@ -1,5 +1,7 @@
 #include "Application.h"
 #include "IO.h"
+#include "ScoreBenchmarks.h"
+#include "EditorBenchmarks.h"
 #include "UI.h"
 #include "Windows.h"
 
@@ -17,6 +19,23 @@ int main()
 		return 1;
 	}
 
+	// Run the benchmarks without creating a window
+	if (argc > 1 && IO::wideStringToMb(args[1]) == "--benchmark")
+	{
+		std::vector<std::string> options;
+		for (int i = 2; i < argc; ++i)
+			options.push_back(IO::wideStringToMb(args[i]));
+
+		// The release build has no console of its own, so print to the one it was started from
+		if (AttachConsole(ATTACH_PARENT_PROCESS))
+			freopen("CONOUT$", "w", stdout);
+
+		Debug::BenchmarkRunner runner;
+		Debug::addScoreBenchmarks(runner);
+		Debug::addEditorBenchmarks(runner, IO::File::getFilepath(IO::wideStringToMb(args[0])));
+		return Debug::runBenchmarks(runner, options);
+	}
+
 	try
 	{
 		std::string dir = IO::File::getFilepath(IO::wideStringToMb(args[0]));
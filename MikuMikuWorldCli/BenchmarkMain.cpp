@@ -0,0 +1,12 @@
+#include "ScoreBenchmarks.h"
+#include <string>
+#include <vector>
+
+// Runs the score benchmarks with the same options as the editor's --benchmark,
+// which also runs the preview, rendering and audio benchmarks that only build with the editor
+int main(int argc, char** argv)
+{
+	Debug::BenchmarkRunner runner;
+	Debug::addScoreBenchmarks(runner);
+	return Debug::runBenchmarks(runner, std::vector<std::string>(argv + 1, argv + argc));
+}
@@ -0,0 +1,116 @@
+#include "ChartBatch.h"
+#include "NativeScoreSerializer.h"
+#include "SusSerializer.h"
+#include "SonolusSerializer.h"
+#include "Constants.h"
+#include "IO.h"
+#include "Stopwatch.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace MikuMikuWorld::Cli
+{
+	static std::unique_ptr<ScoreSerializer> createSerializer(const std::string& filename)
+	{
+		switch (ScoreSerializeController::toSerializeFormat(filename))
+		{
+		case SerializeFormat::NativeFormat:
+			return std::make_unique<NativeScoreSerializer>();
+		case SerializeFormat::SusFormat:
+			return std::make_unique<SusSerializer>("This file was generated by MikuMikuWorldCli");
+		case SerializeFormat::LvlDataFormat:
+			return std::make_unique<SonolusSerializer>(std::make_unique<PySekaiEngine>(), IO::endsWith(filename, GZ_JSON_EXTENSION));
+		default:
+			throw std::runtime_error("Unsupported file format");
+		}
+	}
+
+	Score loadScore(const std::string& filename)
+	{
+		// IDs are only unique within a score, so restart them to keep the ID tables small
+		resetNextID();
+		nextSkillID = 1;
+
+		return createSerializer(filename)->deserialize(filename);
+	}
+
+	void saveScore(const Score& score, const std::string& filename)
+	{
+		createSerializer(filename)->serialize(score, filename);
+	}
+
+	static ChartResult processChart(const ChartJob& job, const BatchOptions& options)
+	{
+		ChartResult result{};
+		result.input = job.input;
+		result.output = job.output;
+		Stopwatch stopwatch;
+
+		try
+		{
+			Score score;
+			try
+			{
+				score = loadScore(job.input);
+			}
+			catch (const PartialScoreDeserializeError& partialError)
+			{
+				score = partialError.getScore();
+				result.issues.push_back({ "partial_load", -1, -1, partialError.what() });
+			}
+			result.loadTime = stopwatch.elapsed();
+			result.noteCount = score.notes.size();
+			result.holdCount = score.holdNotes.size();
+
+			if (options.validate)
+			{
+				std::vector<ScoreIssue> issues = validateScore(score);
+				result.issues.insert(result.issues.end(), issues.begin(), issues.end());
+			}
+
+			if (!job.output.empty())
+			{
+				stopwatch.reset();
+				saveScore(score, job.output);
+				result.saveTime = stopwatch.elapsed();
+			}
+
+			result.success = true;
+		}
+		catch (const std::exception& error)
+		{
+			result.error = error.what();
+		}
+
+		return result;
+	}
+
+	BatchSummary runBatch(const std::vector<ChartJob>& jobs, const BatchOptions& options)
+	{
+		BatchSummary summary;
+		summary.results.resize(jobs.size());
+		summary.threads = std::clamp(options.threads, 1, std::max(static_cast<int>(jobs.size()), 1));
+
+		Stopwatch stopwatch;
+		std::atomic<size_t> nextJob{ 0 };
+		auto worker = [&]()
+		{
+			for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+				summary.results[i] = processChart(jobs[i], options);
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(summary.threads - 1);
+		for (int i = 1; i < summary.threads; ++i)
+			workers.emplace_back(worker);
+
+		// The calling thread works through the jobs too
+		worker();
+		for (std::thread& thread : workers)
+			thread.join();
+
+		summary.elapsed = stopwatch.elapsed();
+		return summary;
+	}
+}
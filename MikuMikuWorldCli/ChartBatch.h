@@ -0,0 +1,59 @@
+#pragma once
+#include "Score.h"
+#include "ScoreValidator.h"
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld::Cli
+{
+	struct ChartJob
+	{
+		std::string input;
+
+		// Empty when the chart is only loaded and validated
+		std::string output;
+	};
+
+	struct ChartResult
+	{
+		std::string input;
+		std::string output;
+		bool success{};
+		std::string error;
+		size_t noteCount{};
+		size_t holdCount{};
+
+		// Seconds spent loading and writing the chart
+		double loadTime{};
+		double saveTime{};
+		std::vector<ScoreIssue> issues;
+	};
+
+	struct BatchOptions
+	{
+		int threads{ 1 };
+		bool validate{ true };
+	};
+
+	struct BatchSummary
+	{
+		std::vector<ChartResult> results;
+		int threads{};
+		double elapsed{};
+	};
+
+	/// <summary>
+	/// Loads a score with the serializer matching the file's extension
+	/// </summary>
+	Score loadScore(const std::string& filename);
+
+	/// <summary>
+	/// Writes a score with the serializer matching the file's extension
+	/// </summary>
+	void saveScore(const Score& score, const std::string& filename);
+
+	/// <summary>
+	/// Runs every job on a pool of worker threads. Results are returned in the order of the jobs.
+	/// </summary>
+	BatchSummary runBatch(const std::vector<ChartJob>& jobs, const BatchOptions& options);
+}
@@ -0,0 +1,174 @@
+#include "ScoreValidator.h"
+#include "Constants.h"
+#include "IO.h"
+#include <algorithm>
+
+namespace MikuMikuWorld::Cli
+{
+	static void addIssue(std::vector<ScoreIssue>& issues, const char* check, const Note& note, std::string message)
+	{
+		issues.push_back({ check, note.ID, note.tick, std::move(message) });
+	}
+
+	static void validateNotes(const Score& score, std::vector<ScoreIssue>& issues)
+	{
+		for (const auto& [id, note] : score.notes)
+		{
+			if (id != note.ID)
+				addIssue(issues, "mismatched_id", note, IO::formatString("Note is stored under ID %d", id));
+
+			if (note.tick < 0)
+				addIssue(issues, "negative_tick", note, "Note is placed before the start of the score");
+
+			if (note.width < MIN_NOTE_WIDTH || note.width > MAX_NOTE_WIDTH ||
+				note.lane < MIN_LANE || note.lane + note.width - 1 > MAX_LANE)
+				addIssue(issues, "out_of_lanes", note, IO::formatString("Lane %d with width %d is outside the lanes", note.lane, note.width));
+
+			switch (note.getType())
+			{
+			case NoteType::Hold:
+				if (!score.holdNotes.count(note.ID))
+					addIssue(issues, "missing_hold", note, "Hold start has no hold data");
+				break;
+
+			case NoteType::HoldMid:
+			case NoteType::HoldEnd:
+			{
+				auto hold = score.holdNotes.find(note.parentID);
+				if (hold == score.holdNotes.end())
+				{
+					addIssue(issues, note.getType() == NoteType::HoldMid ? "dangling_hold_step" : "dangling_hold_end", note,
+						IO::formatString("Parent hold %d does not exist", note.parentID));
+				}
+				else if (note.getType() == NoteType::HoldMid && findHoldStep(hold->second, note.ID) == -1)
+				{
+					addIssue(issues, "dangling_hold_step", note, IO::formatString("Hold %d does not list this step", note.parentID));
+				}
+				else if (note.getType() == NoteType::HoldEnd && hold->second.end != note.ID)
+				{
+					addIssue(issues, "dangling_hold_end", note, IO::formatString("Hold %d ends with another note", note.parentID));
+				}
+				break;
+			}
+
+			default:
+				break;
+			}
+		}
+	}
+
+	static void validateHolds(const Score& score, std::vector<ScoreIssue>& issues)
+	{
+		for (const auto& [id, hold] : score.holdNotes)
+		{
+			auto start = score.notes.find(hold.start.ID);
+			auto end = score.notes.find(hold.end);
+			if (start == score.notes.end() || end == score.notes.end())
+			{
+				issues.push_back({ "broken_hold", id, start != score.notes.end() ? start->second.tick : -1,
+					start == score.notes.end() ? "Hold start note does not exist" : "Hold end note does not exist" });
+				continue;
+			}
+
+			const Note& startNote = start->second;
+			const Note& endNote = end->second;
+			if (endNote.tick < startNote.tick)
+				addIssue(issues, "reversed_hold", startNote, IO::formatString("Hold ends at tick %d before it starts", endNote.tick));
+
+			int previousTick = startNote.tick;
+			for (const HoldStep& step : hold.steps)
+			{
+				auto stepNote = score.notes.find(step.ID);
+				if (stepNote == score.notes.end())
+				{
+					addIssue(issues, "dangling_hold_step", startNote, IO::formatString("Step note %d does not exist", step.ID));
+					continue;
+				}
+
+				const Note& note = stepNote->second;
+				if (note.getType() != NoteType::HoldMid || note.parentID != hold.start.ID)
+					addIssue(issues, "dangling_hold_step", note, IO::formatString("Step belongs to hold %d", note.parentID));
+
+				if (note.tick < startNote.tick || note.tick > endNote.tick)
+					addIssue(issues, "step_outside_hold", note, "Step is outside of its hold");
+				else if (note.tick < previousTick)
+					addIssue(issues, "unsorted_hold_steps", note, "Step comes before the previous step");
+
+				previousTick = std::max(previousTick, note.tick);
+			}
+		}
+	}
+
+	static bool isGuideNote(const Score& score, const Note& note)
+	{
+		int holdID = note.getType() == NoteType::Hold ? note.ID : note.parentID;
+		auto hold = score.holdNotes.find(holdID);
+		return hold != score.holdNotes.end() && hold->second.isGuide();
+	}
+
+	// Notes at the same tick that share a lane are drawn and judged on top of each other.
+	// Hold steps and guides are excluded since they are allowed to overlap other notes.
+	static void validateOverlaps(const Score& score, std::vector<ScoreIssue>& issues)
+	{
+		const std::vector<int>& tickOrder = score.notes.getTickOrder();
+		std::vector<const Note*> sameTick;
+
+		for (size_t i = 0; i < tickOrder.size();)
+		{
+			const int tick = score.notes.at(tickOrder[i]).tick;
+
+			sameTick.clear();
+			for (; i < tickOrder.size() && score.notes.at(tickOrder[i]).tick == tick; ++i)
+			{
+				const Note& note = score.notes.at(tickOrder[i]);
+				if (note.getType() != NoteType::HoldMid && !isGuideNote(score, note))
+					sameTick.push_back(&note);
+			}
+
+			std::sort(sameTick.begin(), sameTick.end(), [](const Note* a, const Note* b) { return a->lane < b->lane; });
+			for (size_t a = 0; a < sameTick.size(); ++a)
+			{
+				for (size_t b = a + 1; b < sameTick.size() && sameTick[b]->lane < sameTick[a]->lane + sameTick[a]->width; ++b)
+				{
+					addIssue(issues, "overlapping_notes", *sameTick[b],
+						IO::formatString("Overlaps note %d on lane %d", sameTick[a]->ID, sameTick[a]->lane));
+				}
+			}
+		}
+	}
+
+	static void validateEvents(const Score& score, std::vector<ScoreIssue>& issues)
+	{
+		if (score.tempoChanges.empty() || score.tempoChanges.front().tick != 0)
+			issues.push_back({ "missing_tempo", -1, 0, "Score has no tempo at tick 0" });
+
+		for (const Tempo& tempo : score.tempoChanges)
+		{
+			if (tempo.bpm < MIN_BPM || tempo.bpm > MAX_BPM)
+				issues.push_back({ "invalid_tempo", -1, tempo.tick, IO::formatString("BPM %g is out of range", tempo.bpm) });
+		}
+
+		if (score.timeSignatures.find(0) == score.timeSignatures.end())
+			issues.push_back({ "missing_time_signature", -1, 0, "Score has no time signature at measure 0" });
+
+		for (const auto& [measure, ts] : score.timeSignatures)
+		{
+			if (ts.numerator < MIN_TIME_SIGNATURE || ts.numerator > MAX_TIME_SIGNATURE_NUMERATOR ||
+				ts.denominator < MIN_TIME_SIGNATURE || ts.denominator > MAX_TIME_SIGNATURE_DENOMINATOR)
+			{
+				issues.push_back({ "invalid_time_signature", -1, -1,
+					IO::formatString("Time signature %d/%d at measure %d is out of range", ts.numerator, ts.denominator, measure) });
+			}
+		}
+	}
+
+	std::vector<ScoreIssue> validateScore(const Score& score)
+	{
+		std::vector<ScoreIssue> issues;
+		validateNotes(score, issues);
+		validateHolds(score, issues);
+		validateOverlaps(score, issues);
+		validateEvents(score, issues);
+		return issues;
+	}
+}
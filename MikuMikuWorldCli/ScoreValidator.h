@@ -0,0 +1,22 @@
+#pragma once
+#include "Score.h"
+#include <string>
+#include <vector>
+
+namespace MikuMikuWorld::Cli
+{
+	struct ScoreIssue
+	{
+		// Short identifier of the check that failed, e.g. "dangling_hold_step"
+		std::string check;
+		int noteID;
+		int tick;
+		std::string message;
+	};
+
+	/// <summary>
+	/// Checks a score for data the editor cannot represent or that the exporters would silently drop:
+	/// broken hold references, notes outside the lanes, overlapping notes and invalid events.
+	/// </summary>
+	std::vector<ScoreIssue> validateScore(const Score& score);
+}
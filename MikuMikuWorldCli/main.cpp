@@ -0,0 +1,268 @@
+#include "ChartBatch.h"
+#include "ScoreSerializer.h"
+#include "Constants.h"
+#include "IO.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <json.hpp>
+#include <thread>
+
+namespace mmw = MikuMikuWorld;
+namespace fs = std::filesystem;
+
+constexpr const char* usage =
+	"Usage: MikuMikuWorldCli [options] <file or directory>...\n"
+	"Loads, validates and optionally converts charts, then prints a JSON summary.\n"
+	"\n"
+	"Options:\n"
+	"  -t, --to <format>   Convert every chart to mmws, sus, json or json.gz\n"
+	"  -o, --out <dir>     Write converted charts to this directory instead of next to their input\n"
+	"  -j, --jobs <count>  Number of worker threads (default: number of cores)\n"
+	"  -r, --recursive     Search directories recursively\n"
+	"  --no-validate       Skip the consistency checks\n"
+	"  --pretty            Indent the JSON summary\n";
+
+struct CliOptions
+{
+	std::vector<std::string> inputs;
+	std::string targetExtension;
+	std::string outputDirectory;
+	int jobs = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	bool recursive = false;
+	bool validate = true;
+	bool pretty = false;
+};
+
+static bool isChartFile(const fs::path& path)
+{
+	const std::string filename = path.filename().u8string();
+	return mmw::ScoreSerializeController::isValidFormat(mmw::ScoreSerializeController::toSerializeFormat(filename));
+}
+
+// Removes the chart extension, including both parts of .json.gz
+static std::string getChartStem(const fs::path& path)
+{
+	std::string filename = path.filename().u8string();
+	for (const char* extension : { mmw::GZ_JSON_EXTENSION, mmw::JSON_EXTENSION, mmw::MMWS_EXTENSION, mmw::SUS_EXTENSION })
+	{
+		if (IO::endsWith(filename, extension))
+			return filename.substr(0, filename.size() - strlen(extension));
+	}
+
+	return path.stem().u8string();
+}
+
+static bool parseArguments(const std::vector<std::string>& args, CliOptions& options)
+{
+	for (size_t i = 0; i < args.size(); ++i)
+	{
+		const std::string& arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+
+		if ((arg == "-t" || arg == "--to") && hasValue)
+		{
+			std::string format = args[++i];
+			if (format != "mmws" && format != "sus" && format != "json" && format != "json.gz")
+				return false;
+
+			options.targetExtension = "." + format;
+		}
+		else if ((arg == "-o" || arg == "--out") && hasValue)
+		{
+			options.outputDirectory = args[++i];
+		}
+		else if ((arg == "-j" || arg == "--jobs") && hasValue)
+		{
+			options.jobs = std::atoi(args[++i].c_str());
+			if (options.jobs < 1)
+				return false;
+		}
+		else if (arg == "-r" || arg == "--recursive")
+		{
+			options.recursive = true;
+		}
+		else if (arg == "--no-validate")
+		{
+			options.validate = false;
+		}
+		else if (arg == "--pretty")
+		{
+			options.pretty = true;
+		}
+		else if (!arg.empty() && arg[0] == '-')
+		{
+			return false;
+		}
+		else
+		{
+			options.inputs.push_back(arg);
+		}
+	}
+
+	return !options.inputs.empty();
+}
+
+static void addJob(const fs::path& file, const fs::path& root, const CliOptions& options, std::vector<mmw::Cli::ChartJob>& jobs)
+{
+	mmw::Cli::ChartJob job{};
+	job.input = file.u8string();
+	if (!options.targetExtension.empty())
+	{
+		fs::path outputDirectory = file.parent_path();
+		if (!options.outputDirectory.empty())
+			outputDirectory = fs::u8path(options.outputDirectory) / file.parent_path().lexically_relative(root);
+
+		fs::path output = outputDirectory / fs::u8path(getChartStem(file) + options.targetExtension);
+		if (output.lexically_normal() == file.lexically_normal())
+			throw std::runtime_error("Converting " + file.u8string() + " to its own format would overwrite it, use --out");
+
+		job.output = output.u8string();
+	}
+
+	jobs.push_back(std::move(job));
+}
+
+static std::vector<mmw::Cli::ChartJob> collectJobs(const CliOptions& options)
+{
+	std::vector<mmw::Cli::ChartJob> jobs;
+	for (const std::string& input : options.inputs)
+	{
+		const fs::path path = fs::u8path(input);
+		if (!fs::is_directory(path))
+		{
+			addJob(path, path.parent_path(), options, jobs);
+			continue;
+		}
+
+		std::vector<fs::path> files;
+		if (options.recursive)
+		{
+			for (const auto& entry : fs::recursive_directory_iterator(path))
+				if (entry.is_regular_file() && isChartFile(entry.path()))
+					files.push_back(entry.path());
+		}
+		else
+		{
+			for (const auto& entry : fs::directory_iterator(path))
+				if (entry.is_regular_file() && isChartFile(entry.path()))
+					files.push_back(entry.path());
+		}
+
+		// Directory iteration order is unspecified, so sort to keep the summary stable between runs
+		std::sort(files.begin(), files.end());
+		for (const fs::path& file : files)
+			addJob(file, path, options, jobs);
+	}
+
+	return jobs;
+}
+
+static nlohmann::json toJson(const mmw::Cli::BatchSummary& summary)
+{
+	int succeeded = 0, chartsWithIssues = 0, issueCount = 0;
+	nlohmann::json results = nlohmann::json::array();
+	for (const auto& result : summary.results)
+	{
+		nlohmann::json issues = nlohmann::json::array();
+		for (const auto& issue : result.issues)
+		{
+			issues.push_back({
+				{ "check", issue.check },
+				{ "noteId", issue.noteID },
+				{ "tick", issue.tick },
+				{ "message", issue.message }
+			});
+		}
+
+		nlohmann::json chart = {
+			{ "input", result.input },
+			{ "status", !result.success ? "error" : result.issues.empty() ? "ok" : "issues" },
+			{ "notes", result.noteCount },
+			{ "holds", result.holdCount },
+			{ "loadMs", result.loadTime * 1000 },
+			{ "issues", issues }
+		};
+
+		if (!result.output.empty())
+		{
+			chart["output"] = result.output;
+			chart["saveMs"] = result.saveTime * 1000;
+		}
+
+		if (!result.success)
+			chart["error"] = result.error;
+
+		succeeded += result.success;
+		chartsWithIssues += !result.issues.empty();
+		issueCount += result.issues.size();
+		results.push_back(std::move(chart));
+	}
+
+	const size_t chartCount = summary.results.size();
+	return {
+		{ "charts", chartCount },
+		{ "succeeded", succeeded },
+		{ "failed", static_cast<int>(chartCount) - succeeded },
+		{ "chartsWithIssues", chartsWithIssues },
+		{ "issues", issueCount },
+		{ "threads", summary.threads },
+		{ "elapsedSeconds", summary.elapsed },
+		{ "chartsPerSecond", summary.elapsed > 0 ? chartCount / summary.elapsed : 0.0 },
+		{ "results", results }
+	};
+}
+
+static int run(const std::vector<std::string>& args)
+{
+	CliOptions options;
+	if (!parseArguments(args, options))
+	{
+		std::cerr << usage;
+		return 2;
+	}
+
+	try
+	{
+		std::vector<mmw::Cli::ChartJob> jobs = collectJobs(options);
+		for (const auto& job : jobs)
+		{
+			const fs::path outputDirectory = fs::u8path(job.output).parent_path();
+			if (!outputDirectory.empty())
+				fs::create_directories(outputDirectory);
+		}
+
+		mmw::Cli::BatchSummary summary = mmw::Cli::runBatch(jobs, { options.jobs, options.validate });
+		nlohmann::json report = toJson(summary);
+
+		std::cout << report.dump(options.pretty ? 2 : -1) << std::endl;
+		std::cerr << IO::formatString("Processed %d charts in %.3fs (%.1f charts/s) on %d threads, %d failed, %d with issues\n",
+			report["charts"].get<int>(), summary.elapsed, report["chartsPerSecond"].get<double>(), summary.threads,
+			report["failed"].get<int>(), report["chartsWithIssues"].get<int>());
+
+		return report["failed"].get<int>() || report["chartsWithIssues"].get<int>() ? 1 : 0;
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "Error: " << error.what() << '\n';
+		return 2;
+	}
+}
+
+#ifdef _WIN32
+// The narrow arguments use the system code page, the wide ones keep every file name intact
+int wmain(int argc, wchar_t** argv)
+{
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; ++i)
+		args.push_back(IO::wideStringToMb(argv[i]));
+
+	return run(args);
+}
+#else
+int main(int argc, char** argv)
+{
+	return run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
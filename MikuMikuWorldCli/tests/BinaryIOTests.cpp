@@ -0,0 +1,196 @@
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Round trips everything BinaryWriter can encode through a file and back through BinaryReader
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; failures++; } } while (0)
+
+static bool throwsOutOfRange(const std::function<void()>& function)
+{
+	try
+	{
+		function();
+	}
+	catch (const std::out_of_range&)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+static std::string getTemporaryFilename(const char* name)
+{
+	return (std::filesystem::temp_directory_path() / name).u8string();
+}
+
+static const uint32_t varUIntValues[] = {
+	0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 0x1fffff, 0x200000, 0xfffffff, 0x10000000, std::numeric_limits<uint32_t>::max()
+};
+
+static const int32_t varIntValues[] = {
+	0, 1, -1, 63, -64, 64, -65, 8191, -8192, 8192, std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()
+};
+
+static std::vector<uint8_t> createRandomBytes(size_t size)
+{
+	std::mt19937 random(static_cast<uint32_t>(size));
+	std::vector<uint8_t> bytes(size);
+	for (uint8_t& byte : bytes)
+		byte = static_cast<uint8_t>(random());
+
+	return bytes;
+}
+
+static void testValuesRoundTrip()
+{
+	const std::string filename = getTemporaryFilename("mmw_binary_io_values.bin");
+	const std::vector<uint8_t> largeBytes = createRandomBytes(5 * 1024 * 1024 + 3);
+	{
+		IO::BinaryWriter writer(filename);
+		CHECK(writer.isStreamValid());
+
+		writer.writeByte(0xab);
+		writer.writeInt16(0xbeef);
+		writer.writeInt32(0xdeadbeef);
+		writer.writeSingle(-1.5f);
+		writer.writeString("");
+		writer.writeString(u8"ミク");
+		writer.writeNull(3);
+
+		for (uint32_t value : varUIntValues)
+			writer.writeVarUInt32(value);
+
+		for (int32_t value : varIntValues)
+			writer.writeVarInt32(value);
+
+		// Written after a flush so the file is rewritten with everything in the buffer
+		writer.flush();
+		writer.writeBytes(largeBytes);
+		writer.writeString("end");
+	}
+
+	IO::BinaryReader reader(filename);
+	CHECK(reader.isStreamValid());
+	CHECK(reader.readByte() == 0xab);
+	CHECK(reader.readInt16() == 0xbeef);
+	CHECK(reader.readInt32() == 0xdeadbeef);
+	CHECK(reader.readSingle() == -1.5f);
+	CHECK(reader.readString().empty());
+	CHECK(reader.readString() == u8"ミク");
+	CHECK(reader.readBytes(3) == std::vector<uint8_t>(3, 0));
+
+	for (uint32_t value : varUIntValues)
+		CHECK(reader.readVarUInt32() == value);
+
+	for (int32_t value : varIntValues)
+		CHECK(reader.readVarInt32() == value);
+
+	CHECK(reader.readBytes(largeBytes.size()) == largeBytes);
+	CHECK(reader.readString() == "end");
+	CHECK(reader.getStreamPosition() == reader.getFileSize());
+	CHECK(throwsOutOfRange([&] { reader.readByte(); }));
+
+	reader.close();
+	std::filesystem::remove(std::filesystem::u8path(filename));
+}
+
+static void testVarIntSizes()
+{
+	IO::BinaryWriter writer;
+	const size_t expectedSizes[] = { 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5 };
+	for (size_t i = 0; i < std::size(varUIntValues); ++i)
+	{
+		const size_t start = writer.getStreamPosition();
+		writer.writeVarUInt32(varUIntValues[i]);
+		CHECK(writer.getStreamPosition() - start == expectedSizes[i]);
+	}
+}
+
+static void testSeekAndPatch()
+{
+	IO::BinaryWriter writer;
+	writer.writeInt32(0);
+	writer.writeString("payload");
+
+	// Size fields are patched in after the data they describe
+	const size_t end = writer.getStreamPosition();
+	writer.seek(0);
+	writer.writeInt32(static_cast<uint32_t>(end));
+	writer.seek(end);
+
+	// Seeking past the end fills the gap with zeros
+	writer.seek(end + 4);
+	writer.writeByte(1);
+	CHECK(writer.getFileSize() == end + 5);
+
+	IO::BinaryReader reader(writer.getBuffer());
+	CHECK(reader.readInt32() == end);
+	CHECK(reader.readString() == "payload");
+	CHECK(reader.readInt32() == 0);
+	CHECK(reader.readByte() == 1);
+}
+
+static void testBufferBoundaries()
+{
+	IO::BinaryWriter writer;
+	writer.writeInt16(0x1234);
+	const std::vector<uint8_t>& bytes = writer.getBuffer();
+
+	// Every read that doesn't fit in the buffer fails without moving
+	IO::BinaryReader reader(std::vector<uint8_t>(bytes.begin(), bytes.begin() + 1));
+	CHECK(throwsOutOfRange([&] { reader.readInt16(); }));
+	CHECK(throwsOutOfRange([&] { reader.readInt32(); }));
+	CHECK(throwsOutOfRange([&] { reader.readBytes(2); }));
+	CHECK(throwsOutOfRange([&] { reader.readBytes(std::numeric_limits<size_t>::max()); }));
+	CHECK(reader.getStreamPosition() == 0);
+	CHECK(reader.readBytes(1) == std::vector<uint8_t>{ 0x34 });
+	CHECK(reader.readBytes(0).empty());
+
+	// A string without a terminator ends with the data
+	IO::BinaryReader unterminated(std::vector<uint8_t>{ 'a', 'b' });
+	CHECK(unterminated.readString() == "ab");
+	CHECK(unterminated.readString().empty());
+
+	// A variable length integer cut off by the end of the data
+	IO::BinaryReader truncated(std::vector<uint8_t>{ 0x80, 0x80 });
+	CHECK(throwsOutOfRange([&] { truncated.readVarUInt32(); }));
+
+	IO::BinaryReader seekedPastEnd(std::vector<uint8_t>{ 1, 2 });
+	seekedPastEnd.seek(3);
+	CHECK(throwsOutOfRange([&] { seekedPastEnd.readByte(); }));
+}
+
+static void testMissingFile()
+{
+	IO::BinaryReader reader(getTemporaryFilename("mmw_binary_io_missing.bin"));
+	CHECK(!reader.isStreamValid());
+	CHECK(reader.getFileSize() == 0);
+}
+
+int main()
+{
+	testValuesRoundTrip();
+	testVarIntSizes();
+	testSeekAndPatch();
+	testBufferBoundaries();
+	testMissingFile();
+
+	if (failures)
+		std::cerr << failures << " checks failed\n";
+
+	return failures ? 1 : 0;
+}
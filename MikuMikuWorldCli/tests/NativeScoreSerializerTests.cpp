@@ -0,0 +1,288 @@
+#include "NativeScoreSerializer.h"
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
+#include "Score.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Round trips scores through every chunk of the MMWS v5 format and checks newer chunks are skipped
+
+using namespace MikuMikuWorld;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; failures++; } } while (0)
+
+struct ChunkEntry
+{
+	uint32_t type;
+	uint32_t flags;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t rawSize;
+};
+
+static constexpr uint32_t chunkEntrySize = 5 * sizeof(uint32_t);
+static constexpr uint32_t chunkCompressed = 1;
+
+static std::string getTemporaryFilename(const char* name)
+{
+	return (std::filesystem::temp_directory_path() / name).u8string();
+}
+
+static void removeFile(const std::string& filename)
+{
+	std::filesystem::remove(std::filesystem::u8path(filename));
+}
+
+static Note createNote(NoteType type, int tick, std::mt19937& random)
+{
+	Note note(type, tick, random() % NUM_LANES, 1 + random() % MAX_NOTE_WIDTH);
+	note.ID = nextID++;
+	note.critical = random() % 3 == 0;
+	note.friction = random() % 4 == 0;
+	if (!note.hasEase())
+		note.flick = static_cast<FlickType>(random() % static_cast<int>(FlickType::FlickTypeCount));
+
+	return note;
+}
+
+// Enough notes that the note chunks are large enough to be compressed
+static Score createScore()
+{
+	std::mt19937 random(5);
+	Score score;
+	score.metadata = { u8"タイトル", "artist", "author", "music.mp3", "jacket.png", -0.25f };
+	score.tempoChanges.push_back({ 1920, 180.5f });
+	score.timeSignatures[4] = { 4, 3, 4 };
+	score.timeSignatures[8] = { 8, 7, 8 };
+	score.hiSpeedChanges.push_back({ 480, 0.5f });
+	score.hiSpeedChanges.push_back({ 960, -2.0f });
+	score.skills.push_back({ nextSkillID++, 3840 });
+	score.skills.push_back({ nextSkillID++, 7680 });
+	score.fever = { 1000, 2000 };
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		Note note = createNote(NoteType::Tap, static_cast<int>(random() % 200000), random);
+		score.notes[note.ID] = note;
+	}
+
+	for (int i = 0; i < 100; ++i)
+	{
+		const int startTick = static_cast<int>(random() % 200000);
+		HoldNote hold;
+		hold.startType = static_cast<HoldNoteType>(random() % 3);
+		hold.endType = hold.startType == HoldNoteType::Guide ? HoldNoteType::Guide : static_cast<HoldNoteType>(random() % 2);
+
+		Note start = createNote(NoteType::Hold, startTick, random);
+		hold.start = { start.ID, HoldStepType::Normal, static_cast<EaseType>(random() % 3) };
+		score.notes[start.ID] = start;
+
+		int tick = startTick;
+		const int stepCount = random() % 5;
+		for (int s = 0; s < stepCount; ++s)
+		{
+			tick += 1 + random() % 480;
+			Note mid = createNote(NoteType::HoldMid, tick, random);
+			mid.parentID = start.ID;
+			score.notes[mid.ID] = mid;
+			hold.steps.push_back({ mid.ID, static_cast<HoldStepType>(random() % 3), static_cast<EaseType>(random() % 3) });
+		}
+
+		Note end = createNote(NoteType::HoldEnd, tick + 1 + random() % 480, random);
+		end.parentID = start.ID;
+		score.notes[end.ID] = end;
+		hold.end = end.ID;
+		score.holdNotes[start.ID] = hold;
+	}
+
+	return score;
+}
+
+static void describeNote(std::ostream& out, const Note& note)
+{
+	out << static_cast<int>(note.getType()) << ' ' << note.tick << ' ' << note.lane << ' ' << note.width << ' '
+		<< note.critical << note.friction << static_cast<int>(note.flick);
+}
+
+// IDs are handed out again on load, so scores are compared by their contents in tick order
+static std::string describeScore(const Score& score)
+{
+	std::ostringstream out;
+	const ScoreMetadata& metadata = score.metadata;
+	out << metadata.title << '|' << metadata.artist << '|' << metadata.author << '|' << metadata.musicFile << '|'
+		<< metadata.jacketFile << '|' << metadata.musicOffset << '\n';
+
+	for (const Tempo& tempo : score.tempoChanges)
+		out << "tempo " << tempo.tick << ' ' << tempo.bpm << '\n';
+
+	for (const auto& [measure, timeSignature] : score.timeSignatures)
+		out << "ts " << measure << ' ' << timeSignature.numerator << '/' << timeSignature.denominator << '\n';
+
+	for (const HiSpeedChange& hiSpeed : score.hiSpeedChanges)
+		out << "hispeed " << hiSpeed.tick << ' ' << hiSpeed.speed << '\n';
+
+	for (const SkillTrigger& skill : score.skills)
+		out << "skill " << skill.tick << '\n';
+
+	out << "fever " << score.fever.startTick << ' ' << score.fever.endTick << '\n';
+
+	for (int id : score.notes.getTickOrder())
+	{
+		const Note& note = score.notes.at(id);
+		if (note.getType() == NoteType::Tap)
+		{
+			out << "tap ";
+			describeNote(out, note);
+			out << '\n';
+		}
+		else if (note.getType() == NoteType::Hold)
+		{
+			const HoldNote& hold = score.holdNotes.at(id);
+			out << "hold " << static_cast<int>(hold.startType) << static_cast<int>(hold.endType) << static_cast<int>(hold.start.ease) << ' ';
+			describeNote(out, note);
+			for (const HoldStep& step : hold.steps)
+			{
+				out << "\n  step " << static_cast<int>(step.type) << static_cast<int>(step.ease) << ' ';
+				describeNote(out, score.notes.at(step.ID));
+			}
+
+			out << "\n  end ";
+			describeNote(out, score.notes.at(hold.end));
+			out << '\n';
+		}
+	}
+
+	return out.str();
+}
+
+static std::vector<ChunkEntry> readDirectory(IO::BinaryReader& reader)
+{
+	CHECK(reader.readString() == "MMWS");
+	CHECK(reader.readInt32() == static_cast<uint32_t>(NativeScoreSerializer::SCORE_VERSION));
+
+	std::vector<ChunkEntry> directory(reader.readInt32());
+	for (ChunkEntry& entry : directory)
+	{
+		entry.type = reader.readInt32();
+		entry.flags = reader.readInt32();
+		entry.offset = reader.readInt32();
+		entry.size = reader.readInt32();
+		entry.rawSize = reader.readInt32();
+	}
+
+	return directory;
+}
+
+static void testRoundTrip(const Score& score, bool compressChunks, bool expectCompressed)
+{
+	const std::string filename = getTemporaryFilename("mmw_native_serializer_round_trip.mmws");
+	NativeScoreSerializer(compressChunks).serialize(score, filename);
+
+	{
+		IO::BinaryReader reader(filename);
+		CHECK(reader.isStreamValid());
+
+		bool anyCompressed = false;
+		const std::vector<ChunkEntry> directory = readDirectory(reader);
+		CHECK(directory.size() == 5);
+		for (const ChunkEntry& entry : directory)
+		{
+			anyCompressed |= (entry.flags & chunkCompressed) != 0;
+			CHECK(entry.offset + entry.size <= reader.getFileSize());
+		}
+
+		CHECK(anyCompressed == expectCompressed);
+		reader.close();
+	}
+
+	const Score loaded = NativeScoreSerializer().deserialize(filename);
+	CHECK(describeScore(loaded) == describeScore(score));
+	CHECK(loaded.notes.size() == score.notes.size());
+	CHECK(loaded.holdNotes.size() == score.holdNotes.size());
+
+	// The edit journal numbers notes by this order, so it has to pair up every note with itself loaded back
+	const std::vector<int> order = NativeScoreSerializer::getNoteOrder(score);
+	const std::vector<int> loadedOrder = NativeScoreSerializer::getNoteOrder(loaded);
+	CHECK(order.size() == score.notes.size());
+	CHECK(loadedOrder.size() == order.size());
+	for (size_t i = 0; i < std::min(order.size(), loadedOrder.size()); ++i)
+	{
+		std::ostringstream note, loadedNote;
+		describeNote(note, score.notes.at(order[i]));
+		describeNote(loadedNote, loaded.notes.at(loadedOrder[i]));
+		CHECK(note.str() == loadedNote.str());
+	}
+
+	removeFile(filename);
+}
+
+// A newer version may add chunks, which are listed first here to make sure lookups skip over them
+static void testUnknownChunksSkipped(const Score& score)
+{
+	const std::string filename = getTemporaryFilename("mmw_native_serializer_unknown_chunk.mmws");
+	NativeScoreSerializer().serialize(score, filename);
+
+	IO::BinaryReader reader(filename);
+	const std::vector<ChunkEntry> directory = readDirectory(reader);
+	const size_t chunksStart = reader.getStreamPosition();
+	const std::vector<uint8_t> chunks = reader.readBytes(reader.getFileSize() - chunksStart);
+	reader.close();
+
+	const std::vector<uint8_t> unknownChunk{ 'n', 'e', 'w', 0, 0xff, 0xfe };
+	const uint32_t unknownOffset = static_cast<uint32_t>(chunksStart + chunkEntrySize + chunks.size());
+	{
+		IO::BinaryWriter writer(filename);
+		writer.writeString("MMWS");
+		writer.writeInt32(NativeScoreSerializer::SCORE_VERSION);
+		writer.writeInt32(static_cast<uint32_t>(directory.size() + 1));
+
+		writer.writeInt32('X' | ('T' << 8) | ('R' << 16) | (static_cast<uint32_t>('A') << 24));
+		writer.writeInt32(0);
+		writer.writeInt32(unknownOffset);
+		writer.writeInt32(static_cast<uint32_t>(unknownChunk.size()));
+		writer.writeInt32(static_cast<uint32_t>(unknownChunk.size()));
+
+		// The directory grew by one entry, which moves every known chunk back by as much
+		for (const ChunkEntry& entry : directory)
+		{
+			writer.writeInt32(entry.type);
+			writer.writeInt32(entry.flags);
+			writer.writeInt32(entry.offset + chunkEntrySize);
+			writer.writeInt32(entry.size);
+			writer.writeInt32(entry.rawSize);
+		}
+
+		writer.writeBytes(chunks);
+		writer.writeBytes(unknownChunk);
+		writer.flush();
+		writer.close();
+	}
+
+	const Score loaded = NativeScoreSerializer().deserialize(filename);
+	CHECK(describeScore(loaded) == describeScore(score));
+
+	removeFile(filename);
+}
+
+int main()
+{
+	const Score score = createScore();
+	testRoundTrip(score, true, true);
+	testRoundTrip(score, false, false);
+	testRoundTrip(Score(), true, false);
+	testUnknownChunksSkipped(score);
+
+	if (failures)
+		std::cerr << failures << " checks failed\n";
+
+	return failures ? 1 : 0;
+}